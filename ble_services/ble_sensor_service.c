@@ -1,6 +1,7 @@
 #include "ble.h"
 #include "ble_sensor_service.h"
 #include "ble_srv_common.h"
+#include "app_timer.h"
 
 #include "nrf_log.h"
 
@@ -8,12 +9,105 @@
 #define BLE_UUID_SENSOR_SERVICE 0x2234  
 #define BLE_UUID_SENSOR_SERVICE_CHARACTERISTIC_1 0x2235               
 #define BLE_UUID_SENSOR_SERVICE_CHARACTERISTIC_2 0x2236      
+#define BLE_UUID_SENSOR_SERVICE_CHARACTERISTIC_3 0x2237
 
 
+#define RATE_TICKS_PER_SEC  (APP_TIMER_CLOCK_FREQ / (APP_TIMER_CONFIG_RTC_FREQUENCY + 1))   /**< app_timer counter frequency (in Hz). */
+
 #define SENSOR_SERVICE_BASE_UUID    {{0x41, 0xee, 0x68, 0x3a, 0x99, 0x0f, 0x0e, 0x72, 0x85, 0x49, 0x8d, 0xb3, 0x00, 0x00, 0x00, 0x00}}
 
 char user_desc_1[] = "Start communication with 0x01.";
 char user_desc_2[] = "Get data from notify characteristic.";
+char user_desc_3[] = "Benchmark results.";
+
+
+/**@brief Function for closing the drain rate window once it has run long enough.
+ *
+ * @param[in] p_client  Link context.
+ */
+static void drain_rate_update(ble_sensor_service_client_context_t * p_client)
+{
+    uint32_t now     = app_timer_cnt_get();
+    uint32_t elapsed = app_timer_cnt_diff_compute(now, p_client->window_start);
+    uint32_t rate;
+
+    if (elapsed < APP_TIMER_TICKS(BLE_SENSOR_SERVICE_RATE_WINDOW_MS))
+    {
+        return;
+    }
+
+    // With nothing sent and nothing waiting the link was idle, not slow, so the rate is kept.
+    if ((p_client->window_bytes > 0) || (p_client->queued_bytes > 0))
+    {
+        rate = (uint32_t)(((uint64_t)p_client->window_bytes * RATE_TICKS_PER_SEC) / elapsed);
+
+        // Rides out a single slow window, follows a PHY or interval change within a few.
+        p_client->drain_rate    = p_client->is_rate_valid ? ((p_client->drain_rate * 3) + rate) / 4 : rate;
+        p_client->is_rate_valid = true;
+    }
+
+    p_client->window_bytes = 0;
+    p_client->window_start = now;
+}
+
+
+/**@brief Function for raising a watermark event when the backlog crosses one.
+ *
+ * @param[in] p_sensor_service  SENSOR Service structure.
+ * @param[in] conn_handle       Connection handle.
+ * @param[in] p_client          Link context.
+ */
+static void backlog_check(ble_sensor_service_t                * p_sensor_service,
+                          uint16_t                              conn_handle,
+                          ble_sensor_service_client_context_t * p_client)
+{
+    ble_sensor_service_evt_t evt;
+    uint64_t                 backlog_ms;
+
+    if ((p_sensor_service->backlog_high_ms == 0) ||
+        (p_sensor_service->data_handler == NULL) ||
+        !p_client->is_rate_valid)
+    {
+        return;
+    }
+
+    if (p_client->drain_rate > 0)
+    {
+        backlog_ms = ((uint64_t)p_client->queued_bytes * 1000) / p_client->drain_rate;
+        backlog_ms = MIN(backlog_ms, UINT32_MAX);
+    }
+    else
+    {
+        backlog_ms = (p_client->queued_bytes > 0) ? UINT32_MAX : 0;
+    }
+
+    memset(&evt, 0, sizeof(ble_sensor_service_evt_t));
+
+    if (!p_client->is_backlog_high && (backlog_ms >= p_sensor_service->backlog_high_ms))
+    {
+        evt.type = BLE_SENSOR_SERVICE_EVT_BACKLOG_HIGH;
+    }
+    else if (p_client->is_backlog_high && (backlog_ms <= p_sensor_service->backlog_low_ms))
+    {
+        evt.type = BLE_SENSOR_SERVICE_EVT_BACKLOG_LOW;
+    }
+    else
+    {
+        return;
+    }
+
+    p_client->is_backlog_high = (evt.type == BLE_SENSOR_SERVICE_EVT_BACKLOG_HIGH);
+
+    evt.p_sensor_service              = p_sensor_service;
+    evt.conn_handle                   = conn_handle;
+    evt.p_link_ctx                    = p_client;
+    evt.params.backlog.queued_bytes   = p_client->queued_bytes;
+    evt.params.backlog.drain_rate     = p_client->drain_rate;
+    evt.params.backlog.backlog_ms     = (uint32_t)backlog_ms;
+
+    p_sensor_service->data_handler(&evt);
+}
+
 
 static void on_connect(ble_sensor_service_t * p_sensor_service, ble_evt_t const * p_ble_evt)
 {
@@ -32,14 +126,41 @@ static void on_connect(ble_sensor_service_t * p_sensor_service, ble_evt_t const
                       p_ble_evt->evt.gap_evt.conn_handle);
     }
 
-    /* Check the hosts CCCD value to inform of readiness to send data using the NOTIFY characteristic(sensor_service_handles_1) */
+    if (p_client != NULL)
+    {
+        // Link contexts are reused, the drain rate of an earlier link means nothing here.
+        p_client->queued_bytes    = 0;
+        p_client->window_bytes    = 0;
+        p_client->window_start    = app_timer_cnt_get();
+        p_client->drain_rate      = 0;
+        p_client->is_rate_valid   = false;
+        p_client->is_backlog_high = false;
+
+        p_client->is_notification_enabled = false;
+    }
+
+    /* Check the hosts CCCD values to inform of readiness to send data using the NOTIFY characteristics.
+     * For a bonded host, Peer Manager has set them from the bond before this observer runs, so the
+     * host need not write them again. */
     memset(&gatts_val, 0, sizeof(ble_gatts_value_t));
     gatts_val.p_value = cccd_value;
     gatts_val.len     = sizeof(cccd_value);
     gatts_val.offset  = 0;
 
     err_code = sd_ble_gatts_value_get(p_ble_evt->evt.gap_evt.conn_handle,
-                                      p_sensor_service->sensor_service_handles_1.cccd_handle,
+                                      p_sensor_service->sensor_service_handles_3.cccd_handle,
+                                      &gatts_val);
+
+    if (p_client != NULL)
+    {
+        p_client->is_result_notification_enabled = (err_code == NRF_SUCCESS) &&
+                                                   ble_srv_is_notification_enabled(gatts_val.p_value);
+    }
+
+    gatts_val.len = sizeof(cccd_value);
+
+    err_code = sd_ble_gatts_value_get(p_ble_evt->evt.gap_evt.conn_handle,
+                                      p_sensor_service->sensor_service_handles_2.cccd_handle,
                                       &gatts_val);
 
     if ((err_code == NRF_SUCCESS)     &&
@@ -123,6 +244,14 @@ static void on_write(ble_sensor_service_t * p_sensor_service, ble_evt_t const *
 
         }
     }
+    else if ((p_evt_write->handle == p_sensor_service->sensor_service_handles_3.cccd_handle) &&
+        (p_evt_write->len == 2))
+    {
+        if (p_client != NULL)
+        {
+            p_client->is_result_notification_enabled = ble_srv_is_notification_enabled(p_evt_write->data);
+        }
+    }
     else
     {
         // Do Nothing. This event is not relevant for this service.
@@ -151,6 +280,8 @@ static void on_hvx_send_data_complete(ble_sensor_service_t * p_sensor_service, b
         return;
     }
 
+    drain_rate_update(p_client);
+
     if (p_client->is_notification_enabled)
     {
         memset(&evt, 0, sizeof(ble_sensor_service_evt_t));
@@ -158,6 +289,7 @@ static void on_hvx_send_data_complete(ble_sensor_service_t * p_sensor_service, b
         evt.p_sensor_service     = p_sensor_service;
         evt.conn_handle          = p_ble_evt->evt.gatts_evt.conn_handle;
         evt.p_link_ctx           = p_client;
+        evt.params.tx_complete.count = p_ble_evt->evt.gatts_evt.params.hvn_tx_complete.count;
 
         p_sensor_service->data_handler(&evt);
     }
@@ -209,7 +341,9 @@ uint32_t ble_sensor_service_init(ble_sensor_service_t * p_sensor_service, ble_se
     VERIFY_PARAM_NOT_NULL(p_sensor_service_init);
 
     // Initialize the service structure.
-    p_sensor_service->data_handler = p_sensor_service_init->data_handler;
+    p_sensor_service->data_handler    = p_sensor_service_init->data_handler;
+    p_sensor_service->backlog_high_ms = p_sensor_service_init->backlog_high_ms;
+    p_sensor_service->backlog_low_ms  = p_sensor_service_init->backlog_low_ms;
 
     /**@snippet [Adding proprietary Service to the SoftDevice] */
     // Add a custom base UUID.
@@ -231,7 +365,7 @@ uint32_t ble_sensor_service_init(ble_sensor_service_t * p_sensor_service, ble_se
     memset(&add_char_params, 0, sizeof(add_char_params));
     add_char_params.uuid                     = BLE_UUID_SENSOR_SERVICE_CHARACTERISTIC_1;
     add_char_params.uuid_type                = p_sensor_service->uuid_type;
-    add_char_params.max_len                  = 1;
+    add_char_params.max_len                  = BLE_SENSOR_SERVICE_CHAR1_MAX_LEN;
     add_char_params.p_init_value             = p_sensor_service->init_value_1;
     add_char_params.init_len                 = sizeof(uint8_t);
     add_char_params.is_var_len               = true;
@@ -287,6 +421,34 @@ uint32_t ble_sensor_service_init(ble_sensor_service_t * p_sensor_service, ble_se
         return err_code;
     }
 
+    // Add the NOTIFY Characteristic 3.
+    memset(&add_char_params, 0, sizeof(add_char_params));
+    add_char_params.uuid                     = BLE_UUID_SENSOR_SERVICE_CHARACTERISTIC_3;
+    add_char_params.uuid_type                = p_sensor_service->uuid_type;
+    add_char_params.max_len                  = BLE_SENSOR_SERVICE_CHAR3_MAX_LEN;
+    add_char_params.p_init_value             = p_sensor_service->init_value_3;
+    add_char_params.init_len                 = sizeof(uint8_t);
+    add_char_params.is_var_len               = true;
+    add_char_params.char_props.write         = 0;
+    add_char_params.char_props.write_wo_resp = 0;
+    add_char_params.char_props.read          = 0;
+    add_char_params.char_props.notify        = 1;
+
+    memset(&user_descr, 0, sizeof(user_descr));
+    user_descr.p_char_user_desc = (uint8_t *) user_desc_3;
+    user_descr.size = strlen(user_desc_3);
+    user_descr.max_size = strlen(user_desc_3);
+    user_descr.read_access  = SEC_OPEN;
+    add_char_params.p_user_descr = &user_descr;
+
+    add_char_params.cccd_write_access = SEC_OPEN;
+
+    err_code = characteristic_add(p_sensor_service->service_handle, &add_char_params, &p_sensor_service->sensor_service_handles_3);
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
     return err_code;    
     /**@snippet [Adding proprietary characteristic to the SoftDevice] */
 }
@@ -384,5 +546,139 @@ uint32_t ble_sensor_service_send_char2(ble_sensor_service_t * p_sensor_service,
     hvx_params.p_len  = &p_length;
     hvx_params.type   = BLE_GATT_HVX_NOTIFICATION;
 
+    err_code = sd_ble_gatts_hvx(conn_handle, &hvx_params);
+    if (err_code == NRF_SUCCESS)
+    {
+        p_client->window_bytes += p_length;
+    }
+
+    return err_code;
+}
+
+
+uint32_t ble_sensor_service_send_char3(ble_sensor_service_t * p_sensor_service,
+                                       uint16_t               conn_handle,
+                                       uint8_t const        * p_data,
+                                       uint16_t               length)
+{
+    ret_code_t                 err_code;
+    ble_gatts_hvx_params_t     hvx_params;
+    ble_sensor_service_client_context_t * p_client;
+
+    VERIFY_PARAM_NOT_NULL(p_sensor_service);
+
+    err_code = blcm_link_ctx_get(p_sensor_service->p_link_ctx_storage, conn_handle, (void *) &p_client);
+    VERIFY_SUCCESS(err_code);
+
+    if ((conn_handle == BLE_CONN_HANDLE_INVALID) || (p_client == NULL))
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    if (!p_client->is_result_notification_enabled)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    if (length > BLE_SENSOR_SERVICE_CHAR3_MAX_LEN)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    memset(&hvx_params, 0, sizeof(hvx_params));
+
+    hvx_params.handle = p_sensor_service->sensor_service_handles_3.value_handle;
+    hvx_params.p_data = p_data;
+    hvx_params.p_len  = &length;
+    hvx_params.type   = BLE_GATT_HVX_NOTIFICATION;
+
     return sd_ble_gatts_hvx(conn_handle, &hvx_params);
-}
\ No newline at end of file
+}
+
+
+uint32_t ble_sensor_service_send_burst(ble_sensor_service_t * p_sensor_service,
+                                       uint16_t               conn_handle,
+                                       uint8_t const        * p_data,
+                                       uint16_t               length,
+                                       uint16_t               stride,
+                                       uint16_t               count,
+                                       uint16_t             * p_queued)
+{
+    ret_code_t                 err_code;
+    ble_gatts_hvx_params_t     hvx_params;
+    uint16_t                   hvx_len;
+    ble_sensor_service_client_context_t * p_client;
+
+    VERIFY_PARAM_NOT_NULL(p_sensor_service);
+    VERIFY_PARAM_NOT_NULL(p_queued);
+
+    *p_queued = 0;
+
+    err_code = blcm_link_ctx_get(p_sensor_service->p_link_ctx_storage, conn_handle, (void *) &p_client);
+    VERIFY_SUCCESS(err_code);
+
+    if ((conn_handle == BLE_CONN_HANDLE_INVALID) || (p_client == NULL))
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    if (!p_client->is_notification_enabled)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    if ((length > BLE_SENSOR_SERVICE_MAX_DATA_LEN) || ((count > 1) && (stride < length)))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    memset(&hvx_params, 0, sizeof(hvx_params));
+
+    hvx_params.handle = p_sensor_service->sensor_service_handles_2.value_handle; // NOTIFY Characteristic handle
+    hvx_params.p_len  = &hvx_len;
+    hvx_params.type   = BLE_GATT_HVX_NOTIFICATION;
+
+    while (*p_queued < count)
+    {
+        // The SoftDevice writes the sent length back, so it is reloaded for every packet.
+        hvx_len           = length;
+        hvx_params.p_data = p_data + ((uint32_t)(*p_queued) * stride);
+
+        err_code = sd_ble_gatts_hvx(conn_handle, &hvx_params);
+        if (err_code != NRF_SUCCESS)
+        {
+            return err_code;
+        }
+
+        p_client->window_bytes += hvx_len;
+        (*p_queued)++;
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+uint32_t ble_sensor_service_backlog_set(ble_sensor_service_t * p_sensor_service,
+                                        uint16_t               conn_handle,
+                                        uint32_t               queued_bytes)
+{
+    ret_code_t                            err_code;
+    ble_sensor_service_client_context_t * p_client;
+
+    VERIFY_PARAM_NOT_NULL(p_sensor_service);
+
+    err_code = blcm_link_ctx_get(p_sensor_service->p_link_ctx_storage, conn_handle, (void *) &p_client);
+    VERIFY_SUCCESS(err_code);
+
+    if ((conn_handle == BLE_CONN_HANDLE_INVALID) || (p_client == NULL))
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    p_client->queued_bytes = queued_bytes;
+
+    drain_rate_update(p_client);
+    backlog_check(p_sensor_service, conn_handle, p_client);
+
+    return NRF_SUCCESS;
+}
@@ -40,6 +40,17 @@ extern "C" {
     #warning NRF_SDH_BLE_GATT_MAX_MTU_SIZE is not defined.
 #endif
 
+/**@brief   Maximum length of a command written to characteristic 1 (in bytes). Fits the default ATT MTU. */
+#define BLE_SENSOR_SERVICE_CHAR1_MAX_LEN    (BLE_GATT_ATT_MTU_DEFAULT - OPCODE_LENGTH - HANDLE_LENGTH)
+
+/**@brief   Maximum length of a result record notified on characteristic 3 (in bytes). Fits the default ATT MTU. */
+#define BLE_SENSOR_SERVICE_CHAR3_MAX_LEN    (BLE_GATT_ATT_MTU_DEFAULT - OPCODE_LENGTH - HANDLE_LENGTH)
+
+/**@brief   Time over which the characteristic 2 drain rate is measured (in ms). */
+#ifndef BLE_SENSOR_SERVICE_RATE_WINDOW_MS
+#define BLE_SENSOR_SERVICE_RATE_WINDOW_MS   100
+#endif
+
 
 /**@brief   SENSOR Service event types. */
 typedef enum
@@ -50,6 +61,8 @@ typedef enum
     BLE_SENSOR_SERVICE_EVT_TRANSMIT_RDY,       /**< Service is ready to accept new data to be transmitted. */
     BLE_SENSOR_SERVICE_EVT_COMM_STARTED,      /**< Notification has been enabled. */
     BLE_SENSOR_SERVICE_EVT_COMM_STOPPED,      /**< Notification has been disabled. */
+    BLE_SENSOR_SERVICE_EVT_BACKLOG_HIGH,      /**< The application backlog takes longer than the high watermark to drain. */
+    BLE_SENSOR_SERVICE_EVT_BACKLOG_LOW,       /**< The backlog is back below the low watermark. */
 } ble_sensor_service_evt_type_t;
 
 
@@ -68,6 +81,26 @@ typedef struct
 } ble_sensor_service_evt_received_data_t;
 
 
+/**@brief   SENSOR Service @ref BLE_SENSOR_SERVICE_EVT_TRANSMIT_RDY event data.
+ *
+ * @details This structure is passed to an event when @ref BLE_SENSOR_SERVICE_EVT_TRANSMIT_RDY occurs.
+ */
+typedef struct
+{
+    uint8_t count; /**< Number of notifications the SoftDevice has completed. */
+} ble_sensor_service_evt_tx_complete_t;
+
+
+/**@brief   SENSOR Service @ref BLE_SENSOR_SERVICE_EVT_BACKLOG_HIGH and @ref BLE_SENSOR_SERVICE_EVT_BACKLOG_LOW event data.
+ */
+typedef struct
+{
+    uint32_t queued_bytes;  /**< Bytes the application has waiting for characteristic 2. */
+    uint32_t drain_rate;    /**< Measured characteristic 2 drain rate (in bytes/s). */
+    uint32_t backlog_ms;    /**< Time the backlog takes to drain at that rate (in ms), UINT32_MAX if the link does not drain. */
+} ble_sensor_service_evt_backlog_t;
+
+
 /**@brief SENSOR Service client context structure.
  *
  * @details This structure contains state context related to hosts.
@@ -75,6 +108,14 @@ typedef struct
 typedef struct
 {
     bool is_notification_enabled; /**< Variable to indicate if the peer has enabled notification of the characteristic.*/
+    bool is_result_notification_enabled; /**< The peer has enabled notification of characteristic 3. */
+
+    uint32_t queued_bytes;      /**< Application backlog for characteristic 2, as last reported (in bytes). */
+    uint32_t window_bytes;      /**< Characteristic 2 bytes handed to the SoftDevice in the current rate window. */
+    uint32_t window_start;      /**< app_timer counter at the start of the rate window. */
+    uint32_t drain_rate;        /**< Measured characteristic 2 drain rate (in bytes/s). */
+    bool     is_rate_valid;     /**< @p drain_rate has been measured at least once. */
+    bool     is_backlog_high;   /**< @ref BLE_SENSOR_SERVICE_EVT_BACKLOG_HIGH was the last watermark event. */
 } ble_sensor_service_client_context_t;
 
 
@@ -91,6 +132,8 @@ typedef struct
     union
     {
         ble_sensor_service_evt_received_data_t received_data;           /**< @ref BLE_sensor_SERVICE_EVT_RECEIVED_DATA event data. */
+        ble_sensor_service_evt_tx_complete_t   tx_complete;             /**< @ref BLE_SENSOR_SERVICE_EVT_TRANSMIT_RDY event data. */
+        ble_sensor_service_evt_backlog_t       backlog;                 /**< Backlog watermark event data. */
     } params;
 } ble_sensor_service_evt_t;
 
@@ -108,6 +151,8 @@ typedef void (* ble_sensor_service_data_handler_t) (ble_sensor_service_evt_t * p
 typedef struct
 {
     ble_sensor_service_data_handler_t   data_handler; /**< Event handler to be called for handling received data. */
+    uint32_t                            backlog_high_ms;    /**< Backlog drain time that raises @ref BLE_SENSOR_SERVICE_EVT_BACKLOG_HIGH (in ms), 0 for no watermark events. */
+    uint32_t                            backlog_low_ms;     /**< Backlog drain time that raises @ref BLE_SENSOR_SERVICE_EVT_BACKLOG_LOW (in ms). */
 } ble_sensor_service_init_t;
 
 
@@ -122,12 +167,16 @@ struct ble_sensor_service_s
     
     ble_gatts_char_handles_t            sensor_service_handles_1;         /**< Handles related to the characteristic 1(as provided by the SoftDevice). */
     ble_gatts_char_handles_t            sensor_service_handles_2;         /**< Handles related to the characteristic 2(as provided by the SoftDevice). */
+    ble_gatts_char_handles_t            sensor_service_handles_3;         /**< Handles related to the characteristic 3(as provided by the SoftDevice). */
 
     uint8_t  *init_value_1;
     uint8_t  *init_value_2;
+    uint8_t  *init_value_3;
 
     blcm_link_ctx_storage_t * const       p_link_ctx_storage; /**< Pointer to link context storage with handles of all current connections and its context. */
     ble_sensor_service_data_handler_t     data_handler;       /**< Event handler to be called for handling received data. */
+    uint32_t                              backlog_high_ms;    /**< High backlog watermark (in ms), 0 if disabled. */
+    uint32_t                              backlog_low_ms;     /**< Low backlog watermark (in ms). */
 };
 
 
@@ -150,6 +199,68 @@ uint32_t ble_sensor_service_send_char2(ble_sensor_service_t * p_sensor_service,
                            uint16_t  p_length,
                            uint16_t  conn_handle);
 
+/**@brief   Function for notifying a benchmark result record on characteristic 3.
+ *
+ * @param[in] p_sensor_service  SENSOR Service structure.
+ * @param[in] conn_handle       Connection handle of the destination client.
+ * @param[in] p_data            Record.
+ * @param[in] length            Length of @p p_data (in bytes).
+ *
+ * @retval NRF_SUCCESS              If the notification was queued.
+ * @retval NRF_ERROR_INVALID_STATE  If the client has not enabled notification of characteristic 3.
+ * @return Otherwise an error code from the checks or from sd_ble_gatts_hvx.
+ */
+uint32_t ble_sensor_service_send_char3(ble_sensor_service_t * p_sensor_service,
+                                       uint16_t               conn_handle,
+                                       uint8_t const        * p_data,
+                                       uint16_t               length);
+
+/**@brief   Function for reporting how much data the application has waiting for characteristic 2.
+ *
+ * @details The backlog is compared with the drain rate the service measures on characteristic 2.
+ *          @ref BLE_SENSOR_SERVICE_EVT_BACKLOG_HIGH is raised once the backlog would take longer
+ *          than the high watermark to send, and @ref BLE_SENSOR_SERVICE_EVT_BACKLOG_LOW once it is
+ *          back under the low watermark, so a producer can slow down or change its encoding before
+ *          data is lost. Call this whenever the backlog changes, from the same interrupt priority
+ *          as the SoftDevice events.
+ *
+ * @param[in] p_sensor_service  SENSOR Service structure.
+ * @param[in] conn_handle       Connection handle of the destination client.
+ * @param[in] queued_bytes      Bytes waiting to be notified.
+ *
+ * @retval NRF_SUCCESS          If the backlog was taken.
+ * @retval NRF_ERROR_NOT_FOUND  If the connection is unknown.
+ */
+uint32_t ble_sensor_service_backlog_set(ble_sensor_service_t * p_sensor_service,
+                                        uint16_t               conn_handle,
+                                        uint32_t               queued_bytes);
+
+/**@brief   Function for queueing several char2 notifications in one call.
+ *
+ * @details Packet i starts at p_data + i * stride and is @p length bytes long. Notifications are
+ *          queued in order until the SoftDevice refuses one. The link context and the notification
+ *          parameters are set up once for the whole burst.
+ *
+ * @param[in]  p_sensor_service  SENSOR Service structure.
+ * @param[in]  conn_handle       Connection handle of the destination client.
+ * @param[in]  p_data            First packet.
+ * @param[in]  length            Length of every packet (in bytes).
+ * @param[in]  stride            Distance between the start of two packets (in bytes).
+ * @param[in]  count             Number of packets.
+ * @param[out] p_queued          Number of packets the SoftDevice accepted.
+ *
+ * @retval NRF_SUCCESS          If all packets were queued.
+ * @retval NRF_ERROR_RESOURCES  If the HVN TX queue filled up, *p_queued tells how far it got.
+ * @return Otherwise an error code from the checks or from sd_ble_gatts_hvx.
+ */
+uint32_t ble_sensor_service_send_burst(ble_sensor_service_t * p_sensor_service,
+                                       uint16_t               conn_handle,
+                                       uint8_t const        * p_data,
+                                       uint16_t               length,
+                                       uint16_t               stride,
+                                       uint16_t               count,
+                                       uint16_t             * p_queued);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,218 @@
+#include <string.h>
+#include "bench_matrix.h"
+
+
+static void uint16_put(uint8_t * p_buf, uint16_t value)
+{
+    p_buf[0] = (uint8_t)(value);
+    p_buf[1] = (uint8_t)(value >> 8);
+}
+
+
+static void uint32_put(uint8_t * p_buf, uint32_t value)
+{
+    p_buf[0] = (uint8_t)(value);
+    p_buf[1] = (uint8_t)(value >> 8);
+    p_buf[2] = (uint8_t)(value >> 16);
+    p_buf[3] = (uint8_t)(value >> 24);
+}
+
+
+static uint16_t uint16_get(uint8_t const * p_buf)
+{
+    return (uint16_t)(p_buf[0] | (p_buf[1] << 8));
+}
+
+
+static uint32_t uint32_get(uint8_t const * p_buf)
+{
+    return ((uint32_t)p_buf[0])
+         | ((uint32_t)p_buf[1] << 8)
+         | ((uint32_t)p_buf[2] << 16)
+         | ((uint32_t)p_buf[3] << 24);
+}
+
+
+uint16_t bench_matrix_cell_count(bench_matrix_axes_t const * p_axes)
+{
+    return (uint16_t)(p_axes->conn_interval_count
+                    * p_axes->phy_count
+                    * p_axes->data_length_count
+                    * p_axes->att_mtu_count
+                    * p_axes->queue_size_count);
+}
+
+
+void bench_matrix_cell_get(bench_matrix_axes_t const * p_axes, uint16_t index, bench_matrix_cell_t * p_cell)
+{
+    // Mixed radix number, the queue depth is the least significant digit.
+    p_cell->queue_size    = p_axes->p_queue_sizes[index % p_axes->queue_size_count];
+    index                /= p_axes->queue_size_count;
+    p_cell->att_mtu       = p_axes->p_att_mtus[index % p_axes->att_mtu_count];
+    index                /= p_axes->att_mtu_count;
+    p_cell->data_length   = p_axes->p_data_lengths[index % p_axes->data_length_count];
+    index                /= p_axes->data_length_count;
+    p_cell->phy           = p_axes->p_phys[index % p_axes->phy_count];
+    index                /= p_axes->phy_count;
+    p_cell->conn_interval = p_axes->p_conn_intervals[index % p_axes->conn_interval_count];
+}
+
+
+bool bench_matrix_start(bench_matrix_t * p_bench, bench_matrix_axes_t const * p_axes)
+{
+    uint16_t cell_count = bench_matrix_cell_count(p_axes);
+
+    if ((cell_count == 0) || (cell_count > UINT8_MAX))
+    {
+        return false;
+    }
+
+    p_bench->p_axes     = p_axes;
+    p_bench->cell_count = cell_count;
+    p_bench->index      = 0;
+    p_bench->is_running = true;
+
+    return true;
+}
+
+
+bool bench_matrix_cell_current(bench_matrix_t const * p_bench, bench_matrix_cell_t * p_cell)
+{
+    if (!p_bench->is_running)
+    {
+        return false;
+    }
+
+    bench_matrix_cell_get(p_bench->p_axes, p_bench->index, p_cell);
+
+    return true;
+}
+
+
+bool bench_matrix_advance(bench_matrix_t * p_bench)
+{
+    if (!p_bench->is_running)
+    {
+        return false;
+    }
+
+    p_bench->index++;
+    if (p_bench->index >= p_bench->cell_count)
+    {
+        p_bench->is_running = false;
+    }
+
+    return p_bench->is_running;
+}
+
+
+void bench_matrix_stop(bench_matrix_t * p_bench)
+{
+    p_bench->is_running = false;
+}
+
+
+void bench_matrix_cell_simulate(bench_matrix_t        * p_bench,
+                                uint32_t                data_len,
+                                uint8_t                 header_len,
+                                uint32_t                event_length_us,
+                                bench_matrix_result_t * p_result)
+{
+    bench_matrix_cell_t cell;
+    link_model_params_t params;
+    link_model_report_t report;
+    uint16_t            hvx_len;
+    uint32_t            packets_left;
+    uint8_t             status = BENCH_MATRIX_STATUS_SIMULATED;
+
+    bench_matrix_cell_get(p_bench->p_axes, p_bench->index, &cell);
+
+    params.conn_interval_us = (uint32_t)cell.conn_interval * 1250;
+    params.event_length_us  = event_length_us;
+    params.phy              = (cell.phy == LINK_MODEL_PHY_2M) ? LINK_MODEL_PHY_2M : LINK_MODEL_PHY_1M;
+    params.data_length      = cell.data_length;
+    params.att_mtu          = cell.att_mtu;
+    params.hvn_queue_size   = cell.queue_size;
+
+    hvx_len      = cell.att_mtu - LINK_MODEL_ATT_HVX_HEADER_LEN;
+    packets_left = (data_len + (hvx_len - header_len) - 1) / (hvx_len - header_len);
+
+    link_model_sim_init(&p_bench->sim, &params);
+
+    while ((packets_left > 0) || (p_bench->sim.queued > 0))
+    {
+        while ((packets_left > 0) && link_model_sim_hvx(&p_bench->sim, hvx_len))
+        {
+            packets_left--;
+        }
+
+        if (link_model_sim_conn_event(&p_bench->sim) == 0)
+        {
+            // The model does not split a notification over connection events, the cell would stall.
+            status = BENCH_MATRIX_STATUS_FAILED;
+            break;
+        }
+    }
+
+    link_model_sim_report(&p_bench->sim, &report);
+
+    memset(p_result, 0, sizeof(bench_matrix_result_t));
+    p_result->index                  = (uint8_t)p_bench->index;
+    p_result->cell_count             = (uint8_t)p_bench->cell_count;
+    p_result->status                 = status;
+    p_result->phy                    = cell.phy;
+    p_result->conn_interval          = cell.conn_interval;
+    p_result->att_mtu                = cell.att_mtu;
+    p_result->data_length            = cell.data_length;
+    p_result->queue_size             = cell.queue_size;
+    p_result->packets_per_event_x100 = (uint16_t)report.packets_per_event_x100;
+    p_result->elapsed_ms             = report.elapsed_us / 1000;
+
+    if (report.elapsed_us > 0)
+    {
+        // Frame headers are not payload, the link model counts whole notifications.
+        p_result->goodput_bps = (uint32_t)(((uint64_t)report.packets * (hvx_len - header_len) * 8 * 1000000)
+                                           / report.elapsed_us);
+    }
+}
+
+
+uint16_t bench_matrix_result_encode(bench_matrix_result_t const * p_result, uint8_t * p_buf)
+{
+    p_buf[0] = p_result->index;
+    p_buf[1] = p_result->cell_count;
+    p_buf[2] = p_result->status;
+    p_buf[3] = p_result->phy;
+    uint16_put(&p_buf[4], p_result->conn_interval);
+    uint16_put(&p_buf[6], p_result->att_mtu);
+    p_buf[8] = p_result->data_length;
+    p_buf[9] = p_result->queue_size;
+    uint32_put(&p_buf[10], p_result->goodput_bps);
+    uint16_put(&p_buf[14], p_result->packets_per_event_x100);
+    uint32_put(&p_buf[16], p_result->elapsed_ms);
+
+    return BENCH_MATRIX_RESULT_LEN;
+}
+
+
+bool bench_matrix_result_decode(uint8_t const * p_buf, uint16_t length, bench_matrix_result_t * p_result)
+{
+    if (length != BENCH_MATRIX_RESULT_LEN)
+    {
+        return false;
+    }
+
+    p_result->index                  = p_buf[0];
+    p_result->cell_count             = p_buf[1];
+    p_result->status                 = p_buf[2];
+    p_result->phy                    = p_buf[3];
+    p_result->conn_interval          = uint16_get(&p_buf[4]);
+    p_result->att_mtu                = uint16_get(&p_buf[6]);
+    p_result->data_length            = p_buf[8];
+    p_result->queue_size             = p_buf[9];
+    p_result->goodput_bps            = uint32_get(&p_buf[10]);
+    p_result->packets_per_event_x100 = uint16_get(&p_buf[14]);
+    p_result->elapsed_ms             = uint32_get(&p_buf[16]);
+
+    return true;
+}
@@ -0,0 +1,182 @@
+#ifndef __BENCH_MATRIX_H
+#define __BENCH_MATRIX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "link_model.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Length of an encoded result record (in bytes). Fits a notification at the default ATT MTU. */
+#define BENCH_MATRIX_RESULT_LEN         20
+
+/**@brief   Result status codes. */
+#define BENCH_MATRIX_STATUS_OK          0   /**< Measured over the air. */
+#define BENCH_MATRIX_STATUS_FAILED      1   /**< The transfer of the cell was aborted. */
+#define BENCH_MATRIX_STATUS_SIMULATED   2   /**< Computed by the link model, no radio involved. */
+
+
+/**@brief   Values of every benchmark axis. A cell takes one value from each. */
+typedef struct
+{
+    uint16_t const * p_conn_intervals;      /**< Connection intervals (in 1.25 ms units). */
+    uint8_t          conn_interval_count;
+    uint8_t const  * p_phys;                /**< PHYs, 1 for LE 1M and 2 for LE 2M as in BLE_GAP_PHY_*. */
+    uint8_t          phy_count;
+    uint16_t const * p_att_mtus;            /**< ATT MTUs (in bytes). */
+    uint8_t          att_mtu_count;
+    uint8_t const  * p_data_lengths;        /**< LL data lengths (in bytes). */
+    uint8_t          data_length_count;
+    uint8_t const  * p_queue_sizes;         /**< HVN TX queue depths (in notifications). */
+    uint8_t          queue_size_count;
+} bench_matrix_axes_t;
+
+
+/**@brief   Link settings of one benchmark cell. */
+typedef struct
+{
+    uint16_t conn_interval;     /**< Connection interval (in 1.25 ms units). */
+    uint8_t  phy;               /**< 1 for LE 1M, 2 for LE 2M. */
+    uint16_t att_mtu;           /**< ATT MTU (in bytes). */
+    uint8_t  data_length;       /**< LL data length (in bytes). */
+    uint8_t  queue_size;        /**< HVN TX queue depth (in notifications). */
+} bench_matrix_cell_t;
+
+
+/**@brief   Outcome of one benchmark cell.
+ *
+ * @details Encoded little endian in @ref BENCH_MATRIX_RESULT_LEN bytes:
+ *
+ * | Offset | Size | Field                                               |
+ * |--------|------|-----------------------------------------------------|
+ * | 0      | 1    | Cell index                                          |
+ * | 1      | 1    | Number of cells in the matrix                       |
+ * | 2      | 1    | Status, BENCH_MATRIX_STATUS_*                       |
+ * | 3      | 1    | PHY in use                                          |
+ * | 4      | 2    | Connection interval in use (1.25 ms units)          |
+ * | 6      | 2    | ATT MTU                                             |
+ * | 8      | 1    | LL data length in use                               |
+ * | 9      | 1    | HVN TX queue depth                                  |
+ * | 10     | 4    | Goodput (bit/s)                                     |
+ * | 14     | 2    | Notifications per connection event, times 100       |
+ * | 16     | 4    | Transfer time (ms)                                  |
+ *
+ * The link values are the ones the central accepted, which may differ from the cell's request.
+ */
+typedef struct
+{
+    uint8_t  index;                     /**< Cell index. */
+    uint8_t  cell_count;                /**< Number of cells in the matrix. */
+    uint8_t  status;                    /**< BENCH_MATRIX_STATUS_* code. */
+    uint8_t  phy;                       /**< PHY in use. */
+    uint16_t conn_interval;             /**< Connection interval in use (in 1.25 ms units). */
+    uint16_t att_mtu;                   /**< ATT MTU (in bytes). */
+    uint8_t  data_length;               /**< LL data length in use (in bytes). */
+    uint8_t  queue_size;                /**< HVN TX queue depth (in notifications). */
+    uint32_t goodput_bps;               /**< Application payload rate (in bit/s). */
+    uint16_t packets_per_event_x100;    /**< Average notifications per connection event, times 100. */
+    uint32_t elapsed_ms;                /**< Transfer time (in ms). */
+} bench_matrix_result_t;
+
+
+/**@brief   Benchmark matrix runner.
+ *
+ * @details Walks the cells in an order that changes the slowest link settings least often: the
+ *          queue depth varies fastest, the connection interval slowest.
+ */
+typedef struct
+{
+    bench_matrix_axes_t const * p_axes;
+    uint16_t                    cell_count;     /**< Number of cells in the matrix. */
+    uint16_t                    index;          /**< Cell being run. */
+    bool                        is_running;     /**< A benchmark is in progress. */
+    link_model_sim_t            sim;            /**< Simulated link used by @ref bench_matrix_cell_simulate. */
+} bench_matrix_t;
+
+
+/**@brief   Function for getting the number of cells of a matrix.
+ */
+uint16_t bench_matrix_cell_count(bench_matrix_axes_t const * p_axes);
+
+
+/**@brief   Function for getting the link settings of a cell.
+ *
+ * @param[in]  p_axes  Matrix axes.
+ * @param[in]  index   Cell index, less than @ref bench_matrix_cell_count.
+ * @param[out] p_cell  Link settings of the cell.
+ */
+void bench_matrix_cell_get(bench_matrix_axes_t const * p_axes, uint16_t index, bench_matrix_cell_t * p_cell);
+
+
+/**@brief   Function for starting a benchmark at the first cell.
+ *
+ * @retval true   If the benchmark was started.
+ * @retval false  If the matrix has no cells or more than UINT8_MAX.
+ */
+bool bench_matrix_start(bench_matrix_t * p_bench, bench_matrix_axes_t const * p_axes);
+
+
+/**@brief   Function for getting the cell being run.
+ *
+ * @retval true   If a benchmark is running and @p p_cell was written.
+ * @retval false  If no benchmark is running.
+ */
+bool bench_matrix_cell_current(bench_matrix_t const * p_bench, bench_matrix_cell_t * p_cell);
+
+
+/**@brief   Function for moving on to the next cell.
+ *
+ * @retval true   If there is another cell to run.
+ * @retval false  If the last cell is done, the benchmark has ended.
+ */
+bool bench_matrix_advance(bench_matrix_t * p_bench);
+
+
+/**@brief   Function for ending a benchmark early.
+ */
+void bench_matrix_stop(bench_matrix_t * p_bench);
+
+
+/**@brief   Function for running the cell being run on a simulated link.
+ *
+ * @details Sends @p data_len bytes of payload in full-MTU notifications through
+ *          @ref link_model_sim_t, so the whole matrix can be run, and the result path checked,
+ *          without a radio and on a host.
+ *
+ * @param[in]  p_bench          Benchmark in progress.
+ * @param[in]  data_len         Payload to send (in bytes).
+ * @param[in]  header_len       Frame header in every notification (in bytes).
+ * @param[in]  event_length_us  Connection event length available to the link (in us).
+ * @param[out] p_result         Result of the cell.
+ */
+void bench_matrix_cell_simulate(bench_matrix_t        * p_bench,
+                                uint32_t                data_len,
+                                uint8_t                 header_len,
+                                uint32_t                event_length_us,
+                                bench_matrix_result_t * p_result);
+
+
+/**@brief   Function for encoding a result record.
+ *
+ * @param[in]  p_result  Result.
+ * @param[out] p_buf     Destination, at least @ref BENCH_MATRIX_RESULT_LEN bytes.
+ *
+ * @return  Number of bytes written.
+ */
+uint16_t bench_matrix_result_encode(bench_matrix_result_t const * p_result, uint8_t * p_buf);
+
+
+/**@brief   Function for decoding a result record.
+ *
+ * @retval true   If the record was decoded.
+ * @retval false  If @p length is not @ref BENCH_MATRIX_RESULT_LEN.
+ */
+bool bench_matrix_result_decode(uint8_t const * p_buf, uint16_t length, bench_matrix_result_t * p_result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __BENCH_MATRIX_H
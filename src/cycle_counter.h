@@ -0,0 +1,26 @@
+#ifndef __CYCLE_COUNTER_H
+#define __CYCLE_COUNTER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Function for starting the DWT cycle counter, used to time code on the target.
+ *
+ * @details The counter runs at the CPU clock and wraps every 2^32 cycles, so take differences of
+ *          @ref cycle_counter_get values. Enabling it again while it runs has no effect.
+ */
+void cycle_counter_enable(void);
+
+
+/**@brief   Function for reading the DWT cycle counter.
+ */
+uint32_t cycle_counter_get(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CYCLE_COUNTER_H
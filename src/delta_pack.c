@@ -0,0 +1,210 @@
+#include <string.h>
+#include "delta_pack.h"
+
+
+#define CLASS_REPEAT        0
+#define CLASS_NARROW        1
+#define CLASS_WIDE          2
+#define CLASS_KEYFRAME      3
+
+#define COUNT_BITS          8
+#define READING_MASK        ((1UL << DELTA_PACK_SAMPLE_BITS) - 1)
+
+
+/**@brief Width of every channel of a sample of each class (in bits). */
+static const uint8_t m_class_bits[] =
+{
+    [CLASS_REPEAT]   = 0,
+    [CLASS_NARROW]   = DELTA_PACK_NARROW_BITS,
+    [CLASS_WIDE]     = DELTA_PACK_WIDE_BITS,
+    [CLASS_KEYFRAME] = DELTA_PACK_SAMPLE_BITS,
+};
+
+
+static uint32_t zigzag_encode(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+
+static int32_t zigzag_decode(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+
+/**@brief Function for writing a field to a bit stream, LSB first.
+ *
+ * @details Bytes are cleared as the stream first reaches them, so a payload buffer need not be.
+ */
+static void bits_put(uint8_t * p_buf, uint16_t * p_bit_pos, uint32_t value, uint8_t bits)
+{
+    for (uint8_t i = 0; i < bits; i++)
+    {
+        uint16_t pos = *p_bit_pos + i;
+
+        if ((pos & 7) == 0)
+        {
+            p_buf[pos >> 3] = 0;
+        }
+
+        p_buf[pos >> 3] |= (uint8_t)(((value >> i) & 1) << (pos & 7));
+    }
+
+    *p_bit_pos += bits;
+}
+
+
+/**@brief Function for reading a field from a bit stream, LSB first.
+ */
+static uint32_t bits_get(uint8_t const * p_buf, uint16_t * p_bit_pos, uint8_t bits)
+{
+    uint32_t value = 0;
+
+    for (uint8_t i = 0; i < bits; i++)
+    {
+        uint16_t pos = *p_bit_pos + i;
+
+        value |= (uint32_t)((p_buf[pos >> 3] >> (pos & 7)) & 1) << i;
+    }
+
+    *p_bit_pos += bits;
+
+    return value;
+}
+
+
+uint16_t delta_pack_sample_put(delta_pack_encoder_t * p_encoder,
+                               uint8_t const        * p_sample,
+                               uint16_t               sample_index,
+                               uint8_t              * p_payload,
+                               uint16_t               payload_max)
+{
+    uint16_t readings[DELTA_PACK_CHANNELS];
+    uint32_t deltas[DELTA_PACK_CHANNELS];
+    uint32_t delta_max = 0;
+    uint8_t  sample_class;
+    uint16_t bit_pos;
+
+    if ((sample_index >= DELTA_PACK_SAMPLES_MAX) || (payload_max == 0))
+    {
+        return 0;
+    }
+
+    for (uint8_t i = 0; i < DELTA_PACK_CHANNELS; i++)
+    {
+        readings[i] = (uint16_t)((p_sample[2 * i] | (p_sample[2 * i + 1] << 8)) & READING_MASK);
+        deltas[i]   = zigzag_encode((int32_t)readings[i] - (int32_t)p_encoder->last[i]);
+
+        if (deltas[i] > delta_max)
+        {
+            delta_max = deltas[i];
+        }
+    }
+
+    if ((sample_index % DELTA_PACK_KEYFRAME_INTERVAL) == 0)
+    {
+        sample_class = CLASS_KEYFRAME;
+    }
+    else if (delta_max == 0)
+    {
+        sample_class = CLASS_REPEAT;
+    }
+    else if (delta_max < (1UL << DELTA_PACK_NARROW_BITS))
+    {
+        sample_class = CLASS_NARROW;
+    }
+    else if (delta_max < (1UL << DELTA_PACK_WIDE_BITS))
+    {
+        sample_class = CLASS_WIDE;
+    }
+    else
+    {
+        sample_class = CLASS_KEYFRAME;
+    }
+
+    bit_pos = (sample_index == 0) ? COUNT_BITS : p_encoder->bit_len;
+
+    if ((uint32_t)bit_pos + DELTA_PACK_CLASS_BITS + DELTA_PACK_CHANNELS * m_class_bits[sample_class] > payload_max * 8UL)
+    {
+        return 0;
+    }
+
+    bits_put(p_payload, &bit_pos, sample_class, DELTA_PACK_CLASS_BITS);
+
+    for (uint8_t i = 0; i < DELTA_PACK_CHANNELS; i++)
+    {
+        bits_put(p_payload,
+                 &bit_pos,
+                 (sample_class == CLASS_KEYFRAME) ? readings[i] : deltas[i],
+                 m_class_bits[sample_class]);
+    }
+
+    memcpy(p_encoder->last, readings, sizeof(readings));
+    p_encoder->bit_len = bit_pos;
+    p_payload[0]       = (uint8_t)(sample_index + 1);
+
+    return (bit_pos + 7) / 8;
+}
+
+
+bool delta_pack_decode(uint8_t const * p_payload,
+                       uint16_t        length,
+                       uint16_t      * p_readings,
+                       uint16_t        max_samples,
+                       uint16_t      * p_count)
+{
+    uint16_t   bit_pos = COUNT_BITS;
+    uint16_t   count;
+    uint16_t * p_last  = NULL;
+
+    if (length == 0)
+    {
+        return false;
+    }
+
+    count = p_payload[0];
+    if (count > max_samples)
+    {
+        return false;
+    }
+
+    for (uint16_t n = 0; n < count; n++)
+    {
+        uint16_t * p_sample = &p_readings[n * DELTA_PACK_CHANNELS];
+        uint8_t    sample_class;
+
+        if ((uint32_t)bit_pos + DELTA_PACK_CLASS_BITS > length * 8UL)
+        {
+            return false;
+        }
+
+        sample_class = (uint8_t)bits_get(p_payload, &bit_pos, DELTA_PACK_CLASS_BITS);
+
+        if (((uint32_t)bit_pos + DELTA_PACK_CHANNELS * m_class_bits[sample_class] > length * 8UL) ||
+            ((p_last == NULL) && (sample_class != CLASS_KEYFRAME)))
+        {
+            return false;
+        }
+
+        for (uint8_t i = 0; i < DELTA_PACK_CHANNELS; i++)
+        {
+            uint32_t field = bits_get(p_payload, &bit_pos, m_class_bits[sample_class]);
+
+            if (sample_class == CLASS_KEYFRAME)
+            {
+                p_sample[i] = (uint16_t)field;
+            }
+            else
+            {
+                p_sample[i] = (uint16_t)((p_last[i] + zigzag_decode(field)) & READING_MASK);
+            }
+        }
+
+        p_last = p_sample;
+    }
+
+    *p_count = count;
+
+    return true;
+}
@@ -0,0 +1,112 @@
+#ifndef __DELTA_PACK_H
+#define __DELTA_PACK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Channels in every sample. */
+#ifndef DELTA_PACK_CHANNELS
+#define DELTA_PACK_CHANNELS             6
+#endif
+
+/**@brief   Significant bits of every channel reading, at most 16. */
+#ifndef DELTA_PACK_SAMPLE_BITS
+#define DELTA_PACK_SAMPLE_BITS          12
+#endif
+
+/**@brief   Width of a delta in a narrow and a wide sample (in bits), less than @ref DELTA_PACK_SAMPLE_BITS. */
+#ifndef DELTA_PACK_NARROW_BITS
+#define DELTA_PACK_NARROW_BITS          2
+#endif
+
+#ifndef DELTA_PACK_WIDE_BITS
+#define DELTA_PACK_WIDE_BITS            6
+#endif
+
+/**@brief   Samples between two keyframes within a frame. Every frame also starts with one. */
+#ifndef DELTA_PACK_KEYFRAME_INTERVAL
+#define DELTA_PACK_KEYFRAME_INTERVAL    64
+#endif
+
+/**@brief   Length of a raw sample: every channel a 16-bit little endian reading (in bytes). */
+#define DELTA_PACK_SAMPLE_LEN           (DELTA_PACK_CHANNELS * sizeof(uint16_t))
+
+/**@brief   Longest encoding of the first sample of a payload, sample count included (in bytes). */
+#define DELTA_PACK_FIRST_SAMPLE_MAX_LEN (1 + (DELTA_PACK_CLASS_BITS + DELTA_PACK_CHANNELS * DELTA_PACK_SAMPLE_BITS + 7) / 8)
+
+/**@brief   Samples in one payload, limited by the count byte. */
+#define DELTA_PACK_SAMPLES_MAX          UINT8_MAX
+
+
+/**@brief   Payload format.
+ *
+ * The first byte is the number of samples. The samples follow as a bit stream, LSB first. Every
+ * sample starts with a @ref DELTA_PACK_CLASS_BITS class code that sets how its channels are
+ * stored:
+ *
+ * | Class | Channels                                                             |
+ * |-------|----------------------------------------------------------------------|
+ * | 0     | Nothing, the sample equals the previous one                          |
+ * | 1     | Zigzag deltas to the previous sample, @ref DELTA_PACK_NARROW_BITS each |
+ * | 2     | Zigzag deltas to the previous sample, @ref DELTA_PACK_WIDE_BITS each |
+ * | 3     | Keyframe, readings of @ref DELTA_PACK_SAMPLE_BITS each               |
+ *
+ * The first sample of a payload is always a keyframe, so every payload decodes on its own.
+ */
+#define DELTA_PACK_CLASS_BITS           2
+
+
+/**@brief   Encoder state of the open payload. */
+typedef struct
+{
+    uint16_t last[DELTA_PACK_CHANNELS];     /**< Readings of the previous sample. */
+    uint16_t bit_len;                       /**< Bits used in the payload so far. */
+} delta_pack_encoder_t;
+
+
+/**@brief   Function for adding a sample to a payload.
+ *
+ * @details Matches @ref sample_coalescer_encoder_t, so the encoder can be plugged into a coalescer.
+ *
+ * @param[in]     p_encoder     Encoder.
+ * @param[in]     p_sample      Sample of @ref DELTA_PACK_SAMPLE_LEN bytes.
+ * @param[in]     sample_index  Index of the sample in the payload, 0 starts a new payload.
+ * @param[in,out] p_payload     Payload.
+ * @param[in]     payload_max   Longest payload (in bytes).
+ *
+ * @return  Payload length with the sample added (in bytes), 0 if it does not fit. The payload and
+ *          the encoder are left as they were then.
+ */
+uint16_t delta_pack_sample_put(delta_pack_encoder_t * p_encoder,
+                               uint8_t const        * p_sample,
+                               uint16_t               sample_index,
+                               uint8_t              * p_payload,
+                               uint16_t               payload_max);
+
+
+/**@brief   Function for decoding a payload.
+ *
+ * @param[in]  p_payload    Payload.
+ * @param[in]  length       Length of @p p_payload (in bytes).
+ * @param[out] p_readings   Readings, @ref DELTA_PACK_CHANNELS per sample.
+ * @param[in]  max_samples  Samples @p p_readings has room for.
+ * @param[out] p_count      Number of samples decoded.
+ *
+ * @retval true   If the payload was decoded.
+ * @retval false  If the payload is truncated or has more than @p max_samples samples.
+ */
+bool delta_pack_decode(uint8_t const * p_payload,
+                       uint16_t        length,
+                       uint16_t      * p_readings,
+                       uint16_t        max_samples,
+                       uint16_t      * p_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DELTA_PACK_H
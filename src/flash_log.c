@@ -0,0 +1,874 @@
+#include <string.h>
+#include "flash_log.h"
+#include "nrf_error.h"
+
+
+#define OFFSET_LENGTH       0
+#define OFFSET_LENGTH_INV   2
+#define OFFSET_MARK         4
+#define OFFSET_TIMESTAMP    8
+
+#define LENGTH_NONE         0xFFFF
+#define MARK_CLEARED        0x00000000UL
+
+
+/**@brief Value the drain mark is written with, flash writes need it to stay valid until they end. */
+static const uint32_t m_mark_cleared = MARK_CLEARED;
+
+
+static uint32_t pos_addr(flash_log_t const * p_log, flash_log_pos_t pos)
+{
+    return p_log->p_fs->start_addr + (uint32_t)pos.page * p_log->page_size + pos.offset;
+}
+
+
+static bool pos_equal(flash_log_pos_t a, flash_log_pos_t b)
+{
+    return (a.page == b.page) && (a.offset == b.offset);
+}
+
+
+static uint16_t page_next(flash_log_t const * p_log, uint16_t page)
+{
+    return (page + 1 < p_log->page_count) ? (page + 1) : 0;
+}
+
+
+/**@brief Function for getting the length of a record in flash, header and padding included (in bytes).
+ */
+static uint16_t record_size(uint16_t length)
+{
+    return FLASH_LOG_RECORD_HEADER_LEN + ((length + 3) & ~3);
+}
+
+
+/**@brief Function for reading the header of the page at @p page.
+ *
+ * @retval true   If the page has been opened by the log.
+ * @retval false  If it has not, or its header was cut short.
+ */
+static bool page_header_read(flash_log_t const * p_log, uint16_t page, uint32_t * p_seq)
+{
+    uint32_t header[FLASH_LOG_PAGE_HEADER_LEN / 4];
+
+    (void)nrf_fstorage_read(p_log->p_fs,
+                            p_log->p_fs->start_addr + (uint32_t)page * p_log->page_size,
+                            header,
+                            sizeof(header));
+
+    *p_seq = header[1];
+
+    return header[0] == FLASH_LOG_PAGE_MAGIC;
+}
+
+
+/**@brief Function for checking the length words of a record header read at @p pos.
+ *
+ * @return  Length of the record data (in bytes), 0 if there is no valid record.
+ */
+static uint16_t record_length_decode(flash_log_t const * p_log, flash_log_pos_t pos, uint8_t const * header)
+{
+    uint16_t length;
+    uint16_t length_inv;
+
+    length     = (uint16_t)(header[OFFSET_LENGTH] | (header[OFFSET_LENGTH + 1] << 8));
+    length_inv = (uint16_t)(header[OFFSET_LENGTH_INV] | (header[OFFSET_LENGTH_INV + 1] << 8));
+
+    if ((length == 0) ||
+        (length == LENGTH_NONE) ||
+        ((length ^ length_inv) != LENGTH_NONE) ||
+        (length > FLASH_LOG_RECORD_MAX_LEN) ||
+        ((uint32_t)pos.offset + record_size(length) > p_log->page_size))
+    {
+        return 0;
+    }
+
+    return length;
+}
+
+
+/**@brief Function for reading the length of the record at @p pos.
+ *
+ * @return  Length of the record data (in bytes), 0 if there is no valid record.
+ */
+static uint16_t record_length_read(flash_log_t const * p_log, flash_log_pos_t pos)
+{
+    uint8_t header[OFFSET_MARK];
+
+    if ((uint32_t)pos.offset + FLASH_LOG_RECORD_HEADER_LEN > p_log->page_size)
+    {
+        return 0;
+    }
+
+    (void)nrf_fstorage_read(p_log->p_fs, pos_addr(p_log, pos), header, sizeof(header));
+
+    return record_length_decode(p_log, pos, header);
+}
+
+
+/**@brief Function for moving a position that is not at the head onto the next record.
+ *
+ * @details A page ends where no valid record follows. Pages without a header are skipped, they
+ *          were erased but never written. The end of the records in the head page is the head,
+ *          even when a torn record closed that page early.
+ */
+static void pos_normalize(flash_log_t const * p_log, flash_log_pos_t * p_pos)
+{
+    uint32_t seq;
+
+    for (uint16_t i = 0; i <= p_log->page_count; i++)
+    {
+        if (pos_equal(*p_pos, p_log->head) || (record_length_read(p_log, *p_pos) != 0))
+        {
+            return;
+        }
+
+        if (p_pos->page == p_log->head.page)
+        {
+            *p_pos = p_log->head;
+            return;
+        }
+
+        do
+        {
+            p_pos->page   = page_next(p_log, p_pos->page);
+            p_pos->offset = FLASH_LOG_PAGE_HEADER_LEN;
+        } while ((p_pos->page != p_log->head.page) && !page_header_read(p_log, p_pos->page, &seq));
+    }
+
+    // Only a corrupt region gets here.
+    *p_pos = p_log->head;
+}
+
+
+/**@brief Function for reading the timestamp of the record at @p pos.
+ */
+static uint32_t record_timestamp_read(flash_log_t const * p_log, flash_log_pos_t pos)
+{
+    uint32_t timestamp;
+
+    (void)nrf_fstorage_read(p_log->p_fs, pos_addr(p_log, pos) + OFFSET_TIMESTAMP, &timestamp, sizeof(timestamp));
+
+    return timestamp;
+}
+
+
+/**@brief Function for moving a position past the record at it.
+ */
+static void pos_advance(flash_log_t const * p_log, flash_log_pos_t * p_pos)
+{
+    p_pos->offset += record_size(record_length_read(p_log, *p_pos));
+    pos_normalize(p_log, p_pos);
+}
+
+
+/**@brief Function for getting the page at @p index in ring order, 0 being the oldest page.
+ */
+static uint16_t page_in_order(flash_log_t const * p_log, uint16_t index)
+{
+    return (uint16_t)((p_log->head.page + 1 + index) % p_log->page_count);
+}
+
+
+/**@brief Function for getting the position of the first record of a page, or of the page end
+ *        if the page has not been opened.
+ */
+static flash_log_pos_t page_start(flash_log_t const * p_log, uint16_t page)
+{
+    flash_log_pos_t pos;
+    uint32_t        seq;
+
+    pos.page   = page;
+    pos.offset = page_header_read(p_log, page, &seq) ? FLASH_LOG_PAGE_HEADER_LEN : (uint16_t)p_log->page_size;
+
+    return pos;
+}
+
+
+/**@brief Function for reading the drain marks of the records of a page.
+ *
+ * @param[in]  p_log            Flash log.
+ * @param[in]  page             Page.
+ * @param[out] p_marked         Offset past the last marked record, 0 if no record is marked.
+ * @param[out] p_after          Records after the last marked one.
+ * @param[out] p_last_timestamp Timestamp of the last record.
+ *
+ * @return  true if the page holds a record.
+ */
+static bool page_marks_read(flash_log_t const * p_log,
+                            uint16_t            page,
+                            uint16_t          * p_marked,
+                            uint32_t          * p_after,
+                            uint32_t          * p_last_timestamp)
+{
+    flash_log_pos_t pos         = page_start(p_log, page);
+    uint16_t        end         = (page == p_log->head.page) ? p_log->head.offset : (uint16_t)p_log->page_size;
+    bool            has_records = false;
+    uint16_t        length;
+
+    *p_marked = 0;
+    *p_after  = 0;
+
+    while ((pos.offset < end) && ((length = record_length_read(p_log, pos)) != 0))
+    {
+        uint32_t mark_timestamp[2];
+
+        (void)nrf_fstorage_read(p_log->p_fs, pos_addr(p_log, pos) + OFFSET_MARK, mark_timestamp, sizeof(mark_timestamp));
+        pos.offset += record_size(length);
+
+        if (mark_timestamp[0] == MARK_CLEARED)
+        {
+            *p_marked = pos.offset;
+            *p_after  = 0;
+        }
+        else
+        {
+            (*p_after)++;
+        }
+
+        *p_last_timestamp = mark_timestamp[1];
+        has_records       = true;
+    }
+
+    return has_records;
+}
+
+
+/**@brief Function for building the time index, from the newest page to the oldest.
+ *
+ * @details A page without records takes the timestamp of the page after it, so the index does
+ *          not go back in ring order.
+ */
+static void index_build(flash_log_t * p_log)
+{
+    uint32_t timestamp = p_log->last_timestamp;
+
+    // One read per page, of its header and the header of its first record.
+    for (uint16_t i = p_log->page_count; i > 0; i--)
+    {
+        uint16_t        page = page_in_order(p_log, i - 1);
+        flash_log_pos_t pos  = {page, FLASH_LOG_PAGE_HEADER_LEN};
+        uint32_t        start[(FLASH_LOG_PAGE_HEADER_LEN + FLASH_LOG_RECORD_HEADER_LEN) / 4];
+        uint8_t const * p_record = (uint8_t const *)&start[FLASH_LOG_PAGE_HEADER_LEN / 4];
+
+        (void)nrf_fstorage_read(p_log->p_fs,
+                                p_log->p_fs->start_addr + (uint32_t)page * p_log->page_size,
+                                start,
+                                sizeof(start));
+
+        if ((start[0] == FLASH_LOG_PAGE_MAGIC) && (record_length_decode(p_log, pos, p_record) != 0))
+        {
+            memcpy(&timestamp, &p_record[OFFSET_TIMESTAMP], sizeof(timestamp));
+        }
+
+        p_log->index[page] = timestamp;
+    }
+
+    p_log->is_index_built = true;
+}
+
+
+/**@brief Function for getting the page the head opens next.
+ */
+static uint16_t page_to_open(flash_log_t const * p_log)
+{
+    return p_log->is_page_open ? page_next(p_log, p_log->head.page) : p_log->head.page;
+}
+
+
+/**@brief Function for checking whether a page holds records sent but not yet delivered.
+ *
+ * @details Records in flight lie from the delivery cursor on, the oldest records of the log. Only
+ *          the oldest page is ever erased, so it is pinned if the delivery cursor is in it.
+ */
+static bool page_is_pinned(flash_log_t const * p_log, uint16_t page)
+{
+    return (p_log->undelivered > p_log->unsent) && (p_log->delivered.page == page);
+}
+
+
+/**@brief Function for giving up the records of a page about to be erased.
+ *
+ * @details Only the oldest page is ever erased, and never while it is pinned, so the records lost
+ *          are the first ones not yet sent.
+ */
+static void page_reclaim(flash_log_t * p_log, uint16_t page)
+{
+    while ((p_log->unsent > 0) && (p_log->sent.page == page))
+    {
+        pos_advance(p_log, &p_log->sent);
+        p_log->unsent--;
+    }
+
+    while ((p_log->undelivered > p_log->unsent) && (p_log->delivered.page == page))
+    {
+        pos_advance(p_log, &p_log->delivered);
+        p_log->undelivered--;
+        p_log->lost++;
+    }
+
+    if (p_log->is_mark_due &&
+        (p_log->mark_addr >= p_log->p_fs->start_addr + (uint32_t)page * p_log->page_size) &&
+        (p_log->mark_addr <  p_log->p_fs->start_addr + (uint32_t)(page + 1) * p_log->page_size))
+    {
+        p_log->is_mark_due = false;
+    }
+}
+
+
+static void evt_send(flash_log_t * p_log, flash_log_evt_type_t type, ret_code_t result)
+{
+    flash_log_evt_t evt;
+
+    if (p_log->evt_handler == NULL)
+    {
+        return;
+    }
+
+    evt.type   = type;
+    evt.result = result;
+
+    p_log->evt_handler(&evt);
+}
+
+
+static ret_code_t record_write_start(flash_log_t * p_log)
+{
+    p_log->op = FLASH_LOG_OP_RECORD;
+
+    return nrf_fstorage_write(p_log->p_fs,
+                              pos_addr(p_log, p_log->head) + OFFSET_MARK,
+                              &p_log->buffer[OFFSET_MARK / 4],
+                              p_log->record_len - OFFSET_MARK,
+                              NULL);
+}
+
+
+static ret_code_t record_length_write_start(flash_log_t * p_log)
+{
+    p_log->op = FLASH_LOG_OP_RECORD_LENGTH;
+
+    return nrf_fstorage_write(p_log->p_fs, pos_addr(p_log, p_log->head), p_log->buffer, OFFSET_MARK, NULL);
+}
+
+
+/**@brief Function for checking that the page of the head is free from the head on.
+ */
+static bool page_rest_is_free(flash_log_t const * p_log)
+{
+    uint32_t words[16];
+    uint32_t addr = pos_addr(p_log, p_log->head);
+    uint32_t end  = p_log->p_fs->start_addr + (uint32_t)(p_log->head.page + 1) * p_log->page_size;
+
+    while (addr < end)
+    {
+        uint32_t len = (end - addr < sizeof(words)) ? (end - addr) : sizeof(words);
+
+        (void)nrf_fstorage_read(p_log->p_fs, addr, words, len);
+
+        for (uint8_t i = 0; i < len / 4; i++)
+        {
+            if (words[i] != 0xFFFFFFFFUL)
+            {
+                return false;
+            }
+        }
+
+        addr += len;
+    }
+
+    return true;
+}
+
+
+static ret_code_t page_open_start(flash_log_t * p_log)
+{
+    uint16_t page = page_to_open(p_log);
+
+    page_reclaim(p_log, page);
+
+    p_log->op = FLASH_LOG_OP_ERASE;
+
+    return nrf_fstorage_erase(p_log->p_fs, p_log->p_fs->start_addr + (uint32_t)page * p_log->page_size, 1, NULL);
+}
+
+
+static ret_code_t page_header_write_start(flash_log_t * p_log)
+{
+    uint16_t page = page_to_open(p_log);
+
+    p_log->page_header[0] = FLASH_LOG_PAGE_MAGIC;
+    p_log->page_header[1] = p_log->page_seq + 1;
+    p_log->op             = FLASH_LOG_OP_PAGE_HEADER;
+
+    return nrf_fstorage_write(p_log->p_fs,
+                              p_log->p_fs->start_addr + (uint32_t)page * p_log->page_size,
+                              p_log->page_header,
+                              sizeof(p_log->page_header),
+                              NULL);
+}
+
+
+static void mark_write_start(flash_log_t * p_log)
+{
+    p_log->op = FLASH_LOG_OP_MARK;
+
+    if (nrf_fstorage_write(p_log->p_fs, p_log->mark_addr + OFFSET_MARK, &m_mark_cleared, sizeof(m_mark_cleared), NULL)
+        != NRF_SUCCESS)
+    {
+        // The fstorage queue is shared, the mark is tried again by flash_log_ack,
+        // flash_log_retry and the end of the next operation of the log.
+        p_log->op = FLASH_LOG_OP_IDLE;
+        return;
+    }
+
+    p_log->is_mark_due = false;
+    p_log->unmarked    = 0;
+}
+
+
+ret_code_t flash_log_init(flash_log_t * p_log, nrf_fstorage_t const * p_fs, flash_log_evt_handler_t evt_handler)
+{
+    bool     is_found  = false;
+    bool     is_marked = false;
+    uint32_t seq;
+
+    if ((p_log == NULL) || (p_fs == NULL) || (p_fs->p_flash_info == NULL))
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    memset(p_log, 0, sizeof(flash_log_t));
+
+    p_log->p_fs        = p_fs;
+    p_log->evt_handler = evt_handler;
+    p_log->page_size   = p_fs->p_flash_info->erase_unit;
+    p_log->page_count  = (uint16_t)((p_fs->end_addr - p_fs->start_addr) / p_log->page_size);
+
+    if ((p_log->page_count < 2) || (p_log->page_count > FLASH_LOG_PAGES_MAX))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    // The head is in the page opened last.
+    for (uint16_t page = 0; page < p_log->page_count; page++)
+    {
+        if (page_header_read(p_log, page, &seq) && (!is_found || ((int32_t)(seq - p_log->page_seq) > 0)))
+        {
+            is_found          = true;
+            p_log->page_seq   = seq;
+            p_log->head.page  = page;
+        }
+    }
+
+    p_log->head.offset = FLASH_LOG_PAGE_HEADER_LEN;
+
+    if (!is_found)
+    {
+        p_log->sent      = p_log->head;
+        p_log->delivered = p_log->head;
+        return NRF_SUCCESS;
+    }
+
+    p_log->is_page_open = true;
+
+    for (uint16_t length = record_length_read(p_log, p_log->head);
+         length != 0;
+         length = record_length_read(p_log, p_log->head))
+    {
+        p_log->head.offset += record_size(length);
+    }
+
+    if (!page_rest_is_free(p_log))
+    {
+        // Something other than free space follows, e.g. a record cut short, nothing more goes
+        // into this page.
+        p_log->head.offset = (uint16_t)p_log->page_size;
+    }
+
+    // Pages are read from the newest back to the one with the last marked record, the delivery
+    // cursor follows that record. Only the records not yet delivered, and those of the page of the
+    // mark, are read.
+    for (uint16_t i = p_log->page_count; i > 0; i--)
+    {
+        uint16_t page = page_in_order(p_log, i - 1);
+        uint16_t marked;
+        uint32_t after;
+        uint32_t timestamp;
+
+        if (!page_marks_read(p_log, page, &marked, &after, &timestamp))
+        {
+            continue;
+        }
+
+        if (!p_log->has_records)
+        {
+            p_log->has_records    = true;
+            p_log->last_timestamp = timestamp;
+        }
+
+        p_log->undelivered += after;
+
+        if (marked != 0)
+        {
+            is_marked               = true;
+            p_log->delivered.page   = page;
+            p_log->delivered.offset = marked;
+            break;
+        }
+    }
+
+    if (!is_marked)
+    {
+        p_log->delivered = page_start(p_log, page_in_order(p_log, 0));
+    }
+    pos_normalize(p_log, &p_log->delivered);
+
+    p_log->sent   = p_log->delivered;
+    p_log->unsent = p_log->undelivered;
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t flash_log_append(flash_log_t * p_log, uint8_t const * p_data, uint16_t length, uint32_t timestamp)
+{
+    uint8_t  * p_record = (uint8_t *)p_log->buffer;
+    ret_code_t err_code;
+    bool       is_page_needed;
+
+    if ((length == 0) || (length > FLASH_LOG_RECORD_MAX_LEN))
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    if (p_log->op != FLASH_LOG_OP_IDLE)
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    is_page_needed = !p_log->is_page_open ||
+                     ((uint32_t)p_log->head.offset + record_size(length) > p_log->page_size);
+
+    if (is_page_needed && page_is_pinned(p_log, page_to_open(p_log)))
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    p_log->record_len = record_size(length);
+
+    memset(p_record, 0xFF, p_log->record_len);
+    p_record[OFFSET_LENGTH]         = (uint8_t)length;
+    p_record[OFFSET_LENGTH + 1]     = (uint8_t)(length >> 8);
+    p_record[OFFSET_LENGTH_INV]     = (uint8_t)~length;
+    p_record[OFFSET_LENGTH_INV + 1] = (uint8_t)(~length >> 8);
+
+    if (p_log->has_records && ((int32_t)(timestamp - p_log->last_timestamp) < 0))
+    {
+        timestamp = p_log->last_timestamp;
+    }
+    memcpy(&p_record[OFFSET_TIMESTAMP], &timestamp, sizeof(timestamp));
+    memcpy(&p_record[FLASH_LOG_RECORD_HEADER_LEN], p_data, length);
+
+    if (is_page_needed)
+    {
+        err_code = page_open_start(p_log);
+    }
+    else
+    {
+        err_code = record_write_start(p_log);
+    }
+
+    if (err_code != NRF_SUCCESS)
+    {
+        p_log->op = FLASH_LOG_OP_IDLE;
+    }
+
+    return err_code;
+}
+
+
+ret_code_t flash_log_peek(flash_log_t * p_log, uint8_t * p_buf, uint16_t buf_len, uint16_t * p_length)
+{
+    uint16_t length;
+
+    if (p_log->unsent == 0)
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    length = record_length_read(p_log, p_log->sent);
+    if (length > buf_len)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    (void)nrf_fstorage_read(p_log->p_fs, pos_addr(p_log, p_log->sent) + FLASH_LOG_RECORD_HEADER_LEN, p_buf, length);
+    *p_length = length;
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t flash_log_peek_mapped(flash_log_t * p_log, uint8_t const ** pp_data, uint16_t * p_length)
+{
+    uint8_t const * p_data;
+
+    if (p_log->unsent == 0)
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    p_data = nrf_fstorage_rmap(p_log->p_fs, pos_addr(p_log, p_log->sent) + FLASH_LOG_RECORD_HEADER_LEN);
+    if (p_data == NULL)
+    {
+        return NRF_ERROR_NOT_SUPPORTED;
+    }
+
+    *pp_data  = p_data;
+    *p_length = record_length_read(p_log, p_log->sent);
+
+    return NRF_SUCCESS;
+}
+
+
+void flash_log_release(flash_log_t * p_log)
+{
+    if (p_log->unsent == 0)
+    {
+        return;
+    }
+
+    pos_advance(p_log, &p_log->sent);
+    p_log->unsent--;
+}
+
+
+void flash_log_ack(flash_log_t * p_log, uint32_t count)
+{
+    while ((count > 0) && (p_log->undelivered > p_log->unsent))
+    {
+        p_log->mark_addr = pos_addr(p_log, p_log->delivered);
+        pos_advance(p_log, &p_log->delivered);
+        p_log->undelivered--;
+        p_log->unmarked++;
+        count--;
+    }
+
+    if ((p_log->unmarked >= FLASH_LOG_CHECKPOINT_INTERVAL) || ((p_log->undelivered == 0) && (p_log->unmarked > 0)))
+    {
+        p_log->unmarked    = 0;
+        p_log->is_mark_due = true;
+    }
+
+    flash_log_retry(p_log);
+}
+
+
+void flash_log_retry(flash_log_t * p_log)
+{
+    if (p_log->is_mark_due && (p_log->op == FLASH_LOG_OP_IDLE))
+    {
+        mark_write_start(p_log);
+    }
+}
+
+
+void flash_log_rewind(flash_log_t * p_log)
+{
+    p_log->sent   = p_log->delivered;
+    p_log->unsent = p_log->undelivered;
+}
+
+
+ret_code_t flash_log_seek(flash_log_t * p_log, uint32_t timestamp)
+{
+    flash_log_pos_t pos;
+    uint32_t        base;
+    uint32_t        target;
+    uint16_t        low;
+    uint16_t        high  = p_log->page_count;
+    uint32_t        count = 0;
+
+    if (p_log->undelivered > p_log->unsent)
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    // The oldest page may be being erased, its records are already given up.
+    low = (p_log->is_page_open && ((p_log->op == FLASH_LOG_OP_ERASE) || (p_log->op == FLASH_LOG_OP_PAGE_HEADER))) ? 1 : 0;
+
+    if (!p_log->is_index_built)
+    {
+        index_build(p_log);
+    }
+
+    // Timestamps are compared as offsets from the oldest page, so they may wrap.
+    base   = p_log->index[page_in_order(p_log, low)];
+    target = timestamp - base;
+    if ((int32_t)target < 0)
+    {
+        target = 0;
+    }
+
+    // Last page whose first record is before the target, the first record since it may be there.
+    while (high - low > 1)
+    {
+        uint16_t mid = (uint16_t)((low + high) / 2);
+
+        if (p_log->index[page_in_order(p_log, mid)] - base < target)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    pos = page_start(p_log, page_in_order(p_log, low));
+    pos_normalize(p_log, &pos);
+
+    while (!pos_equal(pos, p_log->head) && (record_timestamp_read(p_log, pos) - base < target))
+    {
+        pos_advance(p_log, &pos);
+    }
+
+    p_log->sent      = pos;
+    p_log->delivered = pos;
+
+    while (!pos_equal(pos, p_log->head))
+    {
+        pos_advance(p_log, &pos);
+        count++;
+    }
+
+    p_log->unsent      = count;
+    p_log->undelivered = count;
+
+    return NRF_SUCCESS;
+}
+
+
+bool flash_log_last_timestamp_get(flash_log_t const * p_log, uint32_t * p_timestamp)
+{
+    *p_timestamp = p_log->last_timestamp;
+
+    return p_log->has_records;
+}
+
+
+uint32_t flash_log_unsent_count(flash_log_t const * p_log)
+{
+    return p_log->unsent;
+}
+
+
+bool flash_log_is_drained(flash_log_t const * p_log)
+{
+    return (p_log->unsent == 0) &&
+           (p_log->op != FLASH_LOG_OP_ERASE) &&
+           (p_log->op != FLASH_LOG_OP_PAGE_HEADER) &&
+           (p_log->op != FLASH_LOG_OP_RECORD) &&
+           (p_log->op != FLASH_LOG_OP_RECORD_LENGTH);
+}
+
+
+void flash_log_on_fs_evt(flash_log_t * p_log, nrf_fstorage_evt_t const * p_evt)
+{
+    flash_log_op_t op = p_log->op;
+
+    if ((p_evt->id == NRF_FSTORAGE_EVT_READ_RESULT) || (op == FLASH_LOG_OP_IDLE))
+    {
+        return;
+    }
+
+    p_log->op = FLASH_LOG_OP_IDLE;
+
+    if (p_evt->result != NRF_SUCCESS)
+    {
+        // The record is dropped, a page is opened again by the next record. Part of a record may
+        // have been written, so its page takes no more.
+        if ((op == FLASH_LOG_OP_RECORD) || (op == FLASH_LOG_OP_RECORD_LENGTH))
+        {
+            p_log->head.offset = (uint16_t)p_log->page_size;
+        }
+        evt_send(p_log, FLASH_LOG_EVT_ERROR, p_evt->result);
+        return;
+    }
+
+    switch (op)
+    {
+        case FLASH_LOG_OP_ERASE:
+            if (page_header_write_start(p_log) != NRF_SUCCESS)
+            {
+                p_log->op = FLASH_LOG_OP_IDLE;
+                evt_send(p_log, FLASH_LOG_EVT_ERROR, NRF_ERROR_BUSY);
+            }
+            return;
+
+        case FLASH_LOG_OP_PAGE_HEADER:
+            p_log->head.page    = page_to_open(p_log);
+            p_log->head.offset  = FLASH_LOG_PAGE_HEADER_LEN;
+            p_log->is_page_open = true;
+            p_log->page_seq++;
+
+            // The newest page has no records yet.
+            p_log->index[p_log->head.page] = p_log->last_timestamp;
+
+            // Cursors that had caught up with the head stay with it.
+            if (p_log->unsent == 0)
+            {
+                p_log->sent = p_log->head;
+            }
+            if (p_log->undelivered == 0)
+            {
+                p_log->delivered = p_log->head;
+            }
+
+            if (record_write_start(p_log) != NRF_SUCCESS)
+            {
+                p_log->op = FLASH_LOG_OP_IDLE;
+                evt_send(p_log, FLASH_LOG_EVT_ERROR, NRF_ERROR_BUSY);
+            }
+            return;
+
+        case FLASH_LOG_OP_RECORD:
+            if (record_length_write_start(p_log) != NRF_SUCCESS)
+            {
+                p_log->op          = FLASH_LOG_OP_IDLE;
+                p_log->head.offset = (uint16_t)p_log->page_size;
+                evt_send(p_log, FLASH_LOG_EVT_ERROR, NRF_ERROR_BUSY);
+            }
+            return;
+
+        case FLASH_LOG_OP_RECORD_LENGTH:
+            memcpy(&p_log->last_timestamp,
+                   (uint8_t const *)p_log->buffer + OFFSET_TIMESTAMP,
+                   sizeof(p_log->last_timestamp));
+            p_log->has_records = true;
+
+            if (p_log->head.offset == FLASH_LOG_PAGE_HEADER_LEN)
+            {
+                p_log->index[p_log->head.page] = p_log->last_timestamp;
+            }
+
+            p_log->head.offset += p_log->record_len;
+            p_log->unsent++;
+            p_log->undelivered++;
+            break;
+
+        default:
+            break;
+    }
+
+    if (p_log->is_mark_due)
+    {
+        mark_write_start(p_log);
+    }
+
+    if (p_log->op == FLASH_LOG_OP_IDLE)
+    {
+        evt_send(p_log, FLASH_LOG_EVT_READY, NRF_SUCCESS);
+    }
+}
@@ -0,0 +1,312 @@
+#ifndef __FLASH_LOG_H
+#define __FLASH_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "nrf_fstorage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Longest record (in bytes). */
+#ifndef FLASH_LOG_RECORD_MAX_LEN
+#define FLASH_LOG_RECORD_MAX_LEN        256
+#endif
+
+/**@brief   Records delivered between two writes of the drain cursor. */
+#ifndef FLASH_LOG_CHECKPOINT_INTERVAL
+#define FLASH_LOG_CHECKPOINT_INTERVAL   16
+#endif
+
+/**@brief   Pages the time index has room for, the region of a log may not hold more. */
+#ifndef FLASH_LOG_PAGES_MAX
+#define FLASH_LOG_PAGES_MAX             32
+#endif
+
+/**@brief   Flash layout.
+ *
+ * The log is a ring of flash pages, written in order and erased just before they are written
+ * again. Every page starts with a header, followed by records. All fields are little endian words
+ * or half words:
+ *
+ * | Offset | Size | Page header                                                  |
+ * |--------|------|--------------------------------------------------------------|
+ * | 0      | 4    | @ref FLASH_LOG_PAGE_MAGIC                                    |
+ * | 4      | 4    | Page sequence number, one more than the page before          |
+ *
+ * | Offset | Size | Record                                                       |
+ * |--------|------|--------------------------------------------------------------|
+ * | 0      | 2    | Length of the data (in bytes), 0xFFFF where no record is yet |
+ * | 2      | 2    | Length inverted, a record whose header was cut short is void |
+ * | 4      | 4    | Drain mark, 0xFFFFFFFF, cleared once the record was delivered|
+ * | 8      | 4    | Timestamp, never less than the one of the record before      |
+ * | 12     | n    | Data, padded with 0xFF to a word                             |
+ *
+ * A record is written in two steps, the header words from the drain mark on and the data first,
+ * the length last. A record cut short by a reset has no valid length and is never read, and
+ * nothing more goes into its page, as it is no longer free space.
+ *
+ * A page holding records sent but not yet delivered is pinned: it is not erased until those records
+ * have been acknowledged with @ref flash_log_ack or given back with @ref flash_log_rewind. Records
+ * can therefore be sent straight from flash, see @ref flash_log_peek_mapped. A record added while
+ * the oldest page is pinned waits, rather than dropping records the link may still need.
+ *
+ * Pages are reused in ring order, so every page is erased as often as the others.
+ *
+ * The log keeps the timestamp of the first record of every page in RAM. As timestamps never go
+ * back, the page that holds the first record since a time is found by a binary search over the
+ * pages, see @ref flash_log_seek. The index is built the first time it is needed, from one read
+ * per page, and kept up to date as pages are opened.
+ *
+ * The drain cursor is kept in flash by clearing the mark of the last delivered record, which
+ * flash allows without an erase. Every @ref FLASH_LOG_CHECKPOINT_INTERVAL records, and whenever
+ * the log has been delivered up to the last record, the mark is written. After a reset the log
+ * resumes after the last marked record, so at most that many records are sent twice.
+ */
+#define FLASH_LOG_PAGE_MAGIC            0x32474C46UL    /**< "FLG2". */
+#define FLASH_LOG_PAGE_HEADER_LEN       8
+#define FLASH_LOG_RECORD_HEADER_LEN     12
+
+
+/**@brief   Flash log event types. */
+typedef enum
+{
+    FLASH_LOG_EVT_READY,        /**< The flash operation in progress has ended, another record may be added. */
+    FLASH_LOG_EVT_ERROR,        /**< A flash operation failed. A record being added is lost. */
+} flash_log_evt_type_t;
+
+
+/**@brief   Flash log event structure. */
+typedef struct
+{
+    flash_log_evt_type_t type;      /**< Event type. */
+    ret_code_t           result;    /**< Result of the failed operation, NRF_SUCCESS otherwise. */
+} flash_log_evt_t;
+
+
+/**@brief   Flash log event handler type. */
+typedef void (* flash_log_evt_handler_t)(flash_log_evt_t const * p_evt);
+
+
+/**@brief   Position in the log. */
+typedef struct
+{
+    uint16_t page;      /**< Index of the page in the region. */
+    uint16_t offset;    /**< Offset in the page (in bytes). */
+} flash_log_pos_t;
+
+
+/**@brief   Flash operation of a log in progress. */
+typedef enum
+{
+    FLASH_LOG_OP_IDLE,
+    FLASH_LOG_OP_ERASE,             /**< Erasing the page the next record opens. */
+    FLASH_LOG_OP_PAGE_HEADER,       /**< Writing the header of the page the next record opens. */
+    FLASH_LOG_OP_RECORD,            /**< Writing a record, all but its length. */
+    FLASH_LOG_OP_RECORD_LENGTH,     /**< Writing the length of a record, which makes it valid. */
+    FLASH_LOG_OP_MARK,              /**< Clearing the drain mark of a record. */
+} flash_log_op_t;
+
+
+/**@brief   Flash log structure.
+ *
+ * @details The records not yet delivered lie from the delivery cursor to the head, those not yet
+ *          handed to the link from the send cursor to the head. Only the delivery cursor is kept
+ *          in flash. A record that has not been delivered when its page is needed again is lost.
+ *
+ *          The log only uses the nrf_fstorage API, on target with the SoftDevice backend and on
+ *          a host with a RAM backed fake of it.
+ */
+typedef struct
+{
+    nrf_fstorage_t const  * p_fs;           /**< Region of the log, two pages at least. */
+    flash_log_evt_handler_t evt_handler;
+    uint32_t                page_size;      /**< Erase unit of the flash (in bytes). */
+    uint16_t                page_count;     /**< Pages in the region. */
+    bool                    is_page_open;   /**< The head is in a page with a header. */
+    uint32_t                page_seq;       /**< Sequence number of the page of the head. */
+    flash_log_pos_t         head;           /**< Where the next record goes. */
+    flash_log_pos_t         sent;           /**< Next record to send. */
+    flash_log_pos_t         delivered;      /**< First record not yet delivered. */
+    uint32_t                unsent;         /**< Records from the send cursor to the head. */
+    uint32_t                undelivered;    /**< Records from the delivery cursor to the head. */
+    uint32_t                unmarked;       /**< Records delivered since the drain mark was last written. */
+    bool                    is_mark_due;    /**< The mark of @p mark_addr waits for the flash to be free. */
+    uint32_t                mark_addr;      /**< Last record delivered, its mark is written next. */
+    uint32_t                lost;           /**< Records lost to a page needed again before they were delivered. */
+    bool                    has_records;    /**< A record has been added, @p last_timestamp is valid. */
+    uint32_t                last_timestamp; /**< Timestamp of the newest record. */
+    bool                    is_index_built; /**< @p index is valid. */
+    uint32_t                index[FLASH_LOG_PAGES_MAX];  /**< Timestamp of the first record of every page. A page
+                                                              without records has the one of the next page that
+                                                              has, or @p last_timestamp. */
+    flash_log_op_t          op;             /**< Flash operation in progress. */
+    uint16_t                record_len;     /**< Length of the record being added, header and padding included (in bytes). */
+    uint32_t                page_header[FLASH_LOG_PAGE_HEADER_LEN / 4];  /**< Header of the page being opened. */
+    uint32_t                buffer[(FLASH_LOG_RECORD_HEADER_LEN + FLASH_LOG_RECORD_MAX_LEN + 3) / 4];  /**< Record being added, flash writes are word aligned. */
+} flash_log_t;
+
+
+/**@brief   Function for opening the log of a region.
+ *
+ * @details Scans the region for the head and the delivery cursor, every record is read once.
+ *
+ * @param[out] p_log        Flash log.
+ * @param[in]  p_fs         Initialized fstorage instance of the region. Its event handler must
+ *                          pass every event to @ref flash_log_on_fs_evt.
+ * @param[in]  evt_handler  Event handler.
+ *
+ * @retval NRF_SUCCESS              If the log was opened.
+ * @retval NRF_ERROR_NULL           If a parameter was NULL.
+ * @retval NRF_ERROR_INVALID_PARAM  If the region holds less than two pages, or more than
+ *                                  @ref FLASH_LOG_PAGES_MAX.
+ */
+ret_code_t flash_log_init(flash_log_t * p_log, nrf_fstorage_t const * p_fs, flash_log_evt_handler_t evt_handler);
+
+
+/**@brief   Function for adding a record at the head of the log.
+ *
+ * @details The record is copied, so @p p_data may be reused at once. If the head page is full,
+ *          the oldest page is erased and opened first. @ref FLASH_LOG_EVT_READY follows once the
+ *          record is in flash.
+ *
+ * @param[in] p_log      Flash log.
+ * @param[in] p_data     Record data.
+ * @param[in] length     Length of @p p_data (in bytes).
+ * @param[in] timestamp  Time of the record, in any unit. A timestamp before the one of the newest
+ *                       record is stored as that one. Timestamps may wrap, but the records of the
+ *                       log must span less than half their range.
+ *
+ * @retval NRF_SUCCESS               If the record is being written.
+ * @retval NRF_ERROR_BUSY            If a flash operation is in progress, try again on
+ *                                   @ref FLASH_LOG_EVT_READY. Also if the page to erase is pinned,
+ *                                   try again after @ref flash_log_ack or @ref flash_log_rewind.
+ * @retval NRF_ERROR_INVALID_LENGTH  If @p length is 0 or more than @ref FLASH_LOG_RECORD_MAX_LEN.
+ * @return  Any error of nrf_fstorage_write or nrf_fstorage_erase otherwise, e.g. NRF_ERROR_NO_MEM
+ *          if the fstorage queue is full.
+ */
+ret_code_t flash_log_append(flash_log_t * p_log, uint8_t const * p_data, uint16_t length, uint32_t timestamp);
+
+
+/**@brief   Function for reading the record at the send cursor, without moving it.
+ *
+ * @param[in]  p_log     Flash log.
+ * @param[out] p_buf     Record data.
+ * @param[in]  buf_len   Size of @p p_buf (in bytes).
+ * @param[out] p_length  Length of the record (in bytes).
+ *
+ * @retval NRF_SUCCESS         If a record was read.
+ * @retval NRF_ERROR_NOT_FOUND If every record has been sent.
+ * @retval NRF_ERROR_NO_MEM    If the record does not fit @p p_buf.
+ */
+ret_code_t flash_log_peek(flash_log_t * p_log, uint8_t * p_buf, uint16_t buf_len, uint16_t * p_length);
+
+
+/**@brief   Function for getting the record at the send cursor in place, without moving the cursor.
+ *
+ * @details The record data is returned as a pointer into memory mapped flash, so it can be handed
+ *          to the link without a copy in RAM. The record header stays in flash, only the data the
+ *          record was added with is returned.
+ *
+ *          Ownership: the pointer stays valid until @ref flash_log_ack covers the record, or until
+ *          @ref flash_log_rewind, as the page is pinned while the record is in flight. Before
+ *          @ref flash_log_release it is valid until the next call to the log only.
+ *
+ * @param[in]  p_log     Flash log.
+ * @param[out] pp_data   Record data, in flash.
+ * @param[out] p_length  Length of the record (in bytes).
+ *
+ * @retval NRF_SUCCESS               If a record was found.
+ * @retval NRF_ERROR_NOT_FOUND       If every record has been sent.
+ * @retval NRF_ERROR_NOT_SUPPORTED   If the fstorage backend cannot map flash for reading.
+ */
+ret_code_t flash_log_peek_mapped(flash_log_t * p_log, uint8_t const ** pp_data, uint16_t * p_length);
+
+
+/**@brief   Function for moving the send cursor past the record read by @ref flash_log_peek or
+ *          @ref flash_log_peek_mapped.
+ */
+void flash_log_release(flash_log_t * p_log);
+
+
+/**@brief   Function for moving the delivery cursor past records the link has delivered.
+ *
+ * @details The drain mark is written every @ref FLASH_LOG_CHECKPOINT_INTERVAL records, and when
+ *          the log has been delivered up to the head. A mark that found the fstorage queue full
+ *          is tried again, for the last record delivered.
+ *
+ * @param[in] p_log  Flash log.
+ * @param[in] count  Records delivered, in the order they were sent. Capped at the records sent.
+ */
+void flash_log_ack(flash_log_t * p_log, uint32_t count);
+
+
+/**@brief   Function for writing a drain mark that found the fstorage queue full.
+ *
+ * @details The queue is shared by every fstorage user, call this once an operation of any of them
+ *          has ended. Does nothing if no mark is pending or an operation of the log is in progress.
+ */
+void flash_log_retry(flash_log_t * p_log);
+
+
+/**@brief   Function for sending every record not yet delivered again, from the delivery cursor.
+ *
+ * @details Called when the link is lost with records in flight. Pointers to those records, given
+ *          by @ref flash_log_peek_mapped, are no longer valid.
+ */
+void flash_log_rewind(flash_log_t * p_log);
+
+
+/**@brief   Function for sending every record since a time again.
+ *
+ * @details Moves the send and delivery cursors back, or forward, to the first record in flash
+ *          whose timestamp is not before @p timestamp, or to the oldest record if there is none
+ *          before it. The page is found with the time index, in O(log pages) steps, then the
+ *          records from it to the head are read once to count them. The drain mark in flash is
+ *          not moved back, so after a reset the log resumes after the last marked record.
+ *
+ * @param[in] p_log      Flash log.
+ * @param[in] timestamp  Time of the first record to send.
+ *
+ * @retval NRF_SUCCESS     If the cursors were moved.
+ * @retval NRF_ERROR_BUSY  If records are in flight, try again once they were acknowledged or
+ *                         after @ref flash_log_rewind.
+ */
+ret_code_t flash_log_seek(flash_log_t * p_log, uint32_t timestamp);
+
+
+/**@brief   Function for getting the timestamp of the newest record.
+ *
+ * @param[in]  p_log         Flash log.
+ * @param[out] p_timestamp   Timestamp.
+ *
+ * @retval true   If the log holds a record.
+ * @retval false  If no record has been added yet.
+ */
+bool flash_log_last_timestamp_get(flash_log_t const * p_log, uint32_t * p_timestamp);
+
+
+/**@brief   Function for getting the number of records not yet sent.
+ */
+uint32_t flash_log_unsent_count(flash_log_t const * p_log);
+
+
+/**@brief   Function for checking whether every record added has been sent.
+ *
+ * @details Unlike @ref flash_log_unsent_count, a record still being written counts as not sent.
+ *          Data that must stay in order with the log may bypass it only once this is true.
+ */
+bool flash_log_is_drained(flash_log_t const * p_log);
+
+
+/**@brief   Function for handling the events of the fstorage instance of the log.
+ */
+void flash_log_on_fs_evt(flash_log_t * p_log, nrf_fstorage_evt_t const * p_evt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __FLASH_LOG_H
@@ -0,0 +1,28 @@
+#ifndef __FRAME_CRC_H
+#define __FRAME_CRC_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Function for computing a CRC32, or continuing one over more data.
+ *
+ * @details Same CRC as crc32_compute of the SDK (IEEE 802.3, reflected, as in zlib), but table
+ *          driven: one table lookup per byte instead of eight shift and XOR steps, and the data
+ *          is read a word at a time. The table takes 1 kB of flash.
+ *
+ * @param[in] p_data  Data.
+ * @param[in] size    Length of @p p_data (in bytes).
+ * @param[in] p_crc   CRC of the data before, NULL to start a new CRC.
+ *
+ * @return  CRC32 of all the data so far.
+ */
+uint32_t frame_crc32_compute(uint8_t const * p_data, uint32_t size, uint32_t const * p_crc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __FRAME_CRC_H
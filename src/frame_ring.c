@@ -0,0 +1,119 @@
+#include <stddef.h>
+#include "frame_ring.h"
+#include "nrf_error.h"
+
+
+void frame_ring_init(frame_ring_t const * p_ring)
+{
+    nrf_ringbuf_init(p_ring->p_ringbuf);
+    p_ring->p_cb->p_reserved = NULL;
+}
+
+
+ret_code_t frame_ring_reserve(frame_ring_t const * p_ring, uint8_t ** pp_data, uint16_t * p_max_len)
+{
+    ret_code_t err_code;
+    uint8_t  * p_slot;
+    size_t     length = p_ring->slot_size;
+
+    err_code = nrf_ringbuf_alloc(p_ring->p_ringbuf, &p_slot, &length, true);
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
+    if (length < p_ring->slot_size)
+    {
+        // Free space comes in whole slots, anything less is a full ring.
+        if (length > 0)
+        {
+            (void)nrf_ringbuf_put(p_ring->p_ringbuf, 0);
+        }
+        return NRF_ERROR_NO_MEM;
+    }
+
+    p_ring->p_cb->p_reserved = p_slot;
+
+    *pp_data   = p_slot + FRAME_RING_LENGTH_LEN;
+    *p_max_len = p_ring->slot_size - FRAME_RING_LENGTH_LEN;
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t frame_ring_commit(frame_ring_t const * p_ring, uint16_t length)
+{
+    uint8_t * p_slot = p_ring->p_cb->p_reserved;
+
+    if (p_slot == NULL)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    if (length > p_ring->slot_size - FRAME_RING_LENGTH_LEN)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    p_ring->p_cb->p_reserved = NULL;
+
+    if (length == 0)
+    {
+        return nrf_ringbuf_put(p_ring->p_ringbuf, 0);
+    }
+
+    p_slot[0] = (uint8_t)(length);
+    p_slot[1] = (uint8_t)(length >> 8);
+
+    return nrf_ringbuf_put(p_ring->p_ringbuf, p_ring->slot_size);
+}
+
+
+ret_code_t frame_ring_peek(frame_ring_t const * p_ring, uint8_t const ** pp_data, uint16_t * p_length)
+{
+    ret_code_t err_code;
+    uint8_t  * p_slot;
+    size_t     length = p_ring->slot_size;
+
+    err_code = nrf_ringbuf_get(p_ring->p_ringbuf, &p_slot, &length, true);
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
+    if (length < p_ring->slot_size)
+    {
+        // Frames are committed in whole slots, anything less is an empty ring.
+        if (length > 0)
+        {
+            (void)nrf_ringbuf_free(p_ring->p_ringbuf, 0);
+        }
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    *pp_data  = p_slot + FRAME_RING_LENGTH_LEN;
+    *p_length = (uint16_t)(p_slot[0] | (p_slot[1] << 8));
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t frame_ring_release(frame_ring_t const * p_ring)
+{
+    return nrf_ringbuf_free(p_ring->p_ringbuf, p_ring->slot_size);
+}
+
+
+ret_code_t frame_ring_peek_cancel(frame_ring_t const * p_ring)
+{
+    return nrf_ringbuf_free(p_ring->p_ringbuf, 0);
+}
+
+
+uint32_t frame_ring_count(frame_ring_t const * p_ring)
+{
+    nrf_ringbuf_cb_t const * p_cb = p_ring->p_ringbuf->p_cb;
+
+    // Both indexes only grow, their difference is what has been committed and not freed.
+    return (p_cb->wr_idx - p_cb->rd_idx) / p_ring->slot_size;
+}
@@ -0,0 +1,133 @@
+#ifndef __FRAME_RING_H
+#define __FRAME_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "nrf_ringbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Bytes in front of every frame that hold its length. */
+#define FRAME_RING_LENGTH_LEN       2
+
+
+/**@brief   Producer state of a frame ring. */
+typedef struct
+{
+    uint8_t * p_reserved;       /**< Slot handed out by @ref frame_ring_reserve, NULL if none. */
+} frame_ring_cb_t;
+
+
+/**@brief   Frame ring structure.
+ *
+ * @details Frames are kept in fixed-size slots of an nrf_ringbuf. The slot size divides the
+ *          buffer size, so a slot never wraps around the end of the buffer and both sides get
+ *          a frame as one contiguous block, with no copy.
+ *
+ *          One producer and one consumer may run in different interrupt contexts without locks:
+ *          nrf_ringbuf keeps separate write and read indexes, and each side only moves its own.
+ */
+typedef struct
+{
+    nrf_ringbuf_t const * p_ringbuf;    /**< Buffer holding the slots. */
+    frame_ring_cb_t     * p_cb;         /**< Producer state. */
+    uint16_t              slot_size;    /**< Size of every slot, length prefix included (in bytes). */
+} frame_ring_t;
+
+
+/**@brief   Macro for defining a frame ring.
+ *
+ * @param _name        Name of the instance.
+ * @param _slot_size   Size of every slot (in bytes), a power of two. Frames are up to
+ *                     @p _slot_size - @ref FRAME_RING_LENGTH_LEN bytes long.
+ * @param _slot_count  Number of slots, a power of two.
+ */
+#define FRAME_RING_DEF(_name, _slot_size, _slot_count)                      \
+    STATIC_ASSERT(IS_POWER_OF_TWO(_slot_size));                             \
+    STATIC_ASSERT(IS_POWER_OF_TWO(_slot_count));                            \
+    NRF_RINGBUF_DEF(CONCAT_2(_name, _ringbuf), (_slot_size) * (_slot_count)); \
+    static frame_ring_cb_t CONCAT_2(_name, _cb);                            \
+    static frame_ring_t const _name =                                       \
+    {                                                                       \
+        .p_ringbuf = &CONCAT_2(_name, _ringbuf),                            \
+        .p_cb      = &CONCAT_2(_name, _cb),                                 \
+        .slot_size = (_slot_size),                                          \
+    }
+
+
+/**@brief   Function for emptying a frame ring.
+ *
+ * @details Neither side may be using the ring while it is initialized.
+ */
+void frame_ring_init(frame_ring_t const * p_ring);
+
+
+/**@brief   Function for reserving a slot to write a frame into.
+ *
+ * @details Producer side. The frame is written in place and made visible to the consumer with
+ *          @ref frame_ring_commit.
+ *
+ * @param[in]  p_ring     Frame ring.
+ * @param[out] pp_data    Start of the frame.
+ * @param[out] p_max_len  Longest frame the slot can hold (in bytes).
+ *
+ * @retval NRF_SUCCESS       If a slot was reserved.
+ * @retval NRF_ERROR_NO_MEM  If the ring is full.
+ * @retval NRF_ERROR_BUSY    If a slot is already reserved.
+ */
+ret_code_t frame_ring_reserve(frame_ring_t const * p_ring, uint8_t ** pp_data, uint16_t * p_max_len);
+
+
+/**@brief   Function for handing the reserved frame to the consumer.
+ *
+ * @param[in] p_ring  Frame ring.
+ * @param[in] length  Length of the frame (in bytes), 0 to give the slot back unused.
+ *
+ * @retval NRF_SUCCESS              If the frame was committed.
+ * @retval NRF_ERROR_INVALID_STATE  If no slot is reserved.
+ * @retval NRF_ERROR_INVALID_LENGTH If @p length does not fit the slot.
+ */
+ret_code_t frame_ring_commit(frame_ring_t const * p_ring, uint16_t length);
+
+
+/**@brief   Function for getting the oldest frame without removing it.
+ *
+ * @details Consumer side. The frame stays valid until @ref frame_ring_release removes it or
+ *          @ref frame_ring_peek_cancel leaves it in the ring for the next peek.
+ *
+ * @param[in]  p_ring    Frame ring.
+ * @param[out] pp_data   Start of the frame.
+ * @param[out] p_length  Length of the frame (in bytes).
+ *
+ * @retval NRF_SUCCESS          If a frame was found.
+ * @retval NRF_ERROR_NOT_FOUND  If the ring is empty.
+ * @retval NRF_ERROR_BUSY       If a frame is already being peeked.
+ */
+ret_code_t frame_ring_peek(frame_ring_t const * p_ring, uint8_t const ** pp_data, uint16_t * p_length);
+
+
+/**@brief   Function for removing the frame returned by @ref frame_ring_peek.
+ */
+ret_code_t frame_ring_release(frame_ring_t const * p_ring);
+
+
+/**@brief   Function for leaving the frame returned by @ref frame_ring_peek in the ring.
+ */
+ret_code_t frame_ring_peek_cancel(frame_ring_t const * p_ring);
+
+
+/**@brief   Function for getting the number of committed frames not yet released.
+ *
+ * @details Safe from either side. The count may be one frame stale if the other side is
+ *          running at a higher priority.
+ */
+uint32_t frame_ring_count(frame_ring_t const * p_ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __FRAME_RING_H
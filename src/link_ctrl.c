@@ -0,0 +1,429 @@
+#include <string.h>
+#include "link_ctrl.h"
+#include "ble_conn_state.h"
+#include "ble_hci.h"
+#include "app_error.h"
+#include "app_timer.h"
+#include "sdk_macros.h"
+
+#include "nrf_log.h"
+
+
+#define HVX_HEADER_LEN      3       /**< ATT opcode and attribute handle of a notification (in bytes). */
+#define L2CAP_HEADER_LEN    4       /**< L2CAP basic header (in bytes). */
+
+/**@brief Link parameter state of one connection. */
+typedef struct
+{
+    uint16_t conn_handle;   /**< Connection handle, BLE_CONN_HANDLE_INVALID if the slot is free. */
+    uint8_t  tx_phy;        /**< Current TX PHY. */
+    uint8_t  rx_phy;        /**< Current RX PHY. */
+    uint16_t att_mtu;       /**< Effective ATT MTU. */
+    uint16_t data_length;   /**< LL data length. */
+    bool     phy_settled;   /**< The PHY procedure started on connect has ended. */
+    bool     mtu_settled;   /**< The ATT MTU exchange has ended. */
+    bool     dl_settled;    /**< The data length update has ended. */
+    uint8_t  answered;      /**< LINK_CTRL_ANSWERED_* bits of the procedures that have ended. */
+    bool     is_ready;      /**< @ref LINK_CTRL_EVT_READY has been reported. */
+} link_ctrl_link_t;
+
+
+static link_ctrl_evt_handler_t m_evt_handler;                              /**< Application event handler. */
+static nrf_ble_gatt_t        * m_p_gatt;                                   /**< GATT module instance. */
+static link_ctrl_link_t        m_links[NRF_SDH_BLE_TOTAL_LINK_COUNT];      /**< State of every link, indexed by ble_conn_state_conn_idx(). */
+
+APP_TIMER_DEF(m_settle_timer_id);                                          /**< Link settle timeout timer. */
+
+NRF_SDH_BLE_OBSERVER(m_link_ctrl_obs, LINK_CTRL_BLE_OBSERVER_PRIO, link_ctrl_on_ble_evt, NULL);
+
+
+/**@brief Function for getting the state of a link.
+ *
+ * @return  Link state, or NULL if the handle is not a current connection.
+ */
+static link_ctrl_link_t * link_get(uint16_t conn_handle)
+{
+    uint16_t idx = ble_conn_state_conn_idx(conn_handle);
+
+    return (idx < NRF_SDH_BLE_TOTAL_LINK_COUNT) ? &m_links[idx] : NULL;
+}
+
+
+static void evt_send(link_ctrl_evt_type_t type, uint16_t conn_handle)
+{
+    link_ctrl_evt_t evt;
+
+    if (m_evt_handler == NULL)
+    {
+        return;
+    }
+
+    memset(&evt, 0, sizeof(evt));
+    evt.type        = type;
+    evt.conn_handle = conn_handle;
+
+    m_evt_handler(&evt);
+}
+
+
+/**@brief Function for reporting a link as ready once every procedure has settled.
+ */
+static void ready_check(link_ctrl_link_t * p_link, uint16_t conn_handle)
+{
+    uint16_t hvx_len;
+    uint16_t pdu_count;
+
+    if (p_link->is_ready || !p_link->phy_settled || !p_link->mtu_settled || !p_link->dl_settled)
+    {
+        return;
+    }
+
+    p_link->is_ready = true;
+
+    // A notification is an L2CAP PDU of ATT MTU + 4 bytes, split over LL PDUs of data_length bytes.
+    hvx_len   = p_link->att_mtu - HVX_HEADER_LEN;
+    pdu_count = (p_link->att_mtu + L2CAP_HEADER_LEN + p_link->data_length - 1) / p_link->data_length;
+
+    NRF_LOG_INFO("Link 0x%x ready: %s PHY, ATT MTU %d, data length %d.", conn_handle,
+                 (p_link->tx_phy == BLE_GAP_PHY_2MBPS) ? "2M" : "1M",
+                 p_link->att_mtu, p_link->data_length);
+    NRF_LOG_INFO("%d byte notifications in %d LL PDU(s).", hvx_len, pdu_count);
+
+    if (p_link->data_length <= BLE_GAP_DATA_LENGTH_DEFAULT)
+    {
+        NRF_LOG_WARNING("Data length extension not in use, throughput is limited to 27 byte PDUs.");
+    }
+
+    evt_send(LINK_CTRL_EVT_READY, conn_handle);
+}
+
+
+/**@brief Function for declaring links ready with whatever has been negotiated so far.
+ *
+ * @details Some centrals never answer the data length or PHY procedure. Waiting for them forever
+ *          would block every transfer, so the current values are taken once the timeout expires.
+ */
+static void settle_timeout_handler(void * p_context)
+{
+    for (uint16_t idx = 0; idx < NRF_SDH_BLE_TOTAL_LINK_COUNT; idx++)
+    {
+        link_ctrl_link_t * p_link      = &m_links[idx];
+        uint16_t           conn_handle = p_link->conn_handle;
+        uint8_t            data_length;
+
+        if ((conn_handle == BLE_CONN_HANDLE_INVALID) || p_link->is_ready)
+        {
+            continue;
+        }
+
+        NRF_LOG_WARNING("Link 0x%x did not settle: PHY %d, MTU %d, DL %d.", conn_handle,
+                        p_link->phy_settled, p_link->mtu_settled, p_link->dl_settled);
+
+        p_link->att_mtu = nrf_ble_gatt_eff_mtu_get(m_p_gatt, conn_handle);
+        if (nrf_ble_gatt_data_length_get(m_p_gatt, conn_handle, &data_length) == NRF_SUCCESS)
+        {
+            p_link->data_length = data_length;
+        }
+
+        p_link->phy_settled = true;
+        p_link->mtu_settled = true;
+        p_link->dl_settled  = true;
+
+        ready_check(p_link, conn_handle);
+    }
+}
+
+
+static void on_connect(ble_evt_t const * p_ble_evt)
+{
+    ret_code_t         err_code;
+    uint16_t           conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+    link_ctrl_link_t * p_link      = link_get(conn_handle);
+    ble_gap_phys_t const phys =
+    {
+        .rx_phys = LINK_CTRL_PREFERRED_PHYS,
+        .tx_phys = LINK_CTRL_PREFERRED_PHYS,
+    };
+
+    if (p_link == NULL)
+    {
+        return;
+    }
+
+    memset(p_link, 0, sizeof(link_ctrl_link_t));
+    p_link->conn_handle = conn_handle;
+    p_link->tx_phy      = BLE_GAP_PHY_1MBPS;
+    p_link->rx_phy      = BLE_GAP_PHY_1MBPS;
+    p_link->att_mtu     = BLE_GATT_ATT_MTU_DEFAULT;
+    p_link->data_length = BLE_GAP_DATA_LENGTH_DEFAULT;
+
+    // The GATT module starts the ATT MTU exchange and the data length update on this same event.
+    err_code = app_timer_start(m_settle_timer_id, APP_TIMER_TICKS(LINK_CTRL_SETTLE_TIMEOUT_MS), NULL);
+    APP_ERROR_CHECK(err_code);
+
+    // Ask for the fast PHY right away instead of waiting for the central.
+    err_code = sd_ble_gap_phy_update(conn_handle, &phys);
+    if (err_code == NRF_ERROR_BUSY)
+    {
+        // The central has started a PHY procedure, its BLE_GAP_EVT_PHY_UPDATE settles the link.
+        return;
+    }
+    if (err_code != NRF_SUCCESS)
+    {
+        NRF_LOG_WARNING("PHY update request failed, error 0x%x.", err_code);
+        p_link->phy_settled = true;
+        ready_check(p_link, conn_handle);
+    }
+}
+
+
+static void on_phy_update_request(ble_evt_t const * p_ble_evt)
+{
+    ret_code_t           err_code;
+    ble_gap_phys_t const phys =
+    {
+        .rx_phys = BLE_GAP_PHY_AUTO,
+        .tx_phys = BLE_GAP_PHY_AUTO,
+    };
+
+    NRF_LOG_INFO("PHY update request.");
+
+    err_code = sd_ble_gap_phy_update(p_ble_evt->evt.gap_evt.conn_handle, &phys);
+    APP_ERROR_CHECK(err_code);
+}
+
+
+static void on_phy_update(ble_evt_t const * p_ble_evt)
+{
+    uint16_t                          conn_handle  = p_ble_evt->evt.gap_evt.conn_handle;
+    ble_gap_evt_phy_update_t const  * p_phy_update = &p_ble_evt->evt.gap_evt.params.phy_update;
+    link_ctrl_link_t                * p_link       = link_get(conn_handle);
+
+    if (p_link == NULL)
+    {
+        return;
+    }
+
+    p_link->answered |= LINK_CTRL_ANSWERED_PHY;
+
+    if (p_phy_update->status == BLE_HCI_STATUS_CODE_SUCCESS)
+    {
+        p_link->tx_phy = p_phy_update->tx_phy;
+        p_link->rx_phy = p_phy_update->rx_phy;
+    }
+    else
+    {
+        // The central may not support 2M, keep going on the PHY we have.
+        NRF_LOG_WARNING("PHY update failed, status 0x%x.", p_phy_update->status);
+    }
+
+    NRF_LOG_INFO("PHY: tx %d, rx %d.", p_link->tx_phy, p_link->rx_phy);
+
+    p_link->phy_settled = true;
+
+    evt_send(LINK_CTRL_EVT_PHY_UPDATED, conn_handle);
+    ready_check(p_link, conn_handle);
+}
+
+
+void link_ctrl_on_ble_evt(ble_evt_t const * p_ble_evt, void * p_context)
+{
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            on_connect(p_ble_evt);
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+        {
+            link_ctrl_link_t * p_link = link_get(p_ble_evt->evt.gap_evt.conn_handle);
+            if (p_link != NULL)
+            {
+                memset(p_link, 0, sizeof(link_ctrl_link_t));
+                p_link->conn_handle = BLE_CONN_HANDLE_INVALID;
+            }
+        } break;
+
+        case BLE_GAP_EVT_PHY_UPDATE_REQUEST:
+            on_phy_update_request(p_ble_evt);
+            break;
+
+        case BLE_GAP_EVT_PHY_UPDATE:
+            on_phy_update(p_ble_evt);
+            break;
+
+        default:
+            // No implementation needed.
+            break;
+    }
+}
+
+
+void link_ctrl_on_gatt_evt(nrf_ble_gatt_evt_t const * p_evt)
+{
+    link_ctrl_link_t * p_link = link_get(p_evt->conn_handle);
+
+    if (p_link == NULL)
+    {
+        return;
+    }
+
+    switch (p_evt->evt_id)
+    {
+        case NRF_BLE_GATT_EVT_ATT_MTU_UPDATED:
+            p_link->att_mtu     = p_evt->params.att_mtu_effective;
+            p_link->mtu_settled = true;
+            p_link->answered   |= LINK_CTRL_ANSWERED_ATT_MTU;
+            break;
+
+        case NRF_BLE_GATT_EVT_DATA_LENGTH_UPDATED:
+            p_link->data_length = p_evt->params.data_length;
+            p_link->dl_settled  = true;
+            p_link->answered   |= LINK_CTRL_ANSWERED_DATA_LENGTH;
+            break;
+
+        default:
+            return;
+    }
+
+    ready_check(p_link, p_evt->conn_handle);
+}
+
+
+ret_code_t link_ctrl_init(link_ctrl_init_t const * p_init)
+{
+    ret_code_t err_code;
+
+    VERIFY_PARAM_NOT_NULL(p_init);
+    VERIFY_PARAM_NOT_NULL(p_init->p_gatt);
+
+    m_evt_handler = p_init->evt_handler;
+    m_p_gatt      = p_init->p_gatt;
+
+    memset(m_links, 0, sizeof(m_links));
+    for (uint16_t idx = 0; idx < NRF_SDH_BLE_TOTAL_LINK_COUNT; idx++)
+    {
+        m_links[idx].conn_handle = BLE_CONN_HANDLE_INVALID;
+    }
+
+    // Negotiate the largest ATT MTU and LL data length the stack has been configured for.
+    err_code = nrf_ble_gatt_att_mtu_periph_set(m_p_gatt, NRF_SDH_BLE_GATT_MAX_MTU_SIZE);
+    VERIFY_SUCCESS(err_code);
+
+    err_code = nrf_ble_gatt_data_length_set(m_p_gatt, BLE_CONN_HANDLE_INVALID, NRF_SDH_BLE_GAP_DATA_LENGTH);
+    VERIFY_SUCCESS(err_code);
+
+    return app_timer_create(&m_settle_timer_id, APP_TIMER_MODE_SINGLE_SHOT, settle_timeout_handler);
+}
+
+
+ret_code_t link_ctrl_phy_request(uint16_t conn_handle, uint8_t phys)
+{
+    ble_gap_phys_t const gap_phys =
+    {
+        .rx_phys = phys,
+        .tx_phys = phys,
+    };
+
+    if (link_get(conn_handle) == NULL)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    return sd_ble_gap_phy_update(conn_handle, &gap_phys);
+}
+
+
+ret_code_t link_ctrl_data_length_request(uint16_t conn_handle, uint8_t data_length)
+{
+    if (link_get(conn_handle) == NULL)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    return nrf_ble_gatt_data_length_set(m_p_gatt, conn_handle, data_length);
+}
+
+
+ret_code_t link_ctrl_params_get(uint16_t conn_handle, link_ctrl_params_t * p_params)
+{
+    link_ctrl_link_t * p_link = link_get(conn_handle);
+
+    if ((p_link == NULL) || !p_link->is_ready)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    memset(p_params, 0, sizeof(link_ctrl_params_t));
+    p_params->tx_phy      = p_link->tx_phy;
+    p_params->rx_phy      = p_link->rx_phy;
+    p_params->att_mtu     = p_link->att_mtu;
+    p_params->data_length = (uint8_t)p_link->data_length;
+    p_params->answered    = p_link->answered;
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t link_ctrl_params_apply(uint16_t conn_handle, link_ctrl_params_t const * p_params)
+{
+    link_ctrl_link_t * p_link = link_get(conn_handle);
+
+    if ((p_link == NULL) || (p_link->conn_handle != conn_handle))
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    if (!(p_params->answered & LINK_CTRL_ANSWERED_PHY) || !(p_params->tx_phy & LINK_CTRL_PREFERRED_PHYS))
+    {
+        // Unanswered or turned down last time, the outcome of the request sent on connect is
+        // picked up whenever it comes.
+        p_link->phy_settled = true;
+    }
+
+    if (!(p_params->answered & LINK_CTRL_ANSWERED_ATT_MTU))
+    {
+        p_link->mtu_settled = true;
+    }
+
+    if (!(p_params->answered & LINK_CTRL_ANSWERED_DATA_LENGTH))
+    {
+        p_link->dl_settled = true;
+    }
+
+    ready_check(p_link, conn_handle);
+
+    return NRF_SUCCESS;
+}
+
+
+bool link_ctrl_is_ready(uint16_t conn_handle)
+{
+    link_ctrl_link_t * p_link = link_get(conn_handle);
+
+    return (p_link != NULL) && p_link->is_ready;
+}
+
+
+uint8_t link_ctrl_tx_phy_get(uint16_t conn_handle)
+{
+    link_ctrl_link_t * p_link = link_get(conn_handle);
+
+    return (p_link != NULL) ? p_link->tx_phy : BLE_GAP_PHY_1MBPS;
+}
+
+
+uint16_t link_ctrl_att_mtu_get(uint16_t conn_handle)
+{
+    link_ctrl_link_t * p_link = link_get(conn_handle);
+
+    return (p_link != NULL) ? p_link->att_mtu : BLE_GATT_ATT_MTU_DEFAULT;
+}
+
+
+uint16_t link_ctrl_data_length_get(uint16_t conn_handle)
+{
+    link_ctrl_link_t * p_link = link_get(conn_handle);
+
+    return (p_link != NULL) ? p_link->data_length : BLE_GAP_DATA_LENGTH_DEFAULT;
+}
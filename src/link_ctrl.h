@@ -0,0 +1,192 @@
+#ifndef __LINK_CTRL_H
+#define __LINK_CTRL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_config.h"
+#include "ble.h"
+#include "ble_gap.h"
+#include "nrf_sdh_ble.h"
+#include "nrf_ble_gatt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LINK_CTRL_BLE_OBSERVER_PRIO     2
+
+/**@brief   PHYs requested as soon as a central connects. */
+#ifndef LINK_CTRL_PREFERRED_PHYS
+#define LINK_CTRL_PREFERRED_PHYS        BLE_GAP_PHY_2MBPS
+#endif
+
+/**@brief   Time given to the PHY, ATT MTU and data length procedures before a link is declared
+ *          ready with whatever has been negotiated (in ms). */
+#ifndef LINK_CTRL_SETTLE_TIMEOUT_MS
+#define LINK_CTRL_SETTLE_TIMEOUT_MS     3000
+#endif
+
+
+/**@brief   Link procedures the central answered, bits of @ref link_ctrl_params_t::answered. */
+#define LINK_CTRL_ANSWERED_PHY          0x01
+#define LINK_CTRL_ANSWERED_ATT_MTU      0x02
+#define LINK_CTRL_ANSWERED_DATA_LENGTH  0x04
+
+
+/**@brief   Link control event types. */
+typedef enum
+{
+    LINK_CTRL_EVT_PHY_UPDATED,      /**< The PHY of a link changed or a PHY procedure ended. */
+    LINK_CTRL_EVT_READY,            /**< All link parameter procedures have settled, bulk transfers may start. */
+} link_ctrl_evt_type_t;
+
+
+/**@brief   Link control event structure. */
+typedef struct
+{
+    link_ctrl_evt_type_t type;          /**< Event type. */
+    uint16_t             conn_handle;   /**< Connection handle the event refers to. */
+} link_ctrl_evt_t;
+
+
+/**@brief   Link control event handler type. */
+typedef void (* link_ctrl_evt_handler_t)(link_ctrl_evt_t const * p_evt);
+
+
+/**@brief   Link parameters a link settled on, kept to set up the next link to the same peer. */
+typedef struct
+{
+    uint8_t  tx_phy;        /**< TX PHY, BLE_GAP_PHY_*. */
+    uint8_t  rx_phy;        /**< RX PHY, BLE_GAP_PHY_*. */
+    uint16_t att_mtu;       /**< Effective ATT MTU (in bytes). */
+    uint8_t  data_length;   /**< LL data length (in bytes). */
+    uint8_t  answered;      /**< LINK_CTRL_ANSWERED_* bits of the procedures that ended before the settle timeout. */
+    uint16_t reserved;      /**< Keeps the size a multiple of a word, 0. */
+} link_ctrl_params_t;
+
+
+/**@brief   Link control initialization structure. */
+typedef struct
+{
+    link_ctrl_evt_handler_t evt_handler;    /**< Event handler, called from the SoftDevice event context. */
+    nrf_ble_gatt_t        * p_gatt;         /**< GATT module that negotiates the ATT MTU and the data length. */
+} link_ctrl_init_t;
+
+
+/**@brief   Function for initializing the link control module.
+ *
+ * @details On every connection the module requests @ref LINK_CTRL_PREFERRED_PHYS and lets the GATT
+ *          module exchange the largest ATT MTU and LL data length the stack is configured for.
+ *          @ref LINK_CTRL_EVT_READY is reported once all three procedures have settled, or after
+ *          @ref LINK_CTRL_SETTLE_TIMEOUT_MS if the central leaves one of them unanswered.
+ *
+ * @note    The application timer module must be initialized first.
+ *
+ * @param[in] p_init  Initialization parameters.
+ *
+ * @retval NRF_SUCCESS     If the module was initialized.
+ * @retval NRF_ERROR_NULL  If @p p_init or the GATT module was NULL.
+ * @return Otherwise an error code from the GATT or timer modules.
+ */
+ret_code_t link_ctrl_init(link_ctrl_init_t const * p_init);
+
+
+/**@brief   Function for handling BLE events. Registered as a SoftDevice observer by the module. */
+void link_ctrl_on_ble_evt(ble_evt_t const * p_ble_evt, void * p_context);
+
+
+/**@brief   Function for handling GATT module events.
+ *
+ * @details The GATT module takes a single event handler, so the application forwards its events.
+ *
+ * @param[in] p_evt  GATT module event.
+ */
+void link_ctrl_on_gatt_evt(nrf_ble_gatt_evt_t const * p_evt);
+
+
+/**@brief   Function for requesting a PHY on a link that is already set up.
+ *
+ * @details The outcome is reported with @ref LINK_CTRL_EVT_PHY_UPDATED.
+ *
+ * @param[in] conn_handle  Connection handle.
+ * @param[in] phys         BLE_GAP_PHY_* bits wanted in both directions.
+ *
+ * @retval NRF_SUCCESS  If the procedure was started.
+ * @return Otherwise an error code from sd_ble_gap_phy_update.
+ */
+ret_code_t link_ctrl_phy_request(uint16_t conn_handle, uint8_t phys);
+
+
+/**@brief   Function for requesting an LL data length on a link that is already set up.
+ *
+ * @details The new data length is picked up from NRF_BLE_GATT_EVT_DATA_LENGTH_UPDATED.
+ *
+ * @param[in] conn_handle  Connection handle.
+ * @param[in] data_length  LL data length wanted (in bytes).
+ *
+ * @retval NRF_SUCCESS  If the procedure was started.
+ * @return Otherwise an error code from the GATT module.
+ */
+ret_code_t link_ctrl_data_length_request(uint16_t conn_handle, uint8_t data_length);
+
+
+/**@brief   Function for getting the parameters a link has settled on.
+ *
+ * @param[in]  conn_handle  Connection handle.
+ * @param[out] p_params     Link parameters.
+ *
+ * @retval NRF_SUCCESS              If the link is ready and @p p_params was filled in.
+ * @retval NRF_ERROR_INVALID_STATE  If the link is unknown or not ready yet.
+ */
+ret_code_t link_ctrl_params_get(uint16_t conn_handle, link_ctrl_params_t * p_params);
+
+
+/**@brief   Function for setting up a new link with what the last link to the same peer settled on.
+ *
+ * @details The procedures are still run, as their outcome is per link. But those the central left
+ *          unanswered last time are not waited for, so the link is ready after the first few
+ *          connection events rather than after @ref LINK_CTRL_SETTLE_TIMEOUT_MS. Nor is a PHY
+ *          request the central turned down last time.
+ *
+ *          Call on BLE_GAP_EVT_CONNECTED, from an observer of a lower priority than
+ *          @ref LINK_CTRL_BLE_OBSERVER_PRIO.
+ *
+ * @param[in] conn_handle  Connection handle.
+ * @param[in] p_params     Parameters from @ref link_ctrl_params_get on the last link to the peer.
+ *
+ * @retval NRF_SUCCESS              If the parameters were applied.
+ * @retval NRF_ERROR_INVALID_STATE  If the link is unknown.
+ */
+ret_code_t link_ctrl_params_apply(uint16_t conn_handle, link_ctrl_params_t const * p_params);
+
+
+/**@brief   Function for checking whether a link is ready for bulk transfers.
+ *
+ * @param[in] conn_handle  Connection handle.
+ */
+bool link_ctrl_is_ready(uint16_t conn_handle);
+
+
+/**@brief   Function for getting the TX PHY of a link.
+ *
+ * @param[in] conn_handle  Connection handle.
+ *
+ * @return  BLE_GAP_PHY_1MBPS, BLE_GAP_PHY_2MBPS or BLE_GAP_PHY_CODED. BLE_GAP_PHY_1MBPS for unknown links.
+ */
+uint8_t link_ctrl_tx_phy_get(uint16_t conn_handle);
+
+
+/**@brief   Function for getting the effective ATT MTU of a link (in bytes).
+ */
+uint16_t link_ctrl_att_mtu_get(uint16_t conn_handle);
+
+
+/**@brief   Function for getting the LL data length of a link (in bytes).
+ */
+uint16_t link_ctrl_data_length_get(uint16_t conn_handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LINK_CTRL_H
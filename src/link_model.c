@@ -0,0 +1,144 @@
+#include <string.h>
+#include "link_model.h"
+
+
+/**@brief Function for computing the air time of an LL PDU with the given payload (in us).
+ */
+static uint32_t pdu_air_time_us(link_model_phy_t phy, uint16_t payload_len)
+{
+    // The 2M PHY uses a two byte preamble and sends every byte twice as fast.
+    uint32_t preamble_len = (phy == LINK_MODEL_PHY_2M) ? 2 : 1;
+    uint32_t pdu_len      = preamble_len + LINK_MODEL_LL_AA_LEN + LINK_MODEL_LL_HEADER_LEN
+                          + payload_len + LINK_MODEL_LL_CRC_LEN;
+
+    return (pdu_len * 8) / (uint32_t)phy;
+}
+
+
+uint32_t link_model_hvx_air_time_us(link_model_params_t const * p_params, uint16_t length)
+{
+    uint32_t l2cap_len  = length + LINK_MODEL_ATT_HVX_HEADER_LEN + LINK_MODEL_L2CAP_HEADER_LEN;
+    uint32_t air_time   = 0;
+    uint32_t empty_time = pdu_air_time_us(p_params->phy, 0);
+
+    // Every LL PDU is answered by an empty PDU from the central.
+    while (l2cap_len > 0)
+    {
+        uint16_t pdu_len = (l2cap_len > p_params->data_length) ? p_params->data_length : (uint16_t)l2cap_len;
+
+        air_time  += pdu_air_time_us(p_params->phy, pdu_len) + LINK_MODEL_T_IFS_US
+                   + empty_time + LINK_MODEL_T_IFS_US;
+        l2cap_len -= pdu_len;
+    }
+
+    return air_time;
+}
+
+
+/**@brief Function for computing the radio time available in one connection event (in us).
+ */
+static uint32_t event_budget_us(link_model_params_t const * p_params)
+{
+    return (p_params->event_length_us < p_params->conn_interval_us) ? p_params->event_length_us
+                                                                   : p_params->conn_interval_us;
+}
+
+
+uint32_t link_model_hvn_queue_ram(uint8_t queue_size, uint16_t att_mtu)
+{
+    // Entries are word aligned.
+    uint32_t entry_size = (att_mtu + LINK_MODEL_HVN_ENTRY_OVERHEAD + 3) & ~3UL;
+
+    return queue_size * entry_size;
+}
+
+
+void link_model_estimate(link_model_params_t const * p_params, link_model_report_t * p_report)
+{
+    uint16_t length   = p_params->att_mtu - LINK_MODEL_ATT_HVX_HEADER_LEN;
+    uint32_t air_time = link_model_hvx_air_time_us(p_params, length);
+    uint32_t packets  = event_budget_us(p_params) / air_time;
+
+    // The queue is refilled once per event, so it caps the notifications per event.
+    if (packets > p_params->hvn_queue_size)
+    {
+        packets = p_params->hvn_queue_size;
+    }
+
+    memset(p_report, 0, sizeof(link_model_report_t));
+    p_report->conn_events            = 1;
+    p_report->packets                = packets;
+    p_report->payload_bytes          = packets * length;
+    p_report->elapsed_us             = p_params->conn_interval_us;
+    p_report->packets_per_event_x100 = packets * 100;
+    p_report->kbps                   = (uint32_t)(((uint64_t)p_report->payload_bytes * 8 * 1000)
+                                                  / p_params->conn_interval_us);
+}
+
+
+void link_model_sim_init(link_model_sim_t * p_sim, link_model_params_t const * p_params)
+{
+    memset(p_sim, 0, sizeof(link_model_sim_t));
+    p_sim->params = *p_params;
+}
+
+
+bool link_model_sim_hvx(link_model_sim_t * p_sim, uint16_t length)
+{
+    if (p_sim->queued >= p_sim->params.hvn_queue_size)
+    {
+        p_sim->report.busy_count++;
+        return false;
+    }
+
+    p_sim->queued_len[(uint8_t)(p_sim->queue_head + p_sim->queued)] = length;
+    p_sim->queued++;
+
+    return true;
+}
+
+
+uint8_t link_model_sim_conn_event(link_model_sim_t * p_sim)
+{
+    uint32_t budget    = event_budget_us(&p_sim->params);
+    uint8_t  completed = 0;
+
+    while (p_sim->queued > 0)
+    {
+        uint16_t length   = p_sim->queued_len[p_sim->queue_head];
+        uint32_t air_time = link_model_hvx_air_time_us(&p_sim->params, length);
+
+        if (air_time > budget)
+        {
+            break;
+        }
+
+        budget -= air_time;
+        p_sim->queue_head++;
+        p_sim->queued--;
+        completed++;
+
+        p_sim->report.packets++;
+        p_sim->report.payload_bytes += length;
+    }
+
+    p_sim->report.conn_events++;
+    p_sim->report.elapsed_us += p_sim->params.conn_interval_us;
+
+    return completed;
+}
+
+
+void link_model_sim_report(link_model_sim_t * p_sim, link_model_report_t * p_report)
+{
+    link_model_report_t * p_sim_report = &p_sim->report;
+
+    if (p_sim_report->conn_events > 0)
+    {
+        p_sim_report->packets_per_event_x100 = (p_sim_report->packets * 100) / p_sim_report->conn_events;
+        p_sim_report->kbps = (uint32_t)(((uint64_t)p_sim_report->payload_bytes * 8 * 1000)
+                                        / p_sim_report->elapsed_us);
+    }
+
+    *p_report = *p_sim_report;
+}
@@ -0,0 +1,126 @@
+#ifndef __LINK_MODEL_H
+#define __LINK_MODEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Link layer constants used by the model (Bluetooth Core v5.1, Vol 6, Part B). */
+#define LINK_MODEL_T_IFS_US             150     /**< Inter frame space (in us). */
+#define LINK_MODEL_LL_HEADER_LEN        2       /**< LL data PDU header (in bytes). */
+#define LINK_MODEL_LL_AA_LEN            4       /**< Access address (in bytes). */
+#define LINK_MODEL_LL_CRC_LEN           3       /**< LL CRC (in bytes). */
+#define LINK_MODEL_L2CAP_HEADER_LEN     4       /**< L2CAP basic header (in bytes). */
+#define LINK_MODEL_ATT_HVX_HEADER_LEN   3       /**< ATT opcode and attribute handle (in bytes). */
+#define LINK_MODEL_HVN_ENTRY_OVERHEAD   16      /**< Estimated SoftDevice bookkeeping per HVN TX queue entry (in bytes). */
+
+/**@brief   PHY data rates understood by the model. */
+typedef enum
+{
+    LINK_MODEL_PHY_1M = 1,  /**< LE 1M PHY. */
+    LINK_MODEL_PHY_2M = 2,  /**< LE 2M PHY. */
+} link_model_phy_t;
+
+
+/**@brief   Link parameters of one simulated connection. */
+typedef struct
+{
+    uint32_t         conn_interval_us;  /**< Connection interval (in us). */
+    uint32_t         event_length_us;   /**< GAP event length reserved for the link (in us). */
+    link_model_phy_t phy;               /**< PHY used in both directions. */
+    uint16_t         data_length;       /**< LL data channel PDU payload (in bytes, 27 to 251). */
+    uint16_t         att_mtu;           /**< Effective ATT MTU (in bytes). */
+    uint8_t          hvn_queue_size;    /**< SoftDevice HVN TX queue depth (in notifications). */
+} link_model_params_t;
+
+
+/**@brief   Throughput figures produced by the model. */
+typedef struct
+{
+    uint32_t conn_events;           /**< Connection events simulated. */
+    uint32_t packets;               /**< Notifications that went over the air. */
+    uint32_t payload_bytes;         /**< Notification payload that went over the air (in bytes). */
+    uint32_t elapsed_us;            /**< Simulated time (in us). */
+    uint32_t busy_count;            /**< hvx calls rejected because the queue was full. */
+    uint32_t packets_per_event_x100; /**< Average notifications per connection event, times 100. */
+    uint32_t kbps;                  /**< Achieved notification payload throughput (in kbps). */
+} link_model_report_t;
+
+
+/**@brief   State of a simulated SoftDevice link.
+ *
+ * @details The simulation replaces sd_ble_gatts_hvx with @ref link_model_sim_hvx and the radio with
+ *          @ref link_model_sim_conn_event, so a transfer can be run deterministically without a
+ *          radio. It uses nothing but the C library and builds on any host.
+ */
+typedef struct
+{
+    link_model_params_t params;
+    uint8_t             queued;         /**< Notifications waiting in the HVN TX queue. */
+    uint16_t            queued_len[UINT8_MAX + 1]; /**< Length of every queued notification, indexed modulo 256. */
+    uint8_t             queue_head;     /**< Index of the oldest queued notification. */
+    link_model_report_t report;
+} link_model_sim_t;
+
+
+/**@brief   Function for computing the air time of one notification, including the empty PDUs
+ *          sent by the central and the inter frame spaces (in us).
+ *
+ * @param[in] p_params  Link parameters.
+ * @param[in] length    Notification payload (in bytes).
+ */
+uint32_t link_model_hvx_air_time_us(link_model_params_t const * p_params, uint16_t length);
+
+
+/**@brief   Function for estimating the SoftDevice RAM taken by an HVN TX queue (in bytes).
+ *
+ * @details Every queue entry holds one full-MTU notification plus bookkeeping. This is an estimate
+ *          for comparing queue depths; the exact figure for a build is the RAM start address
+ *          reported by nrf_sdh_ble_enable().
+ *
+ * @param[in] queue_size  HVN TX queue depth (in notifications).
+ * @param[in] att_mtu     ATT MTU configured for the connection (in bytes).
+ */
+uint32_t link_model_hvn_queue_ram(uint8_t queue_size, uint16_t att_mtu);
+
+
+/**@brief   Function for estimating the steady state throughput of full-MTU notifications.
+ *
+ * @param[in]  p_params  Link parameters.
+ * @param[out] p_report  Estimated figures for one connection event.
+ */
+void link_model_estimate(link_model_params_t const * p_params, link_model_report_t * p_report);
+
+
+/**@brief   Function for initializing a simulated link.
+ */
+void link_model_sim_init(link_model_sim_t * p_sim, link_model_params_t const * p_params);
+
+
+/**@brief   Function for queueing one notification on the simulated link.
+ *
+ * @retval true   If the notification was queued.
+ * @retval false  If the queue was full, the equivalent of NRF_ERROR_RESOURCES.
+ */
+bool link_model_sim_hvx(link_model_sim_t * p_sim, uint16_t length);
+
+
+/**@brief   Function for running one connection event on the simulated link.
+ *
+ * @return  Number of notifications completed, the value of BLE_GATTS_EVT_HVN_TX_COMPLETE count.
+ */
+uint8_t link_model_sim_conn_event(link_model_sim_t * p_sim);
+
+
+/**@brief   Function for finishing the averages in the simulation report.
+ */
+void link_model_sim_report(link_model_sim_t * p_sim, link_model_report_t * p_report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LINK_MODEL_H
@@ -0,0 +1,205 @@
+#include <string.h>
+#include "lzss.h"
+
+
+#define HISTORY_MASK        (LZSS_HISTORY_LEN - 1)
+#define MATCH_LEN_SHIFT     2
+#define OFFSET_HIGH_MASK    0x03
+
+
+/**@brief Function for hashing the three bytes at the start of a possible match.
+ */
+static uint16_t hash3(uint8_t const * p_data)
+{
+    uint32_t value = ((uint32_t)p_data[0] << 16) | ((uint32_t)p_data[1] << 8) | p_data[2];
+
+    return (uint16_t)(((value * 2654435761UL) >> 16) & (LZSS_HASH_SIZE - 1));
+}
+
+
+void lzss_encoder_init(lzss_encoder_t * p_encoder)
+{
+    memset(p_encoder, 0, sizeof(lzss_encoder_t));
+}
+
+
+uint16_t lzss_encode(lzss_encoder_t * p_encoder,
+                     uint8_t const  * p_in,
+                     uint16_t         in_len,
+                     uint8_t        * p_out,
+                     uint16_t         out_max)
+{
+    uint32_t start    = p_encoder->pos;
+    uint16_t out_len  = 0;
+    uint16_t flag_idx = 0;
+    uint8_t  item     = 8;
+    uint16_t i        = 0;
+
+    if ((in_len == 0) || (in_len > LZSS_BLOCK_MAX))
+    {
+        return 0;
+    }
+
+    // The whole block goes into the history first, so a match may run on into bytes not yet
+    // encoded, and the history is right even if the block does not fit.
+    for (uint16_t k = 0; k < in_len; k++)
+    {
+        p_encoder->history[(start + k) & HISTORY_MASK] = p_in[k];
+    }
+    p_encoder->pos += in_len;
+
+    while (i < in_len)
+    {
+        uint32_t cur       = start + i;
+        uint16_t remaining = in_len - i;
+        uint16_t match_len = 0;
+        uint16_t offset    = 0;
+
+        if (item == 8)
+        {
+            if (out_len >= out_max)
+            {
+                return 0;
+            }
+            flag_idx          = out_len++;
+            p_out[flag_idx]   = 0;
+            item              = 0;
+        }
+
+        if (remaining >= LZSS_MATCH_MIN)
+        {
+            uint16_t h   = hash3(&p_in[i]);
+            uint16_t max = (remaining < LZSS_MATCH_MAX) ? remaining : LZSS_MATCH_MAX;
+
+            // Positions are kept modulo 65536, every candidate is checked byte by byte.
+            offset = (uint16_t)(cur - p_encoder->head[h]);
+            p_encoder->head[h] = (uint16_t)cur;
+
+            if ((offset != 0) && (offset <= LZSS_OFFSET_MAX))
+            {
+                while ((match_len < max) &&
+                       (p_encoder->history[(cur - offset + match_len) & HISTORY_MASK] == p_in[i + match_len]))
+                {
+                    match_len++;
+                }
+            }
+        }
+
+        if (match_len >= LZSS_MATCH_MIN)
+        {
+            if (out_len + 2 > out_max)
+            {
+                return 0;
+            }
+
+            p_out[flag_idx] |= (uint8_t)(1 << item);
+            p_out[out_len++] = (uint8_t)offset;
+            p_out[out_len++] = (uint8_t)(((offset >> 8) & OFFSET_HIGH_MASK) | ((match_len - LZSS_MATCH_MIN) << MATCH_LEN_SHIFT));
+
+            // Later matches may start anywhere inside this one.
+            for (uint16_t k = 1; (k < match_len) && (i + k + LZSS_MATCH_MIN <= in_len); k++)
+            {
+                p_encoder->head[hash3(&p_in[i + k])] = (uint16_t)(cur + k);
+            }
+
+            i += match_len;
+        }
+        else
+        {
+            if (out_len >= out_max)
+            {
+                return 0;
+            }
+
+            p_out[out_len++] = p_in[i++];
+        }
+
+        item++;
+    }
+
+    return out_len;
+}
+
+
+void lzss_decoder_init(lzss_decoder_t * p_decoder)
+{
+    memset(p_decoder, 0, sizeof(lzss_decoder_t));
+}
+
+
+bool lzss_decode(lzss_decoder_t * p_decoder,
+                 uint8_t const  * p_in,
+                 uint16_t         in_len,
+                 uint8_t        * p_out,
+                 uint16_t         out_max,
+                 uint16_t       * p_out_len)
+{
+    uint16_t in_idx  = 0;
+    uint16_t out_len = 0;
+    uint8_t  flags   = 0;
+    uint8_t  item    = 8;
+
+    while (in_idx < in_len)
+    {
+        if (item == 8)
+        {
+            flags = p_in[in_idx++];
+            item  = 0;
+            continue;
+        }
+
+        if (flags & (1 << item))
+        {
+            uint16_t offset;
+            uint16_t match_len;
+
+            if (in_idx + 2 > in_len)
+            {
+                return false;
+            }
+
+            offset    = p_in[in_idx] | ((p_in[in_idx + 1] & OFFSET_HIGH_MASK) << 8);
+            match_len = (p_in[in_idx + 1] >> MATCH_LEN_SHIFT) + LZSS_MATCH_MIN;
+            in_idx   += 2;
+
+            if ((offset == 0) || (out_len + match_len > out_max))
+            {
+                return false;
+            }
+
+            // Byte by byte, a match may overlap the bytes it produces.
+            for (uint16_t k = 0; k < match_len; k++)
+            {
+                uint8_t byte = p_decoder->history[(p_decoder->pos - offset) & HISTORY_MASK];
+
+                p_decoder->history[p_decoder->pos++ & HISTORY_MASK] = byte;
+                p_out[out_len++] = byte;
+            }
+        }
+        else
+        {
+            if (out_len >= out_max)
+            {
+                return false;
+            }
+
+            p_decoder->history[p_decoder->pos++ & HISTORY_MASK] = p_in[in_idx];
+            p_out[out_len++] = p_in[in_idx++];
+        }
+
+        item++;
+    }
+
+    *p_out_len = out_len;
+
+    return true;
+}
+
+
+void lzss_decoder_raw(lzss_decoder_t * p_decoder, uint8_t const * p_data, uint16_t length)
+{
+    for (uint16_t k = 0; k < length; k++)
+    {
+        p_decoder->history[p_decoder->pos++ & HISTORY_MASK] = p_data[k];
+    }
+}
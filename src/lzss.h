@@ -0,0 +1,127 @@
+#ifndef __LZSS_H
+#define __LZSS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Farthest back a match may reach (in bytes). */
+#define LZSS_OFFSET_MAX         1023
+
+/**@brief   Shortest and longest match (in bytes). */
+#define LZSS_MATCH_MIN          3
+#define LZSS_MATCH_MAX          66
+
+/**@brief   Longest block one call encodes (in bytes). */
+#define LZSS_BLOCK_MAX          1024
+
+/**@brief   History kept by both sides, enough for a whole block and the match reach before it. */
+#define LZSS_HISTORY_LEN        2048
+
+/**@brief   Number of hash chain heads of the encoder, a power of two. */
+#ifndef LZSS_HASH_SIZE
+#define LZSS_HASH_SIZE          1024
+#endif
+
+/**@brief   Longest encoding of a block of @p _len bytes: every byte a literal, one flag byte per eight. */
+#define LZSS_BOUND(_len)        ((_len) + (((_len) + 7) / 8))
+
+
+/**@brief   Block format.
+ *
+ * A block is a run of items, grouped by eight behind a flag byte. Bit i of the flag byte, LSB
+ * first, is set if item i is a match and clear if it is a literal. A literal is one byte. A match
+ * is two bytes:
+ *
+ * | Bits      | Field                                                     |
+ * |-----------|-----------------------------------------------------------|
+ * | 0 to 9    | Offset, 1 to @ref LZSS_OFFSET_MAX bytes back              |
+ * | 10 to 15  | Length minus @ref LZSS_MATCH_MIN                          |
+ *
+ * The history runs on from block to block and starts as zeros, so the decoder must see every
+ * block, in order. A block sent uncompressed is still history and must be passed to
+ * @ref lzss_decoder_raw.
+ */
+
+
+/**@brief   Encoder state, about 4 kB. */
+typedef struct
+{
+    uint8_t  history[LZSS_HISTORY_LEN];     /**< Bytes seen so far, indexed modulo @ref LZSS_HISTORY_LEN. */
+    uint16_t head[LZSS_HASH_SIZE];          /**< Latest position of every 3-byte hash, modulo 65536. */
+    uint32_t pos;                           /**< Bytes seen so far. */
+} lzss_encoder_t;
+
+
+/**@brief   Decoder state. */
+typedef struct
+{
+    uint8_t  history[LZSS_HISTORY_LEN];     /**< Bytes output so far, indexed modulo @ref LZSS_HISTORY_LEN. */
+    uint32_t pos;                           /**< Bytes output so far. */
+} lzss_decoder_t;
+
+
+/**@brief   Function for starting a new stream on an encoder.
+ */
+void lzss_encoder_init(lzss_encoder_t * p_encoder);
+
+
+/**@brief   Function for encoding a block.
+ *
+ * @details The block becomes history whether it is encoded or not. If the encoded block does not
+ *          fit @p out_max bytes, the block must be sent as it is.
+ *
+ * @param[in]  p_encoder  Encoder.
+ * @param[in]  p_in       Block to encode.
+ * @param[in]  in_len     Length of @p p_in, at most @ref LZSS_BLOCK_MAX bytes.
+ * @param[out] p_out      Encoded block.
+ * @param[in]  out_max    Size of @p p_out (in bytes).
+ *
+ * @return  Length of the encoded block (in bytes), 0 if it does not fit @p out_max or @p in_len
+ *          is out of range.
+ */
+uint16_t lzss_encode(lzss_encoder_t * p_encoder,
+                     uint8_t const  * p_in,
+                     uint16_t         in_len,
+                     uint8_t        * p_out,
+                     uint16_t         out_max);
+
+
+/**@brief   Function for starting a new stream on a decoder.
+ */
+void lzss_decoder_init(lzss_decoder_t * p_decoder);
+
+
+/**@brief   Function for decoding a block.
+ *
+ * @param[in]  p_decoder  Decoder.
+ * @param[in]  p_in       Encoded block.
+ * @param[in]  in_len     Length of @p p_in (in bytes).
+ * @param[out] p_out      Decoded block.
+ * @param[in]  out_max    Size of @p p_out (in bytes).
+ * @param[out] p_out_len  Length of the decoded block (in bytes).
+ *
+ * @retval true   If the block was decoded.
+ * @retval false  If the block is malformed or does not fit @p out_max. The decoder must be
+ *                started again.
+ */
+bool lzss_decode(lzss_decoder_t * p_decoder,
+                 uint8_t const  * p_in,
+                 uint16_t         in_len,
+                 uint8_t        * p_out,
+                 uint16_t         out_max,
+                 uint16_t       * p_out_len);
+
+
+/**@brief   Function for adding a block that was sent uncompressed to the decoder history.
+ */
+void lzss_decoder_raw(lzss_decoder_t * p_decoder, uint8_t const * p_data, uint16_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LZSS_H
@@ -60,6 +60,8 @@
 #include "nrf_sdh_soc.h"
 #include "app_timer.h"
 #include "fds.h"
+#include "peer_manager.h"
+#include "peer_manager_handler.h"
 #include "nrf_ble_gatt.h"
 #include "nrf_ble_qwr.h"
 #include "ble_conn_state.h"
@@ -70,6 +72,19 @@
 #include "nrf_log_default_backends.h"
 
 #include "ble_sensor_service.h"
+#include "transfer_engine.h"
+#include "sensor_frame.h"
+#include "link_model.h"
+#include "link_ctrl.h"
+#include "transfer_stats.h"
+#include "sensor_cmd.h"
+#include "bench_matrix.h"
+#include "sensor_stream.h"
+#include "frame_crc.h"
+#include "crc16.h"
+#include "cycle_counter.h"
+#include "sample_log.h"
+#include "tx_order.h"
 
 
 #define DEVICE_NAME                         "BLE5_EX"                               /**< Name of device. Will be included in the advertising data. */
@@ -78,7 +93,11 @@
 
 #define APP_ADV_DURATION                    0                                       /**< The advertising duration (180 seconds) in units of 10 milliseconds. */
 
-#define APP_BLE_CONN_CFG_TAG                1                                       /**< A tag identifying the SoftDevice BLE configuration. */
+#define APP_BLE_CONN_CFG_TAG_BULK           1                                       /**< SoftDevice connection configuration with long connection events, for transfers. */
+#define APP_BLE_CONN_CFG_TAG_LOW_POWER      2                                       /**< SoftDevice connection configuration with short connection events, for idle links. */
+#define APP_GAP_EVENT_LENGTH_BULK           NRF_SDH_BLE_GAP_EVENT_LENGTH            /**< Connection event length of the bulk profile (in 1.25 ms units). */
+#define APP_GAP_EVENT_LENGTH_LOW_POWER      BLE_GAP_EVENT_LENGTH_DEFAULT            /**< Connection event length of the low-power profile (in 1.25 ms units). */
+#define APP_CONN_EVT_EXT_ENABLED            1                                       /**< Let connection events run past their length while there is data to send. */
 #define APP_BLE_OBSERVER_PRIO               3                                       /**< Application's BLE observer priority. You shouldn't need to modify this value. */
 
 #define MIN_CONN_INTERVAL                   MSEC_TO_UNITS(11.25, UNIT_1_25_MS)      /**< Minimum acceptable connection interval (0.4 seconds). */
@@ -90,11 +109,62 @@
 #define NEXT_CONN_PARAMS_UPDATE_DELAY       APP_TIMER_TICKS(30000)                  /**< Time between each call to sd_ble_gap_conn_param_update after the first call (30 seconds). */
 #define MAX_CONN_PARAMS_UPDATE_COUNT        3                                       /**< Number of attempts before giving up the connection parameter negotiation. */
 
+#define BULK_MIN_CONN_INTERVAL              MSEC_TO_UNITS(7.5, UNIT_1_25_MS)        /**< Minimum connection interval while a transfer runs (7.5 ms). */
+#define BULK_MAX_CONN_INTERVAL              MSEC_TO_UNITS(15, UNIT_1_25_MS)         /**< Maximum connection interval while a transfer runs (15 ms). */
+#define BULK_SLAVE_LATENCY                  0                                       /**< Slave latency while a transfer runs, every event is used. */
+#define IDLE_MIN_CONN_INTERVAL              MSEC_TO_UNITS(100, UNIT_1_25_MS)        /**< Minimum connection interval between transfers (100 ms). */
+#define IDLE_MAX_CONN_INTERVAL              MSEC_TO_UNITS(200, UNIT_1_25_MS)        /**< Maximum connection interval between transfers (200 ms). */
+#define IDLE_SLAVE_LATENCY                  4                                       /**< Slave latency between transfers. */
+
+#define TRANSFER_DATA_SIZE                  (8*1048576)                             /**< Amount of data sent by one transfer (8 MB). */
+#define TRANSFER_FRAME_FLAGS                0                                       /**< Set SENSOR_FRAME_FLAG_TIMESTAMP to stamp every char2 frame, SENSOR_FRAME_FLAG_CRC to end it with a CRC16. */
+#define TRANSFER_FRAME_OVERHEAD             (sensor_frame_header_len(TRANSFER_FRAME_FLAGS) + ((TRANSFER_FRAME_FLAGS & SENSOR_FRAME_FLAG_CRC) ? SENSOR_FRAME_CRC_LEN : 0))  /**< Bytes of every char2 frame that are not data. */
+#ifndef APP_CRC_BENCHMARK_ENABLED
+#define APP_CRC_BENCHMARK_ENABLED           0                                       /**< Set to 1 to time the CRC kernels at start up, it delays advertising. */
+#endif
+#define CRC_BENCH_LEN                       244                                     /**< Block the CRC kernels are timed on at start up, one frame of data (in bytes). */
+#define CRC_BENCH_ROUNDS                    64                                      /**< Number of times the block is run through each kernel. */
+#define SWEEP_DATA_SIZE                     (512*1024)                              /**< Amount of data sent for every queue depth of a sweep (512 kB). */
+#define APP_TIMER_TICKS_PER_SEC             (APP_TIMER_CLOCK_FREQ / (APP_TIMER_CONFIG_RTC_FREQUENCY + 1))  /**< app_timer counter frequency (in Hz). */
+
+#ifndef APP_HVN_TX_QUEUE_SIZE
+#define APP_HVN_TX_QUEUE_SIZE               8                                       /**< SoftDevice HVN TX queue depth of the bulk connection profile. Can be overridden in the preprocessor definitions. */
+#endif
+#define APP_HVN_TX_QUEUE_SIZE_LOW_POWER     2                                       /**< SoftDevice HVN TX queue depth of the low-power connection profile, transfers still run on it but slower. */
+
+#define RATE_TIMER_INTERVAL_MS              10                                      /**< Credit period of rate limited transfers (10 ms). */
+#define RATE_BURST_PERIODS                  4                                       /**< Unused credit kept by a rate limited transfer (in credit periods). */
+
+#define RELIABLE_WINDOW_FRAMES              64                                      /**< Frames a reliable transfer may send ahead of the first unacknowledged one. */
+#define RELIABLE_ACK_TIMEOUT_MS             1000                                    /**< Time without an acknowledgement before the oldest frame is sent again (1 s). */
+
+#define STREAM_BACKLOG_HIGH_MS              200                                     /**< Backlog drain time that slows the stream down (200 ms). */
+#define STREAM_BACKLOG_LOW_MS               50                                      /**< Backlog drain time that brings the stream back to full rate (50 ms). */
+
+#define BENCH_DATA_SIZE                     (16*1024)                               /**< Amount of data sent for every benchmark cell (16 kB). */
+#define BENCH_SETTLE_MS                     1500                                    /**< Time given to the link procedures of a cell before it is measured (1.5 s). */
+#define BENCH_SIM_STEP_MS                   20                                      /**< Time between two simulated cells, paces the result notifications (20 ms). */
+
+#define PEER_CONN_PARAMS_RETRY_MS           500                                     /**< Time before the stored connection parameters are asked for again after NRF_ERROR_BUSY (0.5 s). */
+#define PEER_CONN_PARAMS_RETRIES_MAX        10                                      /**< Requests refused with NRF_ERROR_BUSY before the stored connection parameters are given up. */
+
+#define SEC_PARAM_BOND                      1                                       /**< Perform bonding. */
+#define SEC_PARAM_MITM                      0                                       /**< Man In The Middle protection not required. */
+#define SEC_PARAM_LESC                      0                                       /**< LE Secure Connections not enabled, see @ref peer_manager_init. */
+#define SEC_PARAM_KEYPRESS                  0                                       /**< Keypress notifications not enabled. */
+#define SEC_PARAM_IO_CAPABILITIES           BLE_GAP_IO_CAPS_NONE                    /**< No I/O capabilities. */
+#define SEC_PARAM_OOB                       0                                       /**< Out Of Band data not available. */
+#define SEC_PARAM_MIN_KEY_SIZE              16                                      /**< Minimum encryption key size, no shortened keys. */
+#define SEC_PARAM_MAX_KEY_SIZE              16                                      /**< Maximum encryption key size. */
+
 #define DEAD_BEEF                           0xDEADBEEF                              /**< Value used as error code on stack dump, can be used to identify stack location on stack unwind. */
 
 
 APP_TIMER_DEF(m_idle_timer_id);                                                 /**< IDLE timer. */
-
+APP_TIMER_DEF(m_rate_timer_id);                                                 /**< Credit timer of rate limited transfers. */
+APP_TIMER_DEF(m_bench_timer_id);                                                /**< Benchmark cell timer. */
+APP_TIMER_DEF(m_ack_timer_id);                                                  /**< Acknowledgement timer of reliable transfers. */
+APP_TIMER_DEF(m_peer_conn_params_timer_id);                                     /**< Retry timer of the stored connection parameter request. */
 
 BLE_BAS_DEF(m_bas);                                                             /**< Structure used to identify the battery service. */
 NRF_BLE_GATT_DEF(m_gatt);                                                       /**< GATT module instance. */
@@ -104,6 +174,120 @@ BLE_SENSOR_SERVICE_DEF(m_sensor_service, NRF_SDH_BLE_TOTAL_LINK_COUNT);
 
 static uint16_t m_conn_handle         = BLE_CONN_HANDLE_INVALID;                       /**< Handle of the current connection. */
 static uint16_t m_ble_sensor_service_max_data_len = BLE_GATT_ATT_MTU_DEFAULT - 3;      /**< Maximum length of data (in bytes) that can be transmitted to the peer by the Nordic UART service module. */
+static uint16_t m_conn_interval       = MIN_CONN_INTERVAL;                              /**< Connection interval of the current connection (in 1.25 ms units). */
+static bool     m_transfer_pending    = false;                                          /**< A transfer is waiting for the link to settle. */
+static uint32_t m_transfer_length     = TRANSFER_DATA_SIZE;                             /**< Payload of the current or pending transfer (in bytes), 0 to stream until stopped. */
+static uint16_t m_transfer_rate_kbps  = 0;                                              /**< Target rate of the current or pending transfer (in kbit/s), 0 for no limit. */
+static transfer_engine_t m_transfer_engine;                                            /**< Event-driven notification transfer engine. */
+
+static uint8_t  m_sweep_queue_limit   = 0;                                              /**< Queue depth of the running sweep step, 0 if no sweep is running. */
+static uint16_t m_packet_size_limit   = 0;                                              /**< Largest char2 notification (in bytes), 0 for no limit below the ATT MTU. */
+
+/**@brief Benchmark matrix axes. */
+static uint16_t const m_bench_conn_intervals[] =
+{
+    MSEC_TO_UNITS(7.5, UNIT_1_25_MS), MSEC_TO_UNITS(15, UNIT_1_25_MS), MSEC_TO_UNITS(30, UNIT_1_25_MS), MSEC_TO_UNITS(50, UNIT_1_25_MS)
+};
+static uint8_t const  m_bench_phys[]           = {BLE_GAP_PHY_1MBPS, BLE_GAP_PHY_2MBPS};
+static uint16_t const m_bench_att_mtus[]       = {BLE_GATT_ATT_MTU_DEFAULT, 185, NRF_SDH_BLE_GATT_MAX_MTU_SIZE};
+static uint8_t const  m_bench_data_lengths[]   = {BLE_GAP_DATA_LENGTH_DEFAULT, NRF_SDH_BLE_GAP_DATA_LENGTH};
+static uint8_t const  m_bench_queue_sizes[]    = {1, 4, APP_HVN_TX_QUEUE_SIZE};
+
+static bench_matrix_axes_t const m_bench_axes =
+{
+    .p_conn_intervals    = m_bench_conn_intervals,
+    .conn_interval_count = ARRAY_SIZE(m_bench_conn_intervals),
+    .p_phys              = m_bench_phys,
+    .phy_count           = ARRAY_SIZE(m_bench_phys),
+    .p_att_mtus          = m_bench_att_mtus,
+    .att_mtu_count       = ARRAY_SIZE(m_bench_att_mtus),
+    .p_data_lengths      = m_bench_data_lengths,
+    .data_length_count   = ARRAY_SIZE(m_bench_data_lengths),
+    .p_queue_sizes       = m_bench_queue_sizes,
+    .queue_size_count    = ARRAY_SIZE(m_bench_queue_sizes),
+};
+
+/**@brief Sources of the notifications in the HVN TX queue. */
+typedef enum
+{
+    APP_TX_OWNER_ENGINE,            /**< Packets of the transfer engine. */
+    APP_TX_OWNER_STREAM,            /**< Frames of the sensor stream. */
+    APP_TX_OWNER_LOG,               /**< Records of the sample log, sent from flash. */
+    APP_TX_OWNER_RESULT,            /**< Benchmark results on char3. */
+} app_tx_owner_t;
+
+static tx_order_t     m_tx_order;                                                      /**< Source of every notification in the HVN TX queue, in queue order. */
+
+static bench_matrix_t m_bench;                                                         /**< Benchmark matrix runner. */
+static bool           m_bench_simulated   = false;                                     /**< The running benchmark uses the link model instead of the radio. */
+static uint32_t       m_bench_data_size   = BENCH_DATA_SIZE;                           /**< Payload of every benchmark cell (in bytes). */
+
+/**@brief Connection profiles, one SoftDevice connection configuration each. */
+typedef enum
+{
+    APP_CONN_PROFILE_BULK,          /**< Long connection events for the highest throughput. */
+    APP_CONN_PROFILE_LOW_POWER,     /**< Short connection events to keep the radio off between packets. */
+    APP_CONN_PROFILE_COUNT
+} app_conn_profile_t;
+
+typedef struct
+{
+    uint8_t      conn_cfg_tag;      /**< SoftDevice connection configuration tag. */
+    uint16_t     event_length;      /**< GAP event length (in 1.25 ms units). */
+    uint8_t      hvn_tx_queue_size; /**< HVN TX queue depth. */
+    char const * p_name;            /**< Name used in logs. */
+} app_conn_profile_cfg_t;
+
+static app_conn_profile_cfg_t const m_conn_profiles[APP_CONN_PROFILE_COUNT] =
+{
+    [APP_CONN_PROFILE_BULK]      = {APP_BLE_CONN_CFG_TAG_BULK,      APP_GAP_EVENT_LENGTH_BULK,      APP_HVN_TX_QUEUE_SIZE,           "bulk"},
+    [APP_CONN_PROFILE_LOW_POWER] = {APP_BLE_CONN_CFG_TAG_LOW_POWER, APP_GAP_EVENT_LENGTH_LOW_POWER, APP_HVN_TX_QUEUE_SIZE_LOW_POWER, "low-power"},
+};
+
+static app_conn_profile_t m_conn_profile_next = APP_CONN_PROFILE_BULK;                 /**< Profile the next connection is set up with. */
+static app_conn_profile_t m_conn_profile      = APP_CONN_PROFILE_BULK;                 /**< Profile of the current connection. */
+static bool               m_conn_evt_ext      = APP_CONN_EVT_EXT_ENABLED;              /**< Connection event extension is enabled. */
+
+/**@brief Connection parameter profiles requested by the application. */
+typedef enum
+{
+    CONN_PARAMS_PROFILE_DEFAULT,    /**< PPCP set by gap_params_init(). */
+    CONN_PARAMS_PROFILE_BULK,       /**< Short interval, no latency, for transfers. */
+    CONN_PARAMS_PROFILE_IDLE,       /**< Long interval, high latency, between transfers. */
+    CONN_PARAMS_PROFILE_FIXED,      /**< One interval, no latency, set by the benchmark. */
+} conn_params_profile_t;
+
+static conn_params_profile_t m_conn_params_profile = CONN_PARAMS_PROFILE_DEFAULT;      /**< Profile last requested on the current connection. */
+
+/**@brief Link parameters kept for every bonded peer, as its Peer Manager application data. */
+typedef struct
+{
+    link_ctrl_params_t link;                /**< PHY, ATT MTU and data length the last link settled on. */
+    uint16_t           conn_interval;       /**< Connection interval last granted outside the idle profile (in 1.25 ms units), 0 if none. */
+    uint16_t           slave_latency;       /**< Slave latency granted with it. */
+    uint16_t           conn_sup_timeout;    /**< Supervision timeout granted with it (in 10 ms units). */
+    uint16_t           reserved;            /**< Keeps the size a multiple of a word, 0. */
+} peer_link_params_t;
+
+__ALIGN(4) static peer_link_params_t m_peer_link_params;                                /**< Link parameters of the connected peer. */
+__ALIGN(4) static peer_link_params_t m_peer_link_params_flash;                          /**< Copy Peer Manager stores from, left alone until the write has ended. */
+static bool    m_peer_link_params_stored        = false;                                /**< @ref m_peer_link_params is what the peer has in flash, or is being written. */
+static bool    m_peer_link_params_store_pending = false;                                /**< A write from @ref m_peer_link_params_flash has not ended yet. */
+static bool    m_peer_conn_params_pending       = false;                                /**< The stored connection parameters are still to be asked for on this link. */
+static uint8_t m_peer_conn_params_retries;                                              /**< Stored connection parameter requests refused with NRF_ERROR_BUSY on this link. */
+
+static uint32_t m_conn_ticks;                                                           /**< app_timer counter when the link came up. */
+static bool     m_first_tx_pending = false;                                             /**< No notification has completed on the link yet. */
+static bool     m_cccd_restored;                                                        /**< The link came up with notifications enabled from the bond. */
+
+static void transfer_start(uint32_t data_size, uint16_t rate_kbps);
+static void transfer_cmd_handle(sensor_cmd_t const * p_cmd);
+static void bench_timeout_handler(void * p_context);
+static void bench_end(void);
+static void stream_link_lost(void);
+static void stream_backlog_handle(ble_sensor_service_evt_t const * p_evt);
+static void conn_params_profile_request(conn_params_profile_t profile);
+static void peer_conn_params_timeout_handler(void * p_context);
 
 /* SENSOR SERVICE HANDLER */
 volatile typedef struct sensor_service_status_s
@@ -113,16 +297,65 @@ volatile typedef struct sensor_service_status_s
 } sensor_service_status_t;
 
 sensor_service_status_t sensor_service_status = {0, 0};
+
+
+/**@brief Function for starting to send once the central has notifications enabled.
+ *
+ * @details What the sample log holds goes first, at the bulk connection parameters.
+ */
+static void sensor_comm_start(void)
+{
+    if (sample_log_unsent_count() > 0)
+    {
+        NRF_LOG_INFO("Sample log: %d frames to send.", sample_log_unsent_count());
+        conn_params_profile_request(CONN_PARAMS_PROFILE_BULK);
+        sensor_stream_drain();
+    }
+}
+
+
+/**@brief Function for reporting the time from connection to the first completed notification.
+ *
+ * @details With a bonded central that left notifications enabled, nothing is discovered or written
+ *          before data flows, this is the latency that saves.
+ */
+static void first_tx_latency_report(void)
+{
+    uint32_t     ticks;
+    pm_peer_id_t peer_id = PM_PEER_ID_INVALID;
+
+    if (!m_first_tx_pending)
+    {
+        return;
+    }
+
+    m_first_tx_pending = false;
+    ticks              = (app_timer_cnt_get() - m_conn_ticks) & TRANSFER_STATS_COUNTER_MASK;
+
+    (void)pm_peer_id_get(m_conn_handle, &peer_id);
+
+    NRF_LOG_INFO("Connection to first notification: %d ms, bonded %d, CCCD restored %d.",
+                 (uint32_t)(((uint64_t)ticks * 1000) / APP_TIMER_TICKS_PER_SEC),
+                 (peer_id != PM_PEER_ID_INVALID),
+                 m_cccd_restored);
+}
+
+
 static void sensor_service_data_handler(ble_sensor_service_evt_t * p_evt)
 {
     if (p_evt->type == BLE_SENSOR_SERVICE_EVT_DATA_RECEIVED_CHAR1)
     {
         NRF_LOG_INFO("SENSOR CHAR 1");
 
-        if(p_evt->params.received_data.p_data[0] == 0x01 && sensor_service_status.is_notification_enabled == 1
-            && sensor_service_status.is_transfer_started == 0 ){
-          
-          sensor_service_status.is_transfer_started = 1;
+        sensor_cmd_t cmd;
+
+        if (sensor_cmd_decode(p_evt->params.received_data.p_data, p_evt->params.received_data.length, &cmd))
+        {
+            transfer_cmd_handle(&cmd);
+        }
+        else
+        {
+            NRF_LOG_WARNING("Unknown command, %d bytes.", p_evt->params.received_data.length);
         }
 
         NRF_LOG_FLUSH();
@@ -138,6 +371,13 @@ static void sensor_service_data_handler(ble_sensor_service_evt_t * p_evt)
         NRF_LOG_FLUSH();
 
         sensor_service_status.is_notification_enabled = true;
+
+        // A CCCD restored from the bond is reported before BLE_GAP_EVT_CONNECTED reaches
+        // ble_evt_handler, sending starts from there then.
+        if (m_conn_handle != BLE_CONN_HANDLE_INVALID)
+        {
+            sensor_comm_start();
+        }
     }
     else if(p_evt->type == BLE_SENSOR_SERVICE_EVT_COMM_STOPPED)
     {
@@ -145,9 +385,26 @@ static void sensor_service_data_handler(ble_sensor_service_evt_t * p_evt)
        NRF_LOG_FLUSH();
 
        sensor_service_status.is_notification_enabled = false;
+       stream_link_lost();
+       transfer_engine_abort(&m_transfer_engine);
     }
     else if(p_evt->type == BLE_SENSOR_SERVICE_EVT_TRANSMIT_RDY)
     {
+        uint16_t counts[TX_ORDER_OWNERS_MAX];
+
+        first_tx_latency_report();
+
+        // Every source only gets its own completions, a log record is not released for a
+        // stream frame queued ahead of it, nor a transfer packet for a log record.
+        tx_order_complete(&m_tx_order, p_evt->params.tx_complete.count, counts);
+        sample_log_on_tx_complete(counts[APP_TX_OWNER_LOG]);
+        transfer_engine_on_tx_complete(&m_transfer_engine, (uint8_t)counts[APP_TX_OWNER_ENGINE]);
+        sensor_stream_drain();
+    }
+    else if((p_evt->type == BLE_SENSOR_SERVICE_EVT_BACKLOG_HIGH) ||
+            (p_evt->type == BLE_SENSOR_SERVICE_EVT_BACKLOG_LOW))
+    {
+        stream_backlog_handle(p_evt);
     } 
 };
 /* End of Sensor Service */
@@ -203,6 +460,48 @@ static void battery_level_update(uint8_t battery_level)
 static void idle_timeout_handler(void * p_context)
 {}
 
+
+/**@brief Function for giving a rate limited transfer the credit of one period.
+ *
+ * @details Runs at the app_timer interrupt priority, the same as SoftDevice events, so it never
+ *          preempts the transfer engine.
+ */
+static void rate_timeout_handler(void * p_context)
+{
+    // kbit/s to bytes per period: 1 kbit/s is 125 bytes/s.
+    uint32_t bytes = ((uint32_t)m_transfer_rate_kbps * 125 * RATE_TIMER_INTERVAL_MS) / 1000;
+
+    transfer_engine_credit_add(&m_transfer_engine, bytes, bytes * RATE_BURST_PERIODS);
+}
+
+/**@brief Function for handling a reliable transfer that has not been acknowledged for a while.
+ */
+static void ack_timeout_handler(void * p_context)
+{
+    ret_code_t err_code;
+
+    transfer_engine_ack_timeout(&m_transfer_engine);
+
+    if (transfer_engine_is_running(&m_transfer_engine))
+    {
+        err_code = app_timer_start(m_ack_timer_id, APP_TIMER_TICKS(RELIABLE_ACK_TIMEOUT_MS), NULL);
+        APP_ERROR_CHECK(err_code);
+    }
+}
+
+
+/**@brief Function for restarting the acknowledgement timer of a reliable transfer.
+ */
+static void ack_timer_restart(void)
+{
+    ret_code_t err_code;
+
+    (void)app_timer_stop(m_ack_timer_id);
+
+    err_code = app_timer_start(m_ack_timer_id, APP_TIMER_TICKS(RELIABLE_ACK_TIMEOUT_MS), NULL);
+    APP_ERROR_CHECK(err_code);
+}
+
 /**@brief Function for the Timer initialization.
  *
  * @details Initializes the timer module. This creates and starts application timers.
@@ -221,6 +520,26 @@ static void timers_init(void)
                             idle_timeout_handler);
     APP_ERROR_CHECK(err_code);
 
+    err_code = app_timer_create(&m_rate_timer_id,
+                                APP_TIMER_MODE_REPEATED,
+                                rate_timeout_handler);
+    APP_ERROR_CHECK(err_code);
+
+    err_code = app_timer_create(&m_bench_timer_id,
+                                APP_TIMER_MODE_SINGLE_SHOT,
+                                bench_timeout_handler);
+    APP_ERROR_CHECK(err_code);
+
+    err_code = app_timer_create(&m_ack_timer_id,
+                                APP_TIMER_MODE_SINGLE_SHOT,
+                                ack_timeout_handler);
+    APP_ERROR_CHECK(err_code);
+
+    err_code = app_timer_create(&m_peer_conn_params_timer_id,
+                                APP_TIMER_MODE_SINGLE_SHOT,
+                                peer_conn_params_timeout_handler);
+    APP_ERROR_CHECK(err_code);
+
     // Start application timers.
     err_code = app_timer_start(m_idle_timer_id, APP_TIMER_TICKS(60*1000), NULL);
     APP_ERROR_CHECK(err_code);
@@ -261,6 +580,8 @@ static void gap_params_init(void)
  */
 static void gatt_evt_handler(nrf_ble_gatt_t * p_gatt, nrf_ble_gatt_evt_t const * p_evt)
 {
+    link_ctrl_on_gatt_evt(p_evt);
+
     if (p_evt->evt_id == NRF_BLE_GATT_EVT_ATT_MTU_UPDATED)
     {
 //        NRF_LOG_INFO("GATT ATT MTU on connection 0x%x changed to %d.",
@@ -269,6 +590,11 @@ static void gatt_evt_handler(nrf_ble_gatt_t * p_gatt, nrf_ble_gatt_evt_t const *
         
         m_ble_sensor_service_max_data_len = p_evt->params.att_mtu_effective - OPCODE_LENGTH - HANDLE_LENGTH;
         NRF_LOG_INFO("ATT MTU size is %d.", m_ble_sensor_service_max_data_len);
+
+        sensor_stream_frame_len_set(m_ble_sensor_service_max_data_len);
+
+        // Log records longer than the default MTU wait for this.
+        sensor_stream_drain();
     }
 }
 
@@ -342,10 +668,13 @@ static void services_init(void)
     ble_sensor_service_init_t sensor_service_init;
     memset(&sensor_service_init, 0, sizeof(sensor_service_init));
 
-    uint8_t init_value_1 = 0, init_value_2 = 0;
-    sensor_service_init.data_handler = sensor_service_data_handler;
+    uint8_t init_value_1 = 0, init_value_2 = 0, init_value_3 = 0;
+    sensor_service_init.data_handler    = sensor_service_data_handler;
+    sensor_service_init.backlog_high_ms = STREAM_BACKLOG_HIGH_MS;
+    sensor_service_init.backlog_low_ms  = STREAM_BACKLOG_LOW_MS;
     m_sensor_service.init_value_1 = &init_value_1;
     m_sensor_service.init_value_2 = &init_value_2; 
+    m_sensor_service.init_value_3 = &init_value_3;
 
     err_code = ble_sensor_service_init(&m_sensor_service, &sensor_service_init);
     APP_ERROR_CHECK(err_code);
@@ -356,20 +685,17 @@ static void services_init(void)
  *
  * @details This function will be called for all events in the Connection Parameters Module which
  *          are passed to the application.
- *          @note All this function does is to disconnect. This could have been done by simply
- *                setting the disconnect_on_fail config parameter, but instead we use the event
- *                handler mechanism to demonstrate its use.
+ *          @note A failed negotiation does not disconnect, disconnect_on_fail is false. The link
+ *                stays up on the parameters the central chose and the failure is only logged.
  *
  * @param[in] p_evt  Event received from the Connection Parameters Module.
  */
 static void on_conn_params_evt(ble_conn_params_evt_t * p_evt)
 {
-    ret_code_t err_code;
-
     if (p_evt->evt_type == BLE_CONN_PARAMS_EVT_FAILED)
     {
-        err_code = sd_ble_gap_disconnect(m_conn_handle, BLE_HCI_CONN_INTERVAL_UNACCEPTABLE);
-        APP_ERROR_CHECK(err_code);
+        // The central keeps its own parameters, transfers still work, only slower or costlier.
+        NRF_LOG_WARNING("Connection parameters rejected, keeping %d x 1.25 ms interval.", m_conn_interval);
     }
 }
 
@@ -380,6 +706,13 @@ static void on_conn_params_evt(ble_conn_params_evt_t * p_evt)
  */
 static void conn_params_error_handler(uint32_t nrf_error)
 {
+    // Another link layer procedure, e.g. a PHY update, is running. The module tries again later.
+    if ((nrf_error == NRF_ERROR_BUSY) || (nrf_error == NRF_ERROR_INVALID_STATE))
+    {
+        NRF_LOG_WARNING("Connection parameter update deferred, error 0x%x.", nrf_error);
+        return;
+    }
+
     APP_ERROR_HANDLER(nrf_error);
 }
 
@@ -406,195 +739,1610 @@ static void conn_params_init(void)
 }
 
 
-/**@brief Function for putting the chip into sleep mode.
+/**@brief Function for requesting a connection parameter profile on the current connection.
  *
- * @note This function will not return.
+ * @details The profile becomes the preferred parameters of the Connection Parameters module,
+ *          which keeps negotiating them. A rejection is reported as @ref BLE_CONN_PARAMS_EVT_FAILED
+ *          and never drops the link.
+ *
+ * @param[in] profile  CONN_PARAMS_PROFILE_BULK or CONN_PARAMS_PROFILE_IDLE.
  */
-static void sleep_mode_enter(void)
+static void conn_params_profile_request(conn_params_profile_t profile)
 {
-    ret_code_t err_code;
+    ret_code_t            err_code;
+    ble_gap_conn_params_t conn_params;
 
-    // Go to system-off mode (this function will not return; wakeup will cause a reset).
-    err_code = sd_power_system_off();
-    APP_ERROR_CHECK(err_code);
+    if ((m_conn_handle == BLE_CONN_HANDLE_INVALID) || (profile == m_conn_params_profile))
+    {
+        return;
+    }
+
+    memset(&conn_params, 0, sizeof(conn_params));
+    conn_params.conn_sup_timeout = CONN_SUP_TIMEOUT;
+
+    if (profile == CONN_PARAMS_PROFILE_BULK)
+    {
+        conn_params.min_conn_interval = BULK_MIN_CONN_INTERVAL;
+        conn_params.max_conn_interval = BULK_MAX_CONN_INTERVAL;
+        conn_params.slave_latency     = BULK_SLAVE_LATENCY;
+    }
+    else
+    {
+        conn_params.min_conn_interval = IDLE_MIN_CONN_INTERVAL;
+        conn_params.max_conn_interval = IDLE_MAX_CONN_INTERVAL;
+        conn_params.slave_latency     = IDLE_SLAVE_LATENCY;
+    }
+
+    err_code = ble_conn_params_change_conn_params(m_conn_handle, &conn_params);
+    if (err_code == NRF_SUCCESS)
+    {
+        m_conn_params_profile = profile;
+        NRF_LOG_INFO("Requested %s connection parameters.",
+                     (uint32_t)((profile == CONN_PARAMS_PROFILE_BULK) ? "bulk" : "idle"));
+    }
+    else
+    {
+        // The next transfer start or end asks again.
+        NRF_LOG_WARNING("Connection parameter request failed, error 0x%x.", err_code);
+    }
 }
 
 
-/**@brief Function for handling advertising events.
+/**@brief Function for requesting one fixed connection interval on the current connection.
  *
- * @details This function will be called for advertising events which are passed to the application.
+ * @details Used by the benchmark, a cell must not measure whatever interval the central picks
+ *          from a range. The interval actually in use is still reported in the result.
  *
- * @param[in] ble_adv_evt  Advertising event.
+ * @param[in] conn_interval  Connection interval (in 1.25 ms units).
  */
-static void on_adv_evt(ble_adv_evt_t ble_adv_evt)
+static void conn_params_interval_request(uint16_t conn_interval)
 {
-    ret_code_t err_code;
+    ret_code_t            err_code;
+    ble_gap_conn_params_t conn_params;
 
-    switch (ble_adv_evt)
+    if (m_conn_handle == BLE_CONN_HANDLE_INVALID)
     {
-        case BLE_ADV_EVT_FAST:
-            NRF_LOG_INFO("Fast advertising.");
-            break;
+        return;
+    }
 
-        case BLE_ADV_EVT_IDLE:
-            sleep_mode_enter();
-            break;
+    memset(&conn_params, 0, sizeof(conn_params));
+    conn_params.min_conn_interval = conn_interval;
+    conn_params.max_conn_interval = conn_interval;
+    conn_params.slave_latency     = 0;
+    conn_params.conn_sup_timeout  = CONN_SUP_TIMEOUT;
 
-        default:
-            break;
+    // Whatever the outcome, the next bulk or idle request has to go out again.
+    m_conn_params_profile = CONN_PARAMS_PROFILE_FIXED;
+
+    err_code = ble_conn_params_change_conn_params(m_conn_handle, &conn_params);
+    if (err_code != NRF_SUCCESS)
+    {
+        NRF_LOG_WARNING("Connection interval request failed, error 0x%x.", err_code);
     }
 }
 
 
-/**@brief Function for handling BLE events.
+/**@brief Function for asking for the connection parameters the connected peer granted last time.
  *
- * @param[in]   p_ble_evt   Bluetooth stack event.
- * @param[in]   p_context   Unused.
+ * @details The SoftDevice refuses the request with NRF_ERROR_BUSY while a PHY or data length
+ *          procedure runs, it is then sent again after @ref PEER_CONN_PARAMS_RETRY_MS or as soon
+ *          as @ref LINK_CTRL_EVT_PHY_UPDATED reports the end of the PHY procedure. It is dropped
+ *          once the application has asked for parameters of its own.
  */
-static void ble_evt_handler(ble_evt_t const * p_ble_evt, void * p_context)
+static void peer_conn_params_request(void)
 {
-    ret_code_t err_code;
+    ret_code_t            err_code;
+    ble_gap_conn_params_t conn_params;
 
-    switch (p_ble_evt->header.evt_id)
+    if (!m_peer_conn_params_pending || (m_conn_handle == BLE_CONN_HANDLE_INVALID))
     {
-        case BLE_GAP_EVT_CONNECTED:
-            NRF_LOG_INFO("Connected.");
-            m_conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
-            err_code = nrf_ble_qwr_conn_handle_assign(&m_qwr, m_conn_handle);
-            APP_ERROR_CHECK(err_code);
+        return;
+    }
 
-            sensor_service_status.is_notification_enabled = 0;
-            sensor_service_status.is_transfer_started = 0;
+    if (m_conn_params_profile != CONN_PARAMS_PROFILE_DEFAULT)
+    {
+        m_peer_conn_params_pending = false;
+        return;
+    }
 
-            nrf_gpio_pin_set(14);
-            break;
+    memset(&conn_params, 0, sizeof(conn_params));
+    conn_params.min_conn_interval = m_peer_link_params.conn_interval;
+    conn_params.max_conn_interval = m_peer_link_params.conn_interval;
+    conn_params.slave_latency     = m_peer_link_params.slave_latency;
+    conn_params.conn_sup_timeout  = m_peer_link_params.conn_sup_timeout;
 
-        case BLE_GAP_EVT_DISCONNECTED:
-            NRF_LOG_INFO("Disconnected, reason %d.",
-                          p_ble_evt->evt.gap_evt.params.disconnected.reason);
-            m_conn_handle = BLE_CONN_HANDLE_INVALID;
+    err_code = ble_conn_params_change_conn_params(m_conn_handle, &conn_params);
+    if (err_code == NRF_SUCCESS)
+    {
+        m_peer_conn_params_pending = false;
+        NRF_LOG_INFO("Requested stored connection parameters, %d x 1.25 ms.", conn_params.max_conn_interval);
+        return;
+    }
 
-            sensor_service_status.is_notification_enabled = 0;
-            sensor_service_status.is_transfer_started = 0;
+    if ((err_code == NRF_ERROR_BUSY) && (m_peer_conn_params_retries < PEER_CONN_PARAMS_RETRIES_MAX))
+    {
+        m_peer_conn_params_retries++;
 
-            nrf_gpio_pin_clear(14);
-            break;
+        (void)app_timer_stop(m_peer_conn_params_timer_id);
+        err_code = app_timer_start(m_peer_conn_params_timer_id, APP_TIMER_TICKS(PEER_CONN_PARAMS_RETRY_MS), NULL);
+        APP_ERROR_CHECK(err_code);
+        return;
+    }
 
-        case BLE_GAP_EVT_PHY_UPDATE_REQUEST:
-        {
-            NRF_LOG_INFO("PHY update request.");
-            ble_gap_phys_t const phys =
-            {
-                .rx_phys = BLE_GAP_PHY_AUTO,
-                .tx_phys = BLE_GAP_PHY_AUTO,
-            };
-            err_code = sd_ble_gap_phy_update(p_ble_evt->evt.gap_evt.conn_handle, &phys);
-            APP_ERROR_CHECK(err_code);
-        } break;
+    m_peer_conn_params_pending = false;
+    NRF_LOG_WARNING("Stored connection parameter request failed, error 0x%x.", err_code);
+}
 
-        case BLE_GAP_EVT_CONN_PARAM_UPDATE:        
-            NRF_LOG_INFO("Connection interval: %d ms", 1.25f * p_ble_evt->evt.gap_evt.params.conn_param_update.conn_params.min_conn_interval);
-            break; 
 
-        case BLE_GATTC_EVT_TIMEOUT:
-            // Disconnect on GATT Client timeout event.
-            NRF_LOG_DEBUG("GATT Client Timeout.");
-            err_code = sd_ble_gap_disconnect(p_ble_evt->evt.gattc_evt.conn_handle,
-                                             BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
-            APP_ERROR_CHECK(err_code);
-            break;
+/**@brief Function for handling the retry timer of the stored connection parameter request.
+ *
+ * @param[in] p_context  Unused.
+ */
+static void peer_conn_params_timeout_handler(void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
 
-        case BLE_GATTS_EVT_TIMEOUT:
-            // Disconnect on GATT Server timeout event.
-            NRF_LOG_DEBUG("GATT Server Timeout.");
-            err_code = sd_ble_gap_disconnect(p_ble_evt->evt.gatts_evt.conn_handle,
-                                             BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
-            APP_ERROR_CHECK(err_code);
-            break;
-    
-        case BLE_GAP_EVT_SEC_PARAMS_REQUEST:
-            NRF_LOG_DEBUG("BLE_GAP_EVT_SEC_PARAMS_REQUEST");
-            break;
-        
-        case BLE_GAP_EVT_AUTH_KEY_REQUEST:
-            NRF_LOG_INFO("BLE_GAP_EVT_AUTH_KEY_REQUEST");
-            break;
+    peer_conn_params_request();
+}
 
-        case BLE_GAP_EVT_LESC_DHKEY_REQUEST:
-            NRF_LOG_INFO("BLE_GAP_EVT_LESC_DHKEY_REQUEST");
-            break;
 
-         case BLE_GAP_EVT_AUTH_STATUS:
-             NRF_LOG_INFO("BLE_GAP_EVT_AUTH_STATUS: status=0x%x bond=0x%x lv4: %d kdist_own:0x%x kdist_peer:0x%x",
-                          p_ble_evt->evt.gap_evt.params.auth_status.auth_status,
-                          p_ble_evt->evt.gap_evt.params.auth_status.bonded,
-                          p_ble_evt->evt.gap_evt.params.auth_status.sm1_levels.lv4,
-                          *((uint8_t *)&p_ble_evt->evt.gap_evt.params.auth_status.kdist_own),
-                          *((uint8_t *)&p_ble_evt->evt.gap_evt.params.auth_status.kdist_peer));
-            break;
+/**@brief Function for setting up a link to a bonded peer with what its last link settled on.
+ *
+ * @details The link procedures the central left unanswered last time are not waited for. The
+ *          connection parameters it granted are asked for once the link is ready, rather than
+ *          after FIRST_CONN_PARAMS_UPDATE_DELAY, see @ref peer_conn_params_request.
+ *
+ * @param[in] conn_handle  Handle of the new connection.
+ */
+static void peer_link_params_restore(uint16_t conn_handle)
+{
+    ret_code_t   err_code;
+    pm_peer_id_t peer_id;
+    uint32_t     length = sizeof(m_peer_link_params);
 
-        default:
-            // No implementation needed.
-            break;
+    // A write still pending for the last link goes on from its own copy.
+    memset(&m_peer_link_params, 0, sizeof(m_peer_link_params));
+    m_peer_link_params_stored  = false;
+    m_peer_conn_params_pending = false;
+    m_peer_conn_params_retries = 0;
+
+    if ((pm_peer_id_get(conn_handle, &peer_id) != NRF_SUCCESS) || (peer_id == PM_PEER_ID_INVALID))
+    {
+        return;
+    }
+
+    err_code = pm_peer_data_app_data_load(peer_id, &m_peer_link_params, &length);
+    if ((err_code != NRF_SUCCESS) || (length != sizeof(m_peer_link_params)))
+    {
+        // Stored once this link has settled.
+        memset(&m_peer_link_params, 0, sizeof(m_peer_link_params));
+        return;
     }
+
+    m_peer_link_params_stored = true;
+
+    (void)link_ctrl_params_apply(conn_handle, &m_peer_link_params.link);
+
+    // The PHY and data length procedures start on this event, the request would only be refused.
+    m_peer_conn_params_pending = (m_peer_link_params.conn_interval != 0);
+
+    NRF_LOG_INFO("Peer %d: asking for %d x 1.25 ms, last ATT MTU %d, data length %d.",
+                 peer_id,
+                 m_peer_link_params.conn_interval,
+                 m_peer_link_params.link.att_mtu,
+                 m_peer_link_params.link.data_length);
 }
 
 
-/**@brief Function for initializing the BLE stack.
+/**@brief Function for writing @ref m_peer_link_params to the flash of the connected peer.
  *
- * @details Initializes the SoftDevice and the BLE event interrupt.
+ * @details Peer Manager writes from @ref m_peer_link_params_flash without copying it, so one write
+ *          runs at a time. Changes made meanwhile are written when it ends, see
+ *          @ref peer_link_params_on_pm_evt.
  */
-static void ble_stack_init(void)
+static void peer_link_params_write(void)
 {
-    ret_code_t err_code;
+    ret_code_t   err_code;
+    pm_peer_id_t peer_id;
 
-    err_code = nrf_sdh_enable_request();
-    APP_ERROR_CHECK(err_code);
+    if (m_peer_link_params_stored || m_peer_link_params_store_pending)
+    {
+        return;
+    }
 
-    // Configure the BLE stack using the default settings.
-    // Fetch the start address of the application RAM.
-    uint32_t ram_start = 0;
-    err_code = nrf_sdh_ble_default_cfg_set(APP_BLE_CONN_CFG_TAG, &ram_start);
-    APP_ERROR_CHECK(err_code);
+    if ((pm_peer_id_get(m_conn_handle, &peer_id) != NRF_SUCCESS) || (peer_id == PM_PEER_ID_INVALID))
+    {
+        return;
+    }
 
-    // Enable BLE stack.
-    err_code = nrf_sdh_ble_enable(&ram_start);
-    APP_ERROR_CHECK(err_code);
+    m_peer_link_params_flash = m_peer_link_params;
 
-    // Register a handler for BLE events.
-    NRF_SDH_BLE_OBSERVER(m_ble_observer, APP_BLE_OBSERVER_PRIO, ble_evt_handler, NULL);
+    err_code = pm_peer_data_app_data_store(peer_id, &m_peer_link_params_flash, sizeof(m_peer_link_params_flash), NULL);
+    if (err_code == NRF_SUCCESS)
+    {
+        m_peer_link_params_stored        = true;
+        m_peer_link_params_store_pending = true;
+    }
+    else
+    {
+        NRF_LOG_WARNING("Link parameters of peer %d not stored, error 0x%x.", peer_id, err_code);
+    }
 }
 
 
-/**@brief Function for initializing the Advertising functionality.
+/**@brief Function for handling the end of a link parameter write.
+ *
+ * @param[in] p_evt  Peer Manager event.
  */
-static void advertising_init(void)
+static void peer_link_params_on_pm_evt(pm_evt_t const * p_evt)
 {
-    ret_code_t             err_code;
-    ble_advertising_init_t init;
+    if ((p_evt->evt_id == PM_EVT_PEER_DATA_UPDATE_SUCCEEDED) &&
+        (p_evt->params.peer_data_update_succeeded.data_id == PM_PEER_DATA_ID_APPLICATION))
+    {
+        m_peer_link_params_store_pending = false;
 
-    memset(&init, 0, sizeof(init));
+        if ((p_evt->conn_handle == m_conn_handle) &&
+            (memcmp(&m_peer_link_params_flash, &m_peer_link_params, sizeof(m_peer_link_params)) != 0))
+        {
+            m_peer_link_params_stored = false;
+            peer_link_params_write();
+        }
+    }
+    else if ((p_evt->evt_id == PM_EVT_PEER_DATA_UPDATE_FAILED) &&
+             (p_evt->params.peer_data_update_failed.data_id == PM_PEER_DATA_ID_APPLICATION))
+    {
+        // Written again on the next change.
+        m_peer_link_params_store_pending = false;
+        m_peer_link_params_stored        = false;
+        NRF_LOG_WARNING("Link parameters of peer %d not stored, error 0x%x.",
+                        p_evt->peer_id, p_evt->params.peer_data_update_failed.error);
+    }
+}
 
-    init.advdata.name_type               = BLE_ADVDATA_FULL_NAME;
-    init.advdata.flags                   = BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE;
 
-    init.config.ble_adv_fast_enabled  = true;
-    init.config.ble_adv_fast_interval = APP_ADV_INTERVAL;
+/**@brief Function for storing the link parameters of the connected peer when they have changed.
+ *
+ * @details Only bonded peers have a place to store them. Nothing is stored while the benchmark
+ *          runs, its cells force the PHY and the connection interval.
+ *
+ * @param[in] p_conn_params  Connection parameters just granted, NULL to keep the last ones.
+ */
+static void peer_link_params_store(ble_gap_conn_params_t const * p_conn_params)
+{
+    peer_link_params_t params = m_peer_link_params;
+
+    if (m_bench.is_running)
+    {
+        return;
+    }
+
+    (void)link_ctrl_params_get(m_conn_handle, &params.link);
+
+    if (p_conn_params != NULL)
+    {
+        params.conn_interval    = p_conn_params->max_conn_interval;
+        params.slave_latency    = p_conn_params->slave_latency;
+        params.conn_sup_timeout = p_conn_params->conn_sup_timeout;
+    }
+
+    if (m_peer_link_params_stored && (memcmp(&params, &m_peer_link_params, sizeof(params)) == 0))
+    {
+        return;
+    }
+
+    m_peer_link_params        = params;
+    m_peer_link_params_stored = false;
+
+    peer_link_params_write();
+}
+
+
+/**@brief Function for handling Peer Manager events.
+ *
+ * @param[in] p_evt  Peer Manager event.
+ */
+static void pm_evt_handler(pm_evt_t const * p_evt)
+{
+    pm_handler_on_pm_evt(p_evt);
+    pm_handler_disconnect_on_sec_failure(p_evt);
+    pm_handler_flash_clean(p_evt);
+
+    peer_link_params_on_pm_evt(p_evt);
+
+    if ((p_evt->evt_id == PM_EVT_CONN_SEC_SUCCEEDED) &&
+        (p_evt->params.conn_sec_succeeded.procedure == PM_CONN_SEC_PROCEDURE_BONDING) &&
+        (p_evt->conn_handle == m_conn_handle))
+    {
+        // A new bond, the link may have settled already.
+        peer_link_params_store(NULL);
+    }
+}
+
+
+/**@brief Function for initializing the Peer Manager, bonds are kept in FDS.
+ *
+ * @details Pairing is legacy Just Works. The bond only lets a central skip the link parameter
+ *          negotiation and keep its CCCDs, the test data is not confidential, and without I/O
+ *          there is no MITM protection with LE Secure Connections either. LESC would only add
+ *          protection against a passive listener at the cost of nrf_crypto and its ECC backend.
+ *          Full size keys are still required.
+ */
+static void peer_manager_init(void)
+{
+    ret_code_t           err_code;
+    ble_gap_sec_params_t sec_param;
+
+    err_code = pm_init();
+    APP_ERROR_CHECK(err_code);
+
+    memset(&sec_param, 0, sizeof(ble_gap_sec_params_t));
+
+    // Security parameters to be used for all security procedures.
+    sec_param.bond           = SEC_PARAM_BOND;
+    sec_param.mitm           = SEC_PARAM_MITM;
+    sec_param.lesc           = SEC_PARAM_LESC;
+    sec_param.keypress       = SEC_PARAM_KEYPRESS;
+    sec_param.io_caps        = SEC_PARAM_IO_CAPABILITIES;
+    sec_param.oob            = SEC_PARAM_OOB;
+    sec_param.min_key_size   = SEC_PARAM_MIN_KEY_SIZE;
+    sec_param.max_key_size   = SEC_PARAM_MAX_KEY_SIZE;
+    sec_param.kdist_own.enc  = 1;
+    sec_param.kdist_own.id   = 1;
+    sec_param.kdist_peer.enc = 1;
+    sec_param.kdist_peer.id  = 1;
+
+    err_code = pm_sec_params_set(&sec_param);
+    APP_ERROR_CHECK(err_code);
+
+    err_code = pm_register(pm_evt_handler);
+    APP_ERROR_CHECK(err_code);
+}
+
+
+/**@brief Function for putting the chip into sleep mode.
+ *
+ * @note This function will not return.
+ */
+static void sleep_mode_enter(void)
+{
+    ret_code_t err_code;
+
+    // Go to system-off mode (this function will not return; wakeup will cause a reset).
+    err_code = sd_power_system_off();
+    APP_ERROR_CHECK(err_code);
+}
+
+
+/**@brief Function for handling advertising events.
+ *
+ * @details This function will be called for advertising events which are passed to the application.
+ *
+ * @param[in] ble_adv_evt  Advertising event.
+ */
+static void on_adv_evt(ble_adv_evt_t ble_adv_evt)
+{
+    ret_code_t err_code;
+
+    switch (ble_adv_evt)
+    {
+        case BLE_ADV_EVT_FAST:
+            NRF_LOG_INFO("Fast advertising.");
+            break;
+
+        case BLE_ADV_EVT_IDLE:
+            sleep_mode_enter();
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+/**@brief Function for handling BLE events.
+ *
+ * @param[in]   p_ble_evt   Bluetooth stack event.
+ * @param[in]   p_context   Unused.
+ */
+static void ble_evt_handler(ble_evt_t const * p_ble_evt, void * p_context)
+{
+    ret_code_t err_code;
+
+    pm_handler_secure_on_connection(p_ble_evt);
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            NRF_LOG_INFO("Connected.");
+            m_conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+            m_conn_interval = p_ble_evt->evt.gap_evt.params.connected.conn_params.max_conn_interval;
+            m_conn_profile        = m_conn_profile_next;
+            m_conn_params_profile = CONN_PARAMS_PROFILE_DEFAULT;
+            NRF_LOG_INFO("Connection profile: %s.", (uint32_t)m_conn_profiles[m_conn_profile].p_name);
+            err_code = nrf_ble_qwr_conn_handle_assign(&m_qwr, m_conn_handle);
+            APP_ERROR_CHECK(err_code);
+
+            sensor_service_status.is_transfer_started = sensor_stream_is_running();
+
+            m_conn_ticks       = app_timer_cnt_get();
+            m_first_tx_pending = true;
+            m_cccd_restored    = sensor_service_status.is_notification_enabled;
+
+            peer_link_params_restore(m_conn_handle);
+
+            if (m_cccd_restored)
+            {
+                sensor_comm_start();
+            }
+
+            nrf_gpio_pin_set(14);
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            NRF_LOG_INFO("Disconnected, reason %d.",
+                          p_ble_evt->evt.gap_evt.params.disconnected.reason);
+            m_conn_handle = BLE_CONN_HANDLE_INVALID;
+
+            m_peer_conn_params_pending = false;
+            (void)app_timer_stop(m_peer_conn_params_timer_id);
+
+            if (m_bench.is_running)
+            {
+                bench_end();
+            }
+            stream_link_lost();
+            transfer_engine_abort(&m_transfer_engine);
+            m_transfer_pending = false;
+            m_first_tx_pending = false;
+            sensor_service_status.is_notification_enabled = 0;
+            sensor_service_status.is_transfer_started = sensor_stream_is_running();
+
+            nrf_gpio_pin_clear(14);
+            break;
+
+        case BLE_GAP_EVT_CONN_PARAM_UPDATE:        
+            m_conn_interval = p_ble_evt->evt.gap_evt.params.conn_param_update.conn_params.max_conn_interval;
+            NRF_LOG_INFO("Connection interval: %d x 1.25 ms, slave latency %d.",
+                         m_conn_interval,
+                         p_ble_evt->evt.gap_evt.params.conn_param_update.conn_params.slave_latency);
+
+            // The idle profile trades throughput for power and the benchmark forces an interval,
+            // neither is what a peer is set up with.
+            if ((m_conn_params_profile == CONN_PARAMS_PROFILE_DEFAULT) ||
+                (m_conn_params_profile == CONN_PARAMS_PROFILE_BULK))
+            {
+                peer_link_params_store(&p_ble_evt->evt.gap_evt.params.conn_param_update.conn_params);
+            }
+            break; 
+
+        case BLE_GATTC_EVT_TIMEOUT:
+            // Disconnect on GATT Client timeout event.
+            NRF_LOG_DEBUG("GATT Client Timeout.");
+            err_code = sd_ble_gap_disconnect(p_ble_evt->evt.gattc_evt.conn_handle,
+                                             BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+            APP_ERROR_CHECK(err_code);
+            break;
+
+        case BLE_GATTS_EVT_TIMEOUT:
+            // Disconnect on GATT Server timeout event.
+            NRF_LOG_DEBUG("GATT Server Timeout.");
+            err_code = sd_ble_gap_disconnect(p_ble_evt->evt.gatts_evt.conn_handle,
+                                             BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+            APP_ERROR_CHECK(err_code);
+            break;
+
+        // Pairing requests are answered by the Peer Manager.
+        case BLE_GAP_EVT_AUTH_STATUS:
+            NRF_LOG_INFO("BLE_GAP_EVT_AUTH_STATUS: status=0x%x bond=0x%x lv4: %d kdist_own:0x%x kdist_peer:0x%x",
+                         p_ble_evt->evt.gap_evt.params.auth_status.auth_status,
+                         p_ble_evt->evt.gap_evt.params.auth_status.bonded,
+                         p_ble_evt->evt.gap_evt.params.auth_status.sm1_levels.lv4,
+                         *((uint8_t *)&p_ble_evt->evt.gap_evt.params.auth_status.kdist_own),
+                         *((uint8_t *)&p_ble_evt->evt.gap_evt.params.auth_status.kdist_peer));
+            break;
+
+        default:
+            // No implementation needed.
+            break;
+    }
+}
+
+
+/**@brief Function for adding the SoftDevice connection configuration of a profile.
+ *
+ * @details The SoftDevice reserves RAM for every tag as if all links could use it, so each tag
+ *          gets only what its profile needs. All profiles share the ATT MTU, so a transfer runs on
+ *          either of them. The low-power profile has short connection events and a shallow HVN TX
+ *          queue, which is what the link buffers and notification queue are sized from.
+ *
+ * @param[in] p_profile  Connection profile.
+ * @param[in] ram_start  Start address of the application RAM.
+ */
+static void conn_profile_cfg_set(app_conn_profile_cfg_t const * p_profile, uint32_t ram_start)
+{
+    ret_code_t err_code;
+    ble_cfg_t  ble_cfg;
+
+    memset(&ble_cfg, 0, sizeof(ble_cfg));
+    ble_cfg.conn_cfg.conn_cfg_tag                     = p_profile->conn_cfg_tag;
+    ble_cfg.conn_cfg.params.gap_conn_cfg.conn_count   = NRF_SDH_BLE_TOTAL_LINK_COUNT;
+    ble_cfg.conn_cfg.params.gap_conn_cfg.event_length = p_profile->event_length;
+    err_code = sd_ble_cfg_set(BLE_CONN_CFG_GAP, &ble_cfg, ram_start);
+    APP_ERROR_CHECK(err_code);
+
+    memset(&ble_cfg, 0, sizeof(ble_cfg));
+    ble_cfg.conn_cfg.conn_cfg_tag                 = p_profile->conn_cfg_tag;
+    ble_cfg.conn_cfg.params.gatt_conn_cfg.att_mtu = NRF_SDH_BLE_GATT_MAX_MTU_SIZE;
+    err_code = sd_ble_cfg_set(BLE_CONN_CFG_GATT, &ble_cfg, ram_start);
+    APP_ERROR_CHECK(err_code);
+
+    // Set the HVN TX queue depth, the default queue holds a single notification.
+    memset(&ble_cfg, 0, sizeof(ble_cfg));
+    ble_cfg.conn_cfg.conn_cfg_tag                            = p_profile->conn_cfg_tag;
+    ble_cfg.conn_cfg.params.gatts_conn_cfg.hvn_tx_queue_size = p_profile->hvn_tx_queue_size;
+    err_code = sd_ble_cfg_set(BLE_CONN_CFG_GATTS, &ble_cfg, ram_start);
+    APP_ERROR_CHECK(err_code);
+}
+
+
+/**@brief Function for enabling or disabling connection event length extension.
+ *
+ * @details With extension, a connection event goes on past its configured length while both
+ *          sides have data and nothing else is scheduled, up to the next connection event.
+ *
+ * @param[in] enable  true to enable extension.
+ */
+static void conn_evt_ext_set(bool enable)
+{
+    ret_code_t  err_code;
+    ble_opt_t   opt;
+
+    memset(&opt, 0, sizeof(opt));
+    opt.common_opt.conn_evt_ext.enable = enable ? 1 : 0;
+
+    err_code = sd_ble_opt_set(BLE_COMMON_OPT_CONN_EVT_EXT, &opt);
+    APP_ERROR_CHECK(err_code);
+
+    m_conn_evt_ext = enable;
+}
+
+
+/**@brief Function for initializing the BLE stack.
+ *
+ * @details Initializes the SoftDevice and the BLE event interrupt.
+ *
+ *          The RAM the SoftDevice needs grows with every connection configuration tag, the vendor
+ *          specific UUIDs, the attribute table (char3, Service Changed) and the HVN TX queues.
+ *          nrf_sdh_ble_enable checks it against RAM_START of the linker script: if RAM_START is
+ *          too low it logs the address it needs and fails, if it is too high it logs the address
+ *          it could be lowered to. The RAM start in use is logged below.
+ */
+static void ble_stack_init(void)
+{
+    ret_code_t err_code;
+
+    err_code = nrf_sdh_enable_request();
+    APP_ERROR_CHECK(err_code);
+
+    // Configure the BLE stack using the default settings.
+    // Fetch the start address of the application RAM.
+    uint32_t ram_start = 0;
+    err_code = nrf_sdh_ble_default_cfg_set(APP_BLE_CONN_CFG_TAG_BULK, &ram_start);
+    APP_ERROR_CHECK(err_code);
+
+    for (uint32_t i = 0; i < APP_CONN_PROFILE_COUNT; i++)
+    {
+        conn_profile_cfg_set(&m_conn_profiles[i], ram_start);
+    }
+
+    // Enable BLE stack.
+    err_code = nrf_sdh_ble_enable(&ram_start);
+    APP_ERROR_CHECK(err_code);
+
+    conn_evt_ext_set(m_conn_evt_ext);
+
+    NRF_LOG_INFO("HVN TX queue: %d bulk, %d low-power, application RAM start: 0x%08x.",
+                 APP_HVN_TX_QUEUE_SIZE,
+                 APP_HVN_TX_QUEUE_SIZE_LOW_POWER,
+                 ram_start);
+
+    // Register a handler for BLE events.
+    NRF_SDH_BLE_OBSERVER(m_ble_observer, APP_BLE_OBSERVER_PRIO, ble_evt_handler, NULL);
+}
+
+
+/**@brief Function for initializing the Advertising functionality.
+ */
+static void advertising_init(void)
+{
+    ret_code_t             err_code;
+    ble_advertising_init_t init;
+
+    memset(&init, 0, sizeof(init));
+
+    init.advdata.name_type               = BLE_ADVDATA_FULL_NAME;
+    init.advdata.flags                   = BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE;
+
+    init.config.ble_adv_fast_enabled  = true;
+    init.config.ble_adv_fast_interval = APP_ADV_INTERVAL;
     init.config.ble_adv_fast_timeout  = APP_ADV_DURATION;
 
-    init.evt_handler = on_adv_evt;
+    init.evt_handler = on_adv_evt;
+
+    err_code = ble_advertising_init(&m_advertising, &init);
+    APP_ERROR_CHECK(err_code);
+
+    ble_advertising_conn_cfg_tag_set(&m_advertising, m_conn_profiles[m_conn_profile_next].conn_cfg_tag);
+}
+
+/* Functions */
+uint32_t my_app_timer_get_counter_value(void)
+{
+  return app_timer_cnt_get();
+}
+
+/**@brief Function for recording notifications just queued by one of the sources sharing the link.
+ */
+static void tx_order_record(app_tx_owner_t owner, uint16_t count)
+{
+    if (!tx_order_push(&m_tx_order, owner, count))
+    {
+        // Completions of these are not credited to any source.
+        NRF_LOG_WARNING("HVN TX queue order lost, %d notifications.", count);
+    }
+}
+
+
+/**@brief Function for queueing a burst of char2 notifications for the transfer engine.
+ */
+static ret_code_t transfer_tx(void          * p_context,
+                              uint8_t const * p_data,
+                              uint16_t        length,
+                              uint16_t        stride,
+                              uint16_t        count,
+                              uint16_t      * p_queued)
+{
+    ret_code_t err_code;
+
+    err_code = ble_sensor_service_send_burst((ble_sensor_service_t *)p_context, m_conn_handle,
+                                             p_data, length, stride, count, p_queued);
+    tx_order_record(APP_TX_OWNER_ENGINE, *p_queued);
+
+    return err_code;
+}
+
+
+/**@brief Function for computing the throughput figures of a finished transfer.
+ *
+ * @param[in]  p_evt     Transfer engine event.
+ * @param[out] p_report  Throughput figures.
+ */
+static void transfer_report_get(transfer_engine_evt_t const * p_evt, transfer_stats_report_t * p_report)
+{
+    transfer_stats_link_t link;
+
+    link.phy           = (link_ctrl_tx_phy_get(m_conn_handle) == BLE_GAP_PHY_2MBPS) ? 2 : 1;
+    link.data_length   = link_ctrl_data_length_get(m_conn_handle);
+    link.ticks_per_sec = APP_TIMER_TICKS_PER_SEC;
+
+    transfer_stats_report(p_evt->p_stats, &link, p_report);
+}
+
+
+/**@brief Function for describing the current connection to the link model.
+ *
+ * @param[out] p_params     Link model parameters.
+ * @param[in]  packet_size  Length of the notifications sent (in bytes).
+ */
+static void link_model_params_get(link_model_params_t * p_params, uint16_t packet_size)
+{
+    p_params->conn_interval_us = m_conn_interval * 1250;
+    p_params->event_length_us  = m_conn_profiles[m_conn_profile].event_length * 1250;
+    p_params->phy              = (link_ctrl_tx_phy_get(m_conn_handle) == BLE_GAP_PHY_2MBPS) ? LINK_MODEL_PHY_2M
+                                                                                            : LINK_MODEL_PHY_1M;
+    p_params->data_length      = link_ctrl_data_length_get(m_conn_handle);
+    p_params->att_mtu          = packet_size + OPCODE_LENGTH + HANDLE_LENGTH;
+    p_params->hvn_queue_size   = (m_transfer_engine.queue_limit != 0) ? m_transfer_engine.queue_limit
+                                                                      : m_conn_profiles[m_conn_profile].hvn_tx_queue_size;
+
+    if (m_conn_evt_ext)
+    {
+        // An extended event may fill the whole connection interval.
+        p_params->event_length_us = p_params->conn_interval_us;
+    }
+}
+
+
+/**@brief Function for logging what the link model predicts for the current connection.
+ *
+ * @details The model runs the same packet sequence through a simulated HVN TX queue, so a large
+ *          gap between prediction and measurement points at the link rather than the firmware.
+ */
+static void transfer_model_report(transfer_engine_evt_t const * p_evt)
+{
+    link_model_params_t params;
+    link_model_report_t estimate;
+
+    link_model_params_get(&params, p_evt->packet_size);
+    link_model_estimate(&params, &estimate);
+
+    NRF_LOG_INFO("Model: %dM PHY, %d us interval, %d us events, %d.%02d packets/event, %d kbps",
+                 params.phy, params.conn_interval_us, params.event_length_us,
+                 estimate.packets_per_event_x100 / 100, estimate.packets_per_event_x100 % 100,
+                 estimate.kbps);
+    NRF_LOG_INFO("TX queue full %d times, %d frames sent again.", p_evt->busy_count, p_evt->retx_count);
+}
+
+
+/**@brief Function for logging one queue sweep step and starting the next one.
+ *
+ * @return  true while the sweep goes on, false after the last step.
+ */
+static bool queue_sweep_step(transfer_engine_evt_t const * p_evt)
+{
+    transfer_stats_report_t report;
+    uint8_t                 queue_size = m_conn_profiles[m_conn_profile].hvn_tx_queue_size;
+
+    transfer_report_get(p_evt, &report);
+
+    NRF_LOG_INFO("Queue %d: %d kbps goodput, est. RAM %d bytes.",
+                 m_sweep_queue_limit,
+                 report.goodput_bps / 1000,
+                 link_model_hvn_queue_ram(m_sweep_queue_limit, p_evt->packet_size + OPCODE_LENGTH + HANDLE_LENGTH));
+
+    if ((p_evt->type != TRANSFER_ENGINE_EVT_COMPLETE) || (m_sweep_queue_limit >= queue_size))
+    {
+        m_sweep_queue_limit = 0;
+        transfer_engine_queue_limit_set(&m_transfer_engine, 0);
+        return false;
+    }
+
+    m_sweep_queue_limit = (m_sweep_queue_limit * 2 > queue_size) ? queue_size : m_sweep_queue_limit * 2;
+    transfer_engine_queue_limit_set(&m_transfer_engine, m_sweep_queue_limit);
+    transfer_start(SWEEP_DATA_SIZE, 0);
+
+    return true;
+}
+
+
+/**@brief Function for sending a benchmark result on char3 and logging it as a CSV line.
+ *
+ * @details The CSV columns follow the record layout of @ref bench_matrix_result_t, so a log
+ *          capture and a notification capture load into the same table.
+ */
+static void bench_result_report(bench_matrix_result_t const * p_result)
+{
+    ret_code_t err_code;
+    uint8_t    record[BENCH_MATRIX_RESULT_LEN];
+    uint16_t   length;
+
+    length   = bench_matrix_result_encode(p_result, record);
+    err_code = ble_sensor_service_send_char3(&m_sensor_service, m_conn_handle, record, length);
+    if (err_code == NRF_SUCCESS)
+    {
+        tx_order_record(APP_TX_OWNER_RESULT, 1);
+    }
+    else
+    {
+        NRF_LOG_WARNING("Result %d not notified, error 0x%x.", p_result->index, err_code);
+    }
+
+    NRF_LOG_RAW_INFO("bench,%d,%d,%d,%d,%d,",
+                     p_result->index, p_result->status, p_result->phy,
+                     p_result->conn_interval, p_result->att_mtu);
+    NRF_LOG_RAW_INFO("%d,%d,%d,%d,%d\r\n",
+                     p_result->data_length, p_result->queue_size, p_result->goodput_bps,
+                     p_result->packets_per_event_x100, p_result->elapsed_ms);
+}
+
+
+/**@brief Function for requesting the link settings of the current benchmark cell.
+ *
+ * @details Only settings that differ from the current link are requested. The cell is measured
+ *          after @ref BENCH_SETTLE_MS, whatever the central has accepted by then. The peripheral
+ *          cannot renegotiate the ATT MTU, so a smaller MTU is emulated by shorter notifications.
+ */
+static void bench_cell_apply(void)
+{
+    ret_code_t          err_code;
+    bench_matrix_cell_t cell;
+    uint32_t            delay_ms = BENCH_SIM_STEP_MS;
+
+    if (!bench_matrix_cell_current(&m_bench, &cell))
+    {
+        return;
+    }
+
+    if (!m_bench_simulated)
+    {
+        if (cell.conn_interval != m_conn_interval)
+        {
+            conn_params_interval_request(cell.conn_interval);
+        }
+
+        if (cell.phy != link_ctrl_tx_phy_get(m_conn_handle))
+        {
+            err_code = link_ctrl_phy_request(m_conn_handle, cell.phy);
+            if (err_code != NRF_SUCCESS)
+            {
+                NRF_LOG_WARNING("PHY request failed, error 0x%x.", err_code);
+            }
+        }
+
+        if (cell.data_length != link_ctrl_data_length_get(m_conn_handle))
+        {
+            err_code = link_ctrl_data_length_request(m_conn_handle, cell.data_length);
+            if (err_code != NRF_SUCCESS)
+            {
+                NRF_LOG_WARNING("Data length request failed, error 0x%x.", err_code);
+            }
+        }
+
+        transfer_engine_queue_limit_set(&m_transfer_engine, cell.queue_size);
+        m_packet_size_limit = cell.att_mtu - OPCODE_LENGTH - HANDLE_LENGTH;
+        delay_ms            = BENCH_SETTLE_MS;
+    }
+
+    err_code = app_timer_start(m_bench_timer_id, APP_TIMER_TICKS(delay_ms), NULL);
+    APP_ERROR_CHECK(err_code);
+}
+
+
+/**@brief Function for starting a benchmark at the first cell.
+ */
+static void bench_start(void)
+{
+    if (!bench_matrix_start(&m_bench, &m_bench_axes))
+    {
+        NRF_LOG_WARNING("Benchmark matrix too large, %d cells.", bench_matrix_cell_count(&m_bench_axes));
+        return;
+    }
+
+    // A benchmark replaces any queue sweep.
+    m_sweep_queue_limit = 0;
+    sensor_service_status.is_transfer_started = 1;
+
+    NRF_LOG_INFO("Benchmark, %d cells, %d bytes each, %s.",
+                 m_bench.cell_count,
+                 m_bench_data_size,
+                 (uint32_t)(m_bench_simulated ? "simulated link" : "over the air"));
+    NRF_LOG_RAW_INFO("bench,index,status,phy,conn_interval,att_mtu,");
+    NRF_LOG_RAW_INFO("data_length,queue_size,goodput_bps,packets_per_event_x100,elapsed_ms\r\n");
+
+    bench_cell_apply();
+}
+
+
+/**@brief Function for ending a benchmark and putting back the link settings used by transfers.
+ */
+static void bench_end(void)
+{
+    (void)app_timer_stop(m_bench_timer_id);
+    bench_matrix_stop(&m_bench);
+
+    m_packet_size_limit = 0;
+    transfer_engine_queue_limit_set(&m_transfer_engine, 0);
+    sensor_service_status.is_transfer_started = 0;
+
+    if ((m_conn_handle != BLE_CONN_HANDLE_INVALID) && !m_bench_simulated)
+    {
+        (void)link_ctrl_phy_request(m_conn_handle, LINK_CTRL_PREFERRED_PHYS);
+        (void)link_ctrl_data_length_request(m_conn_handle, NRF_SDH_BLE_GAP_DATA_LENGTH);
+        conn_params_profile_request(CONN_PARAMS_PROFILE_IDLE);
+    }
+
+    NRF_LOG_INFO("Benchmark ended.");
+}
+
+
+/**@brief Function for moving a benchmark on to its next cell, or ending it after the last one.
+ */
+static void bench_next(void)
+{
+    if (bench_matrix_advance(&m_bench))
+    {
+        bench_cell_apply();
+    }
+    else
+    {
+        bench_end();
+    }
+}
+
+
+/**@brief Function for reporting the transfer of a benchmark cell.
+ *
+ * @param[in] p_evt  Transfer engine event that ended the cell.
+ */
+static void bench_step_done(transfer_engine_evt_t const * p_evt)
+{
+    transfer_stats_report_t report;
+    bench_matrix_cell_t     cell;
+    bench_matrix_result_t   result;
+
+    (void)bench_matrix_cell_current(&m_bench, &cell);
+    transfer_report_get(p_evt, &report);
+
+    memset(&result, 0, sizeof(result));
+    result.index                  = (uint8_t)m_bench.index;
+    result.cell_count             = (uint8_t)m_bench.cell_count;
+    result.status                 = (p_evt->type == TRANSFER_ENGINE_EVT_COMPLETE) ? BENCH_MATRIX_STATUS_OK
+                                                                                 : BENCH_MATRIX_STATUS_FAILED;
+    result.phy                    = link_ctrl_tx_phy_get(m_conn_handle);
+    result.conn_interval          = m_conn_interval;
+    result.att_mtu                = p_evt->packet_size + OPCODE_LENGTH + HANDLE_LENGTH;
+    result.data_length            = (uint8_t)link_ctrl_data_length_get(m_conn_handle);
+    result.queue_size             = cell.queue_size;
+    result.goodput_bps            = report.goodput_bps;
+    result.packets_per_event_x100 = (uint16_t)report.packets_per_event_x100;
+    result.elapsed_ms             = report.elapsed_ms;
+
+    if (m_conn_handle != BLE_CONN_HANDLE_INVALID)
+    {
+        bench_result_report(&result);
+    }
+
+    if (p_evt->type != TRANSFER_ENGINE_EVT_COMPLETE)
+    {
+        NRF_LOG_WARNING("Benchmark stopped at cell %d, error 0x%x.", result.index, p_evt->err_code);
+        bench_end();
+        return;
+    }
+
+    bench_next();
+}
+
+
+/**@brief Function for running the current benchmark cell once its link settings have settled.
+ */
+static void bench_timeout_handler(void * p_context)
+{
+    bench_matrix_cell_t   cell;
+    bench_matrix_result_t result;
+    uint32_t              event_length_us;
+
+    if (!bench_matrix_cell_current(&m_bench, &cell))
+    {
+        return;
+    }
+
+    if (!m_bench_simulated)
+    {
+        transfer_start(m_bench_data_size, 0);
+        if ((sensor_service_status.is_transfer_started == 0) && m_bench.is_running)
+        {
+            // The transfer could not start, no engine event will end the cell.
+            bench_end();
+        }
+        return;
+    }
+
+    // An extended event may fill the whole connection interval.
+    event_length_us = m_conn_evt_ext ? (uint32_t)cell.conn_interval * 1250
+                                     : (uint32_t)m_conn_profiles[m_conn_profile].event_length * 1250;
+
+    bench_matrix_cell_simulate(&m_bench,
+                               m_bench_data_size,
+                               TRANSFER_FRAME_OVERHEAD,
+                               event_length_us,
+                               &result);
+    bench_result_report(&result);
+    bench_next();
+}
+
+
+/**@brief Function for handling transfer engine events.
+ *
+ * @param[in] p_evt  Transfer engine event.
+ */
+static void transfer_evt_handler(transfer_engine_evt_t const * p_evt)
+{
+    transfer_stats_report_t report;
+
+    (void)app_timer_stop(m_ack_timer_id);
+
+    if (m_bench.is_running)
+    {
+        bench_step_done(p_evt);
+        return;
+    }
+
+    if ((m_sweep_queue_limit != 0) && queue_sweep_step(p_evt))
+    {
+        return;
+    }
+
+    sensor_service_status.is_transfer_started = 0;
+    (void)app_timer_stop(m_rate_timer_id);
+    conn_params_profile_request(CONN_PARAMS_PROFILE_IDLE);
+
+    if (p_evt->type == TRANSFER_ENGINE_EVT_ABORTED)
+    {
+        NRF_LOG_INFO("SENDING ABORTED, error 0x%x.", p_evt->err_code);
+        return;
+    }
+
+    NRF_LOG_INFO("SENDING FINISHED.");
+    nrf_gpio_pin_clear(15);
+    NRF_LOG_INFO("Data CRC32: 0x%08x", p_evt->data_crc32);
+
+    transfer_report_get(p_evt, &report);
+
+    NRF_LOG_INFO("Elapsed time: %d ms", report.elapsed_ms);
+    NRF_LOG_INFO("Number of packet: %d, %d bytes each", p_evt->packets_sent, p_evt->packet_size);
+    NRF_LOG_INFO("Payload %d bytes, headers %d bytes, ATT/LL overhead %d bytes",
+                 (uint32_t)p_evt->p_stats->payload_bytes,
+                 (uint32_t)p_evt->p_stats->header_bytes,
+                 (uint32_t)report.ll_overhead_bytes);
+    NRF_LOG_INFO("Goodput: %d kbps, raw: %d kbps, on air: %d kbps",
+                 report.goodput_bps / 1000, report.raw_bps / 1000, report.air_bps / 1000);
+    NRF_LOG_INFO("Packets per connection event: %d.%02d, %s profile, event extension %s",
+                 report.packets_per_event_x100 / 100, report.packets_per_event_x100 % 100,
+                 (uint32_t)m_conn_profiles[m_conn_profile].p_name,
+                 (uint32_t)(m_conn_evt_ext ? "on" : "off"));
+
+    transfer_model_report(p_evt);
+}
+
+
+/**@brief Function for starting a transfer on the current connection.
+ *
+ * @param[in] data_size  Amount of data to send (in bytes), 0 to stream until stopped.
+ * @param[in] rate_kbps  Target notification rate (in kbit/s), 0 for no limit.
+ *
+ * @details The engine queues as many packets as the SoftDevice accepts and is refilled from
+ *          @ref BLE_SENSOR_SERVICE_EVT_TRANSMIT_RDY, so the main loop can keep sleeping. A rate
+ *          limited transfer is also refilled from the rate timer.
+ */
+static void transfer_start(uint32_t data_size, uint16_t rate_kbps)
+{
+    ret_code_t err_code;
+    uint16_t   packet_size = m_ble_sensor_service_max_data_len;
+
+    m_transfer_length    = data_size;
+    m_transfer_rate_kbps = rate_kbps;
+
+    if (!m_bench.is_running)
+    {
+        // Ask early, the central may take a few connection events to switch.
+        conn_params_profile_request(CONN_PARAMS_PROFILE_BULK);
+    }
+
+    if (!link_ctrl_is_ready(m_conn_handle))
+    {
+        // Started from LINK_CTRL_EVT_READY once PHY, ATT MTU and data length have settled.
+        NRF_LOG_INFO("Link not ready, transfer pending.");
+        m_transfer_pending = true;
+        return;
+    }
+
+    m_transfer_pending = false;
+
+    if (data_size == SENSOR_CMD_LENGTH_UNBOUNDED)
+    {
+        NRF_LOG_INFO("SENDING START, streaming until stopped, %d kbps target.", rate_kbps);
+    }
+    else
+    {
+        NRF_LOG_INFO("SENDING START, %d bytes, %d kbps target.", data_size, rate_kbps);
+    }
+
+    if ((m_packet_size_limit != 0) && (m_packet_size_limit < packet_size))
+    {
+        packet_size = m_packet_size_limit;
+    }
+
+    transfer_engine_pacing_set(&m_transfer_engine, (rate_kbps != 0));
+
+    err_code = transfer_engine_start(&m_transfer_engine, packet_size, data_size);
+    if (err_code != NRF_SUCCESS)
+    {
+        NRF_LOG_WARNING("Transfer not started, error 0x%x.", err_code);
+        sensor_service_status.is_transfer_started = 0;
+        return;
+    }
+
+    if (!transfer_engine_is_running(&m_transfer_engine))
+    {
+        // The first packets were rejected, the engine has ended the transfer and reported it.
+        return;
+    }
+
+    if (rate_kbps != 0)
+    {
+        err_code = app_timer_start(m_rate_timer_id, APP_TIMER_TICKS(RATE_TIMER_INTERVAL_MS), NULL);
+        APP_ERROR_CHECK(err_code);
+    }
 
-    err_code = ble_advertising_init(&m_advertising, &init);
+    if (m_transfer_engine.is_reliable)
+    {
+        ack_timer_restart();
+    }
+}
+
+
+/**@brief Function for sending a record of the sample log on char2.
+ *
+ * @details Matches @ref sample_log_tx_t. A record is already a complete frame.
+ */
+static ret_code_t sample_log_tx(uint8_t const * p_record, uint16_t length)
+{
+    ret_code_t err_code;
+
+    err_code = ble_sensor_service_send_char2(&m_sensor_service, (uint8_t *)p_record, length, m_conn_handle);
+    if (err_code == NRF_SUCCESS)
+    {
+        tx_order_record(APP_TX_OWNER_LOG, 1);
+    }
+
+    return err_code;
+}
+
+
+/**@brief Function for handling the events of the sample log.
+ */
+static void sample_log_evt_handler(sample_log_evt_t const * p_evt)
+{
+    switch (p_evt->type)
+    {
+        case SAMPLE_LOG_EVT_REPLAY_STARTED:
+            if (p_evt->unsent_count > 0)
+            {
+                conn_params_profile_request(CONN_PARAMS_PROFILE_BULK);
+            }
+            break;
+
+        case SAMPLE_LOG_EVT_DRAINED:
+            if (!sensor_stream_is_running() && !transfer_engine_is_running(&m_transfer_engine))
+            {
+                conn_params_profile_request(CONN_PARAMS_PROFILE_IDLE);
+            }
+            return;
+
+        default:
+            break;
+    }
+
+    // Stores the frames that waited for the flash, or sends the records replayed.
+    sensor_stream_drain();
+}
+
+
+/**@brief Function for handling the loss of the link the stream and the sample log are sent on.
+ *
+ * @details The stream keeps running and its frames go to the sample log until the link is back.
+ *          Records in flight may not have been delivered, they are sent again.
+ */
+static void stream_link_lost(void)
+{
+    sample_log_link_lost();
+    tx_order_reset(&m_tx_order);
+}
+
+
+/**@brief Function for sending a streamed frame on char2.
+ *
+ * @details Matches @ref sensor_stream_tx_t.
+ */
+static ret_code_t stream_tx(uint8_t const * p_frame, uint16_t length)
+{
+    ret_code_t err_code;
+
+    err_code = ble_sensor_service_send_char2(&m_sensor_service, (uint8_t *)p_frame, length, m_conn_handle);
+    if (err_code == NRF_SUCCESS)
+    {
+        tx_order_record(APP_TX_OWNER_STREAM, 1);
+    }
+
+    return err_code;
+}
+
+
+/**@brief Function for telling the stream and the sample log whether they may send.
+ *
+ * @details Matches @ref sensor_stream_link_get_t. A transfer or benchmark owns the link while it
+ *          runs, the sample log and the stream wait for it to end.
+ */
+static bool stream_link_get(uint16_t * p_max_len)
+{
+    *p_max_len = m_ble_sensor_service_max_data_len;
+
+    return (m_conn_handle != BLE_CONN_HANDLE_INVALID) &&
+           (sensor_service_status.is_notification_enabled == 1) &&
+           !transfer_engine_is_running(&m_transfer_engine) &&
+           !m_bench.is_running;
+}
+
+
+/**@brief Function for logging what the compression of the stream gained on the current link.
+ *
+ * @details The goodput gain is the air time of an average frame before compression over the air
+ *          time of an average frame as sent. It is what the link gains when it is the bottleneck.
+ */
+static void stream_compress_report(sensor_stream_compress_stats_t const * p_stats)
+{
+    link_model_params_t params;
+    uint16_t            raw_len       = p_stats->raw_bytes / p_stats->frames;
+    uint16_t            packed_len    = p_stats->packed_bytes / p_stats->frames;
+    uint32_t            raw_air_us;
+    uint32_t            packed_air_us;
+
+    link_model_params_get(&params, raw_len);
+    raw_air_us    = link_model_hvx_air_time_us(&params, raw_len);
+    packed_air_us = link_model_hvx_air_time_us(&params, packed_len);
+
+    if (packed_air_us == 0)
+    {
+        return;
+    }
+
+    NRF_LOG_INFO("Compression: %d us -> %d us air time per frame, goodput gain x%d.%02d.",
+                 raw_air_us,
+                 packed_air_us,
+                 (raw_air_us * 100 / packed_air_us) / 100,
+                 (raw_air_us * 100 / packed_air_us) % 100);
+}
+
+
+/**@brief Function for handling the events of the sensor stream.
+ */
+static void stream_evt_handler(sensor_stream_evt_t const * p_evt)
+{
+    switch (p_evt->type)
+    {
+        case SENSOR_STREAM_EVT_STARTED:
+            sensor_service_status.is_transfer_started = 1;
+            conn_params_profile_request(CONN_PARAMS_PROFILE_BULK);
+            break;
+
+        case SENSOR_STREAM_EVT_STOPPED:
+            sensor_service_status.is_transfer_started = 0;
+            conn_params_profile_request(CONN_PARAMS_PROFILE_IDLE);
+
+            if (p_evt->params.p_compress_stats != NULL)
+            {
+                stream_compress_report(p_evt->params.p_compress_stats);
+            }
+            break;
+
+        case SENSOR_STREAM_EVT_BACKLOG:
+            (void)ble_sensor_service_backlog_set(&m_sensor_service, m_conn_handle, p_evt->params.backlog_bytes);
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+/**@brief Function for adapting the stream to the backlog watermark events of the sensor service.
+ */
+static void stream_backlog_handle(ble_sensor_service_evt_t const * p_evt)
+{
+    if (!sensor_stream_is_running())
+    {
+        return;
+    }
+
+    NRF_LOG_INFO("Backlog %s: %d bytes, %d bytes/s drain, %d ms.",
+                 (uint32_t)((p_evt->type == BLE_SENSOR_SERVICE_EVT_BACKLOG_HIGH) ? "high" : "low"),
+                 p_evt->params.backlog.queued_bytes,
+                 p_evt->params.backlog.drain_rate,
+                 p_evt->params.backlog.backlog_ms);
+
+    sensor_stream_backlog_set(p_evt->type == BLE_SENSOR_SERVICE_EVT_BACKLOG_HIGH);
+}
+
+
+/**@brief Function for handling a char1 command.
+ *
+ * @param[in] p_cmd  Decoded command.
+ */
+static void transfer_cmd_handle(sensor_cmd_t const * p_cmd)
+{
+    switch (p_cmd->opcode)
+    {
+        case SENSOR_CMD_START_TRANSFER:
+        case SENSOR_CMD_START_QUEUE_SWEEP:
+            if ((sensor_service_status.is_notification_enabled == 0) ||
+                (sensor_service_status.is_transfer_started == 1))
+            {
+                NRF_LOG_WARNING("Start ignored, notifications off or transfer running.");
+                break;
+            }
+
+            sensor_service_status.is_transfer_started = 1;
+
+            if (p_cmd->opcode == SENSOR_CMD_START_QUEUE_SWEEP)
+            {
+                m_sweep_queue_limit = 1;
+                transfer_engine_queue_limit_set(&m_transfer_engine, m_sweep_queue_limit);
+                NRF_LOG_INFO("Queue sweep, %d bytes per step.", SWEEP_DATA_SIZE);
+                transfer_start(SWEEP_DATA_SIZE, 0);
+            }
+            else
+            {
+                transfer_start(p_cmd->has_length ? p_cmd->length : TRANSFER_DATA_SIZE, p_cmd->rate_kbps);
+            }
+            break;
+
+        case SENSOR_CMD_BENCH_START:
+            if ((sensor_service_status.is_notification_enabled == 0) ||
+                (sensor_service_status.is_transfer_started == 1))
+            {
+                NRF_LOG_WARNING("Benchmark ignored, notifications off or transfer running.");
+                break;
+            }
+
+            m_bench_simulated = (p_cmd->value == SENSOR_CMD_BENCH_MODE_SIMULATED);
+            m_bench_data_size = (p_cmd->has_length && (p_cmd->length != 0)) ? p_cmd->length : BENCH_DATA_SIZE;
+            bench_start();
+            break;
+
+        case SENSOR_CMD_STREAM_SET:
+            if (p_cmd->value == SENSOR_CMD_STREAM_OFF)
+            {
+                sensor_stream_stop();
+                break;
+            }
+
+            if (p_cmd->value > SENSOR_CMD_STREAM_DELTA)
+            {
+                NRF_LOG_WARNING("Unknown stream mode %d.", p_cmd->value);
+                break;
+            }
+
+            if ((sensor_service_status.is_notification_enabled == 0) ||
+                (sensor_service_status.is_transfer_started == 1))
+            {
+                NRF_LOG_WARNING("Stream ignored, notifications off or transfer running.");
+                break;
+            }
+
+            sensor_stream_start(p_cmd->value, p_cmd->deadline_ms);
+            break;
+
+        case SENSOR_CMD_LOG_REPLAY:
+            if (sensor_service_status.is_notification_enabled == 0)
+            {
+                NRF_LOG_WARNING("Replay ignored, notifications off.");
+                break;
+            }
+
+            sample_log_replay(p_cmd->age_s);
+            break;
+
+        case SENSOR_CMD_STOP_TRANSFER:
+        case SENSOR_CMD_ABORT_TRANSFER:
+            sensor_stream_stop();
+
+            if (m_bench.is_running)
+            {
+                // Ends the matrix, the transfer of the current cell is stopped below.
+                bench_end();
+            }
+
+            if (m_transfer_pending)
+            {
+                m_transfer_pending                        = false;
+                sensor_service_status.is_transfer_started = 0;
+                NRF_LOG_INFO("Pending transfer cancelled.");
+            }
+
+            // A stop or abort also ends a queue sweep after the current step.
+            m_sweep_queue_limit = 0;
+            transfer_engine_queue_limit_set(&m_transfer_engine, 0);
+
+            if (p_cmd->opcode == SENSOR_CMD_STOP_TRANSFER)
+            {
+                transfer_engine_stop(&m_transfer_engine);
+            }
+            else
+            {
+                transfer_engine_abort(&m_transfer_engine);
+            }
+            break;
+
+        case SENSOR_CMD_CONN_PROFILE_SET:
+            if (p_cmd->value >= APP_CONN_PROFILE_COUNT)
+            {
+                NRF_LOG_WARNING("Unknown connection profile %d.", p_cmd->value);
+                break;
+            }
+
+            // The SoftDevice takes the configuration when a connection is set up.
+            m_conn_profile_next = (app_conn_profile_t)p_cmd->value;
+            ble_advertising_conn_cfg_tag_set(&m_advertising, m_conn_profiles[m_conn_profile_next].conn_cfg_tag);
+            NRF_LOG_INFO("Next connection uses the %s profile.", (uint32_t)m_conn_profiles[m_conn_profile_next].p_name);
+            break;
+
+        case SENSOR_CMD_CONN_EVT_EXT_SET:
+            conn_evt_ext_set(p_cmd->value != 0);
+            NRF_LOG_INFO("Connection event extension %s.", (uint32_t)(m_conn_evt_ext ? "on" : "off"));
+            break;
+
+        case SENSOR_CMD_ACK:
+            if (transfer_engine_is_running(&m_transfer_engine) && m_transfer_engine.is_reliable)
+            {
+                ack_timer_restart();
+                transfer_engine_ack(&m_transfer_engine, p_cmd->seq, p_cmd->bitmap);
+            }
+            break;
+
+        case SENSOR_CMD_RELIABLE_SET:
+            transfer_engine_reliable_set(&m_transfer_engine, (p_cmd->value != 0), RELIABLE_WINDOW_FRAMES);
+            NRF_LOG_INFO("Reliable stream %s from the next start.", (uint32_t)((p_cmd->value != 0) ? "on" : "off"));
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+/**@brief Function for handling link control events.
+ *
+ * @param[in] p_evt  Link control event.
+ */
+static void link_ctrl_evt_handler(link_ctrl_evt_t const * p_evt)
+{
+    if (p_evt->conn_handle != m_conn_handle)
+    {
+        return;
+    }
+
+    switch (p_evt->type)
+    {
+        case LINK_CTRL_EVT_PHY_UPDATED:
+            NRF_LOG_INFO("Link on %dM PHY.",
+                         (link_ctrl_tx_phy_get(m_conn_handle) == BLE_GAP_PHY_2MBPS) ? 2 : 1);
+
+            // The PHY procedure may have kept the stored connection parameter request busy.
+            peer_conn_params_request();
+            break;
+
+        case LINK_CTRL_EVT_READY:
+            NRF_LOG_INFO("Link ready: %dM PHY, ATT MTU %d, data length %d.",
+                         (link_ctrl_tx_phy_get(m_conn_handle) == BLE_GAP_PHY_2MBPS) ? 2 : 1,
+                         link_ctrl_att_mtu_get(m_conn_handle),
+                         link_ctrl_data_length_get(m_conn_handle));
+
+            peer_link_params_store(NULL);
+            peer_conn_params_request();
+
+            if (m_transfer_pending)
+            {
+                transfer_start(m_transfer_length, m_transfer_rate_kbps);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+/**@brief Function for initializing the link control module.
+ */
+static void link_ctrl_module_init(void)
+{
+    ret_code_t       err_code;
+    link_ctrl_init_t init;
+
+    memset(&init, 0, sizeof(init));
+
+    init.evt_handler = link_ctrl_evt_handler;
+    init.p_gatt      = &m_gatt;
+
+    err_code = link_ctrl_init(&init);
     APP_ERROR_CHECK(err_code);
+}
+
+
+/**@brief Function for initializing the transfer engine.
+ */
+static void transfer_init(void)
+{
+    ret_code_t             err_code;
+    transfer_engine_init_t init;
+
+    memset(&init, 0, sizeof(init));
+
+    init.tx_func      = transfer_tx;
+    init.p_tx_context = &m_sensor_service;
+    init.time_func    = my_app_timer_get_counter_value;
+    init.evt_handler  = transfer_evt_handler;
+    init.frame_flags  = TRANSFER_FRAME_FLAGS;
 
-    ble_advertising_conn_cfg_tag_set(&m_advertising, APP_BLE_CONN_CFG_TAG);
+    err_code = transfer_engine_init(&m_transfer_engine, &init);
+    APP_ERROR_CHECK(err_code);
 }
 
-/* Functions */
-uint32_t my_app_timer_get_counter_value(void)
+
+/**@brief Function for opening the sample log.
+ *
+ * @details Frames stored before a reset and not yet delivered are sent once a central enables
+ *          notifications.
+ */
+static void sample_log_module_init(void)
 {
-  return app_timer_cnt_get();
+    ret_code_t        err_code;
+    sample_log_init_t init;
+
+    memset(&init, 0, sizeof(init));
+
+    init.evt_handler = sample_log_evt_handler;
+    init.tx          = sample_log_tx;
+
+    err_code = sample_log_init(&init);
+    APP_ERROR_CHECK(err_code);
+}
+
+
+/**@brief Function for initializing the sensor stream.
+ */
+static void sensor_stream_module_init(void)
+{
+    ret_code_t           err_code;
+    sensor_stream_init_t init;
+
+    memset(&init, 0, sizeof(init));
+
+    init.evt_handler = stream_evt_handler;
+    init.tx          = stream_tx;
+    init.link_get    = stream_link_get;
+
+    err_code = sensor_stream_init(&init);
+    APP_ERROR_CHECK(err_code);
+}
+
+
+#if APP_CRC_BENCHMARK_ENABLED
+/**@brief Function for timing the CRC kernels of the TX path with the cycle counter.
+ *
+ * @details The CRC16 runs over the header of every frame, and over the data of a frame whose data
+ *          changes. The CRC32 runs over the data of every frame once.
+ */
+static void crc_benchmark(void)
+{
+    uint8_t  block[CRC_BENCH_LEN];
+    uint16_t crc16   = 0;
+    uint32_t crc32   = 0;
+    uint32_t cycles;
+    uint32_t crc16_cycles;
+    uint32_t crc32_cycles;
+    uint32_t bytes   = CRC_BENCH_LEN * CRC_BENCH_ROUNDS;
+
+    for (uint16_t i = 0; i < sizeof(block); i++)
+    {
+        block[i] = (uint8_t)i;
+    }
+
+    cycle_counter_enable();
+
+    cycles = cycle_counter_get();
+    for (uint8_t i = 0; i < CRC_BENCH_ROUNDS; i++)
+    {
+        crc16 = crc16_compute(block, sizeof(block), &crc16);
+    }
+    crc16_cycles = cycle_counter_get() - cycles;
+
+    cycles = cycle_counter_get();
+    for (uint8_t i = 0; i < CRC_BENCH_ROUNDS; i++)
+    {
+        crc32 = frame_crc32_compute(block, sizeof(block), &crc32);
+    }
+    crc32_cycles = cycle_counter_get() - cycles;
+
+    NRF_LOG_INFO("CRC16: %d.%02d cycles/byte, CRC32: %d.%02d cycles/byte.",
+                 (crc16_cycles * 100 / bytes) / 100,
+                 (crc16_cycles * 100 / bytes) % 100,
+                 (crc32_cycles * 100 / bytes) / 100,
+                 (crc32_cycles * 100 / bytes) % 100);
+    NRF_LOG_DEBUG("CRC results 0x%04x 0x%08x.", crc16, crc32);
 }
+#endif // APP_CRC_BENCHMARK_ENABLED
+
 
 /**@brief Function for initializing the nrf log module.
  */
@@ -651,7 +2399,15 @@ int main(void)
     gatt_init();
     advertising_init();
     services_init();
+    link_ctrl_module_init();
+    transfer_init();
+    sample_log_module_init();
+    sensor_stream_module_init();
     conn_params_init();
+    peer_manager_init();
+#if APP_CRC_BENCHMARK_ENABLED
+    crc_benchmark();
+#endif
 
     // Start execution.
     NRF_LOG_INFO("Bluetooth example started.");
@@ -661,84 +2417,6 @@ int main(void)
     // Enter main loop.
     while(1)
     {
-        // SEND DATA //
-        if(sensor_service_status.is_transfer_started == 1)
-        {
-            uint32_t return_code = NRF_SUCCESS;
-            bool sendTransferComplete = false;  
-            uint8_t packet[512];
-            uint16_t packet_size = m_ble_sensor_service_max_data_len /*- (m_ble_sensor_service_max_data_len % 8)*/;
-            uint16_t packet_number = (((8*1048576) / packet_size) + 1);  // Number of packet to tranfer 8 Mb data array
-            uint16_t packet_addr = 1;
-            uint32_t start_time=0, end_time=0, number_of_packet = packet_number;
-
-            start_time = my_app_timer_get_counter_value();
-            NRF_LOG_INFO("SENDING START.");
-            NRF_LOG_FLUSH();
-          
-            while(sensor_service_status.is_transfer_started == 1)
-            {
-                /* Create Packet */
-                memset(packet, 0xFF, sizeof(packet));
-                packet[0] = (packet_addr >> 8);
-                packet[1] = (packet_addr);
-                packet[packet_size-1] = 0;
-                
-                if(packet_number == 0)
-                { 
-                  sendTransferComplete = true;  // TRANSFER COMPLETE FLAG
-                  break;
-                }      
-                else
-                {
-                  packet_number--;
-                  packet_addr++;
-                }
-          
-                /* Send Packet */
-                do
-                {
-                  return_code = ble_sensor_service_send_char2(&m_sensor_service, packet, packet_size, m_conn_handle);
-                } while(return_code != NRF_SUCCESS);
-            } 
-
-            if(sendTransferComplete == true)
-            {
-                sendTransferComplete = false;
-
-                end_time = my_app_timer_get_counter_value();
-
-                memset(packet, 0x00, 4);
-                while (1)
-                {
-                    return_code = ble_sensor_service_send_char2(&m_sensor_service, packet, 4, m_conn_handle);
-                    if(return_code == NRF_SUCCESS)
-                    {
-                      NRF_LOG_INFO("SENDING FINISHED.");
-                      NRF_LOG_FLUSH();
-                      nrf_gpio_pin_clear(15);
-                      break;
-                    }
-                }
-            }
-          
-            float elapsed_time = (end_time-start_time)*61.035f;
-            elapsed_time = elapsed_time/(1000.0f*1000.0f);
-          
-            NRF_LOG_INFO("Elapsed time: " NRF_LOG_FLOAT_MARKER " sec", NRF_LOG_FLOAT(elapsed_time));
-            NRF_LOG_FLUSH();
-
-            NRF_LOG_INFO("Number of packet: %d", number_of_packet);
-            NRF_LOG_FLUSH();
-
-            float data_throughput = (number_of_packet*244*8)/(elapsed_time*1000.0f);
-
-            NRF_LOG_INFO("Data Throughput: " NRF_LOG_FLOAT_MARKER " kbps", NRF_LOG_FLOAT(data_throughput));
-            NRF_LOG_FLUSH();
-
-            sensor_service_status.is_transfer_started = 0;
-        } /* IS_TRANSFER_STARTED */
-        
         idle_state_handle();
     }
 }
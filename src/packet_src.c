@@ -0,0 +1,180 @@
+#include <string.h>
+#include "packet_src.h"
+#include "crc16.h"
+
+
+bool packet_src_template_init(packet_src_t * p_src, uint16_t packet_size, uint8_t frame_flags, uint32_t data_len)
+{
+    sensor_frame_header_t header;
+    uint8_t               header_len = sensor_frame_header_len(frame_flags);
+    uint8_t               crc_len    = (frame_flags & SENSOR_FRAME_FLAG_CRC) ? SENSOR_FRAME_CRC_LEN : 0;
+
+    if ((p_src == NULL) || (packet_size <= header_len + crc_len) || (packet_size > PACKET_SRC_MAX_PACKET_LEN))
+    {
+        return false;
+    }
+
+    p_src->packet_size = packet_size;
+    p_src->frame_flags = frame_flags;
+    p_src->data_len    = data_len;
+
+    memset(&header, 0, sizeof(header));
+    header.flags       = frame_flags;
+    header.payload_len = packet_size - header_len;
+
+    for (uint16_t i = 0; i < PACKET_SRC_TEMPLATE_COUNT; i++)
+    {
+        memset(p_src->templates[i], 0xFF, packet_size);
+        (void)sensor_frame_header_encode(&header, p_src->templates[i], packet_size);
+    }
+
+    // Every template carries the same data, its CRC is carried over to every frame.
+    p_src->data_crc16    = crc16_compute(&p_src->templates[0][header_len], packet_size - header_len - crc_len, NULL);
+    p_src->is_tail_built = false;
+
+    return true;
+}
+
+
+/**@brief Function for getting the length of the CRC16 trailer of template frames (in bytes).
+ */
+static uint8_t template_crc_len(packet_src_t const * p_src)
+{
+    return (p_src->frame_flags & SENSOR_FRAME_FLAG_CRC) ? SENSOR_FRAME_CRC_LEN : 0;
+}
+
+
+/**@brief Function for getting the data of a full template frame, without the CRC16 trailer (in bytes).
+ */
+static uint16_t template_payload_len(packet_src_t const * p_src)
+{
+    return p_src->packet_size - sensor_frame_header_len(p_src->frame_flags) - template_crc_len(p_src);
+}
+
+
+uint32_t packet_src_packet_count(packet_src_t const * p_src)
+{
+    uint16_t payload_len = template_payload_len(p_src);
+
+    return (p_src->data_len / payload_len) + ((p_src->data_len % payload_len) ? 1 : 0);
+}
+
+
+bool packet_src_is_unbounded(packet_src_t const * p_src)
+{
+    return (p_src->data_len == 0);
+}
+
+
+/**@brief Function for turning the first template into the short last frame of a transfer.
+ *
+ * @return  Length of the frame (in bytes).
+ */
+static uint16_t template_tail_build(packet_src_t * p_src, uint32_t index, uint16_t payload_len, uint32_t timestamp)
+{
+    sensor_frame_header_t header;
+    uint8_t               header_len;
+
+    memset(&header, 0, sizeof(header));
+    header.flags       = p_src->frame_flags;
+    header.payload_len = payload_len + template_crc_len(p_src);
+    header.seq         = index;
+    header.timestamp   = timestamp;
+
+    p_src->is_tail_built = true;
+
+    header_len = sensor_frame_header_encode(&header, p_src->templates[0], p_src->packet_size);
+
+    if (p_src->frame_flags & SENSOR_FRAME_FLAG_CRC)
+    {
+        sensor_frame_crc_patch(p_src->templates[0],
+                               crc16_compute(&p_src->templates[0][header_len], payload_len, NULL));
+    }
+
+    return header_len + header.payload_len;
+}
+
+
+/**@brief Function for turning the first template back into a full frame after the short one.
+ */
+static void template_full_rebuild(packet_src_t * p_src)
+{
+    sensor_frame_header_t header;
+
+    memset(&header, 0, sizeof(header));
+    header.flags       = p_src->frame_flags;
+    header.payload_len = template_payload_len(p_src) + template_crc_len(p_src);
+
+    (void)sensor_frame_header_encode(&header, p_src->templates[0], p_src->packet_size);
+
+    p_src->is_tail_built = false;
+}
+
+
+void packet_src_next(packet_src_t     * p_src,
+                     uint32_t           index,
+                     uint16_t           max_count,
+                     uint32_t           timestamp,
+                     packet_src_burst_t * p_burst)
+{
+    p_burst->length = p_src->packet_size;
+    p_burst->count  = 0;
+
+    if (max_count > PACKET_SRC_TEMPLATE_COUNT)
+    {
+        max_count = PACKET_SRC_TEMPLATE_COUNT;
+    }
+
+    if (p_src->data_len != 0)
+    {
+        uint16_t payload_len = template_payload_len(p_src);
+        uint32_t last        = p_src->data_len / payload_len;
+        uint16_t tail_len    = p_src->data_len % payload_len;
+
+        if ((index == last) && (tail_len > 0))
+        {
+            // Template 0 is only restored if an earlier frame is asked for again.
+            p_burst->p_data = p_src->templates[0];
+            p_burst->length = template_tail_build(p_src, index, tail_len, timestamp);
+            p_burst->stride = PACKET_SRC_MAX_PACKET_LEN;
+            p_burst->count  = 1;
+            return;
+        }
+
+        // A burst ends before the short frame, all its packets share one length.
+        if (index >= last)
+        {
+            max_count = 0;
+        }
+        else if (last - index < max_count)
+        {
+            max_count = (uint16_t)(last - index);
+        }
+    }
+
+    if (p_src->is_tail_built && (max_count > 0))
+    {
+        template_full_rebuild(p_src);
+    }
+
+    // Only the sequence number, and the timestamp if there is one, change between packets. The
+    // CRC16 trailer follows them, from the CRC of the data computed once.
+    for (uint16_t i = 0; i < max_count; i++)
+    {
+        sensor_frame_seq_patch(p_src->templates[i], index + i);
+
+        if (p_src->frame_flags & SENSOR_FRAME_FLAG_TIMESTAMP)
+        {
+            sensor_frame_timestamp_patch(p_src->templates[i], timestamp);
+        }
+
+        if (p_src->frame_flags & SENSOR_FRAME_FLAG_CRC)
+        {
+            sensor_frame_crc_patch(p_src->templates[i], p_src->data_crc16);
+        }
+    }
+
+    p_burst->p_data = p_src->templates[0];
+    p_burst->stride = PACKET_SRC_MAX_PACKET_LEN;
+    p_burst->count  = max_count;
+}
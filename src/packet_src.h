@@ -0,0 +1,97 @@
+#ifndef __PACKET_SRC_H
+#define __PACKET_SRC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sensor_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Maximum packet the source can produce (in bytes). */
+#define PACKET_SRC_MAX_PACKET_LEN       512
+
+/**@brief   Number of pre-built packet templates, the largest burst a template source returns. */
+#ifndef PACKET_SRC_TEMPLATE_COUNT
+#define PACKET_SRC_TEMPLATE_COUNT       4
+#endif
+
+
+/**@brief   Consecutive packets ready to be handed to the SoftDevice in one burst. */
+typedef struct
+{
+    uint8_t const * p_data;     /**< First packet. */
+    uint16_t        length;     /**< Length of every packet (in bytes). */
+    uint16_t        stride;     /**< Distance between the start of two packets (in bytes). */
+    uint16_t        count;      /**< Number of packets. */
+} packet_src_burst_t;
+
+
+/**@brief   Packet source structure.
+ *
+ * @details The framed test pattern is built once into templates when the source is set up, only
+ *          the sequence header is patched per packet. No payload is copied per packet, so the cost
+ *          per packet does not grow with the packet size.
+ */
+typedef struct
+{
+    uint16_t          packet_size;      /**< Length of every packet (in bytes). */
+    uint8_t           frame_flags;      /**< SENSOR_FRAME_FLAG_* bits of template frames. */
+    uint16_t          data_crc16;       /**< CRC16 of the data of a full template frame. */
+    uint32_t          data_len;         /**< Data of all template frames, without CRC16 trailers (in bytes), 0 if unbounded. */
+    bool              is_tail_built;    /**< The first template holds the short last frame. */
+    uint8_t           templates[PACKET_SRC_TEMPLATE_COUNT][PACKET_SRC_MAX_PACKET_LEN];
+} packet_src_t;
+
+
+/**@brief   Function for setting up a test pattern source.
+ *
+ * @details Every packet is a frame with a @ref sensor_frame_header_t header and a 0xFF filled
+ *          payload. The sequence number is the packet index. The last frame is shorter if
+ *          @p data_len is not a multiple of the frame payload.
+ *
+ * @param[out] p_src        Packet source.
+ * @param[in]  packet_size  Length of every packet including the frame header (in bytes).
+ * @param[in]  frame_flags  SENSOR_FRAME_FLAG_TIMESTAMP to stamp every frame, SENSOR_FRAME_FLAG_CRC
+ *                          to end every frame with a CRC16, 0 otherwise.
+ * @param[in]  data_len     Data to send over all frames, without CRC16 trailers (in bytes), 0 for
+ *                          no end.
+ *
+ * @retval true   If the source was set up.
+ * @retval false  If @p packet_size is out of range.
+ */
+bool packet_src_template_init(packet_src_t * p_src, uint16_t packet_size, uint8_t frame_flags, uint32_t data_len);
+
+
+/**@brief   Function for getting the number of packets a source produces, 0 if unbounded.
+ */
+uint32_t packet_src_packet_count(packet_src_t const * p_src);
+
+
+/**@brief   Function for checking whether a source produces packets until it is stopped.
+ */
+bool packet_src_is_unbounded(packet_src_t const * p_src);
+
+
+/**@brief   Function for getting the next packets from a source.
+ *
+ * @details Packets may be asked for again, in any order, to send them a second time.
+ *
+ * @param[in]  p_src      Packet source.
+ * @param[in]  index      Index of the first packet, counted from 0.
+ * @param[in]  max_count  Maximum number of packets wanted.
+ * @param[in]  timestamp  Time stamp for frames that carry one.
+ * @param[out] p_burst    Packets ready to be queued. Valid until the next call.
+ */
+void packet_src_next(packet_src_t     * p_src,
+                     uint32_t           index,
+                     uint16_t           max_count,
+                     uint32_t           timestamp,
+                     packet_src_burst_t * p_burst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __PACKET_SRC_H
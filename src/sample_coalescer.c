@@ -0,0 +1,258 @@
+#include <string.h>
+#include "sample_coalescer.h"
+
+
+#define SAMPLE_COALESCER_FRAME_FLAGS    SENSOR_FRAME_FLAG_TIMESTAMP
+
+
+/**@brief Function for getting the time since the first sample of the open frame.
+ */
+static uint32_t frame_age(sample_coalescer_t const * p_coalescer, uint32_t ticks)
+{
+    return (ticks - p_coalescer->first_ticks) & p_coalescer->counter_mask;
+}
+
+
+/**@brief Function for checking that a frame of the given length holds at least one sample.
+ */
+static bool frame_len_valid(sample_coalescer_t const * p_coalescer, uint16_t frame_len)
+{
+    return (p_coalescer->sample_size > 0)
+        && (frame_len >= p_coalescer->header_len + p_coalescer->sample_size);
+}
+
+
+/**@brief Function for closing the open frame and handing it to the owner.
+ */
+static void frame_close(sample_coalescer_t * p_coalescer, uint32_t ticks, sample_coalescer_reason_t reason)
+{
+    sample_coalescer_stats_t * p_stats = &p_coalescer->stats;
+    sensor_frame_header_t      header;
+    sample_coalescer_evt_t     evt;
+    uint32_t                   age = frame_age(p_coalescer, ticks);
+
+    memset(&header, 0, sizeof(header));
+    header.flags       = SAMPLE_COALESCER_FRAME_FLAGS | p_coalescer->frame_flags;
+    header.seq         = p_coalescer->seq++;
+    header.timestamp   = p_coalescer->first_ticks;
+    header.payload_len = p_coalescer->length - sensor_frame_header_len(header.flags);
+    (void)sensor_frame_header_encode(&header, p_coalescer->frame, p_coalescer->length);
+
+    memset(&evt, 0, sizeof(evt));
+    evt.type                        = SAMPLE_COALESCER_EVT_FRAME_READY;
+    evt.params.ready.p_frame        = p_coalescer->frame;
+    evt.params.ready.length         = p_coalescer->length;
+    evt.params.ready.sample_count   = p_coalescer->sample_count;
+    evt.params.ready.reason         = reason;
+    evt.params.ready.first_ticks    = p_coalescer->first_ticks;
+    evt.params.ready.close_ticks    = ticks;
+    evt.params.ready.wait_ticks_sum = (uint64_t)p_coalescer->sample_count * age - p_coalescer->age_ticks_sum;
+
+    p_stats->frames++;
+    p_stats->samples        += p_coalescer->sample_count;
+    p_stats->wait_ticks_sum += evt.params.ready.wait_ticks_sum;
+
+    if (age > p_stats->wait_ticks_max)
+    {
+        p_stats->wait_ticks_max = age;
+    }
+
+    if (reason == SAMPLE_COALESCER_REASON_FULL)
+    {
+        p_stats->full_frames++;
+    }
+    else if (reason == SAMPLE_COALESCER_REASON_DEADLINE)
+    {
+        p_stats->deadline_frames++;
+    }
+
+    // The frame is free again before the owner sees it, so the handler may add the next sample.
+    p_coalescer->length = 0;
+
+    p_coalescer->evt_handler(p_coalescer->p_context, &evt);
+}
+
+
+/**@brief Function for opening a frame for the sample added at the given time.
+ */
+static void frame_open(sample_coalescer_t * p_coalescer, uint32_t ticks)
+{
+    sample_coalescer_evt_t evt;
+    uint8_t                header_len = p_coalescer->header_len;
+    uint16_t               capacity   = (p_coalescer->frame_len - header_len) / p_coalescer->sample_size;
+
+    p_coalescer->length        = header_len;
+    p_coalescer->length_max    = (p_coalescer->encoder != NULL) ? p_coalescer->frame_len
+                                                                : header_len + capacity * p_coalescer->sample_size;
+    p_coalescer->sample_count  = 0;
+    p_coalescer->first_ticks   = ticks;
+    p_coalescer->age_ticks_sum = 0;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.type               = SAMPLE_COALESCER_EVT_FRAME_OPENED;
+    evt.params.first_ticks = ticks;
+
+    p_coalescer->evt_handler(p_coalescer->p_context, &evt);
+}
+
+
+/**@brief Function for writing a sample to the open frame.
+ *
+ * @retval true   If the sample was written.
+ * @retval false  If the sample does not fit the open frame.
+ */
+static bool sample_put(sample_coalescer_t * p_coalescer, uint8_t const * p_sample)
+{
+    uint16_t payload_len = p_coalescer->length - p_coalescer->header_len;
+
+    if (p_coalescer->encoder != NULL)
+    {
+        payload_len = p_coalescer->encoder(p_coalescer->p_encoder_context,
+                                           p_sample,
+                                           p_coalescer->sample_count,
+                                           &p_coalescer->frame[p_coalescer->header_len],
+                                           p_coalescer->length_max - p_coalescer->header_len);
+        if (payload_len == 0)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        if (p_coalescer->length + p_coalescer->sample_size > p_coalescer->length_max)
+        {
+            return false;
+        }
+
+        memcpy(&p_coalescer->frame[p_coalescer->length], p_sample, p_coalescer->sample_size);
+        payload_len += p_coalescer->sample_size;
+    }
+
+    p_coalescer->length = p_coalescer->header_len + payload_len;
+
+    return true;
+}
+
+
+bool sample_coalescer_init(sample_coalescer_t * p_coalescer, sample_coalescer_init_t const * p_init)
+{
+    if (p_init->evt_handler == NULL)
+    {
+        return false;
+    }
+
+    memset(p_coalescer, 0, sizeof(sample_coalescer_t));
+
+    p_coalescer->evt_handler       = p_init->evt_handler;
+    p_coalescer->p_context         = p_init->p_context;
+    p_coalescer->encoder           = p_init->encoder;
+    p_coalescer->p_encoder_context = p_init->p_encoder_context;
+    p_coalescer->sample_size       = p_init->sample_size;
+    p_coalescer->frame_flags       = p_init->frame_flags;
+    p_coalescer->header_len        = sensor_frame_header_len(SAMPLE_COALESCER_FRAME_FLAGS | p_init->frame_flags);
+    p_coalescer->deadline_ticks    = p_init->deadline_ticks;
+    p_coalescer->counter_mask      = p_init->counter_mask;
+
+    return sample_coalescer_frame_len_set(p_coalescer, p_init->frame_len);
+}
+
+
+bool sample_coalescer_frame_len_set(sample_coalescer_t * p_coalescer, uint16_t frame_len)
+{
+    if (frame_len > SAMPLE_COALESCER_MAX_FRAME_LEN)
+    {
+        frame_len = SAMPLE_COALESCER_MAX_FRAME_LEN;
+    }
+
+    if (!frame_len_valid(p_coalescer, frame_len))
+    {
+        return false;
+    }
+
+    p_coalescer->frame_len = frame_len;
+
+    return true;
+}
+
+
+void sample_coalescer_deadline_set(sample_coalescer_t * p_coalescer, uint32_t deadline_ticks)
+{
+    p_coalescer->deadline_ticks = deadline_ticks;
+}
+
+
+void sample_coalescer_add(sample_coalescer_t * p_coalescer, uint8_t const * p_sample, uint32_t ticks)
+{
+    // A late timer must not let the new sample stretch a frame past its deadline.
+    (void)sample_coalescer_deadline_check(p_coalescer, ticks);
+
+    if (p_coalescer->length == 0)
+    {
+        frame_open(p_coalescer, ticks);
+    }
+
+    if (!sample_put(p_coalescer, p_sample))
+    {
+        // Only an encoded sample can find the frame full, it starts the next one.
+        frame_close(p_coalescer, ticks, SAMPLE_COALESCER_REASON_FULL);
+        frame_open(p_coalescer, ticks);
+        (void)sample_put(p_coalescer, p_sample);
+    }
+
+    p_coalescer->age_ticks_sum += frame_age(p_coalescer, ticks);
+    p_coalescer->sample_count++;
+
+    if ((p_coalescer->encoder == NULL) &&
+        (p_coalescer->length + p_coalescer->sample_size > p_coalescer->length_max))
+    {
+        frame_close(p_coalescer, ticks, SAMPLE_COALESCER_REASON_FULL);
+    }
+    else
+    {
+        // A deadline of 0 sends every sample on its own.
+        (void)sample_coalescer_deadline_check(p_coalescer, ticks);
+    }
+}
+
+
+bool sample_coalescer_deadline_check(sample_coalescer_t * p_coalescer, uint32_t ticks)
+{
+    if ((p_coalescer->length == 0) || (frame_age(p_coalescer, ticks) < p_coalescer->deadline_ticks))
+    {
+        return false;
+    }
+
+    frame_close(p_coalescer, ticks, SAMPLE_COALESCER_REASON_DEADLINE);
+
+    return true;
+}
+
+
+bool sample_coalescer_deadline_get(sample_coalescer_t const * p_coalescer, uint32_t * p_ticks)
+{
+    if (p_coalescer->length == 0)
+    {
+        return false;
+    }
+
+    *p_ticks = (p_coalescer->first_ticks + p_coalescer->deadline_ticks) & p_coalescer->counter_mask;
+
+    return true;
+}
+
+
+void sample_coalescer_flush(sample_coalescer_t * p_coalescer, uint32_t ticks)
+{
+    if (p_coalescer->length != 0)
+    {
+        frame_close(p_coalescer, ticks, SAMPLE_COALESCER_REASON_FLUSH);
+    }
+}
+
+
+void sample_coalescer_reset(sample_coalescer_t * p_coalescer)
+{
+    p_coalescer->length = 0;
+    p_coalescer->seq    = 0;
+    memset(&p_coalescer->stats, 0, sizeof(p_coalescer->stats));
+}
@@ -0,0 +1,216 @@
+#ifndef __SAMPLE_COALESCER_H
+#define __SAMPLE_COALESCER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sensor_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Longest frame the coalescer builds, header included (in bytes). Fits a notification at
+ *          an ATT MTU of 247. */
+#ifndef SAMPLE_COALESCER_MAX_FRAME_LEN
+#define SAMPLE_COALESCER_MAX_FRAME_LEN      244
+#endif
+
+
+/**@brief   Coalescer event types. */
+typedef enum
+{
+    SAMPLE_COALESCER_EVT_FRAME_OPENED,  /**< The first sample went into an empty frame, the deadline starts now. */
+    SAMPLE_COALESCER_EVT_FRAME_READY,   /**< A frame is complete and must be copied out before the next sample is added. */
+} sample_coalescer_evt_type_t;
+
+
+/**@brief   Reasons for closing a frame. */
+typedef enum
+{
+    SAMPLE_COALESCER_REASON_FULL,       /**< No room for another sample. */
+    SAMPLE_COALESCER_REASON_DEADLINE,   /**< The oldest sample has waited for the deadline. */
+    SAMPLE_COALESCER_REASON_FLUSH,      /**< Closed on request, e.g. when the stream stops. */
+} sample_coalescer_reason_t;
+
+
+/**@brief   Complete frame, for @ref SAMPLE_COALESCER_EVT_FRAME_READY. */
+typedef struct
+{
+    uint8_t const           * p_frame;          /**< Frame with a @ref sensor_frame_header_t header, timestamped with the oldest sample. */
+    uint16_t                  length;           /**< Length of the frame (in bytes). */
+    uint16_t                  sample_count;     /**< Samples in the frame. */
+    sample_coalescer_reason_t reason;           /**< Why the frame was closed. */
+    uint32_t                  first_ticks;      /**< Time of the oldest sample. */
+    uint32_t                  close_ticks;      /**< Time the frame was closed. */
+    uint64_t                  wait_ticks_sum;   /**< Time the samples of the frame waited for it to close, summed over the samples. */
+} sample_coalescer_evt_ready_t;
+
+
+/**@brief   Coalescer event. */
+typedef struct
+{
+    sample_coalescer_evt_type_t type;
+    union
+    {
+        uint32_t                     first_ticks;   /**< Time of the first sample, for @ref SAMPLE_COALESCER_EVT_FRAME_OPENED. */
+        sample_coalescer_evt_ready_t ready;         /**< Complete frame, for @ref SAMPLE_COALESCER_EVT_FRAME_READY. */
+    } params;
+} sample_coalescer_evt_t;
+
+
+/**@brief   Coalescer event handler type. */
+typedef void (*sample_coalescer_evt_handler_t)(void * p_context, sample_coalescer_evt_t const * p_evt);
+
+
+/**@brief   Sample encoder type.
+ *
+ * @details Writes a sample into the payload of the open frame in an encoding of its own, e.g.
+ *          as a delta to the previous one. Every frame must decode on its own, so the first sample
+ *          of a frame must not depend on earlier frames.
+ *
+ * @param[in]     p_context     Encoder context given at initialization.
+ * @param[in]     p_sample      Sample to add.
+ * @param[in]     sample_index  Index of the sample in the frame, 0 for the first one.
+ * @param[in,out] p_payload     Payload of the open frame.
+ * @param[in]     payload_max   Longest payload (in bytes).
+ *
+ * @return  Payload length with the sample added (in bytes), 0 if it does not fit. A sample that
+ *          does not fit must leave the payload and the encoder state as they were.
+ */
+typedef uint16_t (*sample_coalescer_encoder_t)(void          * p_context,
+                                               uint8_t const * p_sample,
+                                               uint16_t        sample_index,
+                                               uint8_t       * p_payload,
+                                               uint16_t        payload_max);
+
+
+/**@brief   Coalescing statistics since the last reset. */
+typedef struct
+{
+    uint32_t frames;            /**< Frames closed. */
+    uint32_t samples;           /**< Samples in the closed frames. */
+    uint32_t full_frames;       /**< Frames closed because they were full. */
+    uint32_t deadline_frames;   /**< Frames closed by the deadline. */
+    uint64_t wait_ticks_sum;    /**< Time samples waited in a frame, summed over the samples. */
+    uint32_t wait_ticks_max;    /**< Longest time a sample waited in a frame. */
+} sample_coalescer_stats_t;
+
+
+/**@brief   Coalescer initialization structure. */
+typedef struct
+{
+    sample_coalescer_evt_handler_t evt_handler;     /**< Event handler. */
+    void                         * p_context;       /**< Passed to @p evt_handler. */
+    sample_coalescer_encoder_t     encoder;         /**< Sample encoder, NULL to copy samples as they are. */
+    void                         * p_encoder_context; /**< Passed to @p encoder. */
+    uint8_t                        sample_size;     /**< Length of every sample (in bytes). With an encoder, the longest
+                                                         the first sample of a frame may encode to. */
+    uint8_t                        frame_flags;     /**< SENSOR_FRAME_FLAG_* bits added to every frame. */
+    uint16_t                       frame_len;       /**< Longest frame, header included (in bytes). */
+    uint32_t                       deadline_ticks;  /**< Longest time the oldest sample of a frame waits (in counter ticks). */
+    uint32_t                       counter_mask;    /**< Width of the time source counter, e.g. 0x00FFFFFF for app_timer. */
+} sample_coalescer_init_t;
+
+
+/**@brief   Sample coalescer.
+ *
+ * @details Packs small fixed-size samples into frames as long as the link allows, so the per
+ *          notification overhead is paid once for many samples. A frame is closed when the next
+ *          sample would not fit or when its oldest sample has waited for the deadline, whichever
+ *          comes first. A longer deadline fills more frames at the cost of latency.
+ *
+ *          The coalescer has no timer of its own. The owner arms one for the time
+ *          @ref sample_coalescer_deadline_get returns, on @ref SAMPLE_COALESCER_EVT_FRAME_OPENED or
+ *          once after adding a batch of samples, and calls @ref sample_coalescer_deadline_check
+ *          when it expires. A check that comes late or for a frame that has since been replaced
+ *          does no harm.
+ */
+typedef struct
+{
+    sample_coalescer_evt_handler_t evt_handler;
+    void                         * p_context;
+    sample_coalescer_encoder_t     encoder;
+    void                         * p_encoder_context;
+    uint8_t                        sample_size;
+    uint8_t                        frame_flags;
+    uint8_t                        header_len;          /**< Frame header length (in bytes). */
+    uint16_t                       frame_len;           /**< Longest frame for the next frame opened (in bytes). */
+    uint32_t                       deadline_ticks;
+    uint32_t                       counter_mask;
+    uint32_t                       seq;                 /**< Sequence number of the next frame. */
+    uint16_t                       length;              /**< Bytes in the open frame, header included, 0 if no frame is open. */
+    uint16_t                       length_max;          /**< Longest length of the open frame (in bytes). */
+    uint16_t                       sample_count;        /**< Samples in the open frame. */
+    uint32_t                       first_ticks;         /**< Time of the first sample of the open frame. */
+    uint64_t                       age_ticks_sum;       /**< Sample times after @p first_ticks, summed over the open frame. */
+    sample_coalescer_stats_t       stats;
+    uint8_t                        frame[SAMPLE_COALESCER_MAX_FRAME_LEN];
+} sample_coalescer_t;
+
+
+/**@brief   Function for initializing a coalescer.
+ *
+ * @retval true   If the coalescer was initialized.
+ * @retval false  If a parameter was invalid or a sample does not fit a frame.
+ */
+bool sample_coalescer_init(sample_coalescer_t * p_coalescer, sample_coalescer_init_t const * p_init);
+
+
+/**@brief   Function for changing the longest frame, e.g. after an ATT MTU update.
+ *
+ * @details Takes effect from the next frame opened, the open frame keeps its size.
+ *
+ * @retval true   If the length was set, clamped to @ref SAMPLE_COALESCER_MAX_FRAME_LEN.
+ * @retval false  If a sample does not fit a frame of @p frame_len bytes.
+ */
+bool sample_coalescer_frame_len_set(sample_coalescer_t * p_coalescer, uint16_t frame_len);
+
+
+/**@brief   Function for changing the deadline. Takes effect at the next deadline check.
+ */
+void sample_coalescer_deadline_set(sample_coalescer_t * p_coalescer, uint32_t deadline_ticks);
+
+
+/**@brief   Function for adding a sample.
+ *
+ * @details Closes the open frame first if its deadline has passed at @p ticks, and closes the
+ *          frame the sample went into if there is no room for another. Encoded samples vary in
+ *          length, so a frame of encoded samples is closed when the next sample does not fit.
+ *
+ * @param[in] p_coalescer  Coalescer.
+ * @param[in] p_sample     Sample, of the size given at initialization.
+ * @param[in] ticks        Current counter value.
+ */
+void sample_coalescer_add(sample_coalescer_t * p_coalescer, uint8_t const * p_sample, uint32_t ticks);
+
+
+/**@brief   Function for closing the open frame if its deadline has passed.
+ *
+ * @retval true   If a frame was closed.
+ * @retval false  If no frame is open or its deadline is still ahead.
+ */
+bool sample_coalescer_deadline_check(sample_coalescer_t * p_coalescer, uint32_t ticks);
+
+
+/**@brief   Function for getting the counter value at which the open frame is due.
+ *
+ * @retval true   If a frame is open and @p p_ticks was written.
+ * @retval false  If no frame is open.
+ */
+bool sample_coalescer_deadline_get(sample_coalescer_t const * p_coalescer, uint32_t * p_ticks);
+
+
+/**@brief   Function for closing the open frame at once, if there is one.
+ */
+void sample_coalescer_flush(sample_coalescer_t * p_coalescer, uint32_t ticks);
+
+
+/**@brief   Function for dropping the open frame and clearing the sequence number and statistics.
+ */
+void sample_coalescer_reset(sample_coalescer_t * p_coalescer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SAMPLE_COALESCER_H
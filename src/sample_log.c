@@ -0,0 +1,250 @@
+#include <stddef.h>
+#include "sample_log.h"
+#include "nordic_common.h"
+#include "app_timer.h"
+#include "nrf_fstorage.h"
+#include "nrf_fstorage_sd.h"
+#include "nrf_sdh_soc.h"
+#include "flash_log.h"
+#include "transfer_stats.h"
+
+#include "nrf_log.h"
+
+
+#define TICKS_PER_SEC   (APP_TIMER_CLOCK_FREQ / (APP_TIMER_CONFIG_RTC_FREQUENCY + 1))   /**< app_timer counter frequency (in Hz). */
+
+
+static void log_fs_evt_handler(nrf_fstorage_evt_t * p_evt);
+static void soc_evt_handler(uint32_t sys_evt, void * p_context);
+
+NRF_FSTORAGE_DEF(nrf_fstorage_t m_log_fs) =
+{
+    .evt_handler = log_fs_evt_handler,
+    .start_addr  = SAMPLE_LOG_START_ADDR,
+    .end_addr    = SAMPLE_LOG_END_ADDR,
+};                                                                      /**< Flash region of the sample log. */
+
+NRF_SDH_SOC_OBSERVER(m_sample_log_soc_obs, SAMPLE_LOG_SOC_OBSERVER_PRIO, soc_evt_handler, NULL);
+
+static sample_log_evt_handler_t m_evt_handler;                          /**< Application event handler. */
+static sample_log_tx_t          m_tx;                                   /**< Sends a record. */
+static flash_log_t              m_log;                                  /**< Records, keep the stream while the link is down. */
+static uint32_t                 m_in_flight      = 0;                   /**< Records queued in the SoftDevice. */
+static uint32_t                 m_time_ms        = 0;                   /**< Log time, the timestamp of records (in ms). */
+static uint32_t                 m_clock_ticks    = 0;                   /**< Counter value the log time was last advanced at. */
+static uint32_t                 m_clock_rem      = 0;                   /**< Part of a ms not yet added to the log time (in ticks x 1000). */
+static bool                     m_replay_pending = false;               /**< A replay waits for the records in flight. */
+static uint32_t                 m_replay_since   = 0;                   /**< Log time the pending replay starts from (in ms). */
+
+
+static void evt_send(sample_log_evt_type_t type)
+{
+    sample_log_evt_t evt;
+
+    evt.type         = type;
+    evt.unsent_count = flash_log_unsent_count(&m_log);
+
+    m_evt_handler(&evt);
+}
+
+
+/**@brief Function for handling the events of the flash log.
+ */
+static void flash_log_evt_handler(flash_log_evt_t const * p_evt)
+{
+    if (p_evt->type == FLASH_LOG_EVT_ERROR)
+    {
+        NRF_LOG_WARNING("Sample log flash operation failed, error 0x%x.", p_evt->result);
+    }
+
+    evt_send(SAMPLE_LOG_EVT_FLASH_READY);
+}
+
+
+/**@brief Function for handling the events of the flash region of the sample log.
+ */
+static void log_fs_evt_handler(nrf_fstorage_evt_t * p_evt)
+{
+    flash_log_on_fs_evt(&m_log, p_evt);
+}
+
+
+/**@brief Function for handling SoC events.
+ *
+ * @details Every flash operation, of Peer Manager as of the log, ends with a SoC event. The fstorage
+ *          queue has room again once its backend has handled it, a drain mark that found the queue
+ *          full is written then.
+ */
+static void soc_evt_handler(uint32_t sys_evt, void * p_context)
+{
+    UNUSED_PARAMETER(p_context);
+
+    if ((sys_evt == NRF_EVT_FLASH_OPERATION_SUCCESS) || (sys_evt == NRF_EVT_FLASH_OPERATION_ERROR))
+    {
+        flash_log_retry(&m_log);
+    }
+}
+
+
+/**@brief Function for moving the send cursor back to @ref m_replay_since once no record is in
+ *        flight.
+ */
+static void replay_start(void)
+{
+    ret_code_t err_code;
+
+    if (m_in_flight > 0)
+    {
+        return;
+    }
+
+    m_replay_pending = false;
+
+    err_code = flash_log_seek(&m_log, m_replay_since);
+    if (err_code != NRF_SUCCESS)
+    {
+        NRF_LOG_WARNING("Sample log replay failed, error 0x%x.", err_code);
+        return;
+    }
+
+    NRF_LOG_INFO("Sample log replay: %d frames.", flash_log_unsent_count(&m_log));
+
+    evt_send(SAMPLE_LOG_EVT_REPLAY_STARTED);
+}
+
+
+ret_code_t sample_log_init(sample_log_init_t const * p_init)
+{
+    ret_code_t err_code;
+
+    if ((p_init == NULL) || (p_init->evt_handler == NULL) || (p_init->tx == NULL))
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    m_evt_handler = p_init->evt_handler;
+    m_tx          = p_init->tx;
+
+    err_code = nrf_fstorage_init(&m_log_fs, &nrf_fstorage_sd, NULL);
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
+    err_code = flash_log_init(&m_log, &m_log_fs, flash_log_evt_handler);
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
+    // Log time goes on from the newest record.
+    if (flash_log_last_timestamp_get(&m_log, &m_time_ms))
+    {
+        m_time_ms++;
+    }
+
+    NRF_LOG_INFO("Sample log: %d frames not yet sent, log time %d ms.", flash_log_unsent_count(&m_log), m_time_ms);
+
+    return NRF_SUCCESS;
+}
+
+
+bool sample_log_send(uint16_t max_len)
+{
+    uint8_t const * p_record;
+    uint16_t        length;
+
+    if (m_replay_pending)
+    {
+        return false;
+    }
+
+    while (flash_log_peek_mapped(&m_log, &p_record, &length) == NRF_SUCCESS)
+    {
+        if (length > max_len)
+        {
+            return false;
+        }
+
+        if (m_tx(p_record, length) != NRF_SUCCESS)
+        {
+            // Sent from the next TX complete event, or again once the link is back.
+            return false;
+        }
+
+        flash_log_release(&m_log);
+        m_in_flight++;
+    }
+
+    return flash_log_is_drained(&m_log);
+}
+
+
+ret_code_t sample_log_append(uint8_t const * p_frame, uint16_t length)
+{
+    return flash_log_append(&m_log, p_frame, length, m_time_ms);
+}
+
+
+void sample_log_on_tx_complete(uint16_t count)
+{
+    uint32_t delivered = MIN(count, m_in_flight);
+
+    if (delivered == 0)
+    {
+        return;
+    }
+
+    m_in_flight -= delivered;
+    flash_log_ack(&m_log, delivered);
+
+    if (m_replay_pending)
+    {
+        replay_start();
+        return;
+    }
+
+    if ((m_in_flight == 0) && flash_log_is_drained(&m_log))
+    {
+        NRF_LOG_INFO("Sample log drained.");
+        evt_send(SAMPLE_LOG_EVT_DRAINED);
+    }
+}
+
+
+void sample_log_link_lost(void)
+{
+    flash_log_rewind(&m_log);
+    m_in_flight      = 0;
+    m_replay_pending = false;
+}
+
+
+void sample_log_replay(uint32_t age_s)
+{
+    m_replay_since   = m_time_ms - MIN(age_s, INT32_MAX / 1000) * 1000;
+    m_replay_pending = true;
+    replay_start();
+}
+
+
+void sample_log_clock_start(uint32_t ticks)
+{
+    m_clock_ticks = ticks;
+}
+
+
+void sample_log_clock_update(uint32_t ticks)
+{
+    m_clock_rem  += ((ticks - m_clock_ticks) & TRANSFER_STATS_COUNTER_MASK) * 1000;
+    m_clock_ticks = ticks;
+
+    m_time_ms   += m_clock_rem / TICKS_PER_SEC;
+    m_clock_rem %= TICKS_PER_SEC;
+}
+
+
+uint32_t sample_log_unsent_count(void)
+{
+    return flash_log_unsent_count(&m_log);
+}
@@ -0,0 +1,158 @@
+#ifndef __SAMPLE_LOG_H
+#define __SAMPLE_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Start of the flash region of the sample log, the 16 pages below FDS. The application
+ *          FLASH_SIZE ends here. */
+#ifndef SAMPLE_LOG_START_ADDR
+#define SAMPLE_LOG_START_ADDR       0x6D000
+#endif
+
+/**@brief   End of the flash region of the sample log, the first page of FDS. */
+#ifndef SAMPLE_LOG_END_ADDR
+#define SAMPLE_LOG_END_ADDR         0x7D000
+#endif
+
+/**@brief   Priority of the SoC event observer, after the one of the fstorage SoftDevice backend. */
+#ifndef SAMPLE_LOG_SOC_OBSERVER_PRIO
+#define SAMPLE_LOG_SOC_OBSERVER_PRIO 1
+#endif
+
+
+/**@brief   Sample log event types. */
+typedef enum
+{
+    SAMPLE_LOG_EVT_FLASH_READY,     /**< A flash operation ended, frames that waited for it can be appended. */
+    SAMPLE_LOG_EVT_REPLAY_STARTED,  /**< The send cursor moved back for a replay. */
+    SAMPLE_LOG_EVT_DRAINED,         /**< Every record of the log has been delivered. */
+} sample_log_evt_type_t;
+
+
+/**@brief   Sample log event structure. */
+typedef struct
+{
+    sample_log_evt_type_t type;         /**< Event type. */
+    uint32_t              unsent_count; /**< Records not yet sent. */
+} sample_log_evt_t;
+
+
+/**@brief   Sample log event handler type. */
+typedef void (* sample_log_evt_handler_t)(sample_log_evt_t const * p_evt);
+
+
+/**@brief   Function type for sending one record as a notification.
+ *
+ * @param[in] p_record  Record, a complete frame mapped in flash.
+ * @param[in] length    Length of @p p_record (in bytes).
+ *
+ * @retval NRF_SUCCESS  If the notification was queued.
+ * @return Otherwise the record is sent again later.
+ */
+typedef ret_code_t (* sample_log_tx_t)(uint8_t const * p_record, uint16_t length);
+
+
+/**@brief   Sample log initialization structure. */
+typedef struct
+{
+    sample_log_evt_handler_t evt_handler;   /**< Event handler, called from the SoftDevice or timer interrupt. */
+    sample_log_tx_t          tx;            /**< Sends a record. */
+} sample_log_init_t;
+
+
+/**@brief   Function for opening the sample log.
+ *
+ * @details Frames stored before a reset and not yet delivered are kept for the next link, and the
+ *          log time goes on from the newest record.
+ *
+ * @note    The SoftDevice must be enabled first, the log is written through nrf_fstorage_sd.
+ *
+ * @param[in] p_init  Initialization parameters.
+ *
+ * @retval NRF_SUCCESS     If the log was opened.
+ * @retval NRF_ERROR_NULL  If @p p_init or a callback was NULL.
+ * @return Otherwise an error code from nrf_fstorage or the flash log.
+ */
+ret_code_t sample_log_init(sample_log_init_t const * p_init);
+
+
+/**@brief   Function for sending the records of the sample log until it is drained or the HVN TX
+ *          queue is full.
+ *
+ * @details Records go out whole, one notification each, so a record longer than @p max_len waits
+ *          for the ATT MTU to be raised. Notifications are sent straight from flash, the log keeps
+ *          the page of a record from being erased until its TX complete event, or until the link
+ *          is lost.
+ *
+ * @param[in] max_len  Longest notification the link takes (in bytes).
+ *
+ * @return  true if every record of the log has been sent.
+ */
+bool sample_log_send(uint16_t max_len);
+
+
+/**@brief   Function for storing a frame, stamped with the current log time.
+ *
+ * @retval NRF_SUCCESS       If the frame is being stored.
+ * @retval NRF_ERROR_BUSY    If a flash operation is running, or the page to erase holds records
+ *                           in flight. Try again on @ref SAMPLE_LOG_EVT_FLASH_READY or once they
+ *                           are delivered.
+ * @retval NRF_ERROR_NO_MEM  If the fstorage queue is full, try again on
+ *                           @ref SAMPLE_LOG_EVT_FLASH_READY.
+ * @return Otherwise the frame cannot be stored, see @ref flash_log_append.
+ */
+ret_code_t sample_log_append(uint8_t const * p_frame, uint16_t length);
+
+
+/**@brief   Function for moving the drain cursor past the records delivered.
+ *
+ * @param[in] count  Records of the log completed.
+ */
+void sample_log_on_tx_complete(uint16_t count);
+
+
+/**@brief   Function for handling the loss of the link records are sent on. Records in flight may
+ *          not have been delivered, they are sent again.
+ */
+void sample_log_link_lost(void);
+
+
+/**@brief   Function for sending the records of the last @p age_s seconds again.
+ *
+ * @details The send cursor only moves back once no record is in flight, the replay waits for the
+ *          TX complete events of those otherwise. @ref SAMPLE_LOG_EVT_REPLAY_STARTED is reported
+ *          when it does. Ages beyond half the range of the log time reach back to the oldest
+ *          record.
+ */
+void sample_log_replay(uint32_t age_s);
+
+
+/**@brief   Function for restarting the log clock, the log time stands still until then.
+ *
+ * @param[in] ticks  Current app_timer counter value.
+ */
+void sample_log_clock_start(uint32_t ticks);
+
+
+/**@brief   Function for advancing the log time to @p ticks.
+ *
+ * @details Call it more often than the counter wraps, e.g. every sampling period.
+ */
+void sample_log_clock_update(uint32_t ticks);
+
+
+/**@brief   Function for getting the number of records not yet sent.
+ */
+uint32_t sample_log_unsent_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SAMPLE_LOG_H
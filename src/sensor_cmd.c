@@ -0,0 +1,163 @@
+#include <string.h>
+#include "sensor_cmd.h"
+
+
+#define OFFSET_OPCODE       0
+#define OFFSET_LENGTH       1
+#define OFFSET_RATE         5
+#define OFFSET_VALUE        1
+#define OFFSET_BENCH_LENGTH 2
+#define OFFSET_ACK_SEQ      1
+#define OFFSET_ACK_BITMAP   5
+#define OFFSET_DEADLINE     2
+#define OFFSET_AGE          1
+
+
+static uint16_t uint16_get(uint8_t const * p_buf)
+{
+    return (uint16_t)(p_buf[0] | (p_buf[1] << 8));
+}
+
+
+static uint32_t uint32_get(uint8_t const * p_buf)
+{
+    return ((uint32_t)p_buf[0])
+         | ((uint32_t)p_buf[1] << 8)
+         | ((uint32_t)p_buf[2] << 16)
+         | ((uint32_t)p_buf[3] << 24);
+}
+
+
+/**@brief Function for decoding the optional parameters of a start command.
+ */
+static bool start_decode(uint8_t const * p_data, uint16_t length, sensor_cmd_t * p_cmd)
+{
+    switch (length)
+    {
+        case OFFSET_RATE + sizeof(uint16_t):
+            p_cmd->rate_kbps = uint16_get(&p_data[OFFSET_RATE]);
+            // fall through
+        case OFFSET_LENGTH + sizeof(uint32_t):
+            p_cmd->has_length = true;
+            p_cmd->length     = uint32_get(&p_data[OFFSET_LENGTH]);
+            // fall through
+        case OFFSET_LENGTH:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+
+/**@brief Function for decoding the optional parameters of a benchmark command.
+ */
+static bool bench_decode(uint8_t const * p_data, uint16_t length, sensor_cmd_t * p_cmd)
+{
+    switch (length)
+    {
+        case OFFSET_BENCH_LENGTH + sizeof(uint32_t):
+            p_cmd->has_length = true;
+            p_cmd->length     = uint32_get(&p_data[OFFSET_BENCH_LENGTH]);
+            // fall through
+        case OFFSET_VALUE + sizeof(uint8_t):
+            p_cmd->value = p_data[OFFSET_VALUE];
+            // fall through
+        case OFFSET_VALUE:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+
+/**@brief Function for decoding the parameters of an acknowledgement.
+ */
+static bool ack_decode(uint8_t const * p_data, uint16_t length, sensor_cmd_t * p_cmd)
+{
+    switch (length)
+    {
+        case OFFSET_ACK_BITMAP + sizeof(uint32_t):
+            p_cmd->bitmap = uint32_get(&p_data[OFFSET_ACK_BITMAP]);
+            // fall through
+        case OFFSET_ACK_SEQ + sizeof(uint32_t):
+            p_cmd->seq = uint32_get(&p_data[OFFSET_ACK_SEQ]);
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+
+/**@brief Function for decoding the parameters of a stream command.
+ */
+static bool stream_decode(uint8_t const * p_data, uint16_t length, sensor_cmd_t * p_cmd)
+{
+    switch (length)
+    {
+        case OFFSET_DEADLINE + sizeof(uint16_t):
+            p_cmd->deadline_ms = uint16_get(&p_data[OFFSET_DEADLINE]);
+            // fall through
+        case OFFSET_VALUE + sizeof(uint8_t):
+            p_cmd->value = p_data[OFFSET_VALUE];
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+
+bool sensor_cmd_decode(uint8_t const * p_data, uint16_t length, sensor_cmd_t * p_cmd)
+{
+    if ((p_data == NULL) || (length == 0))
+    {
+        return false;
+    }
+
+    memset(p_cmd, 0, sizeof(sensor_cmd_t));
+    p_cmd->opcode = p_data[OFFSET_OPCODE];
+
+    switch (p_cmd->opcode)
+    {
+        case SENSOR_CMD_START_TRANSFER:
+            return start_decode(p_data, length, p_cmd);
+
+        case SENSOR_CMD_START_QUEUE_SWEEP:
+        case SENSOR_CMD_STOP_TRANSFER:
+        case SENSOR_CMD_ABORT_TRANSFER:
+            return (length == OFFSET_LENGTH);
+
+        case SENSOR_CMD_CONN_PROFILE_SET:
+        case SENSOR_CMD_CONN_EVT_EXT_SET:
+        case SENSOR_CMD_RELIABLE_SET:
+            if (length != OFFSET_VALUE + sizeof(uint8_t))
+            {
+                return false;
+            }
+            p_cmd->value = p_data[OFFSET_VALUE];
+            return true;
+
+        case SENSOR_CMD_BENCH_START:
+            return bench_decode(p_data, length, p_cmd);
+
+        case SENSOR_CMD_ACK:
+            return ack_decode(p_data, length, p_cmd);
+
+        case SENSOR_CMD_STREAM_SET:
+            return stream_decode(p_data, length, p_cmd);
+
+        case SENSOR_CMD_LOG_REPLAY:
+            if (length != OFFSET_AGE + sizeof(uint32_t))
+            {
+                return false;
+            }
+            p_cmd->age_s = uint32_get(&p_data[OFFSET_AGE]);
+            return true;
+
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,115 @@
+#ifndef __SENSOR_CMD_H
+#define __SENSOR_CMD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Char1 command opcodes.
+ *
+ * Every command starts with a one byte opcode, multi-byte parameters are little endian.
+ *
+ * | Opcode | Parameters                                        | Action                                  |
+ * |--------|---------------------------------------------------|-----------------------------------------|
+ * | 0x01   | [length u32] [rate u16]                           | Start a transfer                        |
+ * | 0x02   | -                                                 | Sweep the HVN TX queue depth            |
+ * | 0x03   | -                                                 | Stop after the queued frames, send END  |
+ * | 0x04   | -                                                 | Abort at once, no END frame             |
+ * | 0x05   | profile u8                                        | Connection profile of the next link     |
+ * | 0x06   | enable u8                                         | Connection event extension on or off    |
+ * | 0x07   | [mode u8] [length u32]                            | Run the benchmark matrix                |
+ * | 0x08   | next_seq u32 [bitmap u32]                         | Acknowledge reliable stream frames      |
+ * | 0x09   | enable u8                                         | Reliable stream mode on or off          |
+ * | 0x0A   | mode u8 [deadline u16]                            | Sampled sensor stream on or off         |
+ * | 0x0B   | age u32                                           | Send the sample log again, age s back   |
+ *
+ * Start parameters are optional and may be cut short: a lone 0x01 starts a transfer of the
+ * default length with no rate limit. A length of 0 streams until stopped. The rate is the target
+ * notification rate in kbit/s, 0 for as fast as the link allows.
+ *
+ * Benchmark parameters are optional too: mode 0 measures over the air, mode 1 runs the matrix on
+ * the link model. The length is the payload sent for every cell.
+ *
+ * An acknowledgement reports every frame before next_seq as received. Bit i of the optional
+ * bitmap is set if frame next_seq + 1 + i was received, so frame next_seq and every clear bit
+ * below the highest set one are missing and are sent again. The END frame is acknowledged like
+ * a data frame. The reliable mode takes effect on the next start.
+ *
+ * Stream mode 0 stops the stream, 1 starts it, 2 starts it with LZSS compressed payloads and 3
+ * with delta encoded samples. A delta encoded frame decodes on its own.
+ * The compressor history runs across frames and frames lost to a full ring never reach it, so a
+ * receiver decodes every frame it gets, in order, even across sequence gaps. Frames whose payload
+ * does not shrink are sent without @ref SENSOR_FRAME_FLAG_COMPRESSED but still extend the history.
+ *
+ * The stream packs its samples into frames as long as the ATT MTU allows. The optional deadline
+ * is the longest time in ms a sample waits for its frame to fill before the frame is sent anyway,
+ * 0 or left out for the firmware default.
+ *
+ * The sample log holds the stream frames produced while the link was down. A replay sends every
+ * frame still in it since the given age, in s of log time, before the stream goes on. Log time
+ * runs while the stream runs and carries on across resets.
+ */
+#define SENSOR_CMD_START_TRANSFER           0x01
+#define SENSOR_CMD_START_QUEUE_SWEEP        0x02
+#define SENSOR_CMD_STOP_TRANSFER            0x03
+#define SENSOR_CMD_ABORT_TRANSFER           0x04
+#define SENSOR_CMD_CONN_PROFILE_SET         0x05
+#define SENSOR_CMD_CONN_EVT_EXT_SET         0x06
+#define SENSOR_CMD_BENCH_START              0x07
+#define SENSOR_CMD_ACK                      0x08
+#define SENSOR_CMD_RELIABLE_SET             0x09
+#define SENSOR_CMD_STREAM_SET               0x0A
+#define SENSOR_CMD_LOG_REPLAY               0x0B
+
+/**@brief   Benchmark modes. */
+#define SENSOR_CMD_BENCH_MODE_AIR           0
+#define SENSOR_CMD_BENCH_MODE_SIMULATED     1
+
+/**@brief   Stream modes. */
+#define SENSOR_CMD_STREAM_OFF               0
+#define SENSOR_CMD_STREAM_ON                1
+#define SENSOR_CMD_STREAM_COMPRESSED        2
+#define SENSOR_CMD_STREAM_DELTA             3
+
+/**@brief   Transfer length that streams until a stop or abort command. */
+#define SENSOR_CMD_LENGTH_UNBOUNDED         0
+
+/**@brief   Longest command (in bytes). */
+#define SENSOR_CMD_MAX_LEN                  9
+
+
+/**@brief   Decoded char1 command. */
+typedef struct
+{
+    uint8_t  opcode;        /**< SENSOR_CMD_* opcode. */
+    bool     has_length;    /**< @p length was sent, use the default length otherwise. */
+    uint32_t length;        /**< Amount of payload to transfer (in bytes), @ref SENSOR_CMD_LENGTH_UNBOUNDED to stream.
+                                 Payload of every cell for @ref SENSOR_CMD_BENCH_START. */
+    uint16_t rate_kbps;     /**< Target notification rate (in kbit/s), 0 for no limit. */
+    uint8_t  value;         /**< Parameter of a one byte parameter command, mode of @ref SENSOR_CMD_BENCH_START. */
+    uint32_t seq;           /**< First frame not received, for @ref SENSOR_CMD_ACK. */
+    uint32_t bitmap;        /**< Frames received after @p seq, 0 if the bitmap was left out. */
+    uint16_t deadline_ms;   /**< Coalescing deadline of @ref SENSOR_CMD_STREAM_SET (in ms), 0 for the default. */
+    uint32_t age_s;         /**< Age of the oldest frame sent by @ref SENSOR_CMD_LOG_REPLAY (in s). */
+} sensor_cmd_t;
+
+
+/**@brief   Function for decoding a char1 write.
+ *
+ * @param[in]  p_data  Written value.
+ * @param[in]  length  Length of @p p_data (in bytes).
+ * @param[out] p_cmd   Decoded command.
+ *
+ * @retval true   If the write is a known command with well-formed parameters.
+ * @retval false  If the opcode is unknown or a parameter is truncated.
+ */
+bool sensor_cmd_decode(uint8_t const * p_data, uint16_t length, sensor_cmd_t * p_cmd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SENSOR_CMD_H
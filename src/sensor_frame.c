@@ -0,0 +1,150 @@
+#include <string.h>
+#include "sensor_frame.h"
+#include "crc16.h"
+
+
+#define OFFSET_VERSION      0
+#define OFFSET_FLAGS        1
+#define OFFSET_PAYLOAD_LEN  2
+#define OFFSET_SEQ          4
+#define OFFSET_TIMESTAMP    8
+
+
+static void uint16_put(uint8_t * p_buf, uint16_t value)
+{
+    p_buf[0] = (uint8_t)(value);
+    p_buf[1] = (uint8_t)(value >> 8);
+}
+
+
+static void uint32_put(uint8_t * p_buf, uint32_t value)
+{
+    p_buf[0] = (uint8_t)(value);
+    p_buf[1] = (uint8_t)(value >> 8);
+    p_buf[2] = (uint8_t)(value >> 16);
+    p_buf[3] = (uint8_t)(value >> 24);
+}
+
+
+static uint16_t uint16_get(uint8_t const * p_buf)
+{
+    return (uint16_t)(p_buf[0] | (p_buf[1] << 8));
+}
+
+
+static uint32_t uint32_get(uint8_t const * p_buf)
+{
+    return ((uint32_t)p_buf[0])
+         | ((uint32_t)p_buf[1] << 8)
+         | ((uint32_t)p_buf[2] << 16)
+         | ((uint32_t)p_buf[3] << 24);
+}
+
+
+uint8_t sensor_frame_header_len(uint8_t flags)
+{
+    return (flags & SENSOR_FRAME_FLAG_TIMESTAMP) ? SENSOR_FRAME_HEADER_MAX_LEN : SENSOR_FRAME_HEADER_LEN;
+}
+
+
+uint8_t sensor_frame_header_encode(sensor_frame_header_t const * p_header, uint8_t * p_buf, uint16_t buf_len)
+{
+    uint8_t header_len = sensor_frame_header_len(p_header->flags);
+
+    if (buf_len < header_len)
+    {
+        return 0;
+    }
+
+    p_buf[OFFSET_VERSION] = SENSOR_FRAME_VERSION;
+    p_buf[OFFSET_FLAGS]   = p_header->flags;
+    uint16_put(&p_buf[OFFSET_PAYLOAD_LEN], p_header->payload_len);
+    uint32_put(&p_buf[OFFSET_SEQ], p_header->seq);
+
+    if (p_header->flags & SENSOR_FRAME_FLAG_TIMESTAMP)
+    {
+        uint32_put(&p_buf[OFFSET_TIMESTAMP], p_header->timestamp);
+    }
+
+    return header_len;
+}
+
+
+void sensor_frame_seq_patch(uint8_t * p_buf, uint32_t seq)
+{
+    uint32_put(&p_buf[OFFSET_SEQ], seq);
+}
+
+
+void sensor_frame_flags_patch(uint8_t * p_buf, uint8_t flags)
+{
+    p_buf[OFFSET_FLAGS] = flags;
+}
+
+
+void sensor_frame_timestamp_patch(uint8_t * p_buf, uint32_t timestamp)
+{
+    uint32_put(&p_buf[OFFSET_TIMESTAMP], timestamp);
+}
+
+
+void sensor_frame_crc_patch(uint8_t * p_buf, uint16_t payload_crc)
+{
+    uint8_t  header_len = sensor_frame_header_len(p_buf[OFFSET_FLAGS]);
+    uint16_t data_len   = uint16_get(&p_buf[OFFSET_PAYLOAD_LEN]) - SENSOR_FRAME_CRC_LEN;
+    uint16_t crc        = crc16_compute(p_buf, header_len, &payload_crc);
+
+    uint16_put(&p_buf[header_len + data_len], crc);
+}
+
+
+bool sensor_frame_crc_check(uint8_t const * p_buf, uint16_t buf_len)
+{
+    uint8_t  header_len = sensor_frame_header_len(p_buf[OFFSET_FLAGS]);
+    uint16_t crc;
+
+    if (!(p_buf[OFFSET_FLAGS] & SENSOR_FRAME_FLAG_CRC))
+    {
+        return true;
+    }
+
+    if (buf_len < header_len + SENSOR_FRAME_CRC_LEN)
+    {
+        return false;
+    }
+
+    crc = crc16_compute(&p_buf[header_len], buf_len - header_len - SENSOR_FRAME_CRC_LEN, NULL);
+    crc = crc16_compute(p_buf, header_len, &crc);
+
+    return crc == uint16_get(&p_buf[buf_len - SENSOR_FRAME_CRC_LEN]);
+}
+
+
+uint8_t sensor_frame_header_decode(uint8_t const * p_buf, uint16_t buf_len, sensor_frame_header_t * p_header)
+{
+    uint8_t header_len;
+
+    if ((buf_len < SENSOR_FRAME_HEADER_LEN) || (p_buf[OFFSET_VERSION] != SENSOR_FRAME_VERSION))
+    {
+        return 0;
+    }
+
+    memset(p_header, 0, sizeof(sensor_frame_header_t));
+    p_header->version     = p_buf[OFFSET_VERSION];
+    p_header->flags       = p_buf[OFFSET_FLAGS];
+    p_header->payload_len = uint16_get(&p_buf[OFFSET_PAYLOAD_LEN]);
+    p_header->seq         = uint32_get(&p_buf[OFFSET_SEQ]);
+
+    header_len = sensor_frame_header_len(p_header->flags);
+    if ((buf_len < header_len) || ((uint32_t)header_len + p_header->payload_len != buf_len))
+    {
+        return 0;
+    }
+
+    if (p_header->flags & SENSOR_FRAME_FLAG_TIMESTAMP)
+    {
+        p_header->timestamp = uint32_get(&p_buf[OFFSET_TIMESTAMP]);
+    }
+
+    return header_len;
+}
@@ -0,0 +1,127 @@
+#ifndef __SENSOR_FRAME_H
+#define __SENSOR_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Version of the char2 frame format written by this firmware. */
+#define SENSOR_FRAME_VERSION                1
+
+/**@brief   Frame header layout, all fields little endian.
+ *
+ * | Offset | Size | Field                                          |
+ * |--------|------|------------------------------------------------|
+ * | 0      | 1    | Version, @ref SENSOR_FRAME_VERSION              |
+ * | 1      | 1    | Flags, SENSOR_FRAME_FLAG_*                     |
+ * | 2      | 2    | Payload length (in bytes)                      |
+ * | 4      | 4    | Sequence number, 0 for the first frame         |
+ * | 8      | 4    | Timestamp (app_timer ticks), only if flagged   |
+ *
+ * A frame flagged with @ref SENSOR_FRAME_FLAG_CRC ends with a CRC16 (CCITT, crc16_compute of the
+ * SDK) of @ref SENSOR_FRAME_CRC_LEN bytes, counted in the payload length. It is computed over the
+ * rest of the payload first and the header after it, so the CRC of a payload that does not change
+ * from frame to frame is only computed once.
+ */
+#define SENSOR_FRAME_HEADER_LEN             8
+#define SENSOR_FRAME_TIMESTAMP_LEN          4
+#define SENSOR_FRAME_HEADER_MAX_LEN         (SENSOR_FRAME_HEADER_LEN + SENSOR_FRAME_TIMESTAMP_LEN)
+#define SENSOR_FRAME_CRC_LEN                2
+
+/**@brief   Payload of the END frame: frame_crc32_compute of the data of all data packets in
+ *          sequence order, without frame headers and CRC16 trailers, little endian. */
+#define SENSOR_FRAME_END_PAYLOAD_LEN        4
+
+#define SENSOR_FRAME_FLAG_TIMESTAMP         0x01    /**< A timestamp follows the sequence number. */
+#define SENSOR_FRAME_FLAG_END               0x02    /**< Last frame of a transfer, carries the transfer CRC32. */
+#define SENSOR_FRAME_FLAG_RETX              0x04    /**< Frame sent again after a NACK, the sequence number is not new. */
+#define SENSOR_FRAME_FLAG_COMPRESSED        0x08    /**< The payload is an LZSS block, see lzss.h. */
+#define SENSOR_FRAME_FLAG_DELTA             0x10    /**< The payload is delta encoded samples, see delta_pack.h. */
+#define SENSOR_FRAME_FLAG_CRC               0x20    /**< The payload ends with a CRC16 of the frame. */
+
+
+/**@brief   Decoded frame header. */
+typedef struct
+{
+    uint8_t  version;       /**< Frame format version. */
+    uint8_t  flags;         /**< SENSOR_FRAME_FLAG_* bits. */
+    uint16_t payload_len;   /**< Length of the payload after the header (in bytes). */
+    uint32_t seq;           /**< Sequence number. */
+    uint32_t timestamp;     /**< Timestamp, valid if @ref SENSOR_FRAME_FLAG_TIMESTAMP is set. */
+} sensor_frame_header_t;
+
+
+/**@brief   Function for getting the encoded length of a header with the given flags (in bytes).
+ */
+uint8_t sensor_frame_header_len(uint8_t flags);
+
+
+/**@brief   Function for encoding a frame header.
+ *
+ * @param[in]  p_header  Header to encode. The version field is ignored, @ref SENSOR_FRAME_VERSION is written.
+ * @param[out] p_buf     Destination.
+ * @param[in]  buf_len   Size of @p p_buf (in bytes).
+ *
+ * @return  Number of bytes written, 0 if @p p_buf is too small.
+ */
+uint8_t sensor_frame_header_encode(sensor_frame_header_t const * p_header, uint8_t * p_buf, uint16_t buf_len);
+
+
+/**@brief   Function for writing only the sequence number of an encoded header.
+ *
+ * @details Lets a pre-built frame be reused with a new sequence number.
+ */
+void sensor_frame_seq_patch(uint8_t * p_buf, uint32_t seq);
+
+
+/**@brief   Function for writing only the flags of an encoded header.
+ */
+void sensor_frame_flags_patch(uint8_t * p_buf, uint8_t flags);
+
+
+/**@brief   Function for writing only the timestamp of an encoded header that has one.
+ */
+void sensor_frame_timestamp_patch(uint8_t * p_buf, uint32_t timestamp);
+
+
+/**@brief   Function for writing the CRC16 trailer of an encoded frame that has one.
+ *
+ * @details Only the header is read, so a frame whose payload is the same as before only costs the
+ *          CRC of its header.
+ *
+ * @param[in,out] p_buf        Encoded frame, trailer included.
+ * @param[in]     payload_crc  crc16_compute of the payload without the trailer, from a NULL start.
+ */
+void sensor_frame_crc_patch(uint8_t * p_buf, uint16_t payload_crc);
+
+
+/**@brief   Function for checking the CRC16 trailer of a received frame.
+ *
+ * @param[in]  p_buf    Received frame, with a header that has been decoded.
+ * @param[in]  buf_len  Length of the received frame (in bytes).
+ *
+ * @retval true   If the frame has no trailer or the trailer matches.
+ * @retval false  If the trailer does not match, or the frame is too short for one.
+ */
+bool sensor_frame_crc_check(uint8_t const * p_buf, uint16_t buf_len);
+
+
+/**@brief   Function for decoding a frame header.
+ *
+ * @param[in]  p_buf     Received frame.
+ * @param[in]  buf_len   Length of the received frame (in bytes).
+ * @param[out] p_header  Decoded header.
+ *
+ * @return  Header length (in bytes), 0 if the frame is truncated, of an unknown version, or its
+ *          payload length does not match @p buf_len.
+ */
+uint8_t sensor_frame_header_decode(uint8_t const * p_buf, uint16_t buf_len, sensor_frame_header_t * p_header);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SENSOR_FRAME_H
@@ -0,0 +1,537 @@
+#include <string.h>
+#include "sensor_stream.h"
+#include "nordic_common.h"
+#include "cycle_counter.h"
+#include "app_error.h"
+#include "app_timer.h"
+#include "sensor_cmd.h"
+#include "sensor_frame.h"
+#include "frame_ring.h"
+#include "sample_coalescer.h"
+#include "sample_log.h"
+#include "lzss.h"
+#include "delta_pack.h"
+#include "transfer_stats.h"
+
+#include "nrf_log.h"
+
+
+#define SAMPLE_SIZE     DELTA_PACK_SAMPLE_LEN                                           /**< Length of one sample, e.g. two 3-axis 16-bit readings (in bytes). */
+#define ADC_MAX         ((1 << DELTA_PACK_SAMPLE_BITS) - 1)                             /**< Largest reading of the stand-in ADC channels. */
+#define TICKS_PER_SEC   (APP_TIMER_CLOCK_FREQ / (APP_TIMER_CONFIG_RTC_FREQUENCY + 1))   /**< app_timer counter frequency (in Hz). */
+
+
+APP_TIMER_DEF(m_stream_timer_id);                                                      /**< Sampling timer. */
+APP_TIMER_DEF(m_coalesce_timer_id);                                                    /**< Deadline timer of the frame being filled. */
+FRAME_RING_DEF(m_stream_ring, SENSOR_STREAM_SLOT_SIZE, SENSOR_STREAM_SLOT_COUNT);      /**< Frames produced by the stream timer and drained by the TX path. */
+
+static sensor_stream_evt_handler_t    m_evt_handler;                                   /**< Application event handler. */
+static sensor_stream_tx_t             m_tx;                                            /**< Sends a frame. */
+static sensor_stream_link_get_t       m_link_get;                                      /**< Tells whether frames may be sent now. */
+
+static bool                           m_running     = false;                           /**< The stream is on. */
+static uint8_t                        m_mode        = SENSOR_CMD_STREAM_ON;            /**< Payload encoding, SENSOR_CMD_STREAM_* mode. */
+static uint32_t                       m_period_ms   = SENSOR_STREAM_PERIOD_MS;         /**< Current sampling period (in ms). */
+static uint32_t                       m_deadline_ms = SENSOR_STREAM_DEADLINE_MS;       /**< Coalescing deadline (in ms). */
+static uint32_t                       m_sent        = 0;                               /**< Frames accepted by the SoftDevice. */
+static uint32_t                       m_overflows   = 0;                               /**< Frames lost to a full ring. */
+static uint32_t                       m_logged      = 0;                               /**< Frames stored in the sample log. */
+static int16_t                        m_channels[SAMPLE_SIZE / sizeof(int16_t)];       /**< Last reading of every stand-in sensor channel. */
+static uint32_t                       m_noise       = 1;                               /**< State of the noise generator of the stand-in channels. */
+static sensor_stream_compress_stats_t m_compress_stats;                                /**< What the compressor did since the stream started. */
+static lzss_encoder_t                 m_lzss_encoder;                                  /**< Compressor of the payloads, history runs across frames. */
+static delta_pack_encoder_t           m_delta_encoder;                                 /**< Delta encoder of the samples. */
+static sample_coalescer_t             m_coalescer;                                     /**< Packs samples into frames for the ring. */
+
+
+/**@brief Function for the longest frame, the shorter of a ring slot and a notification.
+ */
+static uint16_t frame_len_max(uint16_t max_len)
+{
+    return MIN(SENSOR_STREAM_SLOT_SIZE - FRAME_RING_LENGTH_LEN, max_len);
+}
+
+
+/**@brief Function for changing the sampling period of the running stream.
+ */
+static void period_set(uint32_t period_ms)
+{
+    ret_code_t err_code;
+
+    if (period_ms == m_period_ms)
+    {
+        return;
+    }
+
+    m_period_ms = period_ms;
+
+    (void)app_timer_stop(m_stream_timer_id);
+    err_code = app_timer_start(m_stream_timer_id, APP_TIMER_TICKS(m_period_ms), NULL);
+    APP_ERROR_CHECK(err_code);
+}
+
+
+/**@brief Function for compressing the payload of a frame into its ring slot.
+ *
+ * @details The frame is sent as it is if its payload does not shrink. Either way the payload is
+ *          part of the compressor history, so the receiver must feed it to its decoder too.
+ *
+ * @param[in]  p_frame  Frame built by the coalescer.
+ * @param[in]  length   Length of @p p_frame (in bytes).
+ * @param[out] p_slot   Ring slot, at least @p length bytes.
+ *
+ * @return  Length of the frame written to @p p_slot (in bytes).
+ */
+static uint16_t frame_compress(uint8_t const * p_frame, uint16_t length, uint8_t * p_slot)
+{
+    sensor_frame_header_t header;
+    uint8_t               header_len = sensor_frame_header_decode(p_frame, length, &header);
+    uint32_t              cycles     = cycle_counter_get();
+    uint16_t              packed_len;
+
+    packed_len = lzss_encode(&m_lzss_encoder,
+                             &p_frame[header_len],
+                             header.payload_len,
+                             &p_slot[header_len],
+                             header.payload_len - 1);
+
+    m_compress_stats.cycles        += cycle_counter_get() - cycles;
+    m_compress_stats.raw_bytes     += length;
+    m_compress_stats.payload_bytes += header.payload_len;
+    m_compress_stats.frames++;
+
+    if (packed_len == 0)
+    {
+        memcpy(p_slot, p_frame, length);
+        m_compress_stats.packed_bytes += length;
+        return length;
+    }
+
+    header.flags      |= SENSOR_FRAME_FLAG_COMPRESSED;
+    header.payload_len = packed_len;
+    (void)sensor_frame_header_encode(&header, p_slot, header_len + packed_len);
+
+    m_compress_stats.packed_bytes += header_len + packed_len;
+
+    return header_len + packed_len;
+}
+
+
+/**@brief Function for handling the events of the coalescer.
+ *
+ * @details Moves every complete frame into the ring. A frame that finds the ring full is lost,
+ *          its sequence number still counts so the receiver sees the gap.
+ *
+ *          The deadline timer is not touched here. Frames open and close many times in one
+ *          sampling period at a small ATT MTU, and app_timer operations started from its own
+ *          interrupt are only processed once the handler returns, so one per frame would overrun
+ *          the operation queue. See @ref coalesce_timer_arm.
+ */
+static void coalescer_evt_handler(void * p_context, sample_coalescer_evt_t const * p_evt)
+{
+    uint8_t  * p_frame;
+    uint16_t   max_len;
+    uint16_t   length;
+
+    if (p_evt->type == SAMPLE_COALESCER_EVT_FRAME_OPENED)
+    {
+        return;
+    }
+
+    // Frames are no longer than a ring slot, see frame_len_max.
+    if (frame_ring_reserve(&m_stream_ring, &p_frame, &max_len) != NRF_SUCCESS)
+    {
+        // The link is slower than the producer.
+        m_overflows++;
+        return;
+    }
+
+    if (m_mode == SENSOR_CMD_STREAM_COMPRESSED)
+    {
+        length = frame_compress(p_evt->params.ready.p_frame, p_evt->params.ready.length, p_frame);
+    }
+    else
+    {
+        length = p_evt->params.ready.length;
+        memcpy(p_frame, p_evt->params.ready.p_frame, length);
+    }
+
+    (void)frame_ring_commit(&m_stream_ring, length);
+}
+
+
+/**@brief Function for arming the deadline timer for the frame being filled, if there is one.
+ *
+ * @details Called once after every batch of samples and from the timer itself, so it costs at most
+ *          two app_timer operations per sampling period whatever the frame length.
+ */
+static void coalesce_timer_arm(void)
+{
+    ret_code_t err_code;
+    uint32_t   due;
+    uint32_t   ticks;
+
+    (void)app_timer_stop(m_coalesce_timer_id);
+
+    if (!sample_coalescer_deadline_get(&m_coalescer, &due))
+    {
+        return;
+    }
+
+    ticks = (due - app_timer_cnt_get()) & TRANSFER_STATS_COUNTER_MASK;
+    if (ticks > m_coalescer.deadline_ticks)
+    {
+        // Already due, the counter has moved past it.
+        ticks = 0;
+    }
+
+    err_code = app_timer_start(m_coalesce_timer_id, MAX(ticks, APP_TIMER_MIN_TIMEOUT_TICKS), NULL);
+    APP_ERROR_CHECK(err_code);
+}
+
+
+/**@brief Function for closing the frame being filled once its oldest sample has waited for the deadline.
+ */
+static void coalesce_timeout_handler(void * p_context)
+{
+    if (!m_running)
+    {
+        return;
+    }
+
+    if (sample_coalescer_deadline_check(&m_coalescer, app_timer_cnt_get()))
+    {
+        sensor_stream_drain();
+    }
+    else
+    {
+        // Woke up a tick early.
+        coalesce_timer_arm();
+    }
+}
+
+
+/**@brief Function for getting the next sample of the stand-in sensor.
+ *
+ * @details Every channel is a 12-bit reading that drifts by at most one step per sample, like a
+ *          slowly changing ADC input with a little noise.
+ */
+static void sample_get(uint8_t * p_sample)
+{
+    for (uint8_t i = 0; i < ARRAY_SIZE(m_channels); i++)
+    {
+        int16_t step;
+
+        m_noise = m_noise * 1664525UL + 1013904223UL;
+        step    = (int16_t)((m_noise >> 24) % 3) - 1;
+
+        m_channels[i] = MIN(MAX(m_channels[i] + step, 0), ADC_MAX);
+
+        p_sample[2 * i]     = (uint8_t)m_channels[i];
+        p_sample[2 * i + 1] = (uint8_t)(m_channels[i] >> 8);
+    }
+}
+
+
+/**@brief Function for producing the samples of one sampling period.
+ *
+ * @details Samples are packed into frames by @ref m_coalescer, which hands full frames, and frames
+ *          whose deadline has passed, to the ring. The samples are a stand-in for sensor readings.
+ */
+static void stream_timeout_handler(void * p_context)
+{
+    uint8_t  sample[SAMPLE_SIZE];
+    uint32_t ticks = app_timer_cnt_get();
+
+    sample_log_clock_update(ticks);
+
+    for (uint8_t i = 0; i < SENSOR_STREAM_SAMPLES_PER_PERIOD; i++)
+    {
+        sample_get(sample);
+        sample_coalescer_add(&m_coalescer, sample, ticks);
+    }
+
+    coalesce_timer_arm();
+    sensor_stream_drain();
+}
+
+
+/**@brief Function for delta encoding a sample into the frame being filled.
+ *
+ * @details Matches @ref sample_coalescer_encoder_t.
+ */
+static uint16_t sample_encode(void          * p_context,
+                              uint8_t const * p_sample,
+                              uint16_t        sample_index,
+                              uint8_t       * p_payload,
+                              uint16_t        payload_max)
+{
+    return delta_pack_sample_put(&m_delta_encoder, p_sample, sample_index, p_payload, payload_max);
+}
+
+
+/**@brief Function for logging how well the stream compressed.
+ */
+static void compress_report(void)
+{
+    sensor_stream_compress_stats_t const * p_stats = &m_compress_stats;
+
+    if ((p_stats->packed_bytes == 0) || (p_stats->payload_bytes == 0))
+    {
+        return;
+    }
+
+    NRF_LOG_INFO("Compression: %d -> %d bytes, ratio %d.%02d, %d.%02d cycles/byte.",
+                 p_stats->raw_bytes,
+                 p_stats->packed_bytes,
+                 (p_stats->raw_bytes * 100 / p_stats->packed_bytes) / 100,
+                 (p_stats->raw_bytes * 100 / p_stats->packed_bytes) % 100,
+                 (uint32_t)(((uint64_t)p_stats->cycles * 100 / p_stats->payload_bytes) / 100),
+                 (uint32_t)(((uint64_t)p_stats->cycles * 100 / p_stats->payload_bytes) % 100));
+}
+
+
+ret_code_t sensor_stream_init(sensor_stream_init_t const * p_init)
+{
+    ret_code_t err_code;
+
+    if ((p_init == NULL) || (p_init->evt_handler == NULL) || (p_init->tx == NULL) || (p_init->link_get == NULL))
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    m_evt_handler = p_init->evt_handler;
+    m_tx          = p_init->tx;
+    m_link_get    = p_init->link_get;
+
+    err_code = app_timer_create(&m_stream_timer_id, APP_TIMER_MODE_REPEATED, stream_timeout_handler);
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
+    return app_timer_create(&m_coalesce_timer_id, APP_TIMER_MODE_SINGLE_SHOT, coalesce_timeout_handler);
+}
+
+
+void sensor_stream_start(uint8_t mode, uint32_t deadline_ms)
+{
+    ret_code_t              err_code;
+    sample_coalescer_init_t coalescer_init;
+    sensor_stream_evt_t     evt;
+    uint16_t                max_len;
+
+    if (m_running)
+    {
+        return;
+    }
+
+    m_mode        = mode;
+    m_deadline_ms = (deadline_ms != 0) ? deadline_ms : SENSOR_STREAM_DEADLINE_MS;
+
+    (void)m_link_get(&max_len);
+
+    frame_ring_init(&m_stream_ring);
+
+    memset(&coalescer_init, 0, sizeof(coalescer_init));
+    coalescer_init.evt_handler    = coalescer_evt_handler;
+    coalescer_init.sample_size    = SAMPLE_SIZE;
+    coalescer_init.frame_len      = frame_len_max(max_len);
+    coalescer_init.deadline_ticks = APP_TIMER_TICKS(m_deadline_ms);
+    coalescer_init.counter_mask   = TRANSFER_STATS_COUNTER_MASK;
+
+    if (m_mode == SENSOR_CMD_STREAM_DELTA)
+    {
+        coalescer_init.encoder     = sample_encode;
+        coalescer_init.sample_size = DELTA_PACK_FIRST_SAMPLE_MAX_LEN;
+        coalescer_init.frame_flags = SENSOR_FRAME_FLAG_DELTA;
+    }
+
+    if (!sample_coalescer_init(&m_coalescer, &coalescer_init))
+    {
+        NRF_LOG_WARNING("Stream ignored, a sample does not fit a frame.");
+        return;
+    }
+
+    for (uint8_t i = 0; i < ARRAY_SIZE(m_channels); i++)
+    {
+        m_channels[i] = ADC_MAX / 2;
+    }
+
+    if (m_mode == SENSOR_CMD_STREAM_COMPRESSED)
+    {
+        lzss_encoder_init(&m_lzss_encoder);
+
+        // The cycle counter times the compressor.
+        cycle_counter_enable();
+    }
+
+    memset(&m_compress_stats, 0, sizeof(m_compress_stats));
+    m_sent      = 0;
+    m_overflows = 0;
+    m_logged    = 0;
+    m_period_ms = SENSOR_STREAM_PERIOD_MS;
+    m_running   = true;
+    sample_log_clock_start(app_timer_cnt_get());
+
+    evt.type = SENSOR_STREAM_EVT_STARTED;
+    m_evt_handler(&evt);
+
+    err_code = app_timer_start(m_stream_timer_id, APP_TIMER_TICKS(m_period_ms), NULL);
+    APP_ERROR_CHECK(err_code);
+
+    NRF_LOG_INFO("Stream started, %d samples every %d ms, %d ms coalescing deadline, mode %d.",
+                 SENSOR_STREAM_SAMPLES_PER_PERIOD,
+                 SENSOR_STREAM_PERIOD_MS,
+                 m_deadline_ms,
+                 m_mode);
+}
+
+
+void sensor_stream_stop(void)
+{
+    sample_coalescer_stats_t const * p_stats = &m_coalescer.stats;
+    sensor_stream_evt_t              evt;
+
+    if (!m_running)
+    {
+        return;
+    }
+
+    m_running = false;
+    (void)app_timer_stop(m_stream_timer_id);
+    (void)app_timer_stop(m_coalesce_timer_id);
+
+    NRF_LOG_INFO("Stream stopped, %d frames sent, %d stored in the sample log, %d lost to a full ring.",
+                 m_sent,
+                 m_logged,
+                 m_overflows);
+
+    if (p_stats->frames > 0)
+    {
+        NRF_LOG_INFO("Coalescing: %d samples per frame, %d by deadline, %d us average wait, %d us worst.",
+                     p_stats->samples / p_stats->frames,
+                     p_stats->deadline_frames,
+                     (uint32_t)((p_stats->wait_ticks_sum * 1000000) / ((uint64_t)p_stats->samples * TICKS_PER_SEC)),
+                     (uint32_t)(((uint64_t)p_stats->wait_ticks_max * 1000000) / TICKS_PER_SEC));
+    }
+
+    if (m_mode == SENSOR_CMD_STREAM_COMPRESSED)
+    {
+        compress_report();
+    }
+
+    evt.type                    = SENSOR_STREAM_EVT_STOPPED;
+    evt.params.p_compress_stats = ((m_mode == SENSOR_CMD_STREAM_COMPRESSED) && (m_compress_stats.frames > 0))
+                                  ? &m_compress_stats : NULL;
+    m_evt_handler(&evt);
+}
+
+
+void sensor_stream_drain(void)
+{
+    ret_code_t          err_code;
+    uint8_t const     * p_frame;
+    uint16_t            length;
+    uint16_t            max_len;
+    sensor_stream_evt_t evt;
+    bool                is_link_up = m_link_get(&max_len);
+    bool                is_logging = !is_link_up || !sample_log_send(max_len);
+
+    if (!m_running)
+    {
+        return;
+    }
+
+    while (frame_ring_peek(&m_stream_ring, &p_frame, &length) == NRF_SUCCESS)
+    {
+        if (is_logging || (length > max_len))
+        {
+            err_code = sample_log_append(p_frame, length);
+            if ((err_code == NRF_ERROR_BUSY) || (err_code == NRF_ERROR_NO_MEM))
+            {
+                // Stored from the next sample log event, or once records in flight are delivered.
+                (void)frame_ring_peek_cancel(&m_stream_ring);
+                break;
+            }
+
+            (void)frame_ring_release(&m_stream_ring);
+
+            if (err_code == NRF_SUCCESS)
+            {
+                m_logged++;
+            }
+            else
+            {
+                NRF_LOG_WARNING("Frame not logged, error 0x%x.", err_code);
+            }
+
+            // Later frames follow it through the log.
+            is_logging = true;
+            continue;
+        }
+
+        err_code = m_tx(p_frame, length);
+        if (err_code == NRF_ERROR_RESOURCES)
+        {
+            // Sent from the next TX complete event.
+            (void)frame_ring_peek_cancel(&m_stream_ring);
+            return;
+        }
+
+        // The SoftDevice has copied the frame, or will never take it.
+        (void)frame_ring_release(&m_stream_ring);
+
+        if (err_code != NRF_SUCCESS)
+        {
+            NRF_LOG_WARNING("Stream stopped, error 0x%x.", err_code);
+            sensor_stream_stop();
+            return;
+        }
+
+        m_sent++;
+    }
+
+    if (!is_link_up)
+    {
+        return;
+    }
+
+    // Every frame in the ring is one notification of the current length.
+    evt.type                 = SENSOR_STREAM_EVT_BACKLOG;
+    evt.params.backlog_bytes = frame_ring_count(&m_stream_ring) * frame_len_max(max_len);
+    m_evt_handler(&evt);
+}
+
+
+void sensor_stream_backlog_set(bool is_high)
+{
+    if (!m_running)
+    {
+        return;
+    }
+
+    if (is_high)
+    {
+        period_set(MIN(m_period_ms * 2, SENSOR_STREAM_PERIOD_MAX_MS));
+    }
+    else
+    {
+        period_set(MAX(m_period_ms / 2, SENSOR_STREAM_PERIOD_MS));
+    }
+}
+
+
+void sensor_stream_frame_len_set(uint16_t max_len)
+{
+    if (m_running)
+    {
+        (void)sample_coalescer_frame_len_set(&m_coalescer, frame_len_max(max_len));
+    }
+}
+
+
+bool sensor_stream_is_running(void)
+{
+    return m_running;
+}
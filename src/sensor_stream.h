@@ -0,0 +1,174 @@
+#ifndef __SENSOR_STREAM_H
+#define __SENSOR_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Ring slot of one streamed frame, length prefix included (in bytes). */
+#ifndef SENSOR_STREAM_SLOT_SIZE
+#define SENSOR_STREAM_SLOT_SIZE             256
+#endif
+
+/**@brief   Frames buffered between the stream producer and the link. */
+#ifndef SENSOR_STREAM_SLOT_COUNT
+#define SENSOR_STREAM_SLOT_COUNT            16
+#endif
+
+/**@brief   Sampling period of the stream producer at full rate (in ms). */
+#ifndef SENSOR_STREAM_PERIOD_MS
+#define SENSOR_STREAM_PERIOD_MS             10
+#endif
+
+/**@brief   Longest sampling period the stream backs off to (in ms). */
+#ifndef SENSOR_STREAM_PERIOD_MAX_MS
+#define SENSOR_STREAM_PERIOD_MAX_MS         80
+#endif
+
+/**@brief   Samples produced every sampling period. */
+#ifndef SENSOR_STREAM_SAMPLES_PER_PERIOD
+#define SENSOR_STREAM_SAMPLES_PER_PERIOD    16
+#endif
+
+/**@brief   Default longest time a sample waits for its frame to fill (in ms). */
+#ifndef SENSOR_STREAM_DEADLINE_MS
+#define SENSOR_STREAM_DEADLINE_MS           20
+#endif
+
+
+/**@brief   Sensor stream event types. */
+typedef enum
+{
+    SENSOR_STREAM_EVT_STARTED,      /**< The stream was started. */
+    SENSOR_STREAM_EVT_STOPPED,      /**< The stream was stopped, on request or because a frame could not be sent. */
+    SENSOR_STREAM_EVT_BACKLOG,      /**< Frames waiting in the ring after a drain, see @ref sensor_stream_evt_t::backlog_bytes. */
+} sensor_stream_evt_type_t;
+
+
+/**@brief   What the compressor did while the stream ran. */
+typedef struct
+{
+    uint32_t frames;            /**< Frames that went through the compressor. */
+    uint32_t raw_bytes;         /**< Frame bytes before compression, headers included. */
+    uint32_t packed_bytes;      /**< Frame bytes after compression, headers included. */
+    uint32_t payload_bytes;     /**< Payload bytes handed to the compressor, headers excluded. */
+    uint32_t cycles;            /**< CPU cycles spent compressing. */
+} sensor_stream_compress_stats_t;
+
+
+/**@brief   Sensor stream event structure. */
+typedef struct
+{
+    sensor_stream_evt_type_t type;                      /**< Event type. */
+    union
+    {
+        uint32_t                               backlog_bytes;       /**< @ref SENSOR_STREAM_EVT_BACKLOG: bytes of notifications in the ring. */
+        sensor_stream_compress_stats_t const * p_compress_stats;    /**< @ref SENSOR_STREAM_EVT_STOPPED: compressor statistics, NULL if the stream was not compressed. */
+    } params;
+} sensor_stream_evt_t;
+
+
+/**@brief   Sensor stream event handler type. */
+typedef void (* sensor_stream_evt_handler_t)(sensor_stream_evt_t const * p_evt);
+
+
+/**@brief   Function type for sending one frame as a notification.
+ *
+ * @retval NRF_SUCCESS          If the notification was queued.
+ * @retval NRF_ERROR_RESOURCES  If the HVN TX queue is full, the frame is sent again on the next
+ *                              @ref sensor_stream_drain.
+ * @return Otherwise the stream is stopped.
+ */
+typedef ret_code_t (* sensor_stream_tx_t)(uint8_t const * p_frame, uint16_t length);
+
+
+/**@brief   Function type for getting the state of the link frames are sent on.
+ *
+ * @param[out] p_max_len  Longest notification the link takes (in bytes), also while it is down.
+ *
+ * @return  true if frames may be sent, false if they go to the sample log.
+ */
+typedef bool (* sensor_stream_link_get_t)(uint16_t * p_max_len);
+
+
+/**@brief   Sensor stream initialization structure. */
+typedef struct
+{
+    sensor_stream_evt_handler_t evt_handler;    /**< Event handler, called from the SoftDevice or timer interrupt. */
+    sensor_stream_tx_t          tx;             /**< Sends a frame. */
+    sensor_stream_link_get_t    link_get;       /**< Tells whether frames may be sent now. */
+} sensor_stream_init_t;
+
+
+/**@brief   Function for initializing the sensor stream.
+ *
+ * @note    The application timer module and the sample log must be initialized first.
+ *
+ * @param[in] p_init  Initialization parameters.
+ *
+ * @retval NRF_SUCCESS     If the stream was initialized.
+ * @retval NRF_ERROR_NULL  If @p p_init or a callback was NULL.
+ * @return Otherwise an error code from the timer module.
+ */
+ret_code_t sensor_stream_init(sensor_stream_init_t const * p_init);
+
+
+/**@brief   Function for starting the sensor stream.
+ *
+ * @details Samples of a stand-in sensor are packed into frames no longer than a notification,
+ *          and sent as the link takes them. While the link is down, or the sample log still has
+ *          records to send, frames are stored in the log instead, so they reach the central in
+ *          the order they were produced.
+ *
+ * @param[in] mode         Payload encoding, SENSOR_CMD_STREAM_ON, _COMPRESSED or _DELTA.
+ * @param[in] deadline_ms  Longest time a sample waits for its frame to fill (in ms), 0 for
+ *                         @ref SENSOR_STREAM_DEADLINE_MS.
+ */
+void sensor_stream_start(uint8_t mode, uint32_t deadline_ms);
+
+
+/**@brief   Function for stopping the sensor stream. Frames still in the ring, and the frame being
+ *          filled, are dropped.
+ */
+void sensor_stream_stop(void);
+
+
+/**@brief   Function for sending what the sample log holds, then the streamed frames, until the
+ *          ring is empty or the HVN TX queue is full.
+ *
+ * @details Consumer side of the stream ring. Call it from the TX complete event and whenever the
+ *          link or the sample log changes state. It must share one interrupt priority with the
+ *          stream timer, so only one consumer ever runs at a time.
+ */
+void sensor_stream_drain(void);
+
+
+/**@brief   Function for adapting the sampling period to the backlog of the link.
+ *
+ * @details The sampling period doubles on every high watermark, up to
+ *          @ref SENSOR_STREAM_PERIOD_MAX_MS, and halves on every low one, down to
+ *          @ref SENSOR_STREAM_PERIOD_MS.
+ *
+ * @param[in] is_high  true on a high watermark, false on a low one.
+ */
+void sensor_stream_backlog_set(bool is_high);
+
+
+/**@brief   Function for letting frames opened from now on grow to a new notification length.
+ */
+void sensor_stream_frame_len_set(uint16_t max_len);
+
+
+/**@brief   Function for checking whether the stream is on.
+ */
+bool sensor_stream_is_running(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SENSOR_STREAM_H
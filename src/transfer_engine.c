@@ -0,0 +1,657 @@
+#include <string.h>
+#include "transfer_engine.h"
+#include "frame_crc.h"
+#include "crc16.h"
+#include "nrf_error.h"
+
+
+/**@brief Function for fetching the next burst of packets from the packet source.
+ */
+static void burst_fetch(transfer_engine_t * p_engine)
+{
+    uint16_t max_count = TRANSFER_ENGINE_BURST_MAX;
+
+    if (!p_engine->is_unbounded && (p_engine->packets_left < TRANSFER_ENGINE_BURST_MAX))
+    {
+        max_count = (uint16_t)p_engine->packets_left;
+    }
+
+    packet_src_next(&p_engine->src, p_engine->packets_sent, max_count, p_engine->time_func(), &p_engine->staged);
+}
+
+
+/**@brief Function for encoding the end-of-transfer frame.
+ *
+ * @param[in] p_engine     Transfer engine instance.
+ * @param[in] extra_flags  Flags added to those of the data frames besides SENSOR_FRAME_FLAG_END.
+ *
+ * @return  Length of the frame (in bytes).
+ */
+static uint16_t end_frame_build(transfer_engine_t * p_engine, uint8_t extra_flags)
+{
+    sensor_frame_header_t header;
+    uint8_t               header_len;
+    uint8_t             * p_payload;
+
+    memset(&header, 0, sizeof(header));
+    header.flags       = SENSOR_FRAME_FLAG_END | extra_flags | p_engine->frame_flags;
+    header.payload_len = SENSOR_FRAME_END_PAYLOAD_LEN;
+    header.seq         = p_engine->packets_sent;
+    header.timestamp   = p_engine->time_func();
+
+    if (p_engine->frame_flags & SENSOR_FRAME_FLAG_CRC)
+    {
+        header.payload_len += SENSOR_FRAME_CRC_LEN;
+    }
+
+    header_len = sensor_frame_header_encode(&header, p_engine->end_frame, sizeof(p_engine->end_frame));
+    p_payload  = &p_engine->end_frame[header_len];
+
+    p_payload[0] = (uint8_t)(p_engine->data_crc32);
+    p_payload[1] = (uint8_t)(p_engine->data_crc32 >> 8);
+    p_payload[2] = (uint8_t)(p_engine->data_crc32 >> 16);
+    p_payload[3] = (uint8_t)(p_engine->data_crc32 >> 24);
+
+    if (p_engine->frame_flags & SENSOR_FRAME_FLAG_CRC)
+    {
+        sensor_frame_crc_patch(p_engine->end_frame, crc16_compute(p_payload, SENSOR_FRAME_END_PAYLOAD_LEN, NULL));
+    }
+
+    return header_len + header.payload_len;
+}
+
+
+/**@brief Function for reporting the end of a transfer to the application.
+ */
+static void transfer_finish(transfer_engine_t * p_engine, transfer_engine_evt_type_t type, ret_code_t err_code)
+{
+    transfer_engine_evt_t evt;
+
+    p_engine->is_running = false;
+    transfer_stats_time_update(&p_engine->stats, p_engine->time_func());
+
+    memset(&evt, 0, sizeof(evt));
+    evt.type         = type;
+    evt.err_code     = err_code;
+    evt.packets_sent = p_engine->packets_sent;
+    evt.busy_count   = p_engine->busy_count;
+    evt.retx_count   = p_engine->retx_count;
+    evt.packet_size  = p_engine->packet_size;
+    evt.data_crc32   = p_engine->data_crc32;
+    evt.p_stats      = &p_engine->stats;
+
+    if (p_engine->evt_handler != NULL)
+    {
+        p_engine->evt_handler(&evt);
+    }
+}
+
+
+/**@brief Function for limiting a burst to the configured queue depth.
+ *
+ * @return  Number of the @p count packets that may be queued now.
+ */
+static uint16_t queue_room(transfer_engine_t const * p_engine, uint16_t count)
+{
+    uint32_t room;
+
+    if (p_engine->queue_limit == 0)
+    {
+        return count;
+    }
+
+    room = (p_engine->in_flight < p_engine->queue_limit) ? (p_engine->queue_limit - p_engine->in_flight) : 0;
+
+    return (room < count) ? (uint16_t)room : count;
+}
+
+
+/**@brief Function for limiting a burst to the credit of a paced transfer.
+ *
+ * @return  Number of the @p count packets of @p length bytes that may be queued now.
+ */
+static uint16_t credit_room(transfer_engine_t const * p_engine, uint16_t count, uint16_t length)
+{
+    uint32_t room;
+
+    if (!p_engine->is_paced || (count == 0))
+    {
+        return count;
+    }
+
+    room = p_engine->credit / length;
+
+    return (room < count) ? (uint16_t)room : count;
+}
+
+
+/**@brief Function for limiting a burst to the retransmit window of a reliable transfer.
+ *
+ * @return  Number of the @p count frames that may be sent now.
+ */
+static uint16_t window_room(transfer_engine_t const * p_engine, uint16_t count)
+{
+    uint32_t outstanding;
+    uint32_t room;
+
+    if (!p_engine->is_reliable)
+    {
+        return count;
+    }
+
+    outstanding = p_engine->packets_sent - p_engine->ack_seq;
+    room        = (outstanding < p_engine->window) ? (p_engine->window - outstanding) : 0;
+
+    return (room < count) ? (uint16_t)room : count;
+}
+
+
+/**@brief Function for getting the number of frames sent so far, the END frame included.
+ */
+static uint32_t seq_end(transfer_engine_t const * p_engine)
+{
+    return p_engine->packets_sent + (p_engine->is_end_sent ? 1 : 0);
+}
+
+
+static bool retx_is_marked(transfer_engine_t const * p_engine, uint32_t seq)
+{
+    uint32_t bit = seq % TRANSFER_ENGINE_WINDOW_MAX;
+
+    return (p_engine->retx_map[bit / 32] & (1UL << (bit % 32))) != 0;
+}
+
+
+static void retx_mark(transfer_engine_t * p_engine, uint32_t seq)
+{
+    uint32_t bit = seq % TRANSFER_ENGINE_WINDOW_MAX;
+
+    if (!retx_is_marked(p_engine, seq))
+    {
+        p_engine->retx_map[bit / 32] |= (1UL << (bit % 32));
+        p_engine->retx_pending++;
+    }
+}
+
+
+static void retx_clear(transfer_engine_t * p_engine, uint32_t seq)
+{
+    uint32_t bit = seq % TRANSFER_ENGINE_WINDOW_MAX;
+
+    if (retx_is_marked(p_engine, seq))
+    {
+        p_engine->retx_map[bit / 32] &= ~(1UL << (bit % 32));
+        p_engine->retx_pending--;
+    }
+}
+
+
+/**@brief Function for getting the frame header length of every data packet (in bytes).
+ */
+static uint8_t data_header_len(transfer_engine_t const * p_engine)
+{
+    return sensor_frame_header_len(p_engine->frame_flags);
+}
+
+
+/**@brief Function for getting the length of the CRC16 trailer of every data packet (in bytes).
+ */
+static uint8_t data_crc_len(transfer_engine_t const * p_engine)
+{
+    return (p_engine->frame_flags & SENSOR_FRAME_FLAG_CRC) ? SENSOR_FRAME_CRC_LEN : 0;
+}
+
+
+/**@brief Function for adding the data of packets just queued to the transfer CRC32.
+ *
+ * @details Packets are added as they are queued for the first time, in sequence order, so the CRC
+ *          takes one pass over the data and neither frames sent again nor packets fetched but
+ *          dropped count.
+ */
+static void data_crc_update(transfer_engine_t * p_engine, uint8_t const * p_data, uint16_t count)
+{
+    uint8_t  header_len = data_header_len(p_engine);
+    uint16_t data_len   = p_engine->staged.length - header_len - data_crc_len(p_engine);
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        p_engine->data_crc32 = frame_crc32_compute(p_data + header_len, data_len, &p_engine->data_crc32);
+        p_data              += p_engine->staged.stride;
+    }
+}
+
+
+/**@brief Function for sending the frames marked as missing again, oldest first.
+ *
+ * @details Frames are rebuilt from the packet source rather than kept, so the window costs one
+ *          bit per frame. Marked frames always lie within a window of the first unacknowledged
+ *          one.
+ *
+ * @return  true once none is left, false if the queue filled up or the transfer ended.
+ */
+static bool retx_fill(transfer_engine_t * p_engine)
+{
+    ret_code_t         err_code;
+    uint16_t           queued;
+    uint32_t           seq;
+    bool               is_end;
+    packet_src_burst_t burst;
+
+    while (p_engine->retx_pending > 0)
+    {
+        if (queue_room(p_engine, 1) == 0)
+        {
+            return false;
+        }
+
+        seq = p_engine->ack_seq;
+        while (!retx_is_marked(p_engine, seq))
+        {
+            seq++;
+        }
+
+        is_end = p_engine->is_end_sent && (seq == p_engine->packets_sent);
+        if (is_end)
+        {
+            burst.length = end_frame_build(p_engine, SENSOR_FRAME_FLAG_RETX);
+            burst.p_data = p_engine->end_frame;
+        }
+        else
+        {
+            // Staged packets share the templates, they are fetched again afterwards.
+            p_engine->staged.count = 0;
+            packet_src_next(&p_engine->src, seq, 1, p_engine->time_func(), &burst);
+            sensor_frame_flags_patch((uint8_t *)burst.p_data, SENSOR_FRAME_FLAG_RETX | p_engine->frame_flags);
+
+            if (p_engine->frame_flags & SENSOR_FRAME_FLAG_CRC)
+            {
+                // The flags are covered by the trailer. A frame sent again is rare enough to take
+                // a pass over its data.
+                sensor_frame_crc_patch((uint8_t *)burst.p_data,
+                                       crc16_compute(burst.p_data + data_header_len(p_engine),
+                                                     burst.length - data_header_len(p_engine) - SENSOR_FRAME_CRC_LEN,
+                                                     NULL));
+            }
+        }
+
+        err_code = p_engine->tx_func(p_engine->p_tx_context, burst.p_data, burst.length, burst.length, 1, &queued);
+
+        if (!is_end)
+        {
+            // The frame has been copied or rejected, the template is clean for the next burst,
+            // which patches the trailer again.
+            sensor_frame_flags_patch((uint8_t *)burst.p_data, p_engine->frame_flags);
+        }
+
+        if (err_code == NRF_ERROR_RESOURCES)
+        {
+            p_engine->busy_count++;
+            return false;
+        }
+        if (err_code != NRF_SUCCESS)
+        {
+            transfer_finish(p_engine, TRANSFER_ENGINE_EVT_ABORTED, err_code);
+            return false;
+        }
+
+        retx_clear(p_engine, seq);
+        p_engine->in_flight++;
+        p_engine->retx_count++;
+    }
+
+    return true;
+}
+
+
+/**@brief Function for queueing packets until the SoftDevice runs out of buffers.
+ */
+static void queue_fill(transfer_engine_t * p_engine)
+{
+    ret_code_t err_code;
+    uint16_t   queued;
+    uint16_t   count;
+
+    if (!retx_fill(p_engine))
+    {
+        return;
+    }
+
+    while ((p_engine->packets_left > 0) || p_engine->is_unbounded)
+    {
+        if (p_engine->staged.count == 0)
+        {
+            burst_fetch(p_engine);
+        }
+
+        count = queue_room(p_engine, p_engine->staged.count);
+        count = credit_room(p_engine, count, p_engine->staged.length);
+        count = window_room(p_engine, count);
+        if (count == 0)
+        {
+            return;
+        }
+
+        err_code = p_engine->tx_func(p_engine->p_tx_context,
+                                     p_engine->staged.p_data,
+                                     p_engine->staged.length,
+                                     p_engine->staged.stride,
+                                     count,
+                                     &queued);
+
+        data_crc_update(p_engine, p_engine->staged.p_data, queued);
+
+        p_engine->staged.p_data += (uint32_t)queued * p_engine->staged.stride;
+        p_engine->staged.count  -= queued;
+        p_engine->packets_sent += queued;
+        p_engine->in_flight    += queued;
+
+        if (!p_engine->is_unbounded)
+        {
+            p_engine->packets_left -= queued;
+        }
+        if (p_engine->is_paced)
+        {
+            p_engine->credit -= (uint32_t)queued * p_engine->staged.length;
+        }
+
+        transfer_stats_on_queued(&p_engine->stats,
+                                 queued,
+                                 p_engine->staged.length,
+                                 data_header_len(p_engine) + data_crc_len(p_engine));
+
+        if (err_code == NRF_ERROR_RESOURCES)
+        {
+            p_engine->busy_count++;
+            return;
+        }
+        if (err_code != NRF_SUCCESS)
+        {
+            transfer_finish(p_engine, TRANSFER_ENGINE_EVT_ABORTED, err_code);
+            return;
+        }
+    }
+
+    if (!p_engine->is_end_sent)
+    {
+        uint16_t end_len;
+
+        if ((queue_room(p_engine, 1) == 0) || (window_room(p_engine, 1) == 0))
+        {
+            return;
+        }
+
+        end_len  = end_frame_build(p_engine, 0);
+        err_code = p_engine->tx_func(p_engine->p_tx_context,
+                                     p_engine->end_frame,
+                                     end_len,
+                                     end_len,
+                                     1,
+                                     &queued);
+        if (err_code == NRF_ERROR_RESOURCES)
+        {
+            p_engine->busy_count++;
+            return;
+        }
+        if (err_code != NRF_SUCCESS)
+        {
+            transfer_finish(p_engine, TRANSFER_ENGINE_EVT_ABORTED, err_code);
+            return;
+        }
+
+        p_engine->is_end_sent = true;
+        p_engine->in_flight++;
+
+        transfer_stats_on_queued(&p_engine->stats, 1, end_len, (uint8_t)end_len);
+    }
+
+    // A reliable transfer also waits for the END frame to be acknowledged.
+    if ((p_engine->in_flight == 0) && (!p_engine->is_reliable || (p_engine->ack_seq > p_engine->packets_sent)))
+    {
+        transfer_finish(p_engine, TRANSFER_ENGINE_EVT_COMPLETE, NRF_SUCCESS);
+    }
+}
+
+
+ret_code_t transfer_engine_init(transfer_engine_t * p_engine, transfer_engine_init_t const * p_init)
+{
+    if ((p_engine == NULL) || (p_init == NULL) || (p_init->tx_func == NULL) || (p_init->time_func == NULL))
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    memset(p_engine, 0, sizeof(transfer_engine_t));
+
+    p_engine->tx_func      = p_init->tx_func;
+    p_engine->p_tx_context = p_init->p_tx_context;
+    p_engine->time_func    = p_init->time_func;
+    p_engine->evt_handler  = p_init->evt_handler;
+    p_engine->frame_flags  = p_init->frame_flags & (SENSOR_FRAME_FLAG_TIMESTAMP | SENSOR_FRAME_FLAG_CRC);
+
+    return NRF_SUCCESS;
+}
+
+
+/**@brief Function for starting a transfer from the packet source that has been set up.
+ */
+static void transfer_begin(transfer_engine_t * p_engine, uint16_t packet_size)
+{
+    p_engine->is_running       = true;
+    p_engine->is_unbounded     = packet_src_is_unbounded(&p_engine->src);
+    p_engine->is_end_sent      = false;
+    p_engine->packet_size      = packet_size;
+    p_engine->packets_left     = packet_src_packet_count(&p_engine->src);
+    p_engine->packets_sent     = 0;
+    p_engine->in_flight        = 0;
+    p_engine->busy_count       = 0;
+    p_engine->staged.count     = 0;
+    p_engine->credit           = 0;
+    p_engine->is_paced         = p_engine->paced_next;
+    p_engine->is_reliable      = p_engine->reliable_next;
+    p_engine->window           = p_engine->window_next;
+    p_engine->ack_seq          = 0;
+    p_engine->retx_pending     = 0;
+    p_engine->retx_count       = 0;
+    p_engine->ack_retries      = 0;
+    p_engine->data_crc32       = 0;
+
+    memset(p_engine->retx_map, 0, sizeof(p_engine->retx_map));
+    transfer_stats_start(&p_engine->stats, p_engine->time_func());
+
+    queue_fill(p_engine);
+}
+
+
+ret_code_t transfer_engine_start(transfer_engine_t * p_engine, uint16_t packet_size, uint32_t data_len)
+{
+    if (p_engine == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    if (p_engine->is_running)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    if (!packet_src_template_init(&p_engine->src, packet_size, p_engine->frame_flags, data_len))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    transfer_begin(p_engine, packet_size);
+
+    return NRF_SUCCESS;
+}
+
+
+void transfer_engine_stop(transfer_engine_t * p_engine)
+{
+    if ((p_engine == NULL) || !p_engine->is_running)
+    {
+        return;
+    }
+
+    p_engine->is_unbounded = false;
+    p_engine->packets_left = 0;
+    p_engine->staged.count = 0;
+
+    queue_fill(p_engine);
+}
+
+
+void transfer_engine_abort(transfer_engine_t * p_engine)
+{
+    if ((p_engine == NULL) || !p_engine->is_running)
+    {
+        return;
+    }
+
+    transfer_finish(p_engine, TRANSFER_ENGINE_EVT_ABORTED, NRF_SUCCESS);
+}
+
+
+void transfer_engine_on_tx_complete(transfer_engine_t * p_engine, uint8_t count)
+{
+    if ((p_engine == NULL) || !p_engine->is_running)
+    {
+        return;
+    }
+
+    // Other services may share the link, never count their notifications as ours.
+    p_engine->in_flight = (count > p_engine->in_flight) ? 0 : (p_engine->in_flight - count);
+
+    transfer_stats_on_tx_complete(&p_engine->stats, p_engine->time_func());
+
+    queue_fill(p_engine);
+}
+
+
+void transfer_engine_queue_limit_set(transfer_engine_t * p_engine, uint8_t queue_limit)
+{
+    if (p_engine != NULL)
+    {
+        p_engine->queue_limit = queue_limit;
+    }
+}
+
+
+void transfer_engine_pacing_set(transfer_engine_t * p_engine, bool is_paced)
+{
+    if (p_engine != NULL)
+    {
+        p_engine->paced_next = is_paced;
+    }
+}
+
+
+void transfer_engine_credit_add(transfer_engine_t * p_engine, uint32_t bytes, uint32_t max_credit)
+{
+    if ((p_engine == NULL) || !p_engine->is_running || !p_engine->is_paced)
+    {
+        return;
+    }
+
+    if (max_credit < p_engine->packet_size)
+    {
+        max_credit = p_engine->packet_size;
+    }
+
+    p_engine->credit += bytes;
+    if (p_engine->credit > max_credit)
+    {
+        p_engine->credit = max_credit;
+    }
+
+    queue_fill(p_engine);
+}
+
+
+void transfer_engine_reliable_set(transfer_engine_t * p_engine, bool is_reliable, uint16_t window)
+{
+    if (p_engine == NULL)
+    {
+        return;
+    }
+
+    p_engine->reliable_next = is_reliable;
+    p_engine->window_next   = ((window == 0) || (window > TRANSFER_ENGINE_WINDOW_MAX)) ? TRANSFER_ENGINE_WINDOW_MAX
+                                                                                       : window;
+}
+
+
+void transfer_engine_ack(transfer_engine_t * p_engine, uint32_t next_seq, uint32_t bitmap)
+{
+    uint32_t end;
+
+    if ((p_engine == NULL) || !p_engine->is_running || !p_engine->is_reliable)
+    {
+        return;
+    }
+
+    end = seq_end(p_engine);
+    if ((next_seq < p_engine->ack_seq) || (next_seq > end))
+    {
+        return;
+    }
+
+    if (next_seq > p_engine->ack_seq)
+    {
+        p_engine->ack_retries = 0;
+    }
+
+    while (p_engine->ack_seq < next_seq)
+    {
+        retx_clear(p_engine, p_engine->ack_seq);
+        p_engine->ack_seq++;
+    }
+
+    if ((bitmap != 0) && (next_seq < end))
+    {
+        // Frames after the highest one received may still be on their way.
+        retx_mark(p_engine, next_seq);
+
+        for (uint32_t i = 0; (i < 32) && ((bitmap >> i) != 0) && (next_seq + 1 + i < end); i++)
+        {
+            if (bitmap & (1UL << i))
+            {
+                retx_clear(p_engine, next_seq + 1 + i);
+            }
+            else
+            {
+                retx_mark(p_engine, next_seq + 1 + i);
+            }
+        }
+    }
+
+    queue_fill(p_engine);
+}
+
+
+void transfer_engine_ack_timeout(transfer_engine_t * p_engine)
+{
+    if ((p_engine == NULL) || !p_engine->is_running || !p_engine->is_reliable)
+    {
+        return;
+    }
+
+    if (p_engine->ack_seq >= seq_end(p_engine))
+    {
+        // Nothing is waiting for an acknowledgement.
+        return;
+    }
+
+    if (++p_engine->ack_retries > TRANSFER_ENGINE_ACK_RETRIES_MAX)
+    {
+        transfer_finish(p_engine, TRANSFER_ENGINE_EVT_ABORTED, NRF_ERROR_TIMEOUT);
+        return;
+    }
+
+    retx_mark(p_engine, p_engine->ack_seq);
+    queue_fill(p_engine);
+}
+
+
+bool transfer_engine_is_running(transfer_engine_t const * p_engine)
+{
+    return (p_engine != NULL) && p_engine->is_running;
+}
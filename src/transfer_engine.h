@@ -0,0 +1,279 @@
+#ifndef __TRANSFER_ENGINE_H
+#define __TRANSFER_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_errors.h"
+#include "packet_src.h"
+#include "transfer_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Maximum notification payload the engine can send (in bytes). */
+#define TRANSFER_ENGINE_MAX_PACKET_LEN     PACKET_SRC_MAX_PACKET_LEN
+
+/**@brief   Number of packets handed to the SoftDevice in one burst. */
+#ifndef TRANSFER_ENGINE_BURST_MAX
+#define TRANSFER_ENGINE_BURST_MAX          PACKET_SRC_TEMPLATE_COUNT
+#endif
+
+/**@brief   Transfer length that streams until @ref transfer_engine_stop is called. */
+#define TRANSFER_ENGINE_UNBOUNDED          0
+
+/**@brief   Largest retransmit window of a reliable transfer (in frames). A multiple of 32. */
+#ifndef TRANSFER_ENGINE_WINDOW_MAX
+#define TRANSFER_ENGINE_WINDOW_MAX         128
+#endif
+
+/**@brief   Retransmissions on acknowledgement timeout before a reliable transfer is aborted. */
+#ifndef TRANSFER_ENGINE_ACK_RETRIES_MAX
+#define TRANSFER_ENGINE_ACK_RETRIES_MAX    5
+#endif
+
+
+/**@brief   Transfer engine event types. */
+typedef enum
+{
+    TRANSFER_ENGINE_EVT_COMPLETE,       /**< All packets and the end frame have been transmitted. */
+    TRANSFER_ENGINE_EVT_ABORTED,        /**< Transfer stopped before completion. */
+} transfer_engine_evt_type_t;
+
+
+/**@brief   Transfer engine event structure. */
+typedef struct
+{
+    transfer_engine_evt_type_t type;            /**< Event type. */
+    ret_code_t                 err_code;        /**< Error that caused an abort, NRF_SUCCESS otherwise. */
+    uint32_t                   packets_sent;    /**< Number of data packets accepted by the SoftDevice. */
+    uint32_t                   busy_count;      /**< Number of tx calls rejected with NRF_ERROR_RESOURCES. */
+    uint32_t                   retx_count;      /**< Number of frames sent again after a NACK or timeout. */
+    uint16_t                   packet_size;     /**< Size of every data packet (in bytes). */
+    uint32_t                   data_crc32;      /**< CRC32 of the data queued, as sent in the end frame. */
+    transfer_stats_t const   * p_stats;         /**< Bytes and time counted for the transfer. */
+} transfer_engine_evt_t;
+
+
+/**@brief   Function for queueing a burst of notifications.
+ *
+ * @details Packet i starts at p_data + i * stride. The function reports in @p p_queued how many
+ *          packets were accepted and must return NRF_ERROR_RESOURCES when the SoftDevice queue
+ *          filled up. Any other error aborts the transfer. Bound to
+ *          @ref ble_sensor_service_send_burst on target, and to a fake of sd_ble_gatts_hvx when
+ *          the engine is built on a host.
+ */
+typedef ret_code_t (* transfer_engine_tx_func_t)(void          * p_context,
+                                                 uint8_t const * p_data,
+                                                 uint16_t        length,
+                                                 uint16_t        stride,
+                                                 uint16_t        count,
+                                                 uint16_t      * p_queued);
+
+/**@brief   Transfer engine event handler type. */
+typedef void (* transfer_engine_evt_handler_t)(transfer_engine_evt_t const * p_evt);
+
+/**@brief   Function returning the current time in app_timer ticks. */
+typedef uint32_t (* transfer_engine_time_func_t)(void);
+
+
+/**@brief   Transfer engine initialization structure. */
+typedef struct
+{
+    transfer_engine_tx_func_t       tx_func;        /**< Function used to queue notifications. */
+    void                          * p_tx_context;   /**< Context passed to @p tx_func. */
+    transfer_engine_time_func_t     time_func;      /**< Time source (app_timer ticks) for frame stamps and statistics. */
+    transfer_engine_evt_handler_t   evt_handler;    /**< Event handler, called from the TX complete context. */
+    uint8_t                         frame_flags;    /**< SENSOR_FRAME_FLAG_TIMESTAMP to stamp every frame, SENSOR_FRAME_FLAG_CRC to end every frame with a CRC16, 0 otherwise. */
+} transfer_engine_init_t;
+
+
+/**@brief   Transfer engine structure.
+ *
+ * @details The engine never waits for the SoftDevice. It fills the HVN TX queue until it reports
+ *          NRF_ERROR_RESOURCES and refills it from @ref transfer_engine_on_tx_complete, so the CPU
+ *          can sleep between connection events.
+ */
+typedef struct
+{
+    transfer_engine_tx_func_t       tx_func;
+    void                          * p_tx_context;
+    transfer_engine_time_func_t     time_func;
+    transfer_engine_evt_handler_t   evt_handler;
+    uint8_t                         frame_flags;
+
+    volatile bool                   is_running;         /**< A transfer is in progress. */
+    bool                            is_unbounded;       /**< Data packets are queued until the transfer is stopped. */
+    bool                            is_end_sent;        /**< The end-of-transfer frame is queued. */
+    uint16_t                        packet_size;        /**< Size of every data packet (in bytes). */
+    uint32_t                        packets_left;       /**< Data packets still to be queued. */
+    uint32_t                        packets_sent;       /**< Data packets queued so far. */
+    uint32_t                        in_flight;          /**< Packets queued but not yet completed. */
+    uint32_t                        busy_count;         /**< tx calls rejected because the queue was full. */
+    packet_src_burst_t              staged;             /**< Packets fetched from the source but not yet queued. */
+    uint8_t                         queue_limit;        /**< Maximum packets in flight, 0 to use the whole SoftDevice queue. */
+    bool                            paced_next;         /**< The next transfer is paced. */
+    bool                            is_paced;           /**< Data packets are only queued against @p credit. */
+    uint32_t                        credit;             /**< Notification bytes that may be queued while paced. */
+    transfer_stats_t                stats;              /**< Statistics of the running or last transfer. */
+
+    bool                            reliable_next;      /**< The next transfer keeps a retransmit window. */
+    uint16_t                        window_next;        /**< Retransmit window of the next reliable transfer (in frames). */
+    bool                            is_reliable;        /**< Frames are held until acknowledged and sent again if missing. */
+    uint16_t                        window;             /**< Frames that may be sent past the first unacknowledged one. */
+    uint32_t                        ack_seq;            /**< First frame not acknowledged. */
+    uint32_t                        retx_pending;       /**< Frames waiting to be sent again. */
+    uint32_t                        retx_count;         /**< Frames sent again so far. */
+    uint8_t                         ack_retries;        /**< Acknowledgement timeouts since the last progress. */
+    uint32_t                        retx_map[TRANSFER_ENGINE_WINDOW_MAX / 32];  /**< Frames to send again, bit seq % TRANSFER_ENGINE_WINDOW_MAX. */
+    uint32_t                        data_crc32;         /**< CRC32 of the data queued so far, sent in the end frame. */
+
+    packet_src_t                    src;                /**< Source of the packets of the running transfer. */
+    uint8_t                         end_frame[SENSOR_FRAME_HEADER_MAX_LEN + SENSOR_FRAME_END_PAYLOAD_LEN + SENSOR_FRAME_CRC_LEN];
+} transfer_engine_t;
+
+
+/**@brief   Function for initializing the transfer engine.
+ *
+ * @param[out] p_engine  Transfer engine instance.
+ * @param[in]  p_init    Initialization parameters.
+ *
+ * @retval NRF_SUCCESS     If the engine was initialized.
+ * @retval NRF_ERROR_NULL  If a parameter or a required callback was NULL.
+ */
+ret_code_t transfer_engine_init(transfer_engine_t * p_engine, transfer_engine_init_t const * p_init);
+
+
+/**@brief   Function for starting a transfer and filling the TX queue.
+ *
+ * @details Sends @p data_len bytes of test pattern in frames with sequence numbers 0, 1, 2 ...
+ *          followed by a @ref SENSOR_FRAME_FLAG_END frame whose sequence number is the number of
+ *          data frames and whose payload is the CRC32 of the data. The last data frame is shorter
+ *          if @p data_len is not a multiple of the frame payload.
+ *
+ * @param[in] p_engine     Transfer engine instance.
+ * @param[in] packet_size  Size of every data packet, frame header included (in bytes).
+ * @param[in] data_len     Payload to send (in bytes), @ref TRANSFER_ENGINE_UNBOUNDED to stream
+ *                         until @ref transfer_engine_stop is called.
+ *
+ * @retval NRF_SUCCESS              If the transfer was started.
+ * @retval NRF_ERROR_INVALID_STATE  If a transfer is already running.
+ * @retval NRF_ERROR_INVALID_PARAM  If @p packet_size is out of range.
+ */
+ret_code_t transfer_engine_start(transfer_engine_t * p_engine, uint16_t packet_size, uint32_t data_len);
+
+
+/**@brief   Function for ending a running transfer after the packets already queued.
+ *
+ * @details No more data packets are queued. The end frame follows the last queued packet and
+ *          @ref TRANSFER_ENGINE_EVT_COMPLETE is reported once it has been transmitted.
+ *
+ * @param[in] p_engine  Transfer engine instance.
+ */
+void transfer_engine_stop(transfer_engine_t * p_engine);
+
+
+/**@brief   Function for stopping a running transfer without sending the sentinel.
+ *
+ * @param[in] p_engine  Transfer engine instance.
+ */
+void transfer_engine_abort(transfer_engine_t * p_engine);
+
+
+/**@brief   Function for handling completed notifications.
+ *
+ * @details Call this from @ref BLE_SENSOR_SERVICE_EVT_TRANSMIT_RDY with the number of completed
+ *          notifications. Freed queue slots are refilled right away.
+ *
+ * @param[in] p_engine  Transfer engine instance.
+ * @param[in] count     Number of notifications the SoftDevice completed.
+ */
+void transfer_engine_on_tx_complete(transfer_engine_t * p_engine, uint8_t count);
+
+
+/**@brief   Function for limiting the number of packets in flight.
+ *
+ * @details Emulates a shallower HVN TX queue than the one configured in the SoftDevice, so queue
+ *          depths can be compared without rebuilding. Takes effect on the next refill.
+ *
+ * @param[in] p_engine     Transfer engine instance.
+ * @param[in] queue_limit  Maximum packets in flight, 0 for no limit.
+ */
+void transfer_engine_queue_limit_set(transfer_engine_t * p_engine, uint8_t queue_limit);
+
+
+/**@brief   Function for pacing data packets.
+ *
+ * @details While paced, data packets are only queued against credit given with
+ *          @ref transfer_engine_credit_add, so the caller sets the rate. The end frame is never
+ *          held back. Takes effect on the next transfer start.
+ *
+ * @param[in] p_engine  Transfer engine instance.
+ * @param[in] is_paced  true to pace, false to send as fast as the link allows.
+ */
+void transfer_engine_pacing_set(transfer_engine_t * p_engine, bool is_paced);
+
+
+/**@brief   Function for giving a paced transfer credit to queue more data.
+ *
+ * @details Call this periodically, from the same interrupt priority as
+ *          @ref transfer_engine_on_tx_complete, with the bytes allowed per period. Unused credit
+ *          is kept up to @p max_credit, or one packet if that is more, so a slow link does not
+ *          build up a burst.
+ *
+ * @param[in] p_engine    Transfer engine instance.
+ * @param[in] bytes       Notification bytes allowed since the last call.
+ * @param[in] max_credit  Maximum credit kept (in bytes).
+ */
+void transfer_engine_credit_add(transfer_engine_t * p_engine, uint32_t bytes, uint32_t max_credit);
+
+
+/**@brief   Function for making the next transfers reliable.
+ *
+ * @details A reliable transfer keeps up to @p window frames, the END frame included, sent but not
+ *          acknowledged. Missing frames reported with @ref transfer_engine_ack are sent again
+ *          with @ref SENSOR_FRAME_FLAG_RETX, and the transfer completes once the END frame has been
+ *          acknowledged. Takes effect on the next transfer start.
+ *
+ * @param[in] p_engine     Transfer engine instance.
+ * @param[in] is_reliable  true for acknowledged transfers.
+ * @param[in] window       Retransmit window (in frames), 0 or more than
+ *                         @ref TRANSFER_ENGINE_WINDOW_MAX for the largest.
+ */
+void transfer_engine_reliable_set(transfer_engine_t * p_engine, bool is_reliable, uint16_t window);
+
+
+/**@brief   Function for handling an acknowledgement from the receiver.
+ *
+ * @details Frames before @p next_seq leave the window. Frame @p next_seq, and every frame after
+ *          it whose bit is clear below the highest set bit of @p bitmap, is sent again. Stale
+ *          and out of range acknowledgements are ignored.
+ *
+ * @param[in] p_engine  Transfer engine instance.
+ * @param[in] next_seq  First frame the receiver is missing.
+ * @param[in] bitmap    Bit i set if frame @p next_seq + 1 + i was received.
+ */
+void transfer_engine_ack(transfer_engine_t * p_engine, uint32_t next_seq, uint32_t bitmap);
+
+
+/**@brief   Function for handling a missing acknowledgement.
+ *
+ * @details Call this when no acknowledgement has arrived for a while. The first unacknowledged
+ *          frame is sent again to get a fresh acknowledgement, up to
+ *          @ref TRANSFER_ENGINE_ACK_RETRIES_MAX retransmissions in a row. The next timeout
+ *          after those aborts the transfer with NRF_ERROR_TIMEOUT.
+ *
+ * @param[in] p_engine  Transfer engine instance.
+ */
+void transfer_engine_ack_timeout(transfer_engine_t * p_engine);
+
+
+/**@brief   Function for checking whether a transfer is in progress.
+ */
+bool transfer_engine_is_running(transfer_engine_t const * p_engine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TRANSFER_ENGINE_H
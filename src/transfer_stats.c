@@ -0,0 +1,78 @@
+#include <string.h>
+#include "transfer_stats.h"
+#include "link_model.h"
+
+
+void transfer_stats_start(transfer_stats_t * p_stats, uint32_t ticks)
+{
+    memset(p_stats, 0, sizeof(transfer_stats_t));
+    p_stats->last_ticks = ticks;
+}
+
+
+void transfer_stats_on_queued(transfer_stats_t * p_stats, uint16_t count, uint16_t length, uint8_t header_len)
+{
+    p_stats->frames        += count;
+    p_stats->header_bytes  += (uint32_t)count * header_len;
+    p_stats->payload_bytes += (uint32_t)count * (length - header_len);
+}
+
+
+void transfer_stats_time_update(transfer_stats_t * p_stats, uint32_t ticks)
+{
+    p_stats->elapsed_ticks += (ticks - p_stats->last_ticks) & TRANSFER_STATS_COUNTER_MASK;
+    p_stats->last_ticks     = ticks;
+}
+
+
+void transfer_stats_on_tx_complete(transfer_stats_t * p_stats, uint32_t ticks)
+{
+    p_stats->tx_events++;
+    transfer_stats_time_update(p_stats, ticks);
+}
+
+
+/**@brief Function for converting a byte count and a tick count to bit/s.
+ */
+static uint32_t rate_bps(uint64_t bytes, uint64_t ticks, uint32_t ticks_per_sec)
+{
+    return (ticks > 0) ? (uint32_t)((bytes * 8 * ticks_per_sec) / ticks) : 0;
+}
+
+
+void transfer_stats_report(transfer_stats_t const      * p_stats,
+                           transfer_stats_link_t const * p_link,
+                           transfer_stats_report_t     * p_report)
+{
+    uint64_t hvx_bytes = p_stats->payload_bytes + p_stats->header_bytes;
+    uint64_t pdu_count = 0;
+    uint32_t pdu_overhead;
+
+    memset(p_report, 0, sizeof(transfer_stats_report_t));
+
+    if (p_stats->frames > 0)
+    {
+        // Frames of one transfer share a size, so the average notification splits like all of them.
+        uint32_t l2cap_len = (uint32_t)(hvx_bytes / p_stats->frames)
+                           + LINK_MODEL_ATT_HVX_HEADER_LEN + LINK_MODEL_L2CAP_HEADER_LEN;
+
+        pdu_count = (uint64_t)p_stats->frames * ((l2cap_len + p_link->data_length - 1) / p_link->data_length);
+    }
+
+    pdu_overhead = ((p_link->phy == 2) ? 2 : 1) + LINK_MODEL_LL_AA_LEN + LINK_MODEL_LL_HEADER_LEN + LINK_MODEL_LL_CRC_LEN;
+
+    p_report->ll_overhead_bytes = (uint64_t)p_stats->frames * (LINK_MODEL_ATT_HVX_HEADER_LEN + LINK_MODEL_L2CAP_HEADER_LEN)
+                                + pdu_count * pdu_overhead;
+
+    p_report->elapsed_ms  = (uint32_t)((p_stats->elapsed_ticks * 1000) / p_link->ticks_per_sec);
+    p_report->goodput_bps = rate_bps(p_stats->payload_bytes, p_stats->elapsed_ticks, p_link->ticks_per_sec);
+    p_report->raw_bps     = rate_bps(hvx_bytes, p_stats->elapsed_ticks, p_link->ticks_per_sec);
+    p_report->air_bps     = rate_bps(hvx_bytes + p_report->ll_overhead_bytes,
+                                     p_stats->elapsed_ticks,
+                                     p_link->ticks_per_sec);
+
+    if (p_stats->tx_events > 0)
+    {
+        p_report->packets_per_event_x100 = (uint32_t)(((uint64_t)p_stats->frames * 100) / p_stats->tx_events);
+    }
+}
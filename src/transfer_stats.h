@@ -0,0 +1,100 @@
+#ifndef __TRANSFER_STATS_H
+#define __TRANSFER_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Width of the time source counter. app_timer runs on the 24-bit RTC counter. */
+#ifndef TRANSFER_STATS_COUNTER_MASK
+#define TRANSFER_STATS_COUNTER_MASK     0x00FFFFFFUL
+#endif
+
+
+/**@brief   Transfer statistics, updated as packets are queued and completed.
+ *
+ * @details Elapsed time is accumulated one TX complete event at a time, so the counter may wrap
+ *          any number of times during a transfer as long as two events are less than one counter
+ *          period apart (1024 s for app_timer at 16384 Hz).
+ */
+typedef struct
+{
+    uint32_t frames;            /**< Notifications queued. */
+    uint64_t payload_bytes;     /**< Application payload queued (in bytes). */
+    uint64_t header_bytes;      /**< Frame headers queued (in bytes). */
+    uint32_t tx_events;         /**< TX complete events, one per connection event that sent data. */
+    uint32_t last_ticks;        /**< Counter value at the last update. */
+    uint64_t elapsed_ticks;     /**< Time since the start of the transfer (in counter ticks). */
+} transfer_stats_t;
+
+
+/**@brief   Link properties needed to work out the over-the-air overhead. */
+typedef struct
+{
+    uint8_t  phy;               /**< 1 for the 1M PHY, 2 for the 2M PHY. */
+    uint16_t data_length;       /**< LL data length (in bytes). */
+    uint32_t ticks_per_sec;     /**< Frequency of the time source (in Hz). */
+} transfer_stats_link_t;
+
+
+/**@brief   Throughput figures of a transfer. */
+typedef struct
+{
+    uint32_t elapsed_ms;                /**< Transfer time (in ms). */
+    uint64_t ll_overhead_bytes;         /**< ATT, L2CAP and LL bytes added to the notifications (in bytes). */
+    uint32_t goodput_bps;               /**< Application payload rate (in bit/s). */
+    uint32_t raw_bps;                   /**< Notification rate, frame headers included (in bit/s). */
+    uint32_t air_bps;                   /**< Rate of all bytes sent over the air for the transfer (in bit/s). */
+    uint32_t packets_per_event_x100;    /**< Average notifications per connection event, times 100. */
+} transfer_stats_report_t;
+
+
+/**@brief   Function for clearing the statistics at the start of a transfer.
+ *
+ * @param[out] p_stats  Statistics.
+ * @param[in]  ticks    Current counter value.
+ */
+void transfer_stats_start(transfer_stats_t * p_stats, uint32_t ticks);
+
+
+/**@brief   Function for counting notifications that have been queued.
+ *
+ * @param[in] p_stats     Statistics.
+ * @param[in] count       Number of notifications.
+ * @param[in] length      Length of every notification (in bytes).
+ * @param[in] header_len  Frame header in every notification (in bytes).
+ */
+void transfer_stats_on_queued(transfer_stats_t * p_stats, uint16_t count, uint16_t length, uint8_t header_len);
+
+
+/**@brief   Function for counting a TX complete event and advancing the elapsed time.
+ *
+ * @param[in] p_stats  Statistics.
+ * @param[in] ticks    Current counter value.
+ */
+void transfer_stats_on_tx_complete(transfer_stats_t * p_stats, uint32_t ticks);
+
+
+/**@brief   Function for advancing the elapsed time without counting an event.
+ */
+void transfer_stats_time_update(transfer_stats_t * p_stats, uint32_t ticks);
+
+
+/**@brief   Function for computing the throughput figures.
+ *
+ * @param[in]  p_stats   Statistics.
+ * @param[in]  p_link    Link the transfer ran on.
+ * @param[out] p_report  Throughput figures.
+ */
+void transfer_stats_report(transfer_stats_t const      * p_stats,
+                           transfer_stats_link_t const * p_link,
+                           transfer_stats_report_t     * p_report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TRANSFER_STATS_H
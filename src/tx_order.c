@@ -0,0 +1,82 @@
+#include <string.h>
+#include "tx_order.h"
+
+
+void tx_order_reset(tx_order_t * p_order)
+{
+    memset(p_order, 0, sizeof(tx_order_t));
+}
+
+
+bool tx_order_push(tx_order_t * p_order, uint8_t owner, uint16_t count)
+{
+    tx_order_run_t * p_last;
+
+    if ((count == 0) || (owner >= TX_ORDER_OWNERS_MAX))
+    {
+        return (count == 0);
+    }
+
+    if (p_order->run_count > 0)
+    {
+        p_last = &p_order->runs[(p_order->head + p_order->run_count - 1) % TX_ORDER_RUNS_MAX];
+
+        if (p_last->owner == owner)
+        {
+            p_last->count += count;
+            return true;
+        }
+    }
+
+    if (p_order->run_count == TX_ORDER_RUNS_MAX)
+    {
+        return false;
+    }
+
+    p_last        = &p_order->runs[(p_order->head + p_order->run_count) % TX_ORDER_RUNS_MAX];
+    p_last->owner = owner;
+    p_last->count = count;
+    p_order->run_count++;
+
+    return true;
+}
+
+
+void tx_order_complete(tx_order_t * p_order, uint16_t count, uint16_t * p_counts)
+{
+    memset(p_counts, 0, TX_ORDER_OWNERS_MAX * sizeof(uint16_t));
+
+    while ((count > 0) && (p_order->run_count > 0))
+    {
+        tx_order_run_t * p_run = &p_order->runs[p_order->head];
+        uint16_t         done  = (count < p_run->count) ? count : p_run->count;
+
+        p_counts[p_run->owner] += done;
+        p_run->count           -= done;
+        count                  -= done;
+
+        if (p_run->count == 0)
+        {
+            p_order->head = (p_order->head + 1) % TX_ORDER_RUNS_MAX;
+            p_order->run_count--;
+        }
+    }
+}
+
+
+uint32_t tx_order_pending(tx_order_t const * p_order, uint8_t owner)
+{
+    uint32_t pending = 0;
+
+    for (uint8_t i = 0; i < p_order->run_count; i++)
+    {
+        tx_order_run_t const * p_run = &p_order->runs[(p_order->head + i) % TX_ORDER_RUNS_MAX];
+
+        if (p_run->owner == owner)
+        {
+            pending += p_run->count;
+        }
+    }
+
+    return pending;
+}
@@ -0,0 +1,81 @@
+#ifndef __TX_ORDER_H
+#define __TX_ORDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Sources that may share the HVN TX queue. */
+#ifndef TX_ORDER_OWNERS_MAX
+#define TX_ORDER_OWNERS_MAX     4
+#endif
+
+/**@brief   Runs of notifications from one source that can be recorded, at least the HVN TX
+ *          queue depth. */
+#ifndef TX_ORDER_RUNS_MAX
+#define TX_ORDER_RUNS_MAX       16
+#endif
+
+
+/**@brief   Notifications queued in a row by one source. */
+typedef struct
+{
+    uint8_t  owner;             /**< Source of the notifications. */
+    uint16_t count;             /**< Notifications not yet completed. */
+} tx_order_run_t;
+
+
+/**@brief   Order of the notifications in the HVN TX queue.
+ *
+ * @details The SoftDevice completes notifications in the order they were queued, and
+ *          BLE_GATTS_EVT_HVN_TX_COMPLETE only carries a count. Every source records what it
+ *          queued, and the counts of the completion events are handed back to the sources in
+ *          queue order, so no source is credited with a notification of another one.
+ */
+typedef struct
+{
+    tx_order_run_t runs[TX_ORDER_RUNS_MAX];     /**< Runs in queue order, from @ref head. */
+    uint8_t        head;                        /**< Oldest run. */
+    uint8_t        run_count;                   /**< Runs recorded. */
+} tx_order_t;
+
+
+/**@brief   Function for forgetting every notification recorded, e.g. when the link is lost.
+ */
+void tx_order_reset(tx_order_t * p_order);
+
+
+/**@brief   Function for recording notifications just queued.
+ *
+ * @param[in] p_order  Queue order.
+ * @param[in] owner    Source of the notifications, less than @ref TX_ORDER_OWNERS_MAX.
+ * @param[in] count    Notifications queued.
+ *
+ * @retval true   If the notifications were recorded.
+ * @retval false  If a new run did not fit. The queue holds more runs than it should.
+ */
+bool tx_order_push(tx_order_t * p_order, uint8_t owner, uint16_t count);
+
+
+/**@brief   Function for splitting a TX complete count between the sources, oldest first.
+ *
+ * @param[in]  p_order   Queue order.
+ * @param[in]  count     Notifications completed.
+ * @param[out] p_counts  Notifications completed per source, @ref TX_ORDER_OWNERS_MAX entries.
+ *                       Completions beyond those recorded are not counted.
+ */
+void tx_order_complete(tx_order_t * p_order, uint16_t count, uint16_t * p_counts);
+
+
+/**@brief   Function for getting the notifications of a source not yet completed.
+ */
+uint32_t tx_order_pending(tx_order_t const * p_order, uint8_t owner);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TX_ORDER_H
@@ -0,0 +1,195 @@
+#include <string.h>
+#include <time.h>
+#include "test_check.h"
+#include "flash_log.h"
+#include "nrf_fstorage_fake.h"
+#include "nrf_error.h"
+
+
+#define REGION_START        0x3F000                 /**< Start of the simulated region, 400 KB fit below the bootloader. */
+#define RECORD_INTERVAL     20                      /**< Timestamp step between records (in ms). */
+#define BENCH_RUNS          200                     /**< Runs every figure is averaged over. */
+#define SEEK_TAIL_RECORDS   5                       /**< Records after the target of the short seek. */
+
+static const uint16_t m_region_pages[] = {25, 50, 100};    /**< Region sizes benchmarked, up to 400 KB. */
+
+
+static void fs_evt_handler(nrf_fstorage_evt_t * p_evt);
+
+static nrf_fstorage_t m_fs =
+{
+    .evt_handler = fs_evt_handler,
+    .start_addr  = REGION_START,
+};
+static flash_log_t    m_log;
+static uint32_t       m_next_timestamp;
+
+
+/**@brief Result of one figure, averaged over the runs. */
+typedef struct
+{
+    double   us;            /**< Time (in microseconds). */
+    uint32_t reads;         /**< Flash reads. */
+} bench_result_t;
+
+
+static void fs_evt_handler(nrf_fstorage_evt_t * p_evt)
+{
+    flash_log_on_fs_evt(&m_log, p_evt);
+}
+
+
+static double now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+
+static void log_open(void)
+{
+    CHECK(nrf_fstorage_init(&m_fs, &nrf_fstorage_fake, NULL) == NRF_SUCCESS);
+    CHECK(flash_log_init(&m_log, &m_fs, NULL) == NRF_SUCCESS);
+}
+
+
+/**@brief Fills a new region of @p pages pages twice around the ring, with records of 20 to 256
+ *        bytes, so every page holds records and has been erased.
+ */
+static void region_fill(uint16_t pages)
+{
+    uint8_t  buf[FLASH_LOG_RECORD_MAX_LEN];
+    uint32_t count = 2 * pages * (NRF_FSTORAGE_FAKE_PAGE_SIZE / 150);
+
+    m_fs.end_addr = REGION_START + pages * NRF_FSTORAGE_FAKE_PAGE_SIZE;
+    CHECK(nrf_fstorage_init(&m_fs, &nrf_fstorage_fake, NULL) == NRF_SUCCESS);
+    nrf_fstorage_fake_erase_all();
+    nrf_fstorage_fake_stats_clear();
+    log_open();
+
+    m_next_timestamp = 1000;
+
+    for (uint32_t seq = 0; seq < count; seq++)
+    {
+        uint16_t length = 20 + (seq * 37) % (FLASH_LOG_RECORD_MAX_LEN - 19);
+
+        memset(buf, (uint8_t)seq, length);
+        CHECK(flash_log_append(&m_log, buf, length, m_next_timestamp) == NRF_SUCCESS);
+        nrf_fstorage_fake_run(UINT32_MAX);
+        m_next_timestamp += RECORD_INTERVAL;
+    }
+}
+
+
+/**@brief Opens the log, as at boot. The index is not built yet. */
+static bench_result_t bench_init(void)
+{
+    uint32_t reads = nrf_fstorage_fake_stats()->reads;
+    double   start = now_us();
+
+    for (uint32_t i = 0; i < BENCH_RUNS; i++)
+    {
+        log_open();
+    }
+
+    return (bench_result_t){(now_us() - start) / BENCH_RUNS,
+                            (nrf_fstorage_fake_stats()->reads - reads) / BENCH_RUNS};
+}
+
+
+/**@brief Delivers every record left, as a completed sync does. */
+static void log_drain(void)
+{
+    uint8_t const * p_data;
+    uint16_t        length;
+    uint32_t        count = 0;
+
+    while (flash_log_peek_mapped(&m_log, &p_data, &length) == NRF_SUCCESS)
+    {
+        flash_log_release(&m_log);
+        count++;
+    }
+
+    flash_log_ack(&m_log, count);
+    nrf_fstorage_fake_run(UINT32_MAX);
+    CHECK(flash_log_is_drained(&m_log));
+}
+
+
+/**@brief Seeks to @p timestamp, building the index first if @p index_build is set. */
+static bench_result_t bench_seek(uint32_t timestamp, bool index_build)
+{
+    uint32_t reads = nrf_fstorage_fake_stats()->reads;
+    double   start = now_us();
+
+    for (uint32_t i = 0; i < BENCH_RUNS; i++)
+    {
+        m_log.is_index_built = m_log.is_index_built && !index_build;
+        CHECK(flash_log_seek(&m_log, timestamp) == NRF_SUCCESS);
+    }
+
+    return (bench_result_t){(now_us() - start) / BENCH_RUNS,
+                            (nrf_fstorage_fake_stats()->reads - reads) / BENCH_RUNS};
+}
+
+
+int main(void)
+{
+    printf("pages  records   boot scan         index build + seek   seek (last %u)    walk from oldest\n",
+           SEEK_TAIL_RECORDS);
+
+    for (uint8_t i = 0; i < sizeof(m_region_pages) / sizeof(m_region_pages[0]); i++)
+    {
+        uint16_t       pages       = m_region_pages[i];
+        uint32_t       tail;
+        uint32_t       erases_min  = UINT32_MAX;
+        uint32_t       erases_max  = 0;
+        uint32_t       records;
+        bench_result_t init;
+        bench_result_t seek_cold;
+        bench_result_t seek;
+        bench_result_t walk;
+        bench_result_t init_drained;
+
+        region_fill(pages);
+        tail = m_next_timestamp - SEEK_TAIL_RECORDS * RECORD_INTERVAL;
+
+        init      = bench_init();
+        seek_cold = bench_seek(tail, true);
+        seek      = bench_seek(tail, false);
+        CHECK(flash_log_unsent_count(&m_log) == SEEK_TAIL_RECORDS);
+        walk      = bench_seek(0, false);
+        records   = flash_log_unsent_count(&m_log);
+
+        log_drain();
+        init_drained = bench_init();
+        CHECK(flash_log_unsent_count(&m_log) == 0);
+
+        for (uint16_t page = 0; page < pages; page++)
+        {
+            uint32_t erases = nrf_fstorage_fake_page_erases(page);
+
+            erases_min = (erases < erases_min) ? erases : erases_min;
+            erases_max = (erases > erases_max) ? erases : erases_max;
+        }
+
+        printf("%5u  %7u   %7.1f us %5u   %7.1f us %5u     %7.2f us %4u   %7.1f us %6u\n",
+               pages, records,
+               init.us, init.reads,
+               seek_cold.us, seek_cold.reads,
+               seek.us, seek.reads,
+               walk.us, walk.reads);
+        printf("       boot scan, all delivered %.1f us %u, erases per page %u to %u\n",
+               init_drained.us, init_drained.reads, erases_min, erases_max);
+
+        // The index costs one read per page, the seek itself only reads within one page.
+        CHECK(seek_cold.reads - seek.reads == pages);
+        CHECK(seek.reads < 2 * (NRF_FSTORAGE_FAKE_PAGE_SIZE / (FLASH_LOG_RECORD_HEADER_LEN + 20) + SEEK_TAIL_RECORDS + 2));
+        CHECK(erases_max - erases_min <= 1);
+    }
+
+    return EXIT_SUCCESS;
+}
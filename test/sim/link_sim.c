@@ -0,0 +1,128 @@
+#include <string.h>
+#include "link_sim.h"
+#include "softdevice_fake.h"
+#include "ble_sensor_service.h"
+#include "transfer_engine.h"
+#include "transfer_stats.h"
+#include "app_timer.h"
+#include "nrf_error.h"
+
+
+#define LINK_SIM_CONN_HANDLE    0                                                               /**< Handle of the simulated connection. */
+#define TICKS_PER_SEC           (APP_TIMER_CLOCK_FREQ / (APP_TIMER_CONFIG_RTC_FREQUENCY + 1))   /**< app_timer counter frequency (in Hz). */
+
+
+BLE_SENSOR_SERVICE_DEF(m_sensor, NRF_SDH_BLE_PERIPHERAL_LINK_COUNT);
+
+static transfer_engine_t     m_engine;
+static transfer_engine_evt_t m_result;          /**< Event that ended the transfer. */
+static bool                  m_is_done;         /**< The transfer has ended. */
+static bool                  m_is_started;      /**< The peer has enabled notification of characteristic 2. */
+
+
+static ret_code_t sim_tx(void          * p_context,
+                         uint8_t const * p_data,
+                         uint16_t        length,
+                         uint16_t        stride,
+                         uint16_t        count,
+                         uint16_t      * p_queued)
+{
+    return ble_sensor_service_send_burst((ble_sensor_service_t *)p_context, LINK_SIM_CONN_HANDLE,
+                                         p_data, length, stride, count, p_queued);
+}
+
+
+static void sensor_evt_handler(ble_sensor_service_evt_t * p_evt)
+{
+    if (p_evt->type == BLE_SENSOR_SERVICE_EVT_COMM_STARTED)
+    {
+        m_is_started = true;
+    }
+    else if (p_evt->type == BLE_SENSOR_SERVICE_EVT_TRANSMIT_RDY)
+    {
+        transfer_engine_on_tx_complete(&m_engine, p_evt->params.tx_complete.count);
+    }
+}
+
+
+static void engine_evt_handler(transfer_engine_evt_t const * p_evt)
+{
+    m_result  = *p_evt;
+    m_is_done = true;
+}
+
+
+bool link_sim_run(link_sim_params_t const * p_params, link_sim_report_t * p_report)
+{
+    ble_sensor_service_init_t sensor_init;
+    transfer_engine_init_t    engine_init;
+    link_model_report_t       link_report;
+    link_model_report_t       estimate;
+    transfer_stats_link_t     stats_link;
+    transfer_stats_report_t   stats_report;
+
+    memset(p_report, 0, sizeof(link_sim_report_t));
+    m_is_done    = false;
+    m_is_started = false;
+
+    softdevice_fake_init(&p_params->link, &m_sensor_obs);
+
+    memset(&sensor_init, 0, sizeof(sensor_init));
+    sensor_init.data_handler = sensor_evt_handler;
+
+    if (ble_sensor_service_init(&m_sensor, &sensor_init) != NRF_SUCCESS)
+    {
+        return false;
+    }
+
+    softdevice_fake_connect(LINK_SIM_CONN_HANDLE);
+    softdevice_fake_cccd_write(m_sensor.sensor_service_handles_2.cccd_handle, BLE_GATT_HVX_NOTIFICATION);
+
+    if (!m_is_started)
+    {
+        return false;
+    }
+
+    memset(&engine_init, 0, sizeof(engine_init));
+    engine_init.tx_func      = sim_tx;
+    engine_init.p_tx_context = &m_sensor;
+    engine_init.time_func    = app_timer_cnt_get;
+    engine_init.evt_handler  = engine_evt_handler;
+
+    if ((transfer_engine_init(&m_engine, &engine_init) != NRF_SUCCESS) ||
+        (transfer_engine_start(&m_engine,
+                               p_params->link.att_mtu - LINK_MODEL_ATT_HVX_HEADER_LEN,
+                               p_params->data_len) != NRF_SUCCESS))
+    {
+        return false;
+    }
+
+    // The CPU sleeps between connection events, it only runs from the TX complete events.
+    while (!m_is_done && (softdevice_fake_link()->report.conn_events < LINK_SIM_CONN_EVENTS_MAX))
+    {
+        (void)softdevice_fake_conn_event();
+    }
+
+    link_model_sim_report(softdevice_fake_link(), &link_report);
+    link_model_estimate(&p_params->link, &estimate);
+
+    stats_link.phy           = p_params->link.phy;
+    stats_link.data_length   = p_params->link.data_length;
+    stats_link.ticks_per_sec = TICKS_PER_SEC;
+    transfer_stats_report(&m_engine.stats, &stats_link, &stats_report);
+
+    p_report->is_complete                     = m_is_done && (m_result.type == TRANSFER_ENGINE_EVT_COMPLETE);
+    p_report->packets_sent                    = m_result.packets_sent;
+    p_report->packets                         = link_report.packets;
+    p_report->conn_events                     = link_report.conn_events;
+    p_report->packets_per_event_x100          = link_report.packets_per_event_x100;
+    p_report->kbps                            = link_report.kbps;
+    p_report->goodput_kbps                    = stats_report.goodput_bps / 1000;
+    p_report->estimate_packets_per_event_x100 = estimate.packets_per_event_x100;
+    p_report->estimate_kbps                   = estimate.kbps;
+    p_report->hvx_calls                       = softdevice_fake_stats()->hvx_calls;
+    p_report->spins                           = softdevice_fake_stats()->hvx_rejected;
+    p_report->wakeups                         = softdevice_fake_stats()->tx_complete_evts;
+
+    return true;
+}
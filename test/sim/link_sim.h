@@ -0,0 +1,64 @@
+#ifndef __LINK_SIM_H
+#define __LINK_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "link_model.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Connection events after which a transfer is given up. */
+#ifndef LINK_SIM_CONN_EVENTS_MAX
+#define LINK_SIM_CONN_EVENTS_MAX    100000
+#endif
+
+
+/**@brief   Parameters of a link simulation. */
+typedef struct
+{
+    link_model_params_t link;           /**< Simulated link, full-ATT-MTU packets are sent. */
+    uint32_t            data_len;       /**< Test pattern sent by the transfer engine (in bytes). */
+} link_sim_params_t;
+
+
+/**@brief   Outcome of a link simulation. */
+typedef struct
+{
+    bool     is_complete;               /**< The transfer engine reported TRANSFER_ENGINE_EVT_COMPLETE. */
+    uint32_t packets_sent;              /**< Data packets the engine queued. */
+    uint32_t packets;                   /**< Notifications that went over the air, the end frame included. */
+    uint32_t conn_events;               /**< Connection events simulated. */
+    uint32_t packets_per_event_x100;    /**< Average notifications per connection event, times 100. */
+    uint32_t kbps;                      /**< Notification payload throughput (in kbps). */
+    uint32_t goodput_kbps;              /**< Test pattern throughput, as the firmware reports it (in kbps). */
+    uint32_t estimate_packets_per_event_x100;   /**< Steady state notifications per event of @ref link_model_estimate, times 100. */
+    uint32_t estimate_kbps;             /**< Steady state throughput of @ref link_model_estimate (in kbps). */
+    uint32_t hvx_calls;                 /**< Calls to sd_ble_gatts_hvx. */
+    uint32_t spins;                     /**< Calls to sd_ble_gatts_hvx refused because the queue was full. */
+    uint32_t wakeups;                   /**< TX complete events the application handled. */
+} link_sim_report_t;
+
+
+/**@brief   Function for running a transfer through the sensor service on a simulated link.
+ *
+ * @details ble_sensor_service.c and the transfer engine run as in the firmware, against the fake
+ *          SoftDevice of sim/softdevice_fake.h: the peer connects and enables notification of
+ *          characteristic 2, the engine fills the HVN TX queue through
+ *          ble_sensor_service_send_burst and refills it from BLE_SENSOR_SERVICE_EVT_TRANSMIT_RDY.
+ *          The outcome is set against @ref link_model_estimate for the same link.
+ *
+ * @param[in]  p_params  Simulation parameters.
+ * @param[out] p_report  Outcome.
+ *
+ * @retval true   If the simulation ran.
+ * @retval false  If the service or the engine refused the parameters.
+ */
+bool link_sim_run(link_sim_params_t const * p_params, link_sim_report_t * p_report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LINK_SIM_H
@@ -0,0 +1,74 @@
+/**@brief Runs the sensor service and the transfer engine on simulated links.
+ *
+ *   link_sim
+ *
+ * Prints, for every link of the grid, the notifications per connection event, the throughput
+ * and the sd_ble_gatts_hvx calls refused, next to the estimate of the link model. Exits with 1 if
+ * a transfer did not complete.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "link_sim.h"
+
+
+#define DATA_LEN    (100 * 1024)    /**< Test pattern sent on every link (in bytes). */
+
+static const uint32_t m_conn_intervals_us[] = {7500, 15000, 50000};
+static const uint8_t  m_queue_sizes[]       = {1, 2, 4, 8};
+
+
+static bool link_run(link_model_phy_t phy, uint32_t conn_interval_us, uint16_t data_length,
+                     uint16_t att_mtu, uint8_t queue_size)
+{
+    link_sim_params_t params;
+    link_sim_report_t report;
+
+    params.link.phy              = phy;
+    params.link.conn_interval_us = conn_interval_us;
+    params.link.event_length_us  = conn_interval_us;
+    params.link.data_length      = data_length;
+    params.link.att_mtu          = att_mtu;
+    params.link.hvn_queue_size   = queue_size;
+    params.data_len              = DATA_LEN;
+
+    if (!link_sim_run(&params, &report) || !report.is_complete)
+    {
+        printf("%uM %6u us  DL %3u  MTU %3u  queue %2u: transfer did not complete\n",
+               phy, conn_interval_us, data_length, att_mtu, queue_size);
+        return false;
+    }
+
+    printf("%uM %6u us  DL %3u  MTU %3u  queue %2u  %3u.%02u %3u.%02u  %5u %5u %7u  %7u %7u %7u\n",
+           phy, conn_interval_us, data_length, att_mtu, queue_size,
+           report.packets_per_event_x100 / 100, report.packets_per_event_x100 % 100,
+           report.estimate_packets_per_event_x100 / 100, report.estimate_packets_per_event_x100 % 100,
+           report.kbps, report.estimate_kbps, report.goodput_kbps,
+           report.hvx_calls, report.spins, report.wakeups);
+
+    return true;
+}
+
+
+int main(void)
+{
+    bool is_ok = true;
+
+    printf("%-39s  %6s %6s  %5s %5s %7s  %7s %7s %7s\n",
+           "link", "pkt/ev", "est.", "kbps", "est.", "goodput", "hvx", "spins", "wakeups");
+
+    for (link_model_phy_t phy = LINK_MODEL_PHY_1M; phy <= LINK_MODEL_PHY_2M; phy++)
+    {
+        for (uint8_t i = 0; i < sizeof(m_conn_intervals_us) / sizeof(m_conn_intervals_us[0]); i++)
+        {
+            for (uint8_t j = 0; j < sizeof(m_queue_sizes) / sizeof(m_queue_sizes[0]); j++)
+            {
+                is_ok &= link_run(phy, m_conn_intervals_us[i], 251, 247, m_queue_sizes[j]);
+            }
+        }
+    }
+
+    // Without Data Length Extension and MTU exchange, as with an older central.
+    is_ok &= link_run(LINK_MODEL_PHY_1M, 7500, 27, 23, 8);
+
+    return is_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,171 @@
+#include <string.h>
+#include "sample_coalescer_sim.h"
+
+
+/**@brief Function for queuing held frames on the simulated link until its queue is full.
+ */
+static void sim_frames_push(sample_coalescer_sim_t * p_sim)
+{
+    while (p_sim->in_flight < p_sim->count)
+    {
+        sample_coalescer_sim_frame_t * p_frame = &p_sim->frames[(uint8_t)(p_sim->head + p_sim->in_flight)];
+
+        if (!link_model_sim_hvx(&p_sim->link, p_frame->length))
+        {
+            return;
+        }
+
+        p_sim->in_flight++;
+    }
+}
+
+
+/**@brief Function for handling the events of the simulated coalescer.
+ */
+static void sim_evt_handler(void * p_context, sample_coalescer_evt_t const * p_evt)
+{
+    sample_coalescer_sim_t       * p_sim = (sample_coalescer_sim_t *)p_context;
+    sample_coalescer_sim_frame_t * p_frame;
+
+    if (p_evt->type != SAMPLE_COALESCER_EVT_FRAME_READY)
+    {
+        return;
+    }
+
+    if (p_sim->count >= SAMPLE_COALESCER_SIM_FRAMES_MAX)
+    {
+        p_sim->report.dropped_frames++;
+        return;
+    }
+
+    p_frame = &p_sim->frames[(uint8_t)(p_sim->head + p_sim->count)];
+    p_frame->length       = p_evt->params.ready.length;
+    p_frame->sample_count = p_evt->params.ready.sample_count;
+    p_frame->close_us     = p_evt->params.ready.close_ticks;
+    p_frame->first_us     = p_evt->params.ready.first_ticks;
+    p_frame->wait_us_sum  = p_evt->params.ready.wait_ticks_sum;
+    p_sim->count++;
+
+    sim_frames_push(p_sim);
+}
+
+
+bool sample_coalescer_simulate(sample_coalescer_sim_t              * p_sim,
+                               sample_coalescer_sim_params_t const * p_params,
+                               sample_coalescer_sim_report_t       * p_report)
+{
+    sample_coalescer_init_t coalescer_init;
+    link_model_report_t     link_report;
+    uint8_t                 sample[UINT8_MAX];
+    uint64_t                latency_us_sum = 0;
+    uint32_t                sample_us      = 0;
+    uint32_t                event_us       = p_params->link.conn_interval_us;
+    uint32_t                due_us;
+
+    if ((p_params->sample_interval_us == 0) ||
+        (p_params->link.conn_interval_us == 0) ||
+        (p_params->link.att_mtu <= LINK_MODEL_ATT_HVX_HEADER_LEN))
+    {
+        return false;
+    }
+
+    memset(p_sim, 0, sizeof(sample_coalescer_sim_t));
+    memset(sample, 0, sizeof(sample));
+
+    memset(&coalescer_init, 0, sizeof(coalescer_init));
+    coalescer_init.evt_handler    = sim_evt_handler;
+    coalescer_init.p_context      = p_sim;
+    coalescer_init.sample_size    = p_params->sample_size;
+    coalescer_init.frame_len      = p_params->link.att_mtu - LINK_MODEL_ATT_HVX_HEADER_LEN;
+    coalescer_init.deadline_ticks = p_params->deadline_us;
+    coalescer_init.counter_mask   = UINT32_MAX;
+
+    if (!sample_coalescer_init(&p_sim->coalescer, &coalescer_init))
+    {
+        return false;
+    }
+
+    link_model_sim_init(&p_sim->link, &p_params->link);
+
+    for (;;)
+    {
+        bool is_open    = sample_coalescer_deadline_get(&p_sim->coalescer, &due_us);
+        bool has_sample = (sample_us < p_params->duration_us);
+
+        if (!has_sample && !is_open && (p_sim->count == 0))
+        {
+            break;
+        }
+
+        if (has_sample && (sample_us < event_us) && (!is_open || (sample_us < due_us)))
+        {
+            sample_coalescer_add(&p_sim->coalescer, sample, sample_us);
+            sample_us += p_params->sample_interval_us;
+        }
+        else if (is_open && (due_us < event_us))
+        {
+            (void)sample_coalescer_deadline_check(&p_sim->coalescer, due_us);
+        }
+        else
+        {
+            uint8_t completed = link_model_sim_conn_event(&p_sim->link);
+
+            // A notification longer than the event never goes out.
+            if ((completed == 0) && (p_sim->in_flight > 0) && !has_sample && !is_open)
+            {
+                p_sim->report.dropped_frames += p_sim->count;
+                break;
+            }
+
+            for (uint8_t i = 0; i < completed; i++)
+            {
+                sample_coalescer_sim_frame_t const * p_frame = &p_sim->frames[p_sim->head++];
+                uint32_t                             latency = event_us - p_frame->first_us;
+
+                latency_us_sum += (uint64_t)p_frame->sample_count * (event_us - p_frame->close_us) + p_frame->wait_us_sum;
+
+                if (latency > p_sim->report.max_latency_us)
+                {
+                    p_sim->report.max_latency_us = latency;
+                }
+
+                p_sim->report.samples += p_frame->sample_count;
+                p_sim->report.frames++;
+                p_sim->in_flight--;
+                p_sim->count--;
+            }
+
+            sim_frames_push(p_sim);
+            event_us += p_params->link.conn_interval_us;
+        }
+    }
+
+    link_model_sim_report(&p_sim->link, &link_report);
+
+    p_sim->report.full_frames            = p_sim->coalescer.stats.full_frames;
+    p_sim->report.deadline_frames        = p_sim->coalescer.stats.deadline_frames;
+    p_sim->report.packets_per_event_x100 = link_report.packets_per_event_x100;
+
+    if (p_sim->coalescer.stats.samples > 0)
+    {
+        p_sim->report.avg_wait_us = (uint32_t)(p_sim->coalescer.stats.wait_ticks_sum / p_sim->coalescer.stats.samples);
+    }
+
+    if (p_sim->coalescer.stats.frames > 0)
+    {
+        p_sim->report.samples_per_frame_x100 = (p_sim->coalescer.stats.samples * 100) / p_sim->coalescer.stats.frames;
+    }
+
+    if (p_sim->report.samples > 0)
+    {
+        uint64_t sample_bytes = (uint64_t)p_sim->report.samples * p_params->sample_size;
+
+        p_sim->report.avg_latency_us = (uint32_t)(latency_us_sum / p_sim->report.samples);
+        p_sim->report.efficiency_pct = (uint32_t)((sample_bytes * 100) / link_report.payload_bytes);
+        p_sim->report.goodput_bps    = (uint32_t)((sample_bytes * 8 * 1000000) / link_report.elapsed_us);
+    }
+
+    *p_report = p_sim->report;
+
+    return true;
+}
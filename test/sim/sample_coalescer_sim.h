@@ -0,0 +1,92 @@
+#ifndef __SAMPLE_COALESCER_SIM_H
+#define __SAMPLE_COALESCER_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sample_coalescer.h"
+#include "link_model.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Frames the simulation holds between the coalescer and the link, in flight included. */
+#define SAMPLE_COALESCER_SIM_FRAMES_MAX     (UINT8_MAX + 1)
+
+
+/**@brief   Parameters of a coalescing simulation. */
+typedef struct
+{
+    link_model_params_t link;                   /**< Simulated link. */
+    uint32_t            sample_interval_us;     /**< Time between two samples (in us). */
+    uint8_t             sample_size;            /**< Length of every sample (in bytes). */
+    uint32_t            deadline_us;            /**< Coalescing deadline (in us), 0 for one sample per frame. */
+    uint32_t            duration_us;            /**< Time samples are produced for (in us). */
+} sample_coalescer_sim_params_t;
+
+
+/**@brief   Outcome of a coalescing simulation. Latency runs from a sample to the end of the
+ *          connection event that delivered it. */
+typedef struct
+{
+    uint32_t samples;                   /**< Samples delivered. */
+    uint32_t frames;                    /**< Frames delivered. */
+    uint32_t dropped_frames;            /**< Frames lost because the link fell too far behind. */
+    uint32_t full_frames;               /**< Frames closed because they were full. */
+    uint32_t deadline_frames;           /**< Frames closed by the deadline. */
+    uint32_t avg_latency_us;            /**< Average sample latency (in us). */
+    uint32_t max_latency_us;            /**< Worst sample latency (in us). */
+    uint32_t avg_wait_us;               /**< Average time a sample waited for its frame to close (in us). */
+    uint32_t samples_per_frame_x100;    /**< Average samples per frame, times 100. */
+    uint32_t efficiency_pct;            /**< Sample bytes over notification bytes (in percent). */
+    uint32_t packets_per_event_x100;    /**< Average notifications per connection event, times 100. */
+    uint32_t goodput_bps;               /**< Sample rate delivered (in bit/s). */
+} sample_coalescer_sim_report_t;
+
+
+/**@brief   Frame handed from the coalescer to the simulated link. */
+typedef struct
+{
+    uint16_t length;            /**< Notification length (in bytes). */
+    uint16_t sample_count;      /**< Samples in the frame. */
+    uint32_t close_us;          /**< Time the frame was closed. */
+    uint32_t first_us;          /**< Time of the oldest sample. */
+    uint64_t wait_us_sum;       /**< Time the samples waited for the frame to close, summed. */
+} sample_coalescer_sim_frame_t;
+
+
+/**@brief   Coalescing simulation, large enough that it should not live on the stack. */
+typedef struct
+{
+    sample_coalescer_t            coalescer;
+    link_model_sim_t              link;
+    sample_coalescer_sim_frame_t  frames[SAMPLE_COALESCER_SIM_FRAMES_MAX];  /**< Frames in flight, then frames waiting for the queue, indexed modulo 256. */
+    uint8_t                       head;                                     /**< Oldest frame. */
+    uint16_t                      in_flight;                                /**< Frames in the HVN TX queue. */
+    uint16_t                      count;                                    /**< Frames held, @p in_flight included. */
+    sample_coalescer_sim_report_t report;
+} sample_coalescer_sim_t;
+
+
+/**@brief   Function for running a sample stream through a coalescer on a simulated link.
+ *
+ * @details Samples, deadlines and connection events are played in time order, with time in us as
+ *          the counter. Lets the deadline be traded off against latency and throughput on a host,
+ *          before a value is picked for the firmware.
+ *
+ * @param[in]  p_sim     Simulation workspace.
+ * @param[in]  p_params  Simulation parameters.
+ * @param[out] p_report  Outcome.
+ *
+ * @retval true   If the simulation ran.
+ * @retval false  If a parameter was invalid.
+ */
+bool sample_coalescer_simulate(sample_coalescer_sim_t              * p_sim,
+                               sample_coalescer_sim_params_t const * p_params,
+                               sample_coalescer_sim_report_t       * p_report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SAMPLE_COALESCER_SIM_H
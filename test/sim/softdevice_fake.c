@@ -0,0 +1,345 @@
+#include <string.h>
+#include "softdevice_fake.h"
+#include "ble_srv_common.h"
+#include "ble_link_ctx_manager.h"
+#include "app_timer.h"
+#include "nrf_error.h"
+
+
+#define TICKS_PER_SEC   (APP_TIMER_CLOCK_FREQ / (APP_TIMER_CONFIG_RTC_FREQUENCY + 1))   /**< app_timer counter frequency (in Hz). */
+
+
+/**@brief Entry of the attribute table, indexed by handle. */
+typedef struct
+{
+    uint16_t len;
+    uint8_t  value[SOFTDEVICE_FAKE_VALUE_MAX_LEN];
+} fake_attr_t;
+
+
+static link_model_sim_t                   m_link;
+static nrf_sdh_ble_evt_observer_t const * mp_observer;
+static fake_attr_t                        m_attrs[SOFTDEVICE_FAKE_ATTR_MAX];
+static uint16_t                           m_attr_count;       /**< Handles given out, handle 0 is invalid. */
+static uint8_t                            m_uuid_count;       /**< Vendor specific base UUIDs added. */
+static uint16_t                           m_conn_handle = BLE_CONN_HANDLE_INVALID;
+static softdevice_fake_stats_t            m_stats;
+
+
+static void evt_report(ble_evt_t const * p_ble_evt)
+{
+    mp_observer->handler(p_ble_evt, mp_observer->p_context);
+}
+
+
+/**@brief Function for adding an attribute to the table.
+ *
+ * @return  Its handle, 0 if the table is full.
+ */
+static uint16_t attr_add(uint8_t const * p_value, uint16_t len)
+{
+    if (m_attr_count + 1 >= SOFTDEVICE_FAKE_ATTR_MAX)
+    {
+        return 0;
+    }
+
+    m_attr_count++;
+    m_attrs[m_attr_count].len = MIN(len, SOFTDEVICE_FAKE_VALUE_MAX_LEN);
+
+    if (p_value != NULL)
+    {
+        memcpy(m_attrs[m_attr_count].value, p_value, m_attrs[m_attr_count].len);
+    }
+    else
+    {
+        memset(m_attrs[m_attr_count].value, 0, m_attrs[m_attr_count].len);
+    }
+
+    return m_attr_count;
+}
+
+
+static bool attr_is_valid(uint16_t handle)
+{
+    return (handle != 0) && (handle <= m_attr_count);
+}
+
+
+uint32_t app_timer_cnt_get(void)
+{
+    return (uint32_t)(((uint64_t)m_link.report.elapsed_us * TICKS_PER_SEC) / 1000000) & 0x00FFFFFF;
+}
+
+
+uint32_t sd_ble_uuid_vs_add(ble_uuid128_t const * p_vs_uuid, uint8_t * p_uuid_type)
+{
+    if ((p_vs_uuid == NULL) || (p_uuid_type == NULL))
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    // Vendor specific types start after BLE_UUID_TYPE_BLE.
+    *p_uuid_type = 2 + m_uuid_count++;
+
+    return NRF_SUCCESS;
+}
+
+
+uint32_t sd_ble_gatts_service_add(uint8_t type, ble_uuid_t const * p_uuid, uint16_t * p_handle)
+{
+    if ((p_uuid == NULL) || (p_handle == NULL))
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    *p_handle = attr_add(NULL, 0);
+
+    return (*p_handle != 0) ? NRF_SUCCESS : NRF_ERROR_NO_MEM;
+}
+
+
+uint32_t characteristic_add(uint16_t                   service_handle,
+                            ble_add_char_params_t    * p_char_props,
+                            ble_gatts_char_handles_t * p_char_handle)
+{
+    uint8_t const cccd_value[2] = {0};
+
+    if ((p_char_props == NULL) || (p_char_handle == NULL))
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    if (!attr_is_valid(service_handle) || (p_char_props->max_len > SOFTDEVICE_FAKE_VALUE_MAX_LEN))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    // Declaration, value, CCCD and user description, in the order of the SoftDevice.
+    memset(p_char_handle, 0, sizeof(ble_gatts_char_handles_t));
+
+    if (attr_add(NULL, 0) == 0)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    p_char_handle->value_handle = attr_add(p_char_props->p_init_value, p_char_props->init_len);
+    if (p_char_handle->value_handle == 0)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    if (p_char_props->char_props.notify || p_char_props->char_props.indicate)
+    {
+        p_char_handle->cccd_handle = attr_add(cccd_value, sizeof(cccd_value));
+        if (p_char_handle->cccd_handle == 0)
+        {
+            return NRF_ERROR_NO_MEM;
+        }
+    }
+
+    if (p_char_props->p_user_descr != NULL)
+    {
+        p_char_handle->user_desc_handle = attr_add(p_char_props->p_user_descr->p_char_user_desc,
+                                                   p_char_props->p_user_descr->size);
+        if (p_char_handle->user_desc_handle == 0)
+        {
+            return NRF_ERROR_NO_MEM;
+        }
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+uint32_t sd_ble_gatts_value_get(uint16_t conn_handle, uint16_t handle, ble_gatts_value_t * p_value)
+{
+    uint16_t len;
+
+    if (p_value == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    if (!attr_is_valid(handle))
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    if (p_value->offset > m_attrs[handle].len)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    len = MIN(p_value->len, m_attrs[handle].len - p_value->offset);
+
+    if (p_value->p_value != NULL)
+    {
+        memcpy(p_value->p_value, &m_attrs[handle].value[p_value->offset], len);
+    }
+
+    p_value->len = len;
+
+    return NRF_SUCCESS;
+}
+
+
+uint32_t sd_ble_gatts_value_set(uint16_t conn_handle, uint16_t handle, ble_gatts_value_t * p_value)
+{
+    if ((p_value == NULL) || (p_value->p_value == NULL))
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    if (!attr_is_valid(handle))
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    if (p_value->offset + p_value->len > SOFTDEVICE_FAKE_VALUE_MAX_LEN)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    memcpy(&m_attrs[handle].value[p_value->offset], p_value->p_value, p_value->len);
+    m_attrs[handle].len = p_value->offset + p_value->len;
+
+    return NRF_SUCCESS;
+}
+
+
+uint32_t sd_ble_gatts_hvx(uint16_t conn_handle, ble_gatts_hvx_params_t const * p_hvx_params)
+{
+    m_stats.hvx_calls++;
+
+    if ((p_hvx_params == NULL) || (p_hvx_params->p_len == NULL))
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    if ((conn_handle == BLE_CONN_HANDLE_INVALID) || (conn_handle != m_conn_handle))
+    {
+        return BLE_ERROR_INVALID_CONN_HANDLE;
+    }
+
+    if (!attr_is_valid(p_hvx_params->handle))
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    if (*p_hvx_params->p_len > m_link.params.att_mtu - LINK_MODEL_ATT_HVX_HEADER_LEN)
+    {
+        return NRF_ERROR_DATA_SIZE;
+    }
+
+    if (!link_model_sim_hvx(&m_link, *p_hvx_params->p_len))
+    {
+        m_stats.hvx_rejected++;
+        return NRF_ERROR_RESOURCES;
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t blcm_link_ctx_get(blcm_link_ctx_storage_t const * const p_link_ctx_storage,
+                             uint16_t                        const conn_handle,
+                             void                         ** const pp_ctx_data)
+{
+    if ((p_link_ctx_storage == NULL) || (pp_ctx_data == NULL))
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    *pp_ctx_data = NULL;
+
+    // One link, at connection index 0.
+    if ((conn_handle == BLE_CONN_HANDLE_INVALID) || (conn_handle != m_conn_handle))
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    *pp_ctx_data = p_link_ctx_storage->p_ctx_data_pool;
+
+    return NRF_SUCCESS;
+}
+
+
+void softdevice_fake_init(link_model_params_t const * p_params, nrf_sdh_ble_evt_observer_t const * p_observer)
+{
+    link_model_sim_init(&m_link, p_params);
+
+    mp_observer   = p_observer;
+    m_attr_count  = 0;
+    m_uuid_count  = 0;
+    m_conn_handle = BLE_CONN_HANDLE_INVALID;
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+
+void softdevice_fake_connect(uint16_t conn_handle)
+{
+    ble_evt_t evt;
+
+    m_conn_handle = conn_handle;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.header.evt_id           = BLE_GAP_EVT_CONNECTED;
+    evt.evt.gap_evt.conn_handle = conn_handle;
+
+    evt_report(&evt);
+}
+
+
+void softdevice_fake_cccd_write(uint16_t cccd_handle, uint16_t value)
+{
+    ble_evt_t               evt;
+    ble_gatts_evt_write_t * p_write = &evt.evt.gatts_evt.params.write;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.header.evt_id             = BLE_GATTS_EVT_WRITE;
+    evt.evt.gatts_evt.conn_handle = m_conn_handle;
+    p_write->handle               = cccd_handle;
+    p_write->len                  = sizeof(p_write->data);
+    p_write->data[0]              = (uint8_t)value;
+    p_write->data[1]              = (uint8_t)(value >> 8);
+
+    if (attr_is_valid(cccd_handle))
+    {
+        memcpy(m_attrs[cccd_handle].value, p_write->data, sizeof(p_write->data));
+        m_attrs[cccd_handle].len = sizeof(p_write->data);
+    }
+
+    evt_report(&evt);
+}
+
+
+uint8_t softdevice_fake_conn_event(void)
+{
+    ble_evt_t evt;
+    uint8_t   completed = link_model_sim_conn_event(&m_link);
+
+    if (completed > 0)
+    {
+        memset(&evt, 0, sizeof(evt));
+        evt.header.evt_id                             = BLE_GATTS_EVT_HVN_TX_COMPLETE;
+        evt.evt.gatts_evt.conn_handle                 = m_conn_handle;
+        evt.evt.gatts_evt.params.hvn_tx_complete.count = completed;
+
+        m_stats.tx_complete_evts++;
+        evt_report(&evt);
+    }
+
+    return completed;
+}
+
+
+link_model_sim_t * softdevice_fake_link(void)
+{
+    return &m_link;
+}
+
+
+softdevice_fake_stats_t const * softdevice_fake_stats(void)
+{
+    return &m_stats;
+}
@@ -0,0 +1,80 @@
+#ifndef __SOFTDEVICE_FAKE_H
+#define __SOFTDEVICE_FAKE_H
+
+#include <stdint.h>
+#include "ble.h"
+#include "nrf_sdh_ble.h"
+#include "link_model.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Attributes the fake attribute table holds. */
+#ifndef SOFTDEVICE_FAKE_ATTR_MAX
+#define SOFTDEVICE_FAKE_ATTR_MAX        16
+#endif
+
+/**@brief   Longest attribute value the fake stores (in bytes), the largest ATT MTU of the S132. */
+#define SOFTDEVICE_FAKE_VALUE_MAX_LEN   247
+
+
+/**@brief   What the application asked of the fake since @ref softdevice_fake_init. */
+typedef struct
+{
+    uint32_t hvx_calls;         /**< Calls to sd_ble_gatts_hvx. */
+    uint32_t hvx_rejected;      /**< Calls refused with NRF_ERROR_RESOURCES, each a spin of the caller. */
+    uint32_t tx_complete_evts;  /**< BLE_GATTS_EVT_HVN_TX_COMPLETE events reported, each a wakeup. */
+} softdevice_fake_stats_t;
+
+
+/**@brief   Function for starting the fake SoftDevice, with an empty attribute table and no link.
+ *
+ * @details sd_ble_gatts_hvx queues on a @ref link_model_sim_t with @p p_params and reports
+ *          NRF_ERROR_RESOURCES while its HVN TX queue is full. The app_timer counter follows the
+ *          simulated time. Events go to @p p_observer, the observer a module registers with
+ *          NRF_SDH_BLE_OBSERVER.
+ *
+ * @param[in] p_params    Simulated link.
+ * @param[in] p_observer  Observer the events are reported to.
+ */
+void softdevice_fake_init(link_model_params_t const * p_params, nrf_sdh_ble_evt_observer_t const * p_observer);
+
+
+/**@brief   Function for connecting the peer and reporting BLE_GAP_EVT_CONNECTED.
+ */
+void softdevice_fake_connect(uint16_t conn_handle);
+
+
+/**@brief   Function for a write of the peer to a CCCD, stored and reported as BLE_GATTS_EVT_WRITE.
+ *
+ * @param[in] cccd_handle  Handle of the CCCD.
+ * @param[in] value        CCCD value, BLE_GATT_HVX_NOTIFICATION to enable notification.
+ */
+void softdevice_fake_cccd_write(uint16_t cccd_handle, uint16_t value);
+
+
+/**@brief   Function for running one connection event.
+ *
+ * @details Completed notifications are reported in one BLE_GATTS_EVT_HVN_TX_COMPLETE, as the
+ *          SoftDevice does, and none is reported if nothing completed.
+ *
+ * @return  Number of notifications completed.
+ */
+uint8_t softdevice_fake_conn_event(void);
+
+
+/**@brief   Function for getting the simulated link, for its report.
+ */
+link_model_sim_t * softdevice_fake_link(void);
+
+
+/**@brief   Function for getting the call counters.
+ */
+softdevice_fake_stats_t const * softdevice_fake_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SOFTDEVICE_FAKE_H
@@ -0,0 +1,19 @@
+#ifndef APP_TIMER_H__
+#define APP_TIMER_H__
+
+#include <stdint.h>
+#include "sdk_config.h"
+
+// The counter of app_timer: the 24-bit RTC at APP_TIMER_CONFIG_RTC_FREQUENCY of sdk_config.h.
+#define APP_TIMER_CLOCK_FREQ    32768
+#define APP_TIMER_TICKS(MS)     ((uint32_t)(((uint64_t)(MS) * APP_TIMER_CLOCK_FREQ) / (1000 * (APP_TIMER_CONFIG_RTC_FREQUENCY + 1))))
+
+// Counter value, given by the fake SoftDevice of the host build.
+uint32_t app_timer_cnt_get(void);
+
+static inline uint32_t app_timer_cnt_diff_compute(uint32_t ticks_to, uint32_t ticks_from)
+{
+    return (ticks_to - ticks_from) & 0x00FFFFFF;
+}
+
+#endif // APP_TIMER_H__
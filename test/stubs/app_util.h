@@ -0,0 +1,13 @@
+#ifndef APP_UTIL_H__
+#define APP_UTIL_H__
+
+#include <stdint.h>
+#include "nordic_common.h"
+
+#define STATIC_ASSERT(EXPR)     _Static_assert((EXPR), #EXPR)
+
+#define IS_POWER_OF_TWO(A)      (((A) != 0) && ((((A) - 1) & (A)) == 0))
+
+#define ARRAY_SIZE(arr)         (sizeof(arr) / sizeof((arr)[0]))
+
+#endif // APP_UTIL_H__
@@ -0,0 +1,117 @@
+#ifndef BLE_H__
+#define BLE_H__
+
+#include <stdint.h>
+#include "nrf_error.h"
+
+// The part of the S132 API the sensor service uses, with the values of the SoftDevice. The calls
+// are made by the fake SoftDevice of the host build, see sim/softdevice_fake.h.
+
+#define BLE_ERROR_INVALID_CONN_HANDLE   0x3002
+
+#define BLE_CONN_HANDLE_INVALID         0xFFFF
+#define BLE_GATT_ATT_MTU_DEFAULT        23
+#define BLE_GATT_HVX_NOTIFICATION       0x01
+#define BLE_GATT_HVX_INDICATION         0x02
+#define BLE_GATTS_SRVC_TYPE_PRIMARY     0x01
+#define BLE_GATT_HVX_NOTIFICATION_BIT   0x0001
+
+#define BLE_GAP_EVT_CONNECTED           0x10
+#define BLE_GAP_EVT_DISCONNECTED        0x11
+#define BLE_GATTS_EVT_WRITE             0x50
+#define BLE_GATTS_EVT_HVN_TX_COMPLETE   0x57
+
+
+typedef struct
+{
+    uint16_t uuid;
+    uint8_t  type;
+} ble_uuid_t;
+
+typedef struct
+{
+    uint8_t uuid128[16];
+} ble_uuid128_t;
+
+typedef struct
+{
+    uint16_t value_handle;
+    uint16_t user_desc_handle;
+    uint16_t cccd_handle;
+    uint16_t sccd_handle;
+} ble_gatts_char_handles_t;
+
+typedef struct
+{
+    uint16_t  len;
+    uint16_t  offset;
+    uint8_t * p_value;
+} ble_gatts_value_t;
+
+typedef struct
+{
+    uint16_t        handle;
+    uint8_t         type;
+    uint16_t        offset;
+    uint16_t      * p_len;
+    uint8_t const * p_data;
+} ble_gatts_hvx_params_t;
+
+typedef struct
+{
+    uint16_t handle;
+    uint8_t  op;
+    uint8_t  auth_required;
+    uint16_t offset;
+    uint16_t len;
+    uint8_t  data[2];           // Variable length in the SoftDevice, a CCCD value fits.
+} ble_gatts_evt_write_t;
+
+typedef struct
+{
+    uint8_t count;
+} ble_gatts_evt_hvn_tx_complete_t;
+
+typedef struct
+{
+    uint16_t conn_handle;
+} ble_gap_evt_t;
+
+typedef struct
+{
+    uint16_t conn_handle;
+    union
+    {
+        ble_gatts_evt_write_t           write;
+        ble_gatts_evt_hvn_tx_complete_t hvn_tx_complete;
+    } params;
+} ble_gatts_evt_t;
+
+typedef struct
+{
+    uint16_t evt_id;
+    uint16_t evt_len;
+} ble_evt_hdr_t;
+
+typedef struct
+{
+    ble_evt_hdr_t header;
+    union
+    {
+        ble_gap_evt_t   gap_evt;
+        ble_gatts_evt_t gatts_evt;
+    } evt;
+} ble_evt_t;
+
+
+uint32_t sd_ble_uuid_vs_add(ble_uuid128_t const * p_vs_uuid, uint8_t * p_uuid_type);
+
+uint32_t sd_ble_gatts_service_add(uint8_t type, ble_uuid_t const * p_uuid, uint16_t * p_handle);
+
+uint32_t sd_ble_gatts_value_get(uint16_t conn_handle, uint16_t handle, ble_gatts_value_t * p_value);
+
+uint32_t sd_ble_gatts_value_set(uint16_t conn_handle, uint16_t handle, ble_gatts_value_t * p_value);
+
+uint32_t sd_ble_gatts_hvx(uint16_t conn_handle, ble_gatts_hvx_params_t const * p_hvx_params);
+
+#endif // BLE_H__
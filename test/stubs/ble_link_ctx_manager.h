@@ -0,0 +1,29 @@
+#ifndef BLE_LINK_CTX_MANAGER_H__
+#define BLE_LINK_CTX_MANAGER_H__
+
+#include <stdint.h>
+#include "sdk_errors.h"
+#include "nordic_common.h"
+
+typedef struct
+{
+    void     * const p_ctx_data_pool;
+    uint8_t  const   max_links_cnt;
+    uint16_t const   link_ctx_size;
+} blcm_link_ctx_storage_t;
+
+#define BLE_LINK_CTX_MANAGER_DEF(_name, _max_clients, _link_ctx_size_bytes)                    \
+    static uint32_t CONCAT_2(_name, _ctx_data_pool)[(_max_clients) * (((_link_ctx_size_bytes) + 3) / 4)]; \
+    static blcm_link_ctx_storage_t _name =                                                      \
+    {                                                                                           \
+        .p_ctx_data_pool = CONCAT_2(_name, _ctx_data_pool),                                     \
+        .max_links_cnt   = (_max_clients),                                                      \
+        .link_ctx_size   = sizeof(CONCAT_2(_name, _ctx_data_pool)) / (_max_clients)             \
+    }
+
+// Context of the link with @p conn_handle, looked up by the fake SoftDevice of the host build.
+ret_code_t blcm_link_ctx_get(blcm_link_ctx_storage_t const * const p_link_ctx_storage,
+                             uint16_t                        const conn_handle,
+                             void                         ** const pp_ctx_data);
+
+#endif // BLE_LINK_CTX_MANAGER_H__
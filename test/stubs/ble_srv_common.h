@@ -0,0 +1,69 @@
+#ifndef BLE_SRV_COMMON_H__
+#define BLE_SRV_COMMON_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdk_common.h"
+#include "ble.h"
+
+typedef enum
+{
+    SEC_NO_ACCESS,
+    SEC_OPEN,
+    SEC_JUST_WORKS,
+    SEC_MITM,
+} security_req_t;
+
+typedef struct
+{
+    uint8_t broadcast      : 1;
+    uint8_t read           : 1;
+    uint8_t write_wo_resp  : 1;
+    uint8_t write          : 1;
+    uint8_t notify         : 1;
+    uint8_t indicate       : 1;
+    uint8_t auth_signed_wr : 1;
+} ble_gatt_char_props_t;
+
+typedef struct
+{
+    uint16_t       max_size;
+    uint16_t       size;
+    uint8_t      * p_char_user_desc;
+    bool           is_var_len;
+    security_req_t read_access;
+    security_req_t write_access;
+} ble_add_char_user_desc_t;
+
+typedef struct
+{
+    uint16_t                   uuid;
+    uint8_t                    uuid_type;
+    uint16_t                   max_len;
+    uint16_t                   init_len;
+    uint8_t                  * p_init_value;
+    bool                       is_var_len;
+    ble_gatt_char_props_t      char_props;
+    bool                       is_defered_read;
+    bool                       is_defered_write;
+    security_req_t             read_access;
+    security_req_t             write_access;
+    security_req_t             cccd_write_access;
+    bool                       is_value_user;
+    ble_add_char_user_desc_t * p_user_descr;
+} ble_add_char_params_t;
+
+
+static inline bool ble_srv_is_notification_enabled(uint8_t const * p_encoded_data)
+{
+    uint16_t cccd_value = (uint16_t)(p_encoded_data[0] | (p_encoded_data[1] << 8));
+
+    return (cccd_value & BLE_GATT_HVX_NOTIFICATION_BIT) != 0;
+}
+
+// Adds the characteristic to the attribute table of the fake SoftDevice.
+uint32_t characteristic_add(uint16_t                   service_handle,
+                            ble_add_char_params_t    * p_char_props,
+                            ble_gatts_char_handles_t * p_char_handle);
+
+#endif // BLE_SRV_COMMON_H__
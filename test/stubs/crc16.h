@@ -0,0 +1,11 @@
+#ifndef CRC16_H__
+#define CRC16_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**@brief   CRC16 (CCITT) of the SDK, see components/libraries/crc16.
+ */
+uint16_t crc16_compute(uint8_t const * p_data, uint32_t size, uint16_t const * p_crc);
+
+#endif // CRC16_H__
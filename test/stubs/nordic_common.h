@@ -0,0 +1,13 @@
+#ifndef NORDIC_COMMON_H__
+#define NORDIC_COMMON_H__
+
+// Helpers of the SDK the modules under test use.
+#define MIN(a, b)           ((a) < (b) ? (a) : (b))
+#define MAX(a, b)           ((a) < (b) ? (b) : (a))
+
+#define CONCAT_2(p1, p2)    CONCAT_2_(p1, p2)
+#define CONCAT_2_(p1, p2)   p1##p2
+
+#define UNUSED_PARAMETER(X) (void)(X)
+
+#endif // NORDIC_COMMON_H__
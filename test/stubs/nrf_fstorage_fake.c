@@ -0,0 +1,274 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "nrf_fstorage_fake.h"
+#include "nrf_error.h"
+#include "nordic_common.h"
+
+
+/**@brief Write or erase waiting in the queue. */
+typedef struct
+{
+    nrf_fstorage_t const * p_fs;
+    nrf_fstorage_evt_id_t  id;
+    uint32_t               addr;
+    void const           * p_src;
+    uint32_t               len;
+    void                 * p_param;
+} fake_op_t;
+
+
+struct nrf_fstorage_api_s
+{
+    char const * p_name;
+};
+
+nrf_fstorage_api_t const nrf_fstorage_fake = {"fake"};
+
+static nrf_fstorage_info_t       m_info =
+{
+    .erase_unit   = NRF_FSTORAGE_FAKE_PAGE_SIZE,
+    .program_unit = 4,
+    .rmap         = true,
+    .wmap         = false,
+};
+static uint8_t                 * m_flash;           /**< Content of the region. */
+static uint32_t                  m_start;           /**< First address of the region. */
+static uint32_t                  m_size;            /**< Size of the region (in bytes). */
+static uint32_t                * m_page_erases;     /**< Erase count of every page. */
+static fake_op_t                 m_queue[NRF_FSTORAGE_FAKE_QUEUE_SIZE];
+static uint32_t                  m_queue_len;
+static uint32_t                  m_fail_count;
+static nrf_fstorage_fake_stats_t m_stats;
+
+
+static uint8_t * flash_at(uint32_t addr, uint32_t len)
+{
+    assert((addr >= m_start) && (addr + len <= m_start + m_size));
+
+    return &m_flash[addr - m_start];
+}
+
+
+static ret_code_t op_push(fake_op_t const * p_op)
+{
+    if (m_queue_len == NRF_FSTORAGE_FAKE_QUEUE_SIZE)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    m_queue[m_queue_len++] = *p_op;
+
+    return NRF_SUCCESS;
+}
+
+
+static void op_pop(fake_op_t * p_op)
+{
+    *p_op = m_queue[0];
+    m_queue_len--;
+    memmove(&m_queue[0], &m_queue[1], m_queue_len * sizeof(fake_op_t));
+}
+
+
+ret_code_t nrf_fstorage_init(nrf_fstorage_t * p_fs, nrf_fstorage_api_t const * p_api, void * p_param)
+{
+    uint32_t size = p_fs->end_addr - p_fs->start_addr;
+
+    (void)p_param;
+
+    assert(p_api == &nrf_fstorage_fake);
+    assert((size > 0) && ((size % NRF_FSTORAGE_FAKE_PAGE_SIZE) == 0));
+
+    p_fs->p_api        = p_api;
+    p_fs->p_flash_info = &m_info;
+    m_queue_len        = 0;
+
+    if ((m_flash != NULL) && (m_start == p_fs->start_addr) && (m_size == size))
+    {
+        return NRF_SUCCESS;
+    }
+
+    free(m_flash);
+    free(m_page_erases);
+    m_flash       = malloc(size);
+    m_page_erases = calloc(size / NRF_FSTORAGE_FAKE_PAGE_SIZE, sizeof(uint32_t));
+    m_start       = p_fs->start_addr;
+    m_size        = size;
+    assert((m_flash != NULL) && (m_page_erases != NULL));
+
+    nrf_fstorage_fake_erase_all();
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t nrf_fstorage_read(nrf_fstorage_t const * p_fs, uint32_t src, void * p_dest, uint32_t len)
+{
+    (void)p_fs;
+
+    memcpy(p_dest, flash_at(src, len), len);
+    m_stats.reads++;
+    m_stats.read_bytes += len;
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t nrf_fstorage_write(nrf_fstorage_t const * p_fs, uint32_t dest, void const * p_src, uint32_t len, void * p_param)
+{
+    fake_op_t op = {p_fs, NRF_FSTORAGE_EVT_WRITE_RESULT, dest, p_src, len, p_param};
+
+    assert((len > 0) && ((dest % m_info.program_unit) == 0) && ((len % m_info.program_unit) == 0));
+    (void)flash_at(dest, len);
+
+    return op_push(&op);
+}
+
+
+ret_code_t nrf_fstorage_erase(nrf_fstorage_t const * p_fs, uint32_t page_addr, uint32_t len, void * p_param)
+{
+    fake_op_t op = {p_fs, NRF_FSTORAGE_EVT_ERASE_RESULT, page_addr, NULL, len, p_param};
+
+    assert((len > 0) && (((page_addr - m_start) % m_info.erase_unit) == 0));
+    (void)flash_at(page_addr, len * m_info.erase_unit);
+
+    return op_push(&op);
+}
+
+
+uint8_t const * nrf_fstorage_rmap(nrf_fstorage_t const * p_fs, uint32_t addr)
+{
+    (void)p_fs;
+
+    return flash_at(addr, 0);
+}
+
+
+bool nrf_fstorage_is_busy(nrf_fstorage_t const * p_fs)
+{
+    (void)p_fs;
+
+    return m_queue_len > 0;
+}
+
+
+void nrf_fstorage_fake_erase_all(void)
+{
+    memset(m_flash, 0xFF, m_size);
+    m_queue_len  = 0;
+    m_fail_count = 0;
+    nrf_fstorage_fake_stats_clear();
+}
+
+
+uint32_t nrf_fstorage_fake_run(uint32_t max_ops)
+{
+    uint32_t done = 0;
+
+    while ((m_queue_len > 0) && (done < max_ops))
+    {
+        fake_op_t          op;
+        nrf_fstorage_evt_t evt;
+
+        op_pop(&op);
+        done++;
+
+        evt.id      = op.id;
+        evt.result  = NRF_SUCCESS;
+        evt.addr    = op.addr;
+        evt.p_src   = op.p_src;
+        evt.len     = op.len;
+        evt.p_param = op.p_param;
+
+        if (m_fail_count > 0)
+        {
+            m_fail_count--;
+            evt.result = NRF_ERROR_INTERNAL;
+        }
+        else if (op.id == NRF_FSTORAGE_EVT_ERASE_RESULT)
+        {
+            memset(flash_at(op.addr, op.len * m_info.erase_unit), 0xFF, op.len * m_info.erase_unit);
+            for (uint32_t i = 0; i < op.len; i++)
+            {
+                m_page_erases[(op.addr - m_start) / m_info.erase_unit + i]++;
+            }
+            m_stats.erases += op.len;
+        }
+        else
+        {
+            uint8_t       * p_dest = flash_at(op.addr, op.len);
+            uint8_t const * p_src  = op.p_src;
+
+            for (uint32_t i = 0; i < op.len; i++)
+            {
+                p_dest[i] &= p_src[i];
+            }
+            m_stats.writes++;
+        }
+
+        if (op.p_fs->evt_handler != NULL)
+        {
+            op.p_fs->evt_handler(&evt);
+        }
+    }
+
+    return done;
+}
+
+
+void nrf_fstorage_fake_power_cut(uint32_t bytes_done)
+{
+    fake_op_t op;
+
+    if (m_queue_len == 0)
+    {
+        return;
+    }
+
+    op_pop(&op);
+    m_queue_len = 0;
+
+    if (op.id == NRF_FSTORAGE_EVT_ERASE_RESULT)
+    {
+        bytes_done = MIN(bytes_done, op.len * m_info.erase_unit);
+        memset(flash_at(op.addr, bytes_done), 0xFF, bytes_done);
+    }
+    else
+    {
+        uint8_t       * p_dest = flash_at(op.addr, op.len);
+        uint8_t const * p_src  = op.p_src;
+
+        for (uint32_t i = 0; i < MIN(bytes_done, op.len); i++)
+        {
+            p_dest[i] &= p_src[i];
+        }
+    }
+}
+
+
+void nrf_fstorage_fake_fail_next(uint32_t count)
+{
+    m_fail_count = count;
+}
+
+
+uint32_t nrf_fstorage_fake_page_erases(uint32_t page_index)
+{
+    assert(page_index < m_size / m_info.erase_unit);
+
+    return m_page_erases[page_index];
+}
+
+
+nrf_fstorage_fake_stats_t const * nrf_fstorage_fake_stats(void)
+{
+    return &m_stats;
+}
+
+
+void nrf_fstorage_fake_stats_clear(void)
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+    memset(m_page_erases, 0, (m_size / m_info.erase_unit) * sizeof(uint32_t));
+}
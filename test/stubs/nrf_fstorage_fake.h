@@ -0,0 +1,89 @@
+#ifndef NRF_FSTORAGE_FAKE_H__
+#define NRF_FSTORAGE_FAKE_H__
+
+#include <stdint.h>
+#include "nrf_fstorage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief   Flash page of the fake (in bytes), as on the nRF52832. */
+#ifndef NRF_FSTORAGE_FAKE_PAGE_SIZE
+#define NRF_FSTORAGE_FAKE_PAGE_SIZE     4096
+#endif
+
+/**@brief   Operations the fake queues, as NRF_FSTORAGE_SD_QUEUE_SIZE in sdk_config.h. */
+#ifndef NRF_FSTORAGE_FAKE_QUEUE_SIZE
+#define NRF_FSTORAGE_FAKE_QUEUE_SIZE    4
+#endif
+
+
+/**@brief   RAM backed fstorage backend, pass it to nrf_fstorage_init.
+ *
+ * @details One instance at a time. Its region is held in RAM, erased at init, and keeps its content
+ *          across nrf_fstorage_init calls for the same region, as flash keeps it across a reset.
+ *          Writes and erases are queued, as with the SoftDevice backend, and only take effect,
+ *          and report their event, from @ref nrf_fstorage_fake_run. Writes can only clear bits.
+ */
+extern nrf_fstorage_api_t const nrf_fstorage_fake;
+
+
+/**@brief   What the fake has been asked to do since @ref nrf_fstorage_fake_stats_clear. */
+typedef struct
+{
+    uint32_t reads;             /**< Calls to nrf_fstorage_read. */
+    uint32_t read_bytes;        /**< Bytes read by nrf_fstorage_read. */
+    uint32_t writes;            /**< Writes completed. */
+    uint32_t erases;            /**< Pages erased. */
+} nrf_fstorage_fake_stats_t;
+
+
+/**@brief   Function for erasing the whole region and emptying the queue, a new device.
+ */
+void nrf_fstorage_fake_erase_all(void);
+
+
+/**@brief   Function for completing queued operations, oldest first, and reporting their events.
+ *
+ * @details Operations queued by the event handlers are completed too, up to @p max_ops in all.
+ *
+ * @return  Number of operations completed.
+ */
+uint32_t nrf_fstorage_fake_run(uint32_t max_ops);
+
+
+/**@brief   Function for cutting the power.
+ *
+ * @details The oldest queued operation is left half done: the first @p bytes_done bytes of a write
+ *          are written, and an erase sets the first @p bytes_done bytes of its page. Every other
+ *          queued operation is dropped. No event is reported.
+ */
+void nrf_fstorage_fake_power_cut(uint32_t bytes_done);
+
+
+/**@brief   Function for making the next @p count operations to complete fail, leaving flash as
+ *          it was.
+ */
+void nrf_fstorage_fake_fail_next(uint32_t count);
+
+
+/**@brief   Function for getting the erase count of the page at @p page_index in the region.
+ */
+uint32_t nrf_fstorage_fake_page_erases(uint32_t page_index);
+
+
+/**@brief   Function for getting the operation counters.
+ */
+nrf_fstorage_fake_stats_t const * nrf_fstorage_fake_stats(void);
+
+
+/**@brief   Function for clearing the operation counters, and the erase counts of the pages.
+ */
+void nrf_fstorage_fake_stats_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NRF_FSTORAGE_FAKE_H__
@@ -0,0 +1,11 @@
+#ifndef NRF_LOG_H__
+#define NRF_LOG_H__
+
+// The host build does not log.
+#define NRF_LOG_ERROR(...)      do {} while (0)
+#define NRF_LOG_WARNING(...)    do {} while (0)
+#define NRF_LOG_INFO(...)       do {} while (0)
+#define NRF_LOG_DEBUG(...)      do {} while (0)
+#define NRF_LOG_RAW_INFO(...)   do {} while (0)
+
+#endif // NRF_LOG_H__
@@ -0,0 +1,120 @@
+#include "nrf_ringbuf.h"
+#include "nrf_error.h"
+
+
+void nrf_ringbuf_init(nrf_ringbuf_t const * p_ringbuf)
+{
+    p_ringbuf->p_cb->wr_idx     = 0;
+    p_ringbuf->p_cb->tmp_wr_idx = 0;
+    p_ringbuf->p_cb->rd_idx     = 0;
+    p_ringbuf->p_cb->tmp_rd_idx = 0;
+    p_ringbuf->p_cb->wr_flag    = 0;
+    p_ringbuf->p_cb->rd_flag    = 0;
+}
+
+
+ret_code_t nrf_ringbuf_alloc(nrf_ringbuf_t const * p_ringbuf, uint8_t ** pp_data, size_t * p_length, bool start)
+{
+    nrf_ringbuf_cb_t * p_cb = p_ringbuf->p_cb;
+    uint32_t           wr_idx;
+    uint32_t           rd_idx;
+    uint32_t           available;
+
+    if (start && atomic_exchange(&p_cb->wr_flag, 1))
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    if (p_cb->tmp_wr_idx - p_cb->rd_idx == p_ringbuf->bufsize_mask + 1)
+    {
+        *p_length = 0;
+        if (start)
+        {
+            atomic_store(&p_cb->wr_flag, 0);
+        }
+        return NRF_SUCCESS;
+    }
+
+    wr_idx    = p_cb->tmp_wr_idx & p_ringbuf->bufsize_mask;
+    rd_idx    = p_cb->rd_idx & p_ringbuf->bufsize_mask;
+    available = (wr_idx >= rd_idx) ? p_ringbuf->bufsize_mask + 1 - wr_idx
+                                   : p_cb->rd_idx - (p_cb->tmp_wr_idx - (p_ringbuf->bufsize_mask + 1));
+
+    *p_length = (*p_length < available) ? *p_length : available;
+    *pp_data  = &p_ringbuf->p_buffer[wr_idx];
+    p_cb->tmp_wr_idx += *p_length;
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t nrf_ringbuf_put(nrf_ringbuf_t const * p_ringbuf, size_t length)
+{
+    nrf_ringbuf_cb_t * p_cb = p_ringbuf->p_cb;
+
+    if (length > p_cb->tmp_wr_idx - p_cb->wr_idx)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    p_cb->wr_idx    += length;
+    p_cb->tmp_wr_idx = p_cb->wr_idx;
+
+    if (atomic_exchange(&p_cb->wr_flag, 0) == 0)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t nrf_ringbuf_get(nrf_ringbuf_t const * p_ringbuf, uint8_t ** pp_data, size_t * p_length, bool start)
+{
+    nrf_ringbuf_cb_t * p_cb = p_ringbuf->p_cb;
+    uint32_t           available;
+    uint32_t           rd_idx;
+
+    if (start && atomic_exchange(&p_cb->rd_flag, 1))
+    {
+        *p_length = 0;
+        return NRF_ERROR_BUSY;
+    }
+
+    available = p_cb->wr_idx - p_cb->tmp_rd_idx;
+    if (available == 0)
+    {
+        *p_length = 0;
+        if (start)
+        {
+            atomic_store(&p_cb->rd_flag, 0);
+        }
+        return NRF_SUCCESS;
+    }
+
+    rd_idx    = p_cb->tmp_rd_idx & p_ringbuf->bufsize_mask;
+    available = MIN(available, p_ringbuf->bufsize_mask + 1 - rd_idx);
+
+    *p_length = (*p_length < available) ? *p_length : available;
+    *pp_data  = &p_ringbuf->p_buffer[rd_idx];
+    p_cb->tmp_rd_idx += *p_length;
+
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t nrf_ringbuf_free(nrf_ringbuf_t const * p_ringbuf, size_t length)
+{
+    nrf_ringbuf_cb_t * p_cb = p_ringbuf->p_cb;
+
+    if (length > p_cb->tmp_rd_idx - p_cb->rd_idx)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    p_cb->rd_idx    += length;
+    p_cb->tmp_rd_idx = p_cb->rd_idx;
+    atomic_store(&p_cb->rd_flag, 0);
+
+    return NRF_SUCCESS;
+}
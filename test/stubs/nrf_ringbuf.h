@@ -0,0 +1,54 @@
+#ifndef NRF_RINGBUF_H__
+#define NRF_RINGBUF_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "sdk_errors.h"
+#include "app_util.h"
+
+/**@brief   Host version of nrf_ringbuf of the SDK, same interface and behaviour.
+ *
+ * @details The indexes are C11 atomics, so a producer and a consumer may run in two threads the
+ *          way they run in two interrupt priorities on the target.
+ */
+typedef struct
+{
+    atomic_uint         wr_flag;
+    atomic_uint         rd_flag;
+    _Atomic uint32_t    wr_idx;
+    _Atomic uint32_t    tmp_wr_idx;
+    _Atomic uint32_t    rd_idx;
+    _Atomic uint32_t    tmp_rd_idx;
+} nrf_ringbuf_cb_t;
+
+typedef struct
+{
+    uint8_t          * p_buffer;
+    uint32_t           bufsize_mask;
+    nrf_ringbuf_cb_t * p_cb;
+} nrf_ringbuf_t;
+
+#define NRF_RINGBUF_DEF(_name, _size)                                   \
+    STATIC_ASSERT(IS_POWER_OF_TWO(_size));                              \
+    static uint8_t CONCAT_2(_name, _buf)[_size];                        \
+    static nrf_ringbuf_cb_t CONCAT_2(_name, _cb);                       \
+    static const nrf_ringbuf_t _name =                                  \
+    {                                                                   \
+        .p_buffer     = CONCAT_2(_name, _buf),                          \
+        .bufsize_mask = (_size) - 1,                                    \
+        .p_cb         = &CONCAT_2(_name, _cb),                          \
+    }
+
+void nrf_ringbuf_init(nrf_ringbuf_t const * p_ringbuf);
+
+ret_code_t nrf_ringbuf_alloc(nrf_ringbuf_t const * p_ringbuf, uint8_t ** pp_data, size_t * p_length, bool start);
+
+ret_code_t nrf_ringbuf_put(nrf_ringbuf_t const * p_ringbuf, size_t length);
+
+ret_code_t nrf_ringbuf_get(nrf_ringbuf_t const * p_ringbuf, uint8_t ** pp_data, size_t * p_length, bool start);
+
+ret_code_t nrf_ringbuf_free(nrf_ringbuf_t const * p_ringbuf, size_t length);
+
+#endif // NRF_RINGBUF_H__
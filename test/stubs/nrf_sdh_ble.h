@@ -0,0 +1,18 @@
+#ifndef NRF_SDH_BLE_H__
+#define NRF_SDH_BLE_H__
+
+#include "ble.h"
+
+typedef void (* nrf_sdh_ble_evt_handler_t)(ble_evt_t const * p_ble_evt, void * p_context);
+
+typedef struct
+{
+    nrf_sdh_ble_evt_handler_t   handler;
+    void                      * p_context;
+} nrf_sdh_ble_evt_observer_t;
+
+// The host build has no observer section, the fake SoftDevice hands events to the handlers.
+#define NRF_SDH_BLE_OBSERVER(_name, _prio, _handler, _context)                      \
+    static nrf_sdh_ble_evt_observer_t _name __attribute__((used)) = {_handler, _context}
+
+#endif // NRF_SDH_BLE_H__
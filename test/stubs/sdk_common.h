@@ -0,0 +1,12 @@
+#ifndef SDK_COMMON_H__
+#define SDK_COMMON_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "nordic_common.h"
+#include "sdk_errors.h"
+#include "sdk_macros.h"
+#include "app_util.h"
+
+#endif // SDK_COMMON_H__
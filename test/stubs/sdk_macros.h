@@ -0,0 +1,24 @@
+#ifndef SDK_MACROS_H__
+#define SDK_MACROS_H__
+
+// Argument checks of the SDK, returning the error from the calling function.
+#define VERIFY_SUCCESS(statement)           \
+    do                                      \
+    {                                       \
+        uint32_t _err_code = (statement);   \
+        if (_err_code != NRF_SUCCESS)       \
+        {                                   \
+            return _err_code;               \
+        }                                   \
+    } while (0)
+
+#define VERIFY_PARAM_NOT_NULL(param)        \
+    do                                      \
+    {                                       \
+        if ((param) == NULL)                \
+        {                                   \
+            return NRF_ERROR_NULL;          \
+        }                                   \
+    } while (0)
+
+#endif // SDK_MACROS_H__
@@ -0,0 +1,108 @@
+#include <sstream>
+#include "test_check.h"
+#include "bench_csv.h"
+#include "bench_matrix.h"
+#include "hex.h"
+
+
+static const uint16_t m_conn_intervals[] = {6, 24};
+static const uint8_t  m_phys[]           = {1, 2};
+static const uint16_t m_att_mtus[]       = {23, 247};
+static const uint8_t  m_data_lengths[]   = {27, 251};
+static const uint8_t  m_queue_sizes[]    = {1, 7};
+
+static const bench_matrix_axes_t m_axes =
+{
+    m_conn_intervals, sizeof(m_conn_intervals) / sizeof(m_conn_intervals[0]),
+    m_phys,           sizeof(m_phys),
+    m_att_mtus,       sizeof(m_att_mtus) / sizeof(m_att_mtus[0]),
+    m_data_lengths,   sizeof(m_data_lengths),
+    m_queue_sizes,    sizeof(m_queue_sizes),
+};
+
+
+/**@brief Row the firmware logs for @p p_result, after its "bench," tag. */
+static std::string log_row(bench_matrix_result_t const * p_result)
+{
+    std::ostringstream row;
+
+    row << (unsigned)p_result->index << ',' << (unsigned)p_result->status << ','
+        << (unsigned)p_result->phy << ',' << p_result->conn_interval << ','
+        << p_result->att_mtu << ',' << (unsigned)p_result->data_length << ','
+        << (unsigned)p_result->queue_size << ',' << p_result->goodput_bps << ','
+        << p_result->packets_per_event_x100 << ',' << p_result->elapsed_ms;
+
+    return row.str();
+}
+
+
+/**@brief A simulated matrix, as notified on char3 and as logged, gives the same table. */
+static void test_simulated_matrix(void)
+{
+    bench_matrix_t        bench;
+    bench_matrix_result_t result;
+    uint8_t               record[BENCH_MATRIX_RESULT_LEN];
+    std::string           row;
+    uint32_t              cells = 0;
+
+    CHECK(bench_matrix_start(&bench, &m_axes));
+
+    do
+    {
+        bench_matrix_cell_simulate(&bench, 20000, 8, 7500, &result);
+        CHECK(bench_matrix_result_encode(&result, record) == BENCH_MATRIX_RESULT_LEN);
+
+        std::string expected = log_row(&result);
+        std::string hex      = hex_format(record, sizeof(record));
+        std::string dashed;
+
+        // As nRF Connect prints a value.
+        for (size_t i = 0; i < hex.size(); i += 2)
+        {
+            dashed += (i == 0) ? "" : "-";
+            dashed += hex.substr(i, 2);
+        }
+
+        CHECK(bench_csv_row(hex, &row));
+        CHECK(row == expected);
+        CHECK(bench_csv_row(dashed, &row));
+        CHECK(row == expected);
+        CHECK(bench_csv_row("<info> app: bench," + expected + "\r", &row));
+        CHECK(row == expected);
+
+        cells++;
+    } while (bench_matrix_advance(&bench));
+
+    CHECK(cells == bench_matrix_cell_count(&m_axes));
+}
+
+
+static void test_skipped_lines(void)
+{
+    std::vector<uint8_t> record;
+    std::string          row;
+
+    CHECK(!bench_csv_row("", &row));
+    CHECK(!bench_csv_row("<info> app: Benchmark started, 32 cells.", &row));
+    CHECK(!bench_csv_row("00 01 02", &row));
+    CHECK(!bench_csv_row("00 01 02 03 04 05 06 07 08 09 0a 0b 0c 0d 0e 0f 10 11 12", &row));
+    CHECK(!bench_csv_row("00 01 02 03 04 05 06 07 08 09 0a 0b 0c 0d 0e 0f 10 11 12 13 14", &row));
+    CHECK(!bench_csv_row("00 01 02 03 04 05 06 07 08 09 0a 0b 0c 0d 0e 0f 10 11 12 1", &row));
+    CHECK(!bench_csv_row("0 01 02 03 04 05 06 07 08 09 0a 0b 0c 0d 0e 0f 10 11 12 13", &row));
+    CHECK(!bench_csv_row("bench,1,2,3,4,5,6,7,8,9", &row));
+    CHECK(!bench_csv_row("bench,1,2,3,4,5,6,7,8,9,10,11", &row));
+    CHECK(!bench_csv_row("bench,1,2,,4,5,6,7,8,9,10", &row));
+    CHECK(!bench_csv_row("bench,1,2,x,4,5,6,7,8,9,10", &row));
+
+    CHECK(bench_csv_record_parse("0x000102030405060708090A0B0C0D0E0F10111213", &record));
+    CHECK((record.size() == BENCH_MATRIX_RESULT_LEN) && (record[10] == 0x0A) && (record[19] == 0x13));
+}
+
+
+int main(void)
+{
+    RUN(test_simulated_matrix);
+    RUN(test_skipped_lines);
+
+    return EXIT_SUCCESS;
+}
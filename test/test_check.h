@@ -0,0 +1,26 @@
+#ifndef __TEST_CHECK_H
+#define __TEST_CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**@brief   Ends the test with a failure if @p cond is false. */
+#define CHECK(cond)                                                                 \
+    do                                                                              \
+    {                                                                               \
+        if (!(cond))                                                                \
+        {                                                                           \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);  \
+            exit(EXIT_FAILURE);                                                     \
+        }                                                                           \
+    } while (0)
+
+/**@brief   Runs one test case and reports it. */
+#define RUN(test)                   \
+    do                              \
+    {                               \
+        test();                     \
+        printf("%s: ok\n", #test);  \
+    } while (0)
+
+#endif // __TEST_CHECK_H
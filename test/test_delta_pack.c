@@ -0,0 +1,369 @@
+#include <string.h>
+#include "test_check.h"
+#include "delta_pack.h"
+
+
+#define PAYLOAD_MAX     244                                 /**< Longest payload of the tests, one 2M PHY frame (in bytes). */
+#define READING_MAX     ((1u << DELTA_PACK_SAMPLE_BITS) - 1)
+
+#define KEYFRAME_BITS   (DELTA_PACK_CLASS_BITS + DELTA_PACK_CHANNELS * DELTA_PACK_SAMPLE_BITS)
+#define NARROW_BITS     (DELTA_PACK_CLASS_BITS + DELTA_PACK_CHANNELS * DELTA_PACK_NARROW_BITS)
+#define WIDE_BITS       (DELTA_PACK_CLASS_BITS + DELTA_PACK_CHANNELS * DELTA_PACK_WIDE_BITS)
+#define REPEAT_BITS     (DELTA_PACK_CLASS_BITS)
+
+
+static uint32_t m_rand = 7;
+
+
+static uint32_t rand_get(void)
+{
+    m_rand = m_rand * 1664525u + 1013904223u;
+    return m_rand >> 8;
+}
+
+
+static void sample_set(uint8_t * p_sample, uint16_t const * p_readings)
+{
+    for (uint8_t i = 0; i < DELTA_PACK_CHANNELS; i++)
+    {
+        p_sample[2 * i]     = (uint8_t)(p_readings[i]);
+        p_sample[2 * i + 1] = (uint8_t)(p_readings[i] >> 8);
+    }
+}
+
+
+/**@brief Packs @p count samples into one payload, each of which must fit.
+ *
+ * @return  Payload length (in bytes).
+ */
+static uint16_t pack(uint16_t const * p_readings, uint16_t count, uint8_t * p_payload)
+{
+    delta_pack_encoder_t encoder;
+    uint8_t              sample[DELTA_PACK_SAMPLE_LEN];
+    uint16_t             length = 0;
+
+    memset(&encoder, 0xA5, sizeof(encoder));
+
+    for (uint16_t n = 0; n < count; n++)
+    {
+        sample_set(sample, &p_readings[n * DELTA_PACK_CHANNELS]);
+        length = delta_pack_sample_put(&encoder, sample, n, p_payload, PAYLOAD_MAX);
+        CHECK(length > 0);
+    }
+
+    return length;
+}
+
+
+static void unpack_verify(uint8_t const * p_payload, uint16_t length, uint16_t const * p_readings, uint16_t count)
+{
+    static uint16_t decoded[DELTA_PACK_SAMPLES_MAX * DELTA_PACK_CHANNELS];
+    uint16_t        decoded_count = 0;
+
+    CHECK(delta_pack_decode(p_payload, length, decoded, DELTA_PACK_SAMPLES_MAX, &decoded_count));
+    CHECK(decoded_count == count);
+    CHECK(memcmp(decoded, p_readings, count * DELTA_PACK_SAMPLE_LEN) == 0);
+}
+
+
+/**@brief Every class takes the bits the format gives it, and decodes back.
+ */
+static void test_classes(void)
+{
+    static const struct
+    {
+        int16_t  step;      // Added to every channel.
+        uint16_t bits;      // Bits of a sample with that step.
+    } cases[] =
+    {
+        {0,                                   REPEAT_BITS},
+        {1,                                   NARROW_BITS},
+        {-2,                                  NARROW_BITS},
+        {2,                                   WIDE_BITS},
+        {-(1 << (DELTA_PACK_WIDE_BITS - 1)),  WIDE_BITS},
+        {1 << (DELTA_PACK_WIDE_BITS - 1),     KEYFRAME_BITS},
+        {-1000,                               KEYFRAME_BITS},
+    };
+    uint16_t readings[2 * DELTA_PACK_CHANNELS];
+    uint8_t  payload[PAYLOAD_MAX];
+
+    for (uint8_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+    {
+        for (uint8_t i = 0; i < DELTA_PACK_CHANNELS; i++)
+        {
+            readings[i]                       = 2048 + 100 * i;
+            readings[DELTA_PACK_CHANNELS + i] = (uint16_t)(readings[i] + cases[c].step);
+        }
+
+        // The first sample of a payload is a keyframe, after the count byte.
+        CHECK(pack(readings, 1, payload) == (8 + KEYFRAME_BITS + 7) / 8);
+        CHECK(payload[0] == 1);
+        CHECK((payload[1] & 0x03) == 3);
+
+        CHECK(pack(readings, 2, payload) == (8 + KEYFRAME_BITS + cases[c].bits + 7) / 8);
+        CHECK(payload[0] == 2);
+        unpack_verify(payload, (8 + KEYFRAME_BITS + cases[c].bits + 7) / 8, readings, 2);
+    }
+}
+
+
+/**@brief A sample widens to the largest delta of its channels.
+ */
+static void test_class_by_largest_channel(void)
+{
+    uint16_t readings[2 * DELTA_PACK_CHANNELS];
+    uint8_t  payload[PAYLOAD_MAX];
+
+    for (uint8_t i = 0; i < DELTA_PACK_CHANNELS; i++)
+    {
+        readings[i]                       = 1000;
+        readings[DELTA_PACK_CHANNELS + i] = 1000;
+    }
+
+    readings[2 * DELTA_PACK_CHANNELS - 1] = 1001;
+    CHECK(pack(readings, 2, payload) == (8 + KEYFRAME_BITS + NARROW_BITS + 7) / 8);
+    unpack_verify(payload, (8 + KEYFRAME_BITS + NARROW_BITS + 7) / 8, readings, 2);
+
+    readings[DELTA_PACK_CHANNELS] = 1010;
+    CHECK(pack(readings, 2, payload) == (8 + KEYFRAME_BITS + WIDE_BITS + 7) / 8);
+    unpack_verify(payload, (8 + KEYFRAME_BITS + WIDE_BITS + 7) / 8, readings, 2);
+}
+
+
+/**@brief A keyframe every @ref DELTA_PACK_KEYFRAME_INTERVAL samples, even for a flat signal.
+ */
+static void test_keyframe_interval(void)
+{
+    uint16_t readings[(DELTA_PACK_KEYFRAME_INTERVAL + 1) * DELTA_PACK_CHANNELS];
+    uint8_t  payload[PAYLOAD_MAX];
+    uint32_t bits = 8 + KEYFRAME_BITS + (DELTA_PACK_KEYFRAME_INTERVAL - 1) * REPEAT_BITS;
+
+    for (uint16_t i = 0; i < sizeof(readings) / sizeof(readings[0]); i++)
+    {
+        readings[i] = 123;
+    }
+
+    CHECK(pack(readings, DELTA_PACK_KEYFRAME_INTERVAL, payload) == (bits + 7) / 8);
+    CHECK(pack(readings, DELTA_PACK_KEYFRAME_INTERVAL + 1, payload) == (bits + KEYFRAME_BITS + 7) / 8);
+    unpack_verify(payload, (bits + KEYFRAME_BITS + 7) / 8, readings, DELTA_PACK_KEYFRAME_INTERVAL + 1);
+}
+
+
+/**@brief Only @ref DELTA_PACK_SAMPLE_BITS of a reading are kept, and deltas wrap within them.
+ */
+static void test_reading_bits(void)
+{
+    uint16_t readings[3 * DELTA_PACK_CHANNELS];
+    uint16_t expected[3 * DELTA_PACK_CHANNELS];
+    uint8_t  payload[PAYLOAD_MAX];
+    uint16_t length;
+
+    for (uint8_t i = 0; i < DELTA_PACK_CHANNELS; i++)
+    {
+        readings[i]                           = 0xF000 | READING_MAX;
+        readings[DELTA_PACK_CHANNELS + i]     = 0;
+        readings[2 * DELTA_PACK_CHANNELS + i] = READING_MAX;
+    }
+
+    for (uint16_t i = 0; i < sizeof(readings) / sizeof(readings[0]); i++)
+    {
+        expected[i] = readings[i] & READING_MAX;
+    }
+
+    length = pack(readings, 3, payload);
+    unpack_verify(payload, length, expected, 3);
+}
+
+
+/**@brief @ref DELTA_PACK_SAMPLES_MAX samples fit the count byte, one more does not.
+ */
+static void test_samples_max(void)
+{
+    static uint16_t      readings[DELTA_PACK_SAMPLES_MAX * DELTA_PACK_CHANNELS];
+    static uint16_t      decoded[DELTA_PACK_SAMPLES_MAX * DELTA_PACK_CHANNELS];
+    delta_pack_encoder_t encoder;
+    uint8_t              payload[PAYLOAD_MAX];
+    uint8_t              sample[DELTA_PACK_SAMPLE_LEN];
+    uint16_t             length;
+    uint16_t             count;
+
+    for (uint16_t i = 0; i < sizeof(readings) / sizeof(readings[0]); i++)
+    {
+        readings[i] = 500;
+    }
+
+    length = pack(readings, DELTA_PACK_SAMPLES_MAX, payload);
+    CHECK(payload[0] == DELTA_PACK_SAMPLES_MAX);
+    unpack_verify(payload, length, readings, DELTA_PACK_SAMPLES_MAX);
+
+    sample_set(sample, readings);
+    memset(&encoder, 0, sizeof(encoder));
+    CHECK(delta_pack_sample_put(&encoder, sample, DELTA_PACK_SAMPLES_MAX, payload, PAYLOAD_MAX) == 0);
+
+    // A payload with more samples than the caller has room for is refused.
+    CHECK(!delta_pack_decode(payload, length, decoded, DELTA_PACK_SAMPLES_MAX - 1, &count));
+}
+
+
+/**@brief A sample that does not fit leaves the payload and the encoder as they were.
+ */
+static void test_payload_full(void)
+{
+    static uint16_t      readings[DELTA_PACK_SAMPLES_MAX * DELTA_PACK_CHANNELS];
+    delta_pack_encoder_t encoder;
+    delta_pack_encoder_t saved;
+    uint8_t              payload[PAYLOAD_MAX];
+    uint8_t              before[PAYLOAD_MAX];
+    uint8_t              sample[DELTA_PACK_SAMPLE_LEN];
+    uint16_t             payload_max = 40;
+    uint16_t             length      = 0;
+    uint16_t             count       = 0;
+
+    for (uint16_t i = 0; i < sizeof(readings) / sizeof(readings[0]); i++)
+    {
+        readings[i] = (uint16_t)(rand_get() & READING_MAX);
+    }
+
+    memset(&encoder, 0, sizeof(encoder));
+    memset(payload, 0x5A, sizeof(payload));
+
+    for (;;)
+    {
+        uint16_t new_length;
+
+        sample_set(sample, &readings[count * DELTA_PACK_CHANNELS]);
+        memcpy(&saved, &encoder, sizeof(encoder));
+        memcpy(before, payload, sizeof(payload));
+
+        new_length = delta_pack_sample_put(&encoder, sample, count, payload, payload_max);
+        if (new_length == 0)
+        {
+            break;
+        }
+
+        CHECK(new_length <= payload_max);
+        length = new_length;
+        count++;
+    }
+
+    // Random readings are keyframes, as many as fit after the count byte.
+    CHECK(count == (payload_max * 8 - 8) / KEYFRAME_BITS);
+    CHECK(memcmp(&saved, &encoder, sizeof(encoder)) == 0);
+    CHECK(memcmp(before, payload, sizeof(payload)) == 0);
+    unpack_verify(payload, length, readings, count);
+
+    // An empty payload takes nothing.
+    CHECK(delta_pack_sample_put(&encoder, sample, 0, payload, 0) == 0);
+}
+
+
+/**@brief Every truncation of a payload is refused, as is a payload that does not start with a
+ *        keyframe.
+ */
+static void test_truncated(void)
+{
+    static uint16_t decoded[DELTA_PACK_SAMPLES_MAX * DELTA_PACK_CHANNELS];
+    uint16_t        readings[20 * DELTA_PACK_CHANNELS];
+    uint8_t         payload[PAYLOAD_MAX];
+    uint16_t        length;
+    uint16_t        count;
+
+    for (uint16_t i = 0; i < sizeof(readings) / sizeof(readings[0]); i++)
+    {
+        readings[i] = (uint16_t)(2000 + (i / DELTA_PACK_CHANNELS) * ((i % 3) - 1));
+    }
+
+    length = pack(readings, 20, payload);
+    unpack_verify(payload, length, readings, 20);
+
+    for (uint16_t truncated = 0; truncated < length; truncated++)
+    {
+        CHECK(!delta_pack_decode(payload, truncated, decoded, 20, &count));
+    }
+
+    // Count says more samples than the bits hold, even as repeats.
+    CHECK((length - 1) * 8 < DELTA_PACK_SAMPLES_MAX * REPEAT_BITS);
+    payload[0] = DELTA_PACK_SAMPLES_MAX;
+    CHECK(!delta_pack_decode(payload, length, decoded, DELTA_PACK_SAMPLES_MAX, &count));
+
+    // First sample narrow.
+    payload[0] = 1;
+    payload[1] = (payload[1] & ~0x03) | 0x01;
+    CHECK(!delta_pack_decode(payload, length, decoded, 20, &count));
+
+    // No samples at all is a valid payload.
+    payload[0] = 0;
+    CHECK(delta_pack_decode(payload, 1, decoded, 20, &count));
+    CHECK(count == 0);
+}
+
+
+/**@brief Random signals of every slope survive a round trip, across as many payloads as they take.
+ */
+static void test_random_round_trip(void)
+{
+    static const uint16_t slopes[] = {0, 1, 3, 20, 40, READING_MAX};
+    static uint16_t       readings[DELTA_PACK_SAMPLES_MAX * DELTA_PACK_CHANNELS];
+    delta_pack_encoder_t  encoder;
+    uint8_t               payload[PAYLOAD_MAX];
+    uint8_t               sample[DELTA_PACK_SAMPLE_LEN];
+    uint16_t              channels[DELTA_PACK_CHANNELS];
+
+    for (uint8_t s = 0; s < sizeof(slopes) / sizeof(slopes[0]); s++)
+    {
+        for (uint8_t i = 0; i < DELTA_PACK_CHANNELS; i++)
+        {
+            channels[i] = READING_MAX / 2;
+        }
+
+        for (uint16_t payloads = 0; payloads < 200; payloads++)
+        {
+            uint16_t length = 0;
+            uint16_t count  = 0;
+
+            memset(&encoder, 0, sizeof(encoder));
+
+            while (count < DELTA_PACK_SAMPLES_MAX)
+            {
+                uint16_t * p_next = &readings[count * DELTA_PACK_CHANNELS];
+                uint16_t   new_length;
+
+                for (uint8_t i = 0; i < DELTA_PACK_CHANNELS; i++)
+                {
+                    int32_t step = (int32_t)(rand_get() % (2u * slopes[s] + 1)) - slopes[s];
+
+                    p_next[i] = (uint16_t)((channels[i] + step) & READING_MAX);
+                }
+
+                sample_set(sample, p_next);
+                new_length = delta_pack_sample_put(&encoder, sample, count, payload, PAYLOAD_MAX);
+                if (new_length == 0)
+                {
+                    break;
+                }
+
+                memcpy(channels, p_next, sizeof(channels));
+                length = new_length;
+                count++;
+            }
+
+            CHECK(count > 0);
+            unpack_verify(payload, length, readings, count);
+        }
+    }
+}
+
+
+int main(void)
+{
+    RUN(test_classes);
+    RUN(test_class_by_largest_channel);
+    RUN(test_keyframe_interval);
+    RUN(test_reading_bits);
+    RUN(test_samples_max);
+    RUN(test_payload_full);
+    RUN(test_truncated);
+    RUN(test_random_round_trip);
+
+    return EXIT_SUCCESS;
+}
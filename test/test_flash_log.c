@@ -0,0 +1,614 @@
+#include <string.h>
+#include "test_check.h"
+#include "flash_log.h"
+#include "nrf_fstorage_fake.h"
+#include "nrf_error.h"
+
+
+#define REGION_START    0x6D000                             /**< Start of the region of the log, as in sample_log.h. */
+#define REGION_PAGES    8                                   /**< Pages of the region. */
+
+
+static void fs_evt_handler(nrf_fstorage_evt_t * p_evt);
+
+static nrf_fstorage_t m_fs =
+{
+    .evt_handler = fs_evt_handler,
+    .start_addr  = REGION_START,
+    .end_addr    = REGION_START + REGION_PAGES * NRF_FSTORAGE_FAKE_PAGE_SIZE,
+};
+static flash_log_t    m_log;
+static uint32_t       m_errors;         /**< FLASH_LOG_EVT_ERROR events since the log was opened. */
+static uint32_t       m_next_seq;       /**< Sequence number of the next record added. */
+static uint32_t       m_in_flight;      /**< Records sent and not acknowledged. */
+
+
+static void fs_evt_handler(nrf_fstorage_evt_t * p_evt)
+{
+    flash_log_on_fs_evt(&m_log, p_evt);
+}
+
+
+static void log_evt_handler(flash_log_evt_t const * p_evt)
+{
+    if (p_evt->type == FLASH_LOG_EVT_ERROR)
+    {
+        m_errors++;
+    }
+}
+
+
+/**@brief Opens the log, as after a reset. Flash keeps its content, the queue is lost.
+ */
+static void log_open(void)
+{
+    CHECK(nrf_fstorage_init(&m_fs, &nrf_fstorage_fake, NULL) == NRF_SUCCESS);
+    CHECK(flash_log_init(&m_log, &m_fs, log_evt_handler) == NRF_SUCCESS);
+
+    m_errors    = 0;
+    m_in_flight = 0;
+}
+
+
+/**@brief Opens the log of an erased region.
+ */
+static void log_open_new(void)
+{
+    CHECK(nrf_fstorage_init(&m_fs, &nrf_fstorage_fake, NULL) == NRF_SUCCESS);
+    nrf_fstorage_fake_erase_all();
+    log_open();
+    m_next_seq = 0;
+}
+
+
+/**@brief Length of the record with sequence number @p seq, 20 to 256 bytes. */
+static uint16_t record_len(uint32_t seq)
+{
+    return 20 + (seq * 37) % (FLASH_LOG_RECORD_MAX_LEN - 19);
+}
+
+
+/**@brief Fills a record: its sequence number, then bytes derived from it.
+ *
+ * @return  Length of the record (in bytes).
+ */
+static uint16_t record_fill(uint8_t * p_buf, uint32_t seq)
+{
+    uint16_t length = record_len(seq);
+
+    memset(p_buf, (uint8_t)seq, length);
+    memcpy(p_buf, &seq, sizeof(seq));
+
+    return length;
+}
+
+
+/**@brief Checks a record filled by @ref record_fill.
+ *
+ * @return  Sequence number of the record.
+ */
+static uint32_t record_verify(uint8_t const * p_data, uint16_t length)
+{
+    uint32_t seq;
+
+    memcpy(&seq, p_data, sizeof(seq));
+    CHECK(length == record_len(seq));
+
+    for (uint16_t i = sizeof(seq); i < length; i++)
+    {
+        CHECK(p_data[i] == (uint8_t)seq);
+    }
+
+    return seq;
+}
+
+
+/**@brief Starts adding the next record, without completing the flash operations.
+ */
+static ret_code_t append_start(void)
+{
+    uint8_t    buf[FLASH_LOG_RECORD_MAX_LEN];
+    uint16_t   length   = record_fill(buf, m_next_seq);
+    ret_code_t err_code = flash_log_append(&m_log, buf, length, m_next_seq * 10);
+
+    if (err_code == NRF_SUCCESS)
+    {
+        m_next_seq++;
+    }
+
+    return err_code;
+}
+
+
+/**@brief Adds @p count records, each of which must go in.
+ */
+static void append(uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        CHECK(append_start() == NRF_SUCCESS);
+        nrf_fstorage_fake_run(UINT32_MAX);
+        CHECK(m_log.op == FLASH_LOG_OP_IDLE);
+    }
+}
+
+
+/**@brief Sends up to @p count records, checking each and that they follow one another.
+ *
+ * @param[out] p_first  Sequence number of the first record sent, if any.
+ *
+ * @return  Number of records sent.
+ */
+static uint32_t send(uint32_t count, uint32_t * p_first)
+{
+    uint8_t  buf[FLASH_LOG_RECORD_MAX_LEN];
+    uint16_t length;
+    uint32_t sent = 0;
+    uint32_t seq  = 0;
+
+    while ((sent < count) && (flash_log_peek(&m_log, buf, sizeof(buf), &length) == NRF_SUCCESS))
+    {
+        uint8_t const * p_mapped;
+        uint16_t        mapped_len;
+        uint32_t        next = record_verify(buf, length);
+
+        CHECK(flash_log_peek_mapped(&m_log, &p_mapped, &mapped_len) == NRF_SUCCESS);
+        CHECK((mapped_len == length) && (memcmp(p_mapped, buf, length) == 0));
+
+        if (sent == 0)
+        {
+            if (p_first != NULL)
+            {
+                *p_first = next;
+            }
+        }
+        else
+        {
+            CHECK(next == seq + 1);
+        }
+
+        seq = next;
+        flash_log_release(&m_log);
+        sent++;
+    }
+
+    m_in_flight += sent;
+
+    return sent;
+}
+
+
+/**@brief Acknowledges records in flight one at a time, as TX complete events do.
+ */
+static void ack(uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        flash_log_ack(&m_log, 1);
+        m_in_flight--;
+        nrf_fstorage_fake_run(UINT32_MAX);
+    }
+}
+
+
+/**@brief Sends and acknowledges every record, checking that they run from @p first to the newest.
+ */
+static void drain_verify(uint32_t first)
+{
+    uint32_t seq   = UINT32_MAX;
+    uint32_t count = send(UINT32_MAX, &seq);
+
+    CHECK(count == m_next_seq - first);
+    CHECK((count == 0) || (seq == first));
+    CHECK(flash_log_unsent_count(&m_log) == 0);
+    CHECK(flash_log_is_drained(&m_log));
+
+    ack(m_in_flight);
+}
+
+
+/**@brief Sends and acknowledges every record, checking that they follow one another up to the
+ *        newest.
+ */
+static void drain_verify_newest(void)
+{
+    uint32_t first = m_next_seq;
+
+    if (send(1, &first) == 1)
+    {
+        flash_log_rewind(&m_log);
+        m_in_flight = 0;
+    }
+
+    drain_verify(first);
+}
+
+
+static void test_open(void)
+{
+    nrf_fstorage_t small =
+    {
+        .start_addr = REGION_START,
+        .end_addr   = REGION_START + NRF_FSTORAGE_FAKE_PAGE_SIZE,
+    };
+    flash_log_t log;
+    uint8_t     buf[FLASH_LOG_RECORD_MAX_LEN];
+    uint16_t    length;
+    uint32_t    timestamp;
+
+    CHECK(flash_log_init(&log, &small, NULL) == NRF_ERROR_NULL);
+    CHECK(nrf_fstorage_init(&small, &nrf_fstorage_fake, NULL) == NRF_SUCCESS);
+    CHECK(flash_log_init(&log, &small, NULL) == NRF_ERROR_INVALID_PARAM);
+
+    log_open_new();
+    CHECK(flash_log_unsent_count(&m_log) == 0);
+    CHECK(flash_log_is_drained(&m_log));
+    CHECK(!flash_log_last_timestamp_get(&m_log, &timestamp));
+    CHECK(flash_log_peek(&m_log, buf, sizeof(buf), &length) == NRF_ERROR_NOT_FOUND);
+
+    CHECK(flash_log_append(&m_log, buf, 0, 0) == NRF_ERROR_INVALID_LENGTH);
+    CHECK(flash_log_append(&m_log, buf, FLASH_LOG_RECORD_MAX_LEN + 1, 0) == NRF_ERROR_INVALID_LENGTH);
+
+    // A record is not sent before it is in flash.
+    CHECK(append_start() == NRF_SUCCESS);
+    CHECK(!flash_log_is_drained(&m_log));
+    CHECK(append_start() == NRF_ERROR_BUSY);
+    nrf_fstorage_fake_run(UINT32_MAX);
+    CHECK(flash_log_unsent_count(&m_log) == 1);
+    CHECK(flash_log_last_timestamp_get(&m_log, &timestamp) && (timestamp == 0));
+}
+
+
+/**@brief Records survive a reset, and the log goes on after the newest one.
+ */
+static void test_reopen(void)
+{
+    uint32_t timestamp;
+
+    log_open_new();
+    append(100);
+
+    log_open();
+    CHECK(flash_log_unsent_count(&m_log) == 100);
+    CHECK(flash_log_last_timestamp_get(&m_log, &timestamp) && (timestamp == 990));
+    drain_verify(0);
+
+    // Delivered up to the head, the mark is written at once.
+    log_open();
+    CHECK(flash_log_unsent_count(&m_log) == 0);
+
+    append(150);
+    log_open();
+    drain_verify(100);
+}
+
+
+/**@brief After a reset the log resumes after the last drain mark, and records delivered after it
+ *        are sent again.
+ */
+static void test_checkpoint(void)
+{
+    uint32_t first;
+
+    log_open_new();
+    append(60);
+
+    CHECK(send(50, NULL) == 50);
+    ack(2 * FLASH_LOG_CHECKPOINT_INTERVAL + 5);
+
+    log_open();
+    CHECK(flash_log_unsent_count(&m_log) == 60 - 2 * FLASH_LOG_CHECKPOINT_INTERVAL);
+    CHECK(send(1, &first) == 1);
+    CHECK(first == 2 * FLASH_LOG_CHECKPOINT_INTERVAL);
+
+    // Records in flight when the link is lost are sent again.
+    flash_log_rewind(&m_log);
+    m_in_flight = 0;
+    drain_verify(2 * FLASH_LOG_CHECKPOINT_INTERVAL);
+}
+
+
+/**@brief Power cut while a record is being written, at every step of it.
+ */
+static void test_power_cut_record(void)
+{
+    static const uint32_t cuts[] = {0, 2, 4, 8, 12, 16, 32, 64};
+
+    for (uint8_t i = 0; i < sizeof(cuts) / sizeof(cuts[0]); i++)
+    {
+        log_open_new();
+        append(10);
+
+        CHECK(append_start() == NRF_SUCCESS);
+        nrf_fstorage_fake_power_cut(cuts[i]);
+        m_next_seq--;
+
+        // The cut record is void, the records before it are kept.
+        log_open();
+        CHECK(flash_log_unsent_count(&m_log) == 10);
+        CHECK(flash_log_seek(&m_log, 0) == NRF_SUCCESS);
+        CHECK(flash_log_unsent_count(&m_log) == 10);
+
+        append(40);
+        log_open();
+        CHECK(flash_log_unsent_count(&m_log) == 50);
+        drain_verify(0);
+    }
+
+    // Without its length a record is void, even with all the rest written.
+    log_open_new();
+    append(10);
+    CHECK(append_start() == NRF_SUCCESS);
+    nrf_fstorage_fake_power_cut(UINT32_MAX);
+    m_next_seq--;
+    log_open();
+    CHECK(flash_log_unsent_count(&m_log) == 10);
+
+    // With its length written it is kept, even without the event. The page of the void record
+    // takes no more, this one opens the next.
+    CHECK(append_start() == NRF_SUCCESS);
+    while (m_log.op != FLASH_LOG_OP_RECORD_LENGTH)
+    {
+        CHECK(nrf_fstorage_fake_run(1) == 1);
+    }
+    nrf_fstorage_fake_power_cut(UINT32_MAX);
+    log_open();
+    CHECK(flash_log_unsent_count(&m_log) == 11);
+    append(5);
+    log_open();
+    drain_verify(0);
+}
+
+
+/**@brief Power cut while the oldest page is being erased or opened for the head.
+ */
+static void test_power_cut_page_open(void)
+{
+    static const uint32_t erase_cuts[]  = {0, 4, 8, 100, NRF_FSTORAGE_FAKE_PAGE_SIZE};
+    static const uint32_t header_cuts[] = {0, 4, 8};
+
+    for (uint8_t step = 0; step < 2; step++)
+    {
+        uint8_t count = (step == 0) ? sizeof(erase_cuts) / sizeof(erase_cuts[0])
+                                    : sizeof(header_cuts) / sizeof(header_cuts[0]);
+
+        for (uint8_t i = 0; i < count; i++)
+        {
+            uint32_t first;
+            uint32_t unsent;
+
+            log_open_new();
+
+            // Fill the region and wrap, until the next record opens a page.
+            for (;;)
+            {
+                CHECK(append_start() == NRF_SUCCESS);
+                if ((m_next_seq > 300) && (m_log.op == FLASH_LOG_OP_ERASE))
+                {
+                    break;
+                }
+                nrf_fstorage_fake_run(UINT32_MAX);
+            }
+            m_next_seq--;
+
+            unsent = flash_log_unsent_count(&m_log);
+
+            if (step == 0)
+            {
+                nrf_fstorage_fake_power_cut(erase_cuts[i]);
+            }
+            else
+            {
+                CHECK(nrf_fstorage_fake_run(1) == 1);
+                CHECK(m_log.op == FLASH_LOG_OP_PAGE_HEADER);
+                nrf_fstorage_fake_power_cut(header_cuts[i]);
+            }
+
+            // The records of the oldest page were given up when its erase started, a cut before
+            // the erase did anything keeps them.
+            log_open();
+            CHECK(send(1, &first) == 1);
+            flash_log_rewind(&m_log);
+            m_in_flight = 0;
+            CHECK((first == m_next_seq - unsent) ||
+                  ((step == 0) && (erase_cuts[i] == 0) && (first < m_next_seq - unsent)));
+
+            append(100);
+            log_open();
+            drain_verify_newest();
+        }
+    }
+}
+
+
+/**@brief Pages are reused in ring order when nothing is sent, dropping the oldest records, and
+ *        every page is erased as often as the others.
+ */
+static void test_page_reclaim(void)
+{
+    uint32_t erases_min = UINT32_MAX;
+    uint32_t erases_max = 0;
+    uint32_t unsent;
+
+    log_open_new();
+    nrf_fstorage_fake_stats_clear();
+    append(2000);
+
+    unsent = flash_log_unsent_count(&m_log);
+    CHECK(unsent + m_log.lost == 2000);
+    CHECK(unsent < (REGION_PAGES * NRF_FSTORAGE_FAKE_PAGE_SIZE) / (FLASH_LOG_RECORD_HEADER_LEN + 20));
+    CHECK(unsent > (REGION_PAGES - 1) * NRF_FSTORAGE_FAKE_PAGE_SIZE / (FLASH_LOG_RECORD_HEADER_LEN + FLASH_LOG_RECORD_MAX_LEN));
+
+    for (uint32_t page = 0; page < REGION_PAGES; page++)
+    {
+        uint32_t erases = nrf_fstorage_fake_page_erases(page);
+
+        erases_min = (erases < erases_min) ? erases : erases_min;
+        erases_max = (erases > erases_max) ? erases : erases_max;
+    }
+    CHECK(erases_min > 0);
+    CHECK(erases_max - erases_min <= 1);
+
+    // Flash holds exactly the records kept.
+    log_open();
+    CHECK(flash_log_unsent_count(&m_log) == unsent);
+    drain_verify(2000 - unsent);
+}
+
+
+/**@brief Records in flight pin their page: it is not erased, and their mapped data stays valid,
+ *        until they are acknowledged or given back.
+ */
+static void test_pinned_page(void)
+{
+    uint8_t         expected[FLASH_LOG_RECORD_MAX_LEN];
+    uint8_t const * p_mapped;
+    uint16_t        length;
+    ret_code_t      err_code;
+
+    for (uint8_t release = 0; release < 2; release++)
+    {
+        log_open_new();
+        append(20);
+
+        // The oldest record is in flight.
+        CHECK(flash_log_peek_mapped(&m_log, &p_mapped, &length) == NRF_SUCCESS);
+        CHECK(record_verify(p_mapped, length) == 0);
+        memcpy(expected, p_mapped, length);
+        CHECK(send(1, NULL) == 1);
+
+        // Fill the region until the pinned page is the next to erase.
+        while ((err_code = append_start()) == NRF_SUCCESS)
+        {
+            nrf_fstorage_fake_run(UINT32_MAX);
+        }
+
+        CHECK(err_code == NRF_ERROR_BUSY);
+        CHECK(m_log.op == FLASH_LOG_OP_IDLE);
+        CHECK(m_log.lost == 0);
+        CHECK(memcmp(p_mapped, expected, length) == 0);
+        CHECK(flash_log_unsent_count(&m_log) == m_next_seq - 1);
+
+        if (release == 0)
+        {
+            // Delivered: the page may go, with the records after the one in flight.
+            ack(1);
+            append(1);
+            CHECK(m_log.lost > 0);
+            CHECK(flash_log_unsent_count(&m_log) + m_log.lost == m_next_seq - 1);
+            drain_verify(1 + m_log.lost);
+        }
+        else
+        {
+            // Link lost: the record in flight goes back, and is lost with its page.
+            flash_log_rewind(&m_log);
+            m_in_flight = 0;
+            CHECK(flash_log_unsent_count(&m_log) == m_next_seq);
+            append(1);
+            CHECK(flash_log_unsent_count(&m_log) + m_log.lost == m_next_seq);
+            drain_verify(m_log.lost);
+        }
+    }
+}
+
+
+/**@brief A failed flash operation drops the record being added, and the log goes on.
+ */
+static void test_flash_error(void)
+{
+    log_open_new();
+    append(10);
+
+    // Record write.
+    nrf_fstorage_fake_fail_next(1);
+    CHECK(append_start() == NRF_SUCCESS);
+    nrf_fstorage_fake_run(UINT32_MAX);
+    CHECK(m_errors == 1);
+    CHECK(m_log.op == FLASH_LOG_OP_IDLE);
+    CHECK(flash_log_unsent_count(&m_log) == 10);
+    m_next_seq--;
+
+    // Page erase.
+    while (append_start() == NRF_SUCCESS)
+    {
+        if (m_log.op == FLASH_LOG_OP_ERASE)
+        {
+            break;
+        }
+        nrf_fstorage_fake_run(UINT32_MAX);
+    }
+    nrf_fstorage_fake_fail_next(1);
+    nrf_fstorage_fake_run(UINT32_MAX);
+    CHECK(m_errors == 2);
+    m_next_seq--;
+
+    append(50);
+    drain_verify(0);
+
+    log_open();
+    CHECK(flash_log_unsent_count(&m_log) == 0);
+}
+
+
+/**@brief A drain mark that finds the fstorage queue full is written once there is room again.
+ */
+static void test_mark_queue_full(void)
+{
+    static const uint32_t erased = 0xFFFFFFFF;
+
+    log_open_new();
+    append(20);
+    CHECK(send(20, NULL) == 20);
+
+    // Another fstorage user fills the queue, its writes leave flash as it is.
+    while (nrf_fstorage_write(&m_fs, m_fs.end_addr - sizeof(erased), &erased, sizeof(erased), NULL) == NRF_SUCCESS)
+    {
+    }
+
+    flash_log_ack(&m_log, FLASH_LOG_CHECKPOINT_INTERVAL);
+    CHECK(m_log.is_mark_due);
+
+    // Operations of the other user end, the next acknowledgement writes the mark.
+    nrf_fstorage_fake_run(UINT32_MAX);
+    CHECK(m_log.is_mark_due);
+    flash_log_ack(&m_log, 1);
+    CHECK(!m_log.is_mark_due);
+    nrf_fstorage_fake_run(UINT32_MAX);
+
+    log_open();
+    CHECK(flash_log_unsent_count(&m_log) == 20 - FLASH_LOG_CHECKPOINT_INTERVAL - 1);
+    CHECK(send(20, NULL) == 20 - FLASH_LOG_CHECKPOINT_INTERVAL - 1);
+
+    // The last acknowledgement finds the queue full, no other acknowledgement follows.
+    while (nrf_fstorage_write(&m_fs, m_fs.end_addr - sizeof(erased), &erased, sizeof(erased), NULL) == NRF_SUCCESS)
+    {
+    }
+
+    flash_log_ack(&m_log, 20);
+    CHECK(m_log.is_mark_due);
+    nrf_fstorage_fake_run(UINT32_MAX);
+
+    flash_log_retry(&m_log);
+    CHECK(!m_log.is_mark_due);
+    nrf_fstorage_fake_run(UINT32_MAX);
+    CHECK(m_errors == 0);
+
+    log_open();
+    CHECK(flash_log_unsent_count(&m_log) == 0);
+}
+
+
+int main(void)
+{
+    RUN(test_open);
+    RUN(test_reopen);
+    RUN(test_checkpoint);
+    RUN(test_power_cut_record);
+    RUN(test_power_cut_page_open);
+    RUN(test_page_reclaim);
+    RUN(test_pinned_page);
+    RUN(test_flash_error);
+    RUN(test_mark_queue_full);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,248 @@
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "test_check.h"
+#include "frame_ring.h"
+#include "nrf_error.h"
+
+
+#define SLOT_SIZE       64                                  /**< Slot size of the rings under test (in bytes). */
+#define SLOT_COUNT      8                                   /**< Slots of the rings under test. */
+#define FRAME_MAX_LEN   (SLOT_SIZE - FRAME_RING_LENGTH_LEN) /**< Longest frame of a slot (in bytes). */
+#define STRESS_FRAMES   200000                              /**< Frames passed between the two threads. */
+
+FRAME_RING_DEF(m_ring, SLOT_SIZE, SLOT_COUNT);
+
+
+/**@brief Length of the frame with sequence number @p seq, 4 to @ref FRAME_MAX_LEN bytes. */
+static uint16_t frame_len(uint32_t seq)
+{
+    return 4 + (seq % (FRAME_MAX_LEN - 3));
+}
+
+
+/**@brief Fills a frame: its sequence number, then bytes derived from it. */
+static void frame_fill(uint8_t * p_data, uint32_t seq)
+{
+    memcpy(p_data, &seq, sizeof(seq));
+    for (uint16_t i = sizeof(seq); i < frame_len(seq); i++)
+    {
+        p_data[i] = (uint8_t)(seq + i);
+    }
+}
+
+
+/**@brief Checks a frame filled by @ref frame_fill.
+ */
+static void frame_verify(uint8_t const * p_data, uint16_t length, uint32_t seq)
+{
+    uint32_t frame_seq;
+
+    memcpy(&frame_seq, p_data, sizeof(frame_seq));
+    CHECK(frame_seq == seq);
+    CHECK(length == frame_len(seq));
+
+    for (uint16_t i = sizeof(seq); i < length; i++)
+    {
+        CHECK(p_data[i] == (uint8_t)(seq + i));
+    }
+}
+
+
+static void test_empty_and_full(void)
+{
+    uint8_t       * p_data;
+    uint8_t const * p_frame;
+    uint16_t        max_len;
+    uint16_t        length;
+
+    frame_ring_init(&m_ring);
+    CHECK(frame_ring_count(&m_ring) == 0);
+    CHECK(frame_ring_peek(&m_ring, &p_frame, &length) == NRF_ERROR_NOT_FOUND);
+
+    for (uint32_t i = 0; i < SLOT_COUNT; i++)
+    {
+        CHECK(frame_ring_reserve(&m_ring, &p_data, &max_len) == NRF_SUCCESS);
+        CHECK(max_len == FRAME_MAX_LEN);
+        frame_fill(p_data, i);
+        CHECK(frame_ring_commit(&m_ring, frame_len(i)) == NRF_SUCCESS);
+        CHECK(frame_ring_count(&m_ring) == i + 1);
+    }
+
+    CHECK(frame_ring_reserve(&m_ring, &p_data, &max_len) == NRF_ERROR_NO_MEM);
+
+    // A failed reserve leaves nothing reserved.
+    CHECK(frame_ring_commit(&m_ring, 1) == NRF_ERROR_INVALID_STATE);
+
+    for (uint32_t i = 0; i < SLOT_COUNT; i++)
+    {
+        CHECK(frame_ring_peek(&m_ring, &p_frame, &length) == NRF_SUCCESS);
+        frame_verify(p_frame, length, i);
+        CHECK(frame_ring_release(&m_ring) == NRF_SUCCESS);
+    }
+
+    CHECK(frame_ring_count(&m_ring) == 0);
+    CHECK(frame_ring_peek(&m_ring, &p_frame, &length) == NRF_ERROR_NOT_FOUND);
+}
+
+
+static void test_misuse(void)
+{
+    uint8_t       * p_data;
+    uint8_t       * p_other;
+    uint8_t const * p_frame;
+    uint16_t        max_len;
+    uint16_t        length;
+
+    frame_ring_init(&m_ring);
+
+    CHECK(frame_ring_commit(&m_ring, 1) == NRF_ERROR_INVALID_STATE);
+
+    CHECK(frame_ring_reserve(&m_ring, &p_data, &max_len) == NRF_SUCCESS);
+    CHECK(frame_ring_reserve(&m_ring, &p_other, &max_len) == NRF_ERROR_BUSY);
+    CHECK(frame_ring_commit(&m_ring, FRAME_MAX_LEN + 1) == NRF_ERROR_INVALID_LENGTH);
+
+    // Giving the slot back unused commits nothing.
+    CHECK(frame_ring_commit(&m_ring, 0) == NRF_SUCCESS);
+    CHECK(frame_ring_count(&m_ring) == 0);
+    CHECK(frame_ring_peek(&m_ring, &p_frame, &length) == NRF_ERROR_NOT_FOUND);
+
+    CHECK(frame_ring_reserve(&m_ring, &p_data, &max_len) == NRF_SUCCESS);
+    frame_fill(p_data, 7);
+    CHECK(frame_ring_commit(&m_ring, frame_len(7)) == NRF_SUCCESS);
+
+    // A cancelled peek leaves the frame for the next one.
+    CHECK(frame_ring_peek(&m_ring, &p_frame, &length) == NRF_SUCCESS);
+    CHECK(frame_ring_peek(&m_ring, &p_frame, &length) == NRF_ERROR_BUSY);
+    CHECK(frame_ring_peek_cancel(&m_ring) == NRF_SUCCESS);
+    CHECK(frame_ring_count(&m_ring) == 1);
+    CHECK(frame_ring_peek(&m_ring, &p_frame, &length) == NRF_SUCCESS);
+    frame_verify(p_frame, length, 7);
+    CHECK(frame_ring_release(&m_ring) == NRF_SUCCESS);
+    CHECK(frame_ring_count(&m_ring) == 0);
+}
+
+
+/**@brief Fills the ring and takes a few frames out, over and over, so the indexes cross the end
+ *        of the buffer at every possible slot.
+ */
+static void test_wraparound(void)
+{
+    uint8_t       * p_data;
+    uint8_t const * p_frame;
+    uint16_t        max_len;
+    uint16_t        length;
+    uint32_t        write_seq = 0;
+    uint32_t        read_seq  = 0;
+
+    frame_ring_init(&m_ring);
+
+    for (uint32_t round = 0; round < 1000; round++)
+    {
+        uint32_t take = 1 + (round % SLOT_COUNT);
+
+        while (frame_ring_reserve(&m_ring, &p_data, &max_len) == NRF_SUCCESS)
+        {
+            // The slot is contiguous, up to its end.
+            CHECK(max_len == FRAME_MAX_LEN);
+            CHECK(p_data >= CONCAT_2(m_ring_ringbuf, _buf) + FRAME_RING_LENGTH_LEN);
+            CHECK(p_data + max_len <= CONCAT_2(m_ring_ringbuf, _buf) + SLOT_SIZE * SLOT_COUNT);
+
+            frame_fill(p_data, write_seq);
+            CHECK(frame_ring_commit(&m_ring, frame_len(write_seq)) == NRF_SUCCESS);
+            write_seq++;
+        }
+
+        CHECK(frame_ring_count(&m_ring) == SLOT_COUNT);
+
+        for (uint32_t i = 0; i < take; i++)
+        {
+            CHECK(frame_ring_peek(&m_ring, &p_frame, &length) == NRF_SUCCESS);
+            frame_verify(p_frame, length, read_seq);
+            CHECK(frame_ring_release(&m_ring) == NRF_SUCCESS);
+            read_seq++;
+        }
+
+        CHECK(frame_ring_count(&m_ring) == SLOT_COUNT - take);
+    }
+
+    while (frame_ring_peek(&m_ring, &p_frame, &length) == NRF_SUCCESS)
+    {
+        frame_verify(p_frame, length, read_seq);
+        CHECK(frame_ring_release(&m_ring) == NRF_SUCCESS);
+        read_seq++;
+    }
+
+    CHECK(read_seq == write_seq);
+    CHECK(frame_ring_count(&m_ring) == 0);
+}
+
+
+/**@brief Producer thread of @ref test_concurrent, stands in for the stream timer.
+ */
+static void * producer(void * p_context)
+{
+    uint8_t * p_data;
+    uint16_t  max_len;
+    uint32_t  seq = 0;
+
+    (void)p_context;
+
+    while (seq < STRESS_FRAMES)
+    {
+        if (frame_ring_reserve(&m_ring, &p_data, &max_len) != NRF_SUCCESS)
+        {
+            sched_yield();
+            continue;
+        }
+
+        frame_fill(p_data, seq);
+        CHECK(frame_ring_commit(&m_ring, frame_len(seq)) == NRF_SUCCESS);
+        seq++;
+    }
+
+    return NULL;
+}
+
+
+/**@brief One producer and one consumer thread share the ring without locks, as the stream timer
+ *        and the TX complete event do on the target. Every frame arrives once, whole, in order.
+ */
+static void test_concurrent(void)
+{
+    pthread_t       thread;
+    uint8_t const * p_frame;
+    uint16_t        length;
+    uint32_t        seq = 0;
+
+    frame_ring_init(&m_ring);
+    CHECK(pthread_create(&thread, NULL, producer, NULL) == 0);
+
+    while (seq < STRESS_FRAMES)
+    {
+        if (frame_ring_peek(&m_ring, &p_frame, &length) != NRF_SUCCESS)
+        {
+            sched_yield();
+            continue;
+        }
+
+        CHECK(frame_ring_count(&m_ring) >= 1);
+        frame_verify(p_frame, length, seq);
+        CHECK(frame_ring_release(&m_ring) == NRF_SUCCESS);
+        seq++;
+    }
+
+    CHECK(pthread_join(thread, NULL) == 0);
+    CHECK(frame_ring_count(&m_ring) == 0);
+}
+
+
+int main(void)
+{
+    RUN(test_empty_and_full);
+    RUN(test_misuse);
+    RUN(test_wraparound);
+    RUN(test_concurrent);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+#include "test_check.h"
+#include "link_sim.h"
+
+
+#define DATA_LEN    (64 * 1024)     /**< Test pattern sent on every link (in bytes). */
+
+
+static link_sim_report_t link_run(link_model_phy_t phy, uint32_t conn_interval_us, uint16_t data_length,
+                                  uint16_t att_mtu, uint8_t queue_size)
+{
+    link_sim_params_t params;
+    link_sim_report_t report;
+
+    params.link.phy              = phy;
+    params.link.conn_interval_us = conn_interval_us;
+    params.link.event_length_us  = conn_interval_us;
+    params.link.data_length      = data_length;
+    params.link.att_mtu          = att_mtu;
+    params.link.hvn_queue_size   = queue_size;
+    params.data_len              = DATA_LEN;
+
+    CHECK(link_sim_run(&params, &report));
+    CHECK(report.is_complete);
+
+    return report;
+}
+
+
+/**@brief Every packet the engine queued goes over the air, then the end frame. */
+static void test_all_delivered(void)
+{
+    link_sim_report_t report = link_run(LINK_MODEL_PHY_2M, 7500, 251, 247, 4);
+
+    CHECK(report.packets_sent > 0);
+    CHECK(report.packets == report.packets_sent + 1);
+    CHECK(report.hvx_calls == report.packets + report.spins);
+}
+
+
+/**@brief The engine keeps the queue full, so the firmware reaches the steady state of the model. */
+static void test_matches_estimate(void)
+{
+    static const uint8_t queue_sizes[] = {1, 2, 4, 8};
+
+    for (link_model_phy_t phy = LINK_MODEL_PHY_1M; phy <= LINK_MODEL_PHY_2M; phy++)
+    {
+        for (uint8_t i = 0; i < sizeof(queue_sizes); i++)
+        {
+            link_sim_report_t report = link_run(phy, 15000, 251, 247, queue_sizes[i]);
+
+            CHECK(report.kbps * 100 >= report.estimate_kbps * 97);
+            CHECK(report.kbps <= report.estimate_kbps);
+        }
+    }
+}
+
+
+static void test_phy_and_queue(void)
+{
+    link_sim_report_t q1_1m = link_run(LINK_MODEL_PHY_1M, 7500, 251, 247, 1);
+    link_sim_report_t q8_1m = link_run(LINK_MODEL_PHY_1M, 7500, 251, 247, 8);
+    link_sim_report_t q8_2m = link_run(LINK_MODEL_PHY_2M, 7500, 251, 247, 8);
+    link_sim_report_t short_1m = link_run(LINK_MODEL_PHY_1M, 7500, 27, 23, 8);
+
+    CHECK(q8_1m.kbps > q1_1m.kbps);
+    CHECK(q8_2m.kbps > q8_1m.kbps);
+    CHECK(q8_2m.packets_per_event_x100 > q8_1m.packets_per_event_x100);
+    CHECK(short_1m.kbps < q8_1m.kbps);
+}
+
+
+/**@brief The engine never busy-waits: at most one refused call per wakeup, and one when it starts. */
+static void test_spins_bounded(void)
+{
+    link_sim_report_t report = link_run(LINK_MODEL_PHY_1M, 50000, 251, 247, 2);
+
+    CHECK(report.spins <= report.wakeups + 1);
+    CHECK(report.wakeups <= report.conn_events);
+}
+
+
+int main(void)
+{
+    RUN(test_all_delivered);
+    RUN(test_matches_estimate);
+    RUN(test_phy_and_queue);
+    RUN(test_spins_bounded);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,206 @@
+#include <string.h>
+#include "test_check.h"
+#include "lzss.h"
+#include "lzss_unpack.h"
+
+
+#define STREAM_LEN      200000      /**< Bytes of every stream of the round trip tests. */
+#define CHANNELS        4           /**< Channels of the sensor-like stream. */
+
+
+static lzss_encoder_t m_encoder;
+static lzss_decoder_t m_c_decoder;
+
+
+/**@brief Fills @p p_buf with 12-bit readings of @ref CHANNELS channels drifting slowly, as the
+ *        stand-in sensor of the firmware produces.
+ */
+static void sensor_fill(uint8_t * p_buf, size_t length)
+{
+    static uint16_t channels[CHANNELS] = {2048, 1000, 3000, 500};
+
+    for (size_t i = 0; i + 1 < length; i += 2)
+    {
+        uint16_t * p_channel = &channels[(i / 2) % CHANNELS];
+
+        *p_channel = (uint16_t)((*p_channel + (rand() % 5) - 2) & 0x0FFF);
+        p_buf[i]     = (uint8_t)*p_channel;
+        p_buf[i + 1] = (uint8_t)(*p_channel >> 8);
+    }
+}
+
+
+/**@brief Encodes a stream block by block with the firmware encoder, and checks that the C++ and
+ *        the firmware decoders give it back.
+ *
+ * @return  Encoded length of the stream (in bytes).
+ */
+static size_t round_trip(bool sensor_like)
+{
+    static uint8_t       in[STREAM_LEN];
+    uint8_t              packed[LZSS_BLOCK_MAX];
+    uint8_t              c_out[LZSS_BLOCK_MAX];
+    uint16_t             c_out_len;
+    std::vector<uint8_t> out;
+    LzssDecoder          decoder;
+    size_t               packed_total = 0;
+
+    for (size_t i = 0; i < sizeof(in); i++)
+    {
+        in[i] = (uint8_t)rand();
+    }
+    if (sensor_like)
+    {
+        sensor_fill(in, sizeof(in));
+    }
+
+    lzss_encoder_init(&m_encoder);
+    lzss_decoder_init(&m_c_decoder);
+
+    for (size_t pos = 0; pos < sizeof(in);)
+    {
+        uint16_t block_len = (uint16_t)(1 + rand() % LZSS_BLOCK_MAX);
+        uint16_t packed_len;
+
+        block_len  = (pos + block_len > sizeof(in)) ? (uint16_t)(sizeof(in) - pos) : block_len;
+        packed_len = lzss_encode(&m_encoder, &in[pos], block_len, packed, block_len - 1);
+
+        if (packed_len == 0)
+        {
+            // Sent as it is, still history.
+            decoder.raw(&in[pos], block_len);
+            lzss_decoder_raw(&m_c_decoder, &in[pos], block_len);
+            packed_total += block_len;
+        }
+        else
+        {
+            CHECK(decoder.decode(packed, packed_len, &out));
+            CHECK((out.size() == block_len) && (memcmp(out.data(), &in[pos], block_len) == 0));
+
+            CHECK(lzss_decode(&m_c_decoder, packed, packed_len, c_out, sizeof(c_out), &c_out_len));
+            CHECK((c_out_len == block_len) && (memcmp(c_out, &in[pos], block_len) == 0));
+            packed_total += packed_len;
+        }
+
+        pos += block_len;
+    }
+
+    return packed_total;
+}
+
+
+static void test_round_trip(void)
+{
+    srand(18);
+
+    // Random data does not shrink, every block goes as it is.
+    CHECK(round_trip(false) == STREAM_LEN);
+    CHECK(round_trip(true) < STREAM_LEN);
+}
+
+
+/**@brief Frames built as the sensor stream does, some compressed and some not, unpack to their
+ *        payloads.
+ */
+static void test_frames(void)
+{
+    uint8_t               frame[SENSOR_FRAME_HEADER_MAX_LEN + 244];
+    uint8_t               slot[sizeof(frame)];
+    sensor_frame_header_t header;
+    std::vector<uint8_t>  payload;
+    LzssDecoder           decoder;
+    uint32_t              compressed = 0;
+
+    srand(18);
+    lzss_encoder_init(&m_encoder);
+
+    for (uint32_t seq = 0; seq < 2000; seq++)
+    {
+        uint16_t payload_len = (uint16_t)(10 + rand() % 235);
+        uint8_t  header_len;
+        uint16_t packed_len;
+        uint16_t slot_len;
+
+        memset(&header, 0, sizeof(header));
+        header.flags       = (seq % 3) ? SENSOR_FRAME_FLAG_TIMESTAMP : 0;
+        header.payload_len = payload_len;
+        header.seq         = seq;
+        header.timestamp   = seq * 10;
+
+        header_len = sensor_frame_header_encode(&header, frame, sizeof(frame));
+        CHECK(header_len != 0);
+
+        // Every eighth frame is noise, which does not shrink.
+        if (seq % 8)
+        {
+            sensor_fill(&frame[header_len], payload_len);
+        }
+        else
+        {
+            for (uint16_t i = 0; i < payload_len; i++)
+            {
+                frame[header_len + i] = (uint8_t)rand();
+            }
+        }
+
+        // As frame_compress of the sensor stream.
+        packed_len = lzss_encode(&m_encoder, &frame[header_len], payload_len, &slot[header_len], payload_len - 1);
+        if (packed_len == 0)
+        {
+            memcpy(slot, frame, header_len + payload_len);
+            slot_len = header_len + payload_len;
+        }
+        else
+        {
+            header.flags      |= SENSOR_FRAME_FLAG_COMPRESSED;
+            header.payload_len = packed_len;
+            CHECK(sensor_frame_header_encode(&header, slot, header_len + packed_len) == header_len);
+            slot_len = header_len + packed_len;
+            compressed++;
+        }
+
+        CHECK(lzss_frame_unpack(&decoder, slot, slot_len, &header, &payload));
+        CHECK(header.seq == seq);
+        CHECK((payload.size() == payload_len) && (memcmp(payload.data(), &frame[header_len], payload_len) == 0));
+    }
+
+    CHECK((compressed > 1000) && (compressed < 2000));
+
+    // A frame cut short.
+    CHECK(!lzss_frame_unpack(&decoder, slot, 5, &header, &payload));
+}
+
+
+static void test_malformed(void)
+{
+    static const uint8_t zero_offset[] = {0x01, 0x00, 0x00};
+    static const uint8_t cut_match[]   = {0x01, 0x05};
+    uint8_t              too_long[2 * 17];
+    std::vector<uint8_t> out;
+    LzssDecoder          decoder;
+
+    CHECK(!decoder.decode(zero_offset, sizeof(zero_offset), &out));
+    CHECK(!decoder.decode(cut_match, sizeof(cut_match), &out));
+
+    // Two groups of eight matches of 66 bytes, 1 back, run past a block.
+    for (size_t i = 0; i < sizeof(too_long); i++)
+    {
+        too_long[i] = ((i % 17) == 0) ? 0xFF : (((i % 17) % 2) ? 0x01 : 0xFC);
+    }
+    CHECK(!decoder.decode(too_long, sizeof(too_long), &out));
+
+    // An empty block is nothing.
+    decoder.reset();
+    CHECK(decoder.decode(NULL, 0, &out));
+    CHECK(out.empty());
+}
+
+
+int main(void)
+{
+    RUN(test_round_trip);
+    RUN(test_frames);
+    RUN(test_malformed);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+#include "test_check.h"
+#include "sample_coalescer_sim.h"
+
+
+#define CONN_INTERVAL_US    15000       /**< Connection interval of the simulated link (in us). */
+#define SAMPLE_INTERVAL_US  1000        /**< Time between two samples (in us). */
+#define SAMPLE_SIZE         6           /**< Length of every sample (in bytes). */
+#define DURATION_US         2000000     /**< Time samples are produced for (in us). */
+#define SAMPLES             (DURATION_US / SAMPLE_INTERVAL_US)
+
+static sample_coalescer_sim_t m_sim;
+
+
+static void simulate(uint32_t deadline_us, sample_coalescer_sim_report_t * p_report)
+{
+    sample_coalescer_sim_params_t params =
+    {
+        .link =
+        {
+            .conn_interval_us = CONN_INTERVAL_US,
+            .event_length_us  = 7500,
+            .phy              = LINK_MODEL_PHY_2M,
+            .data_length      = 251,
+            .att_mtu          = 247,
+            .hvn_queue_size   = 8,
+        },
+        .sample_interval_us = SAMPLE_INTERVAL_US,
+        .sample_size        = SAMPLE_SIZE,
+        .deadline_us        = deadline_us,
+        .duration_us        = DURATION_US,
+    };
+
+    CHECK(sample_coalescer_simulate(&m_sim, &params, p_report));
+}
+
+
+/**@brief A sample per frame overruns the link, a few ms of deadline lets it keep up. */
+static void test_no_deadline(void)
+{
+    sample_coalescer_sim_report_t report;
+
+    simulate(0, &report);
+    CHECK(report.samples_per_frame_x100 == 100);
+    CHECK(report.dropped_frames > 0);
+    CHECK(report.samples + report.dropped_frames == SAMPLES);
+}
+
+
+/**@brief A longer deadline packs more samples in a frame, for better efficiency and more latency. */
+static void test_deadlines(void)
+{
+    static const uint32_t deadlines_us[] = {5000, 20000, 100000};
+    sample_coalescer_sim_report_t report;
+    sample_coalescer_sim_report_t last = {0};
+
+    for (uint8_t i = 0; i < sizeof(deadlines_us) / sizeof(deadlines_us[0]); i++)
+    {
+        uint32_t deadline_us = deadlines_us[i];
+
+        simulate(deadline_us, &report);
+        printf("deadline %6u us: %4u frames, %5u samples per frame x100, latency avg %6u us max %6u us, %3u%% efficient\n",
+               deadline_us, report.frames, report.samples_per_frame_x100,
+               report.avg_latency_us, report.max_latency_us, report.efficiency_pct);
+
+        CHECK(report.samples == SAMPLES);
+        CHECK(report.dropped_frames == 0);
+        CHECK(report.full_frames + report.deadline_frames == report.frames);
+
+        // A sample waits no longer than the deadline, then for the next connection event.
+        CHECK(report.avg_wait_us <= deadline_us);
+        CHECK(report.max_latency_us <= deadline_us + CONN_INTERVAL_US);
+
+        if (i > 0)
+        {
+            CHECK(report.frames < last.frames);
+            CHECK(report.samples_per_frame_x100 > last.samples_per_frame_x100);
+            CHECK(report.efficiency_pct > last.efficiency_pct);
+            CHECK(report.avg_latency_us > last.avg_latency_us);
+        }
+
+        last = report;
+    }
+
+    // Frames fill up before a long deadline expires.
+    CHECK(last.full_frames > last.deadline_frames);
+    CHECK(last.samples_per_frame_x100 <= 100 * ((SAMPLE_COALESCER_MAX_FRAME_LEN - SENSOR_FRAME_HEADER_MAX_LEN) / SAMPLE_SIZE));
+}
+
+
+static void test_invalid_params(void)
+{
+    sample_coalescer_sim_params_t params = {{0}};
+    sample_coalescer_sim_report_t report;
+
+    params.link.conn_interval_us = CONN_INTERVAL_US;
+    params.link.att_mtu          = 247;
+    params.sample_size           = SAMPLE_SIZE;
+    CHECK(!sample_coalescer_simulate(&m_sim, &params, &report));
+
+    params.sample_interval_us = SAMPLE_INTERVAL_US;
+    params.link.att_mtu       = LINK_MODEL_ATT_HVX_HEADER_LEN;
+    CHECK(!sample_coalescer_simulate(&m_sim, &params, &report));
+}
+
+
+int main(void)
+{
+    RUN(test_no_deadline);
+    RUN(test_deadlines);
+    RUN(test_invalid_params);
+
+    return EXIT_SUCCESS;
+}
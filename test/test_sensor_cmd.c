@@ -0,0 +1,189 @@
+#include <string.h>
+#include "test_check.h"
+#include "sensor_cmd.h"
+
+
+/**@brief Checks which lengths of a command, cut short from @p p_full, are accepted.
+ *
+ * @param[in] p_full     Command with every parameter, @ref SENSOR_CMD_MAX_LEN bytes.
+ * @param[in] accepted   Bit n set if a command of n bytes is accepted.
+ */
+static void lengths_check(uint8_t const * p_full, uint32_t accepted)
+{
+    sensor_cmd_t cmd;
+
+    for (uint16_t length = 1; length <= SENSOR_CMD_MAX_LEN + 1; length++)
+    {
+        bool is_accepted = sensor_cmd_decode(p_full, length, &cmd);
+
+        CHECK(is_accepted == ((accepted & (1u << length)) != 0));
+        CHECK(cmd.opcode == p_full[0]);
+    }
+}
+
+
+static void test_start(void)
+{
+    static const uint8_t full[SENSOR_CMD_MAX_LEN + 1] = {SENSOR_CMD_START_TRANSFER, 0x78, 0x56, 0x34, 0x12, 0xCD, 0xAB};
+    sensor_cmd_t         cmd;
+
+    lengths_check(full, (1u << 1) | (1u << 5) | (1u << 7));
+
+    // A lone opcode is the default transfer.
+    CHECK(sensor_cmd_decode(full, 1, &cmd));
+    CHECK(!cmd.has_length);
+    CHECK(cmd.length == 0);
+    CHECK(cmd.rate_kbps == 0);
+
+    CHECK(sensor_cmd_decode(full, 5, &cmd));
+    CHECK(cmd.has_length);
+    CHECK(cmd.length == 0x12345678);
+    CHECK(cmd.rate_kbps == 0);
+
+    CHECK(sensor_cmd_decode(full, 7, &cmd));
+    CHECK(cmd.has_length);
+    CHECK(cmd.length == 0x12345678);
+    CHECK(cmd.rate_kbps == 0xABCD);
+}
+
+
+static void test_no_parameters(void)
+{
+    static const uint8_t opcodes[] =
+    {
+        SENSOR_CMD_START_QUEUE_SWEEP,
+        SENSOR_CMD_STOP_TRANSFER,
+        SENSOR_CMD_ABORT_TRANSFER,
+    };
+
+    for (uint8_t i = 0; i < sizeof(opcodes); i++)
+    {
+        uint8_t full[SENSOR_CMD_MAX_LEN + 1] = {opcodes[i], 1, 2, 3};
+
+        lengths_check(full, 1u << 1);
+    }
+}
+
+
+static void test_one_byte_parameter(void)
+{
+    static const uint8_t opcodes[] =
+    {
+        SENSOR_CMD_CONN_PROFILE_SET,
+        SENSOR_CMD_CONN_EVT_EXT_SET,
+        SENSOR_CMD_RELIABLE_SET,
+    };
+    sensor_cmd_t cmd;
+
+    for (uint8_t i = 0; i < sizeof(opcodes); i++)
+    {
+        uint8_t full[SENSOR_CMD_MAX_LEN + 1] = {opcodes[i], 0xA5, 2, 3};
+
+        lengths_check(full, 1u << 2);
+
+        CHECK(sensor_cmd_decode(full, 2, &cmd));
+        CHECK(cmd.value == 0xA5);
+    }
+}
+
+
+static void test_bench(void)
+{
+    static const uint8_t full[SENSOR_CMD_MAX_LEN + 1] = {SENSOR_CMD_BENCH_START, SENSOR_CMD_BENCH_MODE_SIMULATED, 0x00, 0x40, 0x02, 0x01};
+    sensor_cmd_t         cmd;
+
+    lengths_check(full, (1u << 1) | (1u << 2) | (1u << 6));
+
+    CHECK(sensor_cmd_decode(full, 1, &cmd));
+    CHECK(cmd.value == SENSOR_CMD_BENCH_MODE_AIR);
+    CHECK(!cmd.has_length);
+
+    CHECK(sensor_cmd_decode(full, 2, &cmd));
+    CHECK(cmd.value == SENSOR_CMD_BENCH_MODE_SIMULATED);
+    CHECK(!cmd.has_length);
+
+    CHECK(sensor_cmd_decode(full, 6, &cmd));
+    CHECK(cmd.value == SENSOR_CMD_BENCH_MODE_SIMULATED);
+    CHECK(cmd.has_length);
+    CHECK(cmd.length == 0x01024000);
+}
+
+
+static void test_ack(void)
+{
+    static const uint8_t full[SENSOR_CMD_MAX_LEN + 1] = {SENSOR_CMD_ACK, 0x04, 0x03, 0x02, 0x01, 0x88, 0x77, 0x66, 0x55};
+    sensor_cmd_t         cmd;
+
+    // The sequence number is required, the bitmap is not.
+    lengths_check(full, (1u << 5) | (1u << 9));
+
+    CHECK(sensor_cmd_decode(full, 5, &cmd));
+    CHECK(cmd.seq == 0x01020304);
+    CHECK(cmd.bitmap == 0);
+
+    CHECK(sensor_cmd_decode(full, 9, &cmd));
+    CHECK(cmd.seq == 0x01020304);
+    CHECK(cmd.bitmap == 0x55667788);
+}
+
+
+static void test_stream(void)
+{
+    static const uint8_t full[SENSOR_CMD_MAX_LEN + 1] = {SENSOR_CMD_STREAM_SET, SENSOR_CMD_STREAM_DELTA, 0x34, 0x12};
+    sensor_cmd_t         cmd;
+
+    // The mode is required, the deadline is not.
+    lengths_check(full, (1u << 2) | (1u << 4));
+
+    CHECK(sensor_cmd_decode(full, 2, &cmd));
+    CHECK(cmd.value == SENSOR_CMD_STREAM_DELTA);
+    CHECK(cmd.deadline_ms == 0);
+
+    CHECK(sensor_cmd_decode(full, 4, &cmd));
+    CHECK(cmd.value == SENSOR_CMD_STREAM_DELTA);
+    CHECK(cmd.deadline_ms == 0x1234);
+}
+
+
+static void test_log_replay(void)
+{
+    static const uint8_t full[SENSOR_CMD_MAX_LEN + 1] = {SENSOR_CMD_LOG_REPLAY, 0x10, 0x0E, 0x00, 0x80};
+    sensor_cmd_t         cmd;
+
+    lengths_check(full, 1u << 5);
+
+    CHECK(sensor_cmd_decode(full, 5, &cmd));
+    CHECK(cmd.age_s == 0x80000E10);
+}
+
+
+static void test_unknown(void)
+{
+    static const uint8_t opcodes[] = {0x00, SENSOR_CMD_LOG_REPLAY + 1, 0x7F, 0xFF};
+    uint8_t              data[SENSOR_CMD_MAX_LEN] = {0};
+    sensor_cmd_t         cmd;
+
+    for (uint8_t i = 0; i < sizeof(opcodes); i++)
+    {
+        data[0] = opcodes[i];
+        lengths_check(data, 0);
+    }
+
+    CHECK(!sensor_cmd_decode(NULL, 1, &cmd));
+    CHECK(!sensor_cmd_decode(data, 0, &cmd));
+}
+
+
+int main(void)
+{
+    RUN(test_start);
+    RUN(test_no_parameters);
+    RUN(test_one_byte_parameter);
+    RUN(test_bench);
+    RUN(test_ack);
+    RUN(test_stream);
+    RUN(test_log_replay);
+    RUN(test_unknown);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,220 @@
+#include <string.h>
+#include "test_check.h"
+#include "sensor_frame.h"
+#include "crc16.h"
+
+
+#define DATA_LEN    20      /**< Data bytes of the frames built by the tests. */
+
+
+/**@brief Builds a frame of @ref DATA_LEN data bytes, plus a CRC16 trailer if flagged.
+ *
+ * @return  Length of the frame (in bytes).
+ */
+static uint16_t frame_build(uint8_t flags, uint32_t seq, uint8_t * p_buf)
+{
+    sensor_frame_header_t header;
+    uint16_t              trailer_len = (flags & SENSOR_FRAME_FLAG_CRC) ? SENSOR_FRAME_CRC_LEN : 0;
+    uint8_t               header_len;
+
+    memset(&header, 0, sizeof(header));
+    header.flags       = flags;
+    header.payload_len = DATA_LEN + trailer_len;
+    header.seq         = seq;
+    header.timestamp   = 0xA1B2C3D4;
+
+    header_len = sensor_frame_header_encode(&header, p_buf, SENSOR_FRAME_HEADER_MAX_LEN + DATA_LEN + SENSOR_FRAME_CRC_LEN);
+    CHECK(header_len == sensor_frame_header_len(flags));
+
+    for (uint16_t i = 0; i < DATA_LEN; i++)
+    {
+        p_buf[header_len + i] = (uint8_t)(i * 7);
+    }
+
+    if (flags & SENSOR_FRAME_FLAG_CRC)
+    {
+        sensor_frame_crc_patch(p_buf, crc16_compute(&p_buf[header_len], DATA_LEN, NULL));
+    }
+
+    return header_len + DATA_LEN + trailer_len;
+}
+
+
+static void test_header_len(void)
+{
+    CHECK(sensor_frame_header_len(0) == SENSOR_FRAME_HEADER_LEN);
+    CHECK(sensor_frame_header_len(SENSOR_FRAME_FLAG_CRC) == SENSOR_FRAME_HEADER_LEN);
+    CHECK(sensor_frame_header_len(SENSOR_FRAME_FLAG_TIMESTAMP) == SENSOR_FRAME_HEADER_MAX_LEN);
+    CHECK(sensor_frame_header_len(0xFF) == SENSOR_FRAME_HEADER_MAX_LEN);
+}
+
+
+static void test_round_trip(void)
+{
+    static const uint8_t flags[] =
+    {
+        0,
+        SENSOR_FRAME_FLAG_TIMESTAMP,
+        SENSOR_FRAME_FLAG_END | SENSOR_FRAME_FLAG_RETX,
+        SENSOR_FRAME_FLAG_TIMESTAMP | SENSOR_FRAME_FLAG_COMPRESSED | SENSOR_FRAME_FLAG_CRC,
+    };
+    uint8_t               buf[SENSOR_FRAME_HEADER_MAX_LEN + DATA_LEN + SENSOR_FRAME_CRC_LEN];
+    sensor_frame_header_t header;
+
+    for (uint8_t i = 0; i < sizeof(flags); i++)
+    {
+        uint16_t length = frame_build(flags[i], 0x12345678 + i, buf);
+
+        CHECK(sensor_frame_header_decode(buf, length, &header) == sensor_frame_header_len(flags[i]));
+        CHECK(header.version == SENSOR_FRAME_VERSION);
+        CHECK(header.flags == flags[i]);
+        CHECK(header.payload_len == length - sensor_frame_header_len(flags[i]));
+        CHECK(header.seq == 0x12345678u + i);
+        CHECK(header.timestamp == ((flags[i] & SENSOR_FRAME_FLAG_TIMESTAMP) ? 0xA1B2C3D4 : 0));
+    }
+}
+
+
+static void test_little_endian(void)
+{
+    static const uint8_t expected[] = {SENSOR_FRAME_VERSION, SENSOR_FRAME_FLAG_TIMESTAMP,
+                                       0x34, 0x12, 0x04, 0x03, 0x02, 0x01, 0xDD, 0xCC, 0xBB, 0xAA};
+    uint8_t               buf[SENSOR_FRAME_HEADER_MAX_LEN];
+    sensor_frame_header_t header;
+
+    memset(&header, 0, sizeof(header));
+    header.version     = 0x77;      // Ignored, the current version is written.
+    header.flags       = SENSOR_FRAME_FLAG_TIMESTAMP;
+    header.payload_len = 0x1234;
+    header.seq         = 0x01020304;
+    header.timestamp   = 0xAABBCCDD;
+
+    CHECK(sensor_frame_header_encode(&header, buf, sizeof(buf)) == sizeof(expected));
+    CHECK(memcmp(buf, expected, sizeof(expected)) == 0);
+}
+
+
+static void test_encode_short_buffer(void)
+{
+    uint8_t               buf[SENSOR_FRAME_HEADER_MAX_LEN];
+    sensor_frame_header_t header;
+
+    memset(&header, 0, sizeof(header));
+    header.flags = SENSOR_FRAME_FLAG_TIMESTAMP;
+
+    CHECK(sensor_frame_header_encode(&header, buf, SENSOR_FRAME_HEADER_MAX_LEN - 1) == 0);
+    CHECK(sensor_frame_header_encode(&header, buf, SENSOR_FRAME_HEADER_MAX_LEN) == SENSOR_FRAME_HEADER_MAX_LEN);
+
+    header.flags = 0;
+    CHECK(sensor_frame_header_encode(&header, buf, SENSOR_FRAME_HEADER_LEN - 1) == 0);
+    CHECK(sensor_frame_header_encode(&header, buf, SENSOR_FRAME_HEADER_LEN) == SENSOR_FRAME_HEADER_LEN);
+}
+
+
+static void test_decode_rejects(void)
+{
+    uint8_t               buf[SENSOR_FRAME_HEADER_MAX_LEN + DATA_LEN + SENSOR_FRAME_CRC_LEN];
+    sensor_frame_header_t header;
+    uint16_t              length;
+
+    // Truncated before the end of the fixed header.
+    length = frame_build(0, 1, buf);
+    CHECK(sensor_frame_header_decode(buf, SENSOR_FRAME_HEADER_LEN - 1, &header) == 0);
+
+    // Payload length does not match the received length, either way.
+    CHECK(sensor_frame_header_decode(buf, length - 1, &header) == 0);
+    CHECK(sensor_frame_header_decode(buf, length + 1, &header) == 0);
+
+    // Unknown version.
+    buf[0] = SENSOR_FRAME_VERSION + 1;
+    CHECK(sensor_frame_header_decode(buf, length, &header) == 0);
+
+    // Flagged timestamp cut off.
+    length = frame_build(SENSOR_FRAME_FLAG_TIMESTAMP, 1, buf);
+    buf[2] = 0;
+    buf[3] = 0;
+    CHECK(sensor_frame_header_decode(buf, SENSOR_FRAME_HEADER_LEN, &header) == 0);
+    CHECK(sensor_frame_header_decode(buf, SENSOR_FRAME_HEADER_MAX_LEN, &header) == SENSOR_FRAME_HEADER_MAX_LEN);
+    CHECK(header.payload_len == 0);
+}
+
+
+static void test_patch(void)
+{
+    uint8_t               buf[SENSOR_FRAME_HEADER_MAX_LEN + DATA_LEN + SENSOR_FRAME_CRC_LEN];
+    sensor_frame_header_t header;
+    uint16_t              length = frame_build(SENSOR_FRAME_FLAG_TIMESTAMP, 1, buf);
+
+    sensor_frame_seq_patch(buf, 0xCAFEF00D);
+    sensor_frame_flags_patch(buf, SENSOR_FRAME_FLAG_TIMESTAMP | SENSOR_FRAME_FLAG_RETX);
+    sensor_frame_timestamp_patch(buf, 42);
+
+    CHECK(sensor_frame_header_decode(buf, length, &header) == SENSOR_FRAME_HEADER_MAX_LEN);
+    CHECK(header.seq == 0xCAFEF00D);
+    CHECK(header.flags == (SENSOR_FRAME_FLAG_TIMESTAMP | SENSOR_FRAME_FLAG_RETX));
+    CHECK(header.timestamp == 42);
+    CHECK(buf[SENSOR_FRAME_HEADER_MAX_LEN + 1] == 7);
+}
+
+
+static void test_crc(void)
+{
+    uint8_t  buf[SENSOR_FRAME_HEADER_MAX_LEN + DATA_LEN + SENSOR_FRAME_CRC_LEN];
+    uint8_t  flags[] = {SENSOR_FRAME_FLAG_CRC, SENSOR_FRAME_FLAG_CRC | SENSOR_FRAME_FLAG_TIMESTAMP};
+    uint16_t length;
+    uint16_t crc;
+
+    for (uint8_t i = 0; i < sizeof(flags); i++)
+    {
+        uint8_t header_len = sensor_frame_header_len(flags[i]);
+
+        length = frame_build(flags[i], 9, buf);
+        CHECK(sensor_frame_crc_check(buf, length));
+
+        // The trailer covers the data first, then the header.
+        crc = crc16_compute(&buf[header_len], DATA_LEN, NULL);
+        crc = crc16_compute(buf, header_len, &crc);
+        CHECK(buf[length - 2] == (uint8_t)crc);
+        CHECK(buf[length - 1] == (uint8_t)(crc >> 8));
+
+        // A new sequence number only needs the trailer patched, from the same payload CRC.
+        sensor_frame_seq_patch(buf, 10);
+        CHECK(!sensor_frame_crc_check(buf, length));
+        sensor_frame_crc_patch(buf, crc16_compute(&buf[header_len], DATA_LEN, NULL));
+        CHECK(sensor_frame_crc_check(buf, length));
+
+        // Corrupted data, header or trailer.
+        buf[header_len + 3] ^= 0x01;
+        CHECK(!sensor_frame_crc_check(buf, length));
+        buf[header_len + 3] ^= 0x01;
+        buf[4]              ^= 0x80;
+        CHECK(!sensor_frame_crc_check(buf, length));
+        buf[4]              ^= 0x80;
+        buf[length - 1]     ^= 0x10;
+        CHECK(!sensor_frame_crc_check(buf, length));
+        buf[length - 1]     ^= 0x10;
+        CHECK(sensor_frame_crc_check(buf, length));
+
+        // Too short for a trailer.
+        CHECK(!sensor_frame_crc_check(buf, header_len + 1));
+    }
+
+    // Frames without the flag have no trailer to check.
+    length = frame_build(0, 9, buf);
+    buf[length - 1] ^= 0xFF;
+    CHECK(sensor_frame_crc_check(buf, length));
+}
+
+
+int main(void)
+{
+    RUN(test_header_len);
+    RUN(test_round_trip);
+    RUN(test_little_endian);
+    RUN(test_encode_short_buffer);
+    RUN(test_decode_rejects);
+    RUN(test_patch);
+    RUN(test_crc);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,205 @@
+#include <stdlib.h>
+#include <string.h>
+#include "test_check.h"
+#include "tx_order.h"
+
+
+#define QUEUE_MAX   64      /**< Notifications the queue model of @ref test_random holds. */
+
+
+static tx_order_t m_order;
+
+
+static void test_push_and_complete(void)
+{
+    uint16_t counts[TX_ORDER_OWNERS_MAX];
+
+    tx_order_reset(&m_order);
+    CHECK(tx_order_pending(&m_order, 0) == 0);
+
+    CHECK(tx_order_push(&m_order, 0, 3));
+    CHECK(tx_order_push(&m_order, 0, 2));
+    CHECK(m_order.run_count == 1);
+    CHECK(tx_order_pending(&m_order, 0) == 5);
+    CHECK(tx_order_pending(&m_order, 1) == 0);
+
+    tx_order_complete(&m_order, 4, counts);
+    CHECK(counts[0] == 4);
+    CHECK(counts[1] == 0);
+    CHECK(tx_order_pending(&m_order, 0) == 1);
+
+    tx_order_complete(&m_order, 1, counts);
+    CHECK(counts[0] == 1);
+    CHECK(m_order.run_count == 0);
+}
+
+
+static void test_interleaved(void)
+{
+    uint16_t counts[TX_ORDER_OWNERS_MAX];
+
+    tx_order_reset(&m_order);
+
+    // Queue: 0 0 1 2 2 2 0 1
+    CHECK(tx_order_push(&m_order, 0, 2));
+    CHECK(tx_order_push(&m_order, 1, 1));
+    CHECK(tx_order_push(&m_order, 2, 3));
+    CHECK(tx_order_push(&m_order, 0, 1));
+    CHECK(tx_order_push(&m_order, 1, 1));
+    CHECK(m_order.run_count == 5);
+    CHECK(tx_order_pending(&m_order, 0) == 3);
+    CHECK(tx_order_pending(&m_order, 1) == 2);
+    CHECK(tx_order_pending(&m_order, 2) == 3);
+
+    // One completion event across three runs, ending in the middle of one.
+    tx_order_complete(&m_order, 4, counts);
+    CHECK(counts[0] == 2);
+    CHECK(counts[1] == 1);
+    CHECK(counts[2] == 1);
+    CHECK(counts[3] == 0);
+    CHECK(tx_order_pending(&m_order, 2) == 2);
+
+    tx_order_complete(&m_order, 3, counts);
+    CHECK(counts[0] == 1);
+    CHECK(counts[1] == 0);
+    CHECK(counts[2] == 2);
+
+    tx_order_complete(&m_order, 1, counts);
+    CHECK(counts[1] == 1);
+    CHECK(m_order.run_count == 0);
+}
+
+
+static void test_bad_arguments(void)
+{
+    tx_order_reset(&m_order);
+
+    // Nothing queued is nothing to record.
+    CHECK(tx_order_push(&m_order, 0, 0));
+    CHECK(tx_order_push(&m_order, TX_ORDER_OWNERS_MAX, 0));
+    CHECK(m_order.run_count == 0);
+
+    CHECK(!tx_order_push(&m_order, TX_ORDER_OWNERS_MAX, 1));
+    CHECK(m_order.run_count == 0);
+}
+
+
+static void test_runs_full(void)
+{
+    uint16_t counts[TX_ORDER_OWNERS_MAX];
+
+    tx_order_reset(&m_order);
+
+    for (uint32_t i = 0; i < TX_ORDER_RUNS_MAX; i++)
+    {
+        CHECK(tx_order_push(&m_order, i % 2, 1));
+    }
+
+    // A new run does not fit, more of the last one does.
+    CHECK(!tx_order_push(&m_order, TX_ORDER_RUNS_MAX % 2, 1));
+    CHECK(tx_order_push(&m_order, (TX_ORDER_RUNS_MAX - 1) % 2, 1));
+    CHECK(m_order.run_count == TX_ORDER_RUNS_MAX);
+    CHECK(tx_order_pending(&m_order, 0) + tx_order_pending(&m_order, 1) == TX_ORDER_RUNS_MAX + 1);
+
+    // A completed run makes room, across the end of the array.
+    tx_order_complete(&m_order, 1, counts);
+    CHECK(counts[0] == 1);
+    CHECK(tx_order_push(&m_order, 3, 1));
+    CHECK(tx_order_pending(&m_order, 3) == 1);
+}
+
+
+static void test_complete_beyond_recorded(void)
+{
+    uint16_t counts[TX_ORDER_OWNERS_MAX];
+
+    tx_order_reset(&m_order);
+    CHECK(tx_order_push(&m_order, 1, 2));
+
+    tx_order_complete(&m_order, 5, counts);
+    CHECK(counts[0] == 0);
+    CHECK(counts[1] == 2);
+    CHECK(m_order.run_count == 0);
+
+    tx_order_complete(&m_order, 1, counts);
+    CHECK(counts[0] + counts[1] + counts[2] + counts[3] == 0);
+}
+
+
+/**@brief Random pushes and completions checked against a model of the queue, one owner per
+ *        notification.
+ */
+static void test_random(void)
+{
+    uint8_t  queue[QUEUE_MAX];
+    uint32_t queue_count = 0;
+    uint16_t counts[TX_ORDER_OWNERS_MAX];
+
+    srand(21);
+    tx_order_reset(&m_order);
+
+    for (uint32_t step = 0; step < 100000; step++)
+    {
+        if ((rand() % 2) && (queue_count < QUEUE_MAX))
+        {
+            uint8_t  owner = rand() % TX_ORDER_OWNERS_MAX;
+            uint16_t count = 1 + rand() % 3;
+
+            if (queue_count + count > QUEUE_MAX)
+            {
+                count = QUEUE_MAX - queue_count;
+            }
+
+            if (!tx_order_push(&m_order, owner, count))
+            {
+                CHECK(m_order.run_count == TX_ORDER_RUNS_MAX);
+                continue;
+            }
+
+            memset(&queue[queue_count], owner, count);
+            queue_count += count;
+        }
+        else
+        {
+            uint16_t count = rand() % 5;
+            uint16_t expected[TX_ORDER_OWNERS_MAX] = {0};
+            uint32_t done = (count < queue_count) ? count : queue_count;
+
+            for (uint32_t i = 0; i < done; i++)
+            {
+                expected[queue[i]]++;
+            }
+
+            memmove(queue, &queue[done], queue_count - done);
+            queue_count -= done;
+
+            tx_order_complete(&m_order, count, counts);
+            CHECK(memcmp(counts, expected, sizeof(counts)) == 0);
+        }
+
+        for (uint8_t owner = 0; owner < TX_ORDER_OWNERS_MAX; owner++)
+        {
+            uint32_t pending = 0;
+
+            for (uint32_t i = 0; i < queue_count; i++)
+            {
+                pending += (queue[i] == owner);
+            }
+
+            CHECK(tx_order_pending(&m_order, owner) == pending);
+        }
+    }
+}
+
+
+int main(void)
+{
+    RUN(test_push_and_complete);
+    RUN(test_interleaved);
+    RUN(test_bad_arguments);
+    RUN(test_runs_full);
+    RUN(test_complete_beyond_recorded);
+    RUN(test_random);
+
+    return EXIT_SUCCESS;
+}
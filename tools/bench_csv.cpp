@@ -0,0 +1,106 @@
+#include <cctype>
+#include <sstream>
+#include "bench_csv.h"
+#include "hex.h"
+
+#define RESULT_LEN      20      /**< Length of a result record, BENCH_MATRIX_RESULT_LEN. */
+#define LOG_TAG         "bench,"
+#define LOG_FIELDS      10      /**< Numbers in a "bench," log line. */
+
+char const * const BENCH_CSV_HEADER =
+    "cell,status,phy,conn_interval,att_mtu,data_length,queue_size,goodput_bps,packets_per_event_x100,elapsed_ms";
+
+
+static uint32_t uint_get(std::vector<uint8_t> const & record, size_t offset, size_t size)
+{
+    uint32_t value = 0;
+
+    for (size_t i = size; i > 0; i--)
+    {
+        value = (value << 8) | record[offset + i - 1];
+    }
+
+    return value;
+}
+
+
+bool bench_csv_record_parse(std::string const & line, std::vector<uint8_t> * p_record)
+{
+    return hex_parse(line, p_record) && (p_record->size() == RESULT_LEN);
+}
+
+
+/**@brief Function for checking the fields of a "bench," log line, @ref LOG_FIELDS numbers.
+ */
+static bool log_fields_check(std::string const & fields)
+{
+    size_t count  = 0;
+    bool   digits = false;
+
+    for (size_t i = 0; i < fields.size(); i++)
+    {
+        if (std::isdigit((unsigned char)fields[i]))
+        {
+            digits = true;
+        }
+        else if ((fields[i] == ',') && digits)
+        {
+            count++;
+            digits = false;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return digits && (count + 1 == LOG_FIELDS);
+}
+
+
+bool bench_csv_row(std::string const & line, std::string * p_row)
+{
+    std::vector<uint8_t> record;
+    size_t               tag = line.find(LOG_TAG);
+
+    if (tag != std::string::npos)
+    {
+        // Log lines may carry a prefix of the logger and end in "\r".
+        std::string fields = line.substr(tag + sizeof(LOG_TAG) - 1);
+
+        while (!fields.empty() && std::isspace((unsigned char)fields[fields.size() - 1]))
+        {
+            fields.erase(fields.size() - 1);
+        }
+
+        if (!log_fields_check(fields))
+        {
+            return false;
+        }
+
+        *p_row = fields;
+        return true;
+    }
+
+    if (!bench_csv_record_parse(line, &record))
+    {
+        return false;
+    }
+
+    std::ostringstream row;
+
+    row << uint_get(record, 0, 1)  << ','    // Cell index, the cell count is not in the log line.
+        << uint_get(record, 2, 1)  << ','
+        << uint_get(record, 3, 1)  << ','
+        << uint_get(record, 4, 2)  << ','
+        << uint_get(record, 6, 2)  << ','
+        << uint_get(record, 8, 1)  << ','
+        << uint_get(record, 9, 1)  << ','
+        << uint_get(record, 10, 4) << ','
+        << uint_get(record, 14, 2) << ','
+        << uint_get(record, 16, 4);
+
+    *p_row = row.str();
+
+    return true;
+}
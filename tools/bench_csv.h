@@ -0,0 +1,39 @@
+#ifndef __BENCH_CSV_H
+#define __BENCH_CSV_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**@brief   Header line of the CSV table, the columns of the "bench," log lines of the firmware. */
+extern char const * const BENCH_CSV_HEADER;
+
+
+/**@brief   Function for parsing a result record captured from char3.
+ *
+ * @details The record is written in hex, see @ref hex_parse. See bench_matrix_result_t for the
+ *          layout.
+ *
+ * @param[in]  line      Captured line.
+ * @param[out] p_record  Record bytes.
+ *
+ * @retval true   If the line holds one record and nothing else.
+ * @retval false  Otherwise.
+ */
+bool bench_csv_record_parse(std::string const & line, std::vector<uint8_t> * p_record);
+
+
+/**@brief   Function for turning a captured line into a row of the CSV table.
+ *
+ * @details Takes either a result record captured from char3, see @ref bench_csv_record_parse, or
+ *          a "bench," line of the firmware log. Both give the same row for the same result.
+ *
+ * @param[in]  line   Captured line.
+ * @param[out] p_row  Row, without line end.
+ *
+ * @retval true   If the line held a result.
+ * @retval false  If it did not, the line is to be skipped.
+ */
+bool bench_csv_row(std::string const & line, std::string * p_row);
+
+#endif // __BENCH_CSV_H
@@ -0,0 +1,64 @@
+/**@brief Turns benchmark matrix results into a CSV table.
+ *
+ *   bench_csv [capture...]
+ *
+ * Reads the captures given, or the standard input, and writes the table to the standard output.
+ * A capture may hold char3 notification values, one per line in hex, and lines of the firmware
+ * log; other lines are skipped. Exits with 1 if no result was found.
+ */
+#include <fstream>
+#include <iostream>
+#include "bench_csv.h"
+
+
+static size_t capture_convert(std::istream & in)
+{
+    std::string line;
+    std::string row;
+    size_t      rows = 0;
+
+    while (std::getline(in, line))
+    {
+        if (bench_csv_row(line, &row))
+        {
+            std::cout << row << '\n';
+            rows++;
+        }
+    }
+
+    return rows;
+}
+
+
+int main(int argc, char * argv[])
+{
+    size_t rows = 0;
+
+    std::cout << BENCH_CSV_HEADER << '\n';
+
+    if (argc < 2)
+    {
+        rows = capture_convert(std::cin);
+    }
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::ifstream in(argv[i]);
+
+        if (!in)
+        {
+            std::cerr << argv[i] << ": cannot open\n";
+            return 2;
+        }
+
+        rows += capture_convert(in);
+    }
+
+    if (rows == 0)
+    {
+        std::cerr << "no result found\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <cctype>
+#include "hex.h"
+
+
+/**@brief Function for getting the value of a hex digit, -1 if @p c is not one.
+ */
+static int hex_value(char c)
+{
+    if ((c >= '0') && (c <= '9'))
+    {
+        return c - '0';
+    }
+
+    c = (char)std::tolower((unsigned char)c);
+
+    return ((c >= 'a') && (c <= 'f')) ? (c - 'a' + 10) : -1;
+}
+
+
+bool hex_parse(std::string const & text, std::vector<uint8_t> * p_bytes)
+{
+    int high = -1;
+
+    p_bytes->clear();
+
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        char c = text[i];
+        int  value;
+
+        if ((c == ' ') || (c == '-') || (c == ':') || (c == '\t') || (c == '\r'))
+        {
+            // A separator may not split a byte.
+            if (high >= 0)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        if ((c == '0') && (high < 0) && (i + 1 < text.size()) && ((text[i + 1] == 'x') || (text[i + 1] == 'X')))
+        {
+            i++;
+            continue;
+        }
+
+        value = hex_value(c);
+        if (value < 0)
+        {
+            return false;
+        }
+
+        if (high < 0)
+        {
+            high = value;
+        }
+        else
+        {
+            p_bytes->push_back((uint8_t)((high << 4) | value));
+            high = -1;
+        }
+    }
+
+    return (high < 0) && !p_bytes->empty();
+}
+
+
+std::string hex_format(uint8_t const * p_bytes, size_t length)
+{
+    static char const digits[] = "0123456789abcdef";
+    std::string       text;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        text += digits[p_bytes[i] >> 4];
+        text += digits[p_bytes[i] & 0x0F];
+    }
+
+    return text;
+}
@@ -0,0 +1,26 @@
+#ifndef __HEX_H
+#define __HEX_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**@brief   Function for parsing bytes written in hex.
+ *
+ * @details Bytes may be separated by space, '-' or ':', and prefixed with "0x", as capture tools
+ *          such as nRF Connect print a notification value.
+ *
+ * @param[in]  text     Text to parse.
+ * @param[out] p_bytes  Bytes.
+ *
+ * @retval true   If @p text holds hex bytes and nothing else.
+ * @retval false  Otherwise.
+ */
+bool hex_parse(std::string const & text, std::vector<uint8_t> * p_bytes);
+
+
+/**@brief   Function for writing bytes in hex, without separators.
+ */
+std::string hex_format(uint8_t const * p_bytes, size_t length);
+
+#endif // __HEX_H
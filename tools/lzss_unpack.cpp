@@ -0,0 +1,126 @@
+#include <algorithm>
+#include "lzss_unpack.h"
+#include "lzss.h"
+
+#define MATCH_LEN_SHIFT     2
+#define OFFSET_HIGH_MASK    0x03
+
+
+LzssDecoder::LzssDecoder()
+    : m_history(LZSS_HISTORY_LEN)
+{
+    reset();
+}
+
+
+void LzssDecoder::reset()
+{
+    // Both sides start from a history of zeros.
+    std::fill(m_history.begin(), m_history.end(), 0);
+    m_pos = 0;
+}
+
+
+void LzssDecoder::put(uint8_t byte)
+{
+    m_history[m_pos++ % m_history.size()] = byte;
+}
+
+
+bool LzssDecoder::decode(uint8_t const * p_in, size_t in_len, std::vector<uint8_t> * p_out)
+{
+    size_t  in_idx = 0;
+    uint8_t flags  = 0;
+    uint8_t item   = 8;
+
+    p_out->clear();
+
+    while (in_idx < in_len)
+    {
+        if (item == 8)
+        {
+            flags = p_in[in_idx++];
+            item  = 0;
+            continue;
+        }
+
+        if (flags & (1 << item))
+        {
+            uint16_t offset;
+            uint16_t match_len;
+
+            if (in_idx + 2 > in_len)
+            {
+                return false;
+            }
+
+            offset    = p_in[in_idx] | ((p_in[in_idx + 1] & OFFSET_HIGH_MASK) << 8);
+            match_len = (p_in[in_idx + 1] >> MATCH_LEN_SHIFT) + LZSS_MATCH_MIN;
+            in_idx   += 2;
+
+            if ((offset == 0) || (p_out->size() + match_len > LZSS_BLOCK_MAX))
+            {
+                return false;
+            }
+
+            // Byte by byte, a match may overlap the bytes it produces.
+            for (uint16_t k = 0; k < match_len; k++)
+            {
+                uint8_t byte = m_history[(m_pos - offset) % m_history.size()];
+
+                put(byte);
+                p_out->push_back(byte);
+            }
+        }
+        else
+        {
+            if (p_out->size() >= LZSS_BLOCK_MAX)
+            {
+                return false;
+            }
+
+            put(p_in[in_idx]);
+            p_out->push_back(p_in[in_idx++]);
+        }
+
+        item++;
+    }
+
+    return true;
+}
+
+
+void LzssDecoder::raw(uint8_t const * p_data, size_t length)
+{
+    for (size_t k = 0; k < length; k++)
+    {
+        put(p_data[k]);
+    }
+}
+
+
+bool lzss_frame_unpack(LzssDecoder           * p_decoder,
+                       uint8_t const         * p_frame,
+                       size_t                  length,
+                       sensor_frame_header_t * p_header,
+                       std::vector<uint8_t>  * p_payload)
+{
+    uint8_t         header_len = sensor_frame_header_decode(p_frame, (uint16_t)length, p_header);
+    uint8_t const * p_data     = &p_frame[header_len];
+
+    p_payload->clear();
+
+    if (header_len == 0)
+    {
+        return false;
+    }
+
+    if (!(p_header->flags & SENSOR_FRAME_FLAG_COMPRESSED))
+    {
+        p_decoder->raw(p_data, p_header->payload_len);
+        p_payload->assign(p_data, p_data + p_header->payload_len);
+        return true;
+    }
+
+    return p_decoder->decode(p_data, p_header->payload_len, p_payload);
+}
@@ -0,0 +1,61 @@
+#ifndef __LZSS_UNPACK_H
+#define __LZSS_UNPACK_H
+
+#include <stdint.h>
+#include <vector>
+#include "sensor_frame.h"
+
+/**@brief   Decoder of the LZSS blocks of the compressed sensor stream, see lzss.h for the format.
+ *
+ * @details The history runs on from block to block, so every frame of the stream must be passed
+ *          in, in order, the ones sent uncompressed too.
+ */
+class LzssDecoder
+{
+public:
+    LzssDecoder();
+
+    /**@brief   Function for starting a new stream, as the firmware does when the stream starts. */
+    void reset();
+
+    /**@brief   Function for decoding a block.
+     *
+     * @param[in]  p_in     Encoded block.
+     * @param[in]  in_len   Length of @p p_in (in bytes).
+     * @param[out] p_out    Decoded block.
+     *
+     * @retval true   If the block was decoded.
+     * @retval false  If the block is malformed or decodes to more than @ref LZSS_BLOCK_MAX bytes.
+     *                The decoder must be reset.
+     */
+    bool decode(uint8_t const * p_in, size_t in_len, std::vector<uint8_t> * p_out);
+
+    /**@brief   Function for adding a block that was sent uncompressed to the history. */
+    void raw(uint8_t const * p_data, size_t length);
+
+private:
+    std::vector<uint8_t> m_history;     /**< Bytes output so far, indexed modulo its size. */
+    uint32_t             m_pos;         /**< Bytes output so far. */
+
+    void put(uint8_t byte);
+};
+
+
+/**@brief   Function for unpacking the payload of a sensor frame captured from char2.
+ *
+ * @param[in]  p_decoder  Decoder of the stream.
+ * @param[in]  p_frame    Frame.
+ * @param[in]  length     Length of @p p_frame (in bytes).
+ * @param[out] p_header   Header of the frame, payload_len as sent.
+ * @param[out] p_payload  Payload, decoded if the frame was compressed.
+ *
+ * @retval true   If the frame was unpacked.
+ * @retval false  If the frame header or its compressed payload is malformed.
+ */
+bool lzss_frame_unpack(LzssDecoder           * p_decoder,
+                       uint8_t const         * p_frame,
+                       size_t                  length,
+                       sensor_frame_header_t * p_header,
+                       std::vector<uint8_t>  * p_payload);
+
+#endif // __LZSS_UNPACK_H
@@ -0,0 +1,69 @@
+/**@brief Unpacks a capture of the compressed sensor stream.
+ *
+ *   lzss_unpack [capture]
+ *
+ * Reads char2 notification values, one per line in hex, from the capture given or the standard
+ * input. Writes one line per frame: its sequence number, then its payload in hex. Lines that are
+ * not hex are skipped. Every notification of the stream must be in the capture, in order.
+ */
+#include <fstream>
+#include <iostream>
+#include "hex.h"
+#include "lzss_unpack.h"
+
+
+static int capture_unpack(std::istream & in)
+{
+    LzssDecoder           decoder;
+    sensor_frame_header_t header;
+    std::vector<uint8_t>  frame;
+    std::vector<uint8_t>  payload;
+    std::string           line;
+    size_t                line_no = 0;
+
+    while (std::getline(in, line))
+    {
+        line_no++;
+
+        if (!hex_parse(line, &frame))
+        {
+            continue;
+        }
+
+        // The firmware starts the sequence numbers and the history over with every stream.
+        if ((sensor_frame_header_decode(frame.data(), (uint16_t)frame.size(), &header) != 0) &&
+            (header.seq == 0))
+        {
+            decoder.reset();
+        }
+
+        if (!lzss_frame_unpack(&decoder, frame.data(), frame.size(), &header, &payload))
+        {
+            std::cerr << "line " << line_no << ": malformed frame, the rest of the stream cannot be unpacked\n";
+            return 1;
+        }
+
+        std::cout << header.seq << ' ' << hex_format(payload.data(), payload.size()) << '\n';
+    }
+
+    return 0;
+}
+
+
+int main(int argc, char * argv[])
+{
+    if (argc < 2)
+    {
+        return capture_unpack(std::cin);
+    }
+
+    std::ifstream in(argv[1]);
+
+    if (!in)
+    {
+        std::cerr << argv[1] << ": cannot open\n";
+        return 2;
+    }
+
+    return capture_unpack(in);
+}